@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Función de mezcla de SplitMix64: biyección de 64 bits con buena difusión.
+ */
+inline uint64_t mezclar64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Para qué se usa un número aleatorio. Separa los sorteos de distinto tipo
+ * para que nunca compartan valores aunque coincidan piso, celda y turno.
+ */
+enum class Proposito : uint32_t {
+    Celda = 1,      // Contenido de una celda al generar el piso
+    Dados = 2,      // Tiradas de dados de moverJugador
+    Combate = 3,    // Turno inicial y objetivos en los combates
+    Taberna = 4,    // Recluta obtenida en una taberna
+    Politica = 5    // Decisiones de las políticas de movimiento automáticas
+};
+
+/**
+ * Generador aleatorio basado en contador, propio de cada partida.
+ *
+ * No guarda estado entre sorteos: cada número es una función pura de
+ * (semilla, flujo, propósito, piso, celda, turno, contador), calculada con dos
+ * rondas de SplitMix64. Así cualquier decisión de la partida se puede
+ * reproducir o saltar en O(1), y dos partidas con flujos distintos son
+ * independientes aunque se jueguen a la vez en hilos distintos.
+ */
+class GeneradorPartida {
+public:
+    GeneradorPartida(uint64_t semilla = 0, uint64_t flujo = 0)
+        : semilla(semilla), flujo(flujo), base(mezclar64(semilla ^ mezclar64(flujo))) {}
+
+    uint64_t obtenerSemilla() const { return semilla; }
+    uint64_t obtenerFlujo() const { return flujo; }
+
+    /**
+     * 64 bits aleatorios para una decisión concreta.
+     */
+    uint64_t bits(Proposito proposito, uint32_t piso, uint32_t celda, uint32_t turno, uint32_t contador) const {
+        return mezclar64(mezclaCelda(proposito, piso, celda) ^ (static_cast<uint64_t>(turno) << 32 | contador));
+    }
+
+    /**
+     * Valor al que se le suma (con xor) el número de celda en la primera ronda de bits().
+     */
+    uint64_t clavePiso(Proposito proposito, uint32_t piso) const {
+        return base ^ (static_cast<uint64_t>(proposito) << 56 ^ static_cast<uint64_t>(piso) << 32);
+    }
+
+    /**
+     * Primera ronda de bits(): no depende del turno ni del contador, así que
+     * todos los sorteos de una misma celda pueden compartirla.
+     */
+    uint64_t mezclaCelda(Proposito proposito, uint32_t piso, uint32_t celda) const {
+        return mezclar64(clavePiso(proposito, piso) ^ celda);
+    }
+
+    /**
+     * Entero uniforme en [0, n) sin sesgo (método de Lemire con rechazo).
+     * Los reintentos, muy poco frecuentes, usan contadores derivados del original.
+     */
+    int uniforme(int n, Proposito proposito, uint32_t piso, uint32_t celda, uint32_t turno, uint32_t contador) const {
+        uint32_t limite = static_cast<uint32_t>(n);
+        uint64_t x = bits(proposito, piso, celda, turno, contador);
+        uint64_t m = (x >> 32) * limite;
+        uint32_t bajo = static_cast<uint32_t>(m);
+        if (bajo < limite) {
+            uint32_t umbral = (0u - limite) % limite;
+            for (uint32_t reintento = 1; bajo < umbral; ++reintento) {
+                x = mezclar64(x ^ reintento);
+                m = (x >> 32) * limite;
+                bajo = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<int>(m >> 32);
+    }
+
+private:
+    uint64_t semilla;   // Semilla de la partida
+    uint64_t flujo;     // Identificador de flujo (p. ej. número de partida en una simulación)
+    uint64_t base;      // Mezcla precalculada de semilla y flujo
+};
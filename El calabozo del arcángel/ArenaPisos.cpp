@@ -0,0 +1,108 @@
+#include "ArenaPisos.h"
+
+ArenaPisos::~ArenaPisos() {
+    for (const BloqueArena& bloque : libres) {
+        ::operator delete(bloque.datos);
+    }
+}
+
+void ArenaPisos::soltarGuardado(size_t indice) {
+    bytesGuardados -= libres[indice].bytes;
+    ::operator delete(libres[indice].datos);
+    libres.erase(libres.begin() + static_cast<std::ptrdiff_t>(indice));
+}
+
+BloqueArena ArenaPisos::tomar(size_t bytes) {
+    std::lock_guard<std::mutex> candado(mutex);
+
+    // El bloque guardado más chico que alcance, si no desperdicia más de la mitad
+    size_t elegido = libres.size();
+    for (size_t i = 0; i < libres.size(); ++i) {
+        if (libres[i].bytes >= bytes && libres[i].bytes / 2 <= bytes
+            && (elegido == libres.size() || libres[i].bytes < libres[elegido].bytes)) {
+            elegido = i;
+        }
+    }
+    if (elegido < libres.size()) {
+        BloqueArena bloque = libres[elegido];
+        libres.erase(libres.begin() + static_cast<std::ptrdiff_t>(elegido));
+        bytesGuardados -= bloque.bytes;
+        bytesEnUso += bloque.bytes;
+        ++numReusos;
+        return bloque;
+    }
+
+    if (limiteBytes > 0) {
+        if (bytes > limiteBytes - std::min(limiteBytes, bytesEnUso)) {
+            throw std::bad_alloc(); // Ni soltando todo lo guardado alcanza
+        }
+        while (bytesEnUso + bytesGuardados + bytes > limiteBytes) {
+            soltarGuardado(0);
+        }
+    }
+
+    BloqueArena bloque;
+    bloque.datos = ::operator new(bytes);
+    bloque.bytes = bytes;
+    bytesEnUso += bytes;
+    bytesPico = std::max(bytesPico, bytesEnUso + bytesGuardados);
+    ++numReservas;
+    return bloque;
+}
+
+void ArenaPisos::devolver(const BloqueArena& bloque) noexcept {
+    std::lock_guard<std::mutex> candado(mutex);
+    bytesEnUso -= bloque.bytes;
+    if (libres.size() == maxGuardados) {
+        soltarGuardado(0); // El más viejo
+    }
+    libres.push_back(bloque);
+    bytesGuardados += bloque.bytes;
+}
+
+BloqueArena ArenaPisos::tomarDe(ArenaPisos* arena, size_t bytes) {
+    if (arena) {
+        return arena->tomar(bytes);
+    }
+    BloqueArena bloque;
+    bloque.datos = ::operator new(bytes);
+    bloque.bytes = bytes;
+    return bloque;
+}
+
+void ArenaPisos::devolverA(ArenaPisos* arena, const BloqueArena& bloque) noexcept {
+    if (!bloque.datos) {
+        return;
+    }
+    if (arena) {
+        arena->devolver(bloque);
+    }
+    else {
+        ::operator delete(bloque.datos);
+    }
+}
+
+size_t ArenaPisos::enUso() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return bytesEnUso;
+}
+
+size_t ArenaPisos::guardados() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return bytesGuardados;
+}
+
+size_t ArenaPisos::pico() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return bytesPico;
+}
+
+uint64_t ArenaPisos::reservas() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numReservas;
+}
+
+uint64_t ArenaPisos::reusos() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numReusos;
+}
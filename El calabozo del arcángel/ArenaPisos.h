@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Bloque de memoria entregado por una ArenaPisos, con su tamaño real.
+ */
+struct BloqueArena {
+    void* datos = nullptr;
+    size_t bytes = 0;
+};
+
+/**
+ * Memoria de los pisos de una sesión. Los pisos piden bloques grandes (la
+ * cuadrícula entera, o tramos de celdas en los pisos perezosos) y al cambiar
+ * de piso los devuelven todos de una vez; la arena se queda con ellos y se los
+ * da al piso siguiente, así que una partida deja de pedir memoria al sistema
+ * después del primer piso.
+ *
+ * Lleva la cuenta de los bytes de la sesión (en uso y guardados para reusar)
+ * y puede tener un límite: un pedido que lo supera, aun soltando los bloques
+ * guardados, lanza std::bad_alloc como lo haría un std::vector.
+ *
+ * Es segura entre hilos: el preparador de pisos y el guardado en segundo plano
+ * piden y devuelven bloques de la misma arena. Debe vivir más que los pisos que
+ * la usan.
+ */
+class ArenaPisos {
+public:
+    /**
+     * param limite Bytes máximos de la sesión (0 = sin límite).
+     */
+    explicit ArenaPisos(size_t limite = 0) : limiteBytes(limite) {}
+    ~ArenaPisos();
+
+    ArenaPisos(const ArenaPisos&) = delete;
+    ArenaPisos& operator=(const ArenaPisos&) = delete;
+
+    /**
+     * Entrega un bloque de al menos 'bytes' bytes, reusando uno guardado si hay
+     * alguno que sirva.
+     */
+    BloqueArena tomar(size_t bytes);
+
+    /**
+     * Recibe un bloque que ya no se usa y lo guarda para el próximo piso.
+     */
+    void devolver(const BloqueArena& bloque) noexcept;
+
+    /**
+     * Como tomar y devolver, pero sin arena usan el montículo directamente.
+     */
+    static BloqueArena tomarDe(ArenaPisos* arena, size_t bytes);
+    static void devolverA(ArenaPisos* arena, const BloqueArena& bloque) noexcept;
+
+    size_t enUso() const;           // Bytes en bloques entregados
+    size_t guardados() const;       // Bytes en bloques guardados para reusar
+    size_t pico() const;            // Mayor enUso() + guardados() alcanzado
+    size_t limite() const { return limiteBytes; }
+    uint64_t reservas() const;      // Bloques pedidos al sistema
+    uint64_t reusos() const;        // Bloques entregados sin pedir memoria
+
+private:
+    static const size_t maxGuardados = 8;
+
+    void soltarGuardado(size_t indice);
+
+    mutable std::mutex mutex;
+    std::vector<BloqueArena> libres;
+    size_t limiteBytes;
+    size_t bytesEnUso = 0;
+    size_t bytesGuardados = 0;
+    size_t bytesPico = 0;
+    uint64_t numReservas = 0;
+    uint64_t numReusos = 0;
+};
+
+/**
+ * Arreglo de tamaño fijo cuyos elementos viven en un bloque de una ArenaPisos.
+ * Copiarlo pide otro bloque a la misma arena; moverlo no pide nada.
+ */
+template <typename T>
+class ArregloArena {
+    static_assert(std::is_trivially_copyable<T>::value, "Los elementos se copian byte a byte");
+
+public:
+    ArregloArena() = default;
+
+    ArregloArena(const ArregloArena& otro) : arena(otro.arena) {
+        redimensionar(otro.cantidad, otro.arena);
+        if (cantidad > 0) {
+            std::memcpy(bloque.datos, otro.bloque.datos, cantidad * sizeof(T));
+        }
+    }
+
+    ArregloArena(ArregloArena&& otro) noexcept : arena(otro.arena), bloque(otro.bloque), cantidad(otro.cantidad) {
+        otro.bloque = BloqueArena();
+        otro.cantidad = 0;
+    }
+
+    ArregloArena& operator=(const ArregloArena& otro) {
+        if (this != &otro) {
+            ArregloArena copia(otro);
+            *this = std::move(copia);
+        }
+        return *this;
+    }
+
+    ArregloArena& operator=(ArregloArena&& otro) noexcept {
+        if (this != &otro) {
+            liberar();
+            arena = otro.arena;
+            bloque = otro.bloque;
+            cantidad = otro.cantidad;
+            otro.bloque = BloqueArena();
+            otro.cantidad = 0;
+        }
+        return *this;
+    }
+
+    ~ArregloArena() {
+        liberar();
+    }
+
+    /**
+     * Deja n copias de 'valor'. Si el bloque actual alcanza y es de la misma
+     * arena, se reusa sin pedir memoria.
+     */
+    void asignar(size_t n, const T& valor, ArenaPisos* nuevaArena) {
+        redimensionar(n, nuevaArena);
+        std::fill(data(), data() + n, valor);
+    }
+
+    /**
+     * Devuelve el bloque a la arena; el arreglo queda vacío.
+     */
+    void liberar() noexcept {
+        ArenaPisos::devolverA(arena, bloque);
+        bloque = BloqueArena();
+        cantidad = 0;
+    }
+
+    size_t size() const { return cantidad; }
+    bool empty() const { return cantidad == 0; }
+    T* data() { return static_cast<T*>(bloque.datos); }
+    const T* data() const { return static_cast<const T*>(bloque.datos); }
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    T* begin() { return data(); }
+    T* end() { return data() + cantidad; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + cantidad; }
+    size_t bytesReservados() const { return bloque.bytes; }
+
+    /**
+     * Como asignar, pero los n elementos quedan sin inicializar: quien llama
+     * debe escribirlos todos.
+     */
+    void redimensionar(size_t n, ArenaPisos* nuevaArena) {
+        size_t bytes = n * sizeof(T);
+        if (nuevaArena != arena || bytes > bloque.bytes) {
+            liberar();
+            arena = nuevaArena;
+            if (bytes > 0) {
+                bloque = ArenaPisos::tomarDe(arena, bytes);
+            }
+        }
+        cantidad = n;
+    }
+
+private:
+    ArenaPisos* arena = nullptr;
+    BloqueArena bloque;
+    size_t cantidad = 0;
+};
+
+/**
+ * Tabla de valores por clave entera cuyos valores no se mueven nunca: viven en
+ * tramos de una ArenaPisos y solo el índice (direccionamiento abierto) se
+ * rehace al crecer. vaciar() devuelve todos los tramos de una vez.
+ *
+ * Los tramos empiezan chicos y duplican su tamaño hasta MaxTramo: una tabla
+ * con pocos valores (un piso perezoso recién empezado) ocupa poco.
+ */
+template <typename T>
+class TablaArena {
+    static_assert(std::is_trivially_copyable<T>::value, "Los valores se copian byte a byte");
+
+public:
+    TablaArena() = default;
+
+    TablaArena(const TablaArena& otro) : arena(otro.arena) {
+        for (const Ranura& ranura : otro.ranuras) {
+            if (ranura.valor) {
+                insertar(ranura.clave, *ranura.valor);
+            }
+        }
+    }
+
+    TablaArena(TablaArena&& otro) noexcept
+        : arena(otro.arena), tramos(std::move(otro.tramos)), usadosUltimo(otro.usadosUltimo),
+        capacidadUltimo(otro.capacidadUltimo), ranuras(std::move(otro.ranuras)), cantidad(otro.cantidad) {
+        otro.tramos.clear();
+        otro.usadosUltimo = 0;
+        otro.capacidadUltimo = 0;
+        otro.cantidad = 0;
+    }
+
+    TablaArena& operator=(const TablaArena& otro) {
+        if (this != &otro) {
+            TablaArena copia(otro);
+            *this = std::move(copia);
+        }
+        return *this;
+    }
+
+    TablaArena& operator=(TablaArena&& otro) noexcept {
+        if (this != &otro) {
+            vaciar();
+            arena = otro.arena;
+            tramos = std::move(otro.tramos);
+            usadosUltimo = otro.usadosUltimo;
+            capacidadUltimo = otro.capacidadUltimo;
+            ranuras = std::move(otro.ranuras);
+            cantidad = otro.cantidad;
+            otro.tramos.clear();
+            otro.usadosUltimo = 0;
+            otro.capacidadUltimo = 0;
+            otro.cantidad = 0;
+        }
+        return *this;
+    }
+
+    ~TablaArena() {
+        vaciar();
+    }
+
+    /**
+     * Vacía la tabla y elige la arena de los próximos valores.
+     */
+    void reiniciar(ArenaPisos* nuevaArena) {
+        vaciar();
+        arena = nuevaArena;
+    }
+
+    /**
+     * Devuelve todos los tramos y el índice a la arena.
+     */
+    void vaciar() noexcept {
+        for (const BloqueArena& tramo : tramos) {
+            ArenaPisos::devolverA(arena, tramo);
+        }
+        tramos.clear();
+        usadosUltimo = 0;
+        capacidadUltimo = 0;
+        ranuras.liberar();
+        cantidad = 0;
+    }
+
+    T* buscar(int64_t clave) {
+        if (ranuras.empty()) {
+            return nullptr;
+        }
+        for (size_t i = posicion(clave);; i = (i + 1) & (ranuras.size() - 1)) {
+            if (!ranuras[i].valor || ranuras[i].clave == clave) {
+                return ranuras[i].valor;
+            }
+        }
+    }
+
+    const T* buscar(int64_t clave) const {
+        return const_cast<TablaArena*>(this)->buscar(clave);
+    }
+
+    /**
+     * Agrega un valor con una clave que todavía no está en la tabla.
+     * return Dirección del valor, estable hasta vaciar la tabla.
+     */
+    T* insertar(int64_t clave, const T& valor) {
+        if ((cantidad + 1) * 4 > ranuras.size() * 3) {
+            crecer();
+        }
+        if (usadosUltimo == capacidadUltimo) {
+            size_t capacidad = capacidadUltimo == 0 ? PrimerTramo : capacidadUltimo * 2;
+            if (capacidad > MaxTramo) {
+                capacidad = MaxTramo;
+            }
+            tramos.push_back(ArenaPisos::tomarDe(arena, capacidad * sizeof(T)));
+            capacidadUltimo = capacidad;
+            usadosUltimo = 0;
+        }
+        T* nuevo = static_cast<T*>(tramos.back().datos) + usadosUltimo++;
+        std::memcpy(static_cast<void*>(nuevo), &valor, sizeof(T));
+        colocar(clave, nuevo);
+        ++cantidad;
+        return nuevo;
+    }
+
+    size_t size() const { return cantidad; }
+
+    /**
+     * Llama a funcion(clave, valor) para cada valor de la tabla, sin orden fijo.
+     */
+    template <class Funcion>
+    void paraCada(Funcion&& funcion) const {
+        for (const Ranura& ranura : ranuras) {
+            if (ranura.valor) {
+                funcion(ranura.clave, static_cast<const T&>(*ranura.valor));
+            }
+        }
+    }
+
+private:
+    static const size_t PrimerTramo = 16;
+    static const size_t MaxTramo = 256;
+    static const size_t MinRanuras = 16;
+
+    struct Ranura {
+        int64_t clave;
+        T* valor;       // nullptr = ranura libre
+    };
+
+    size_t posicion(int64_t clave) const {
+        uint64_t h = static_cast<uint64_t>(clave) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32)) & (ranuras.size() - 1);
+    }
+
+    void colocar(int64_t clave, T* valor) {
+        size_t i = posicion(clave);
+        while (ranuras[i].valor) {
+            i = (i + 1) & (ranuras.size() - 1);
+        }
+        ranuras[i].clave = clave;
+        ranuras[i].valor = valor;
+    }
+
+    void crecer() {
+        ArregloArena<Ranura> anteriores(std::move(ranuras));
+        ranuras.asignar(anteriores.empty() ? MinRanuras : anteriores.size() * 2, Ranura{ 0, nullptr }, arena);
+        for (const Ranura& ranura : anteriores) {
+            if (ranura.valor) {
+                colocar(ranura.clave, ranura.valor);
+            }
+        }
+    }
+
+    ArenaPisos* arena = nullptr;
+    std::vector<BloqueArena> tramos;
+    size_t usadosUltimo = 0;            // Valores ocupados del último tramo
+    size_t capacidadUltimo = 0;         // Valores que caben en el último tramo
+    ArregloArena<Ranura> ranuras;       // Potencia de 2
+    size_t cantidad = 0;
+};
@@ -0,0 +1,393 @@
+#include "Barrido.h"
+#include "Bits.h"
+#include "Guardado.h"
+#include "PoolHilos.h"
+#include "Simulacion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+    const char* nombresVeredictos[] = { "dentro", "dudosa", "debajo", "encima" };
+
+    /**
+     * Intervalo de Wilson para una proporción: a diferencia del normal, no se
+     * sale de [0, 1] ni colapsa cuando todas las partidas terminan igual.
+     */
+    void intervaloWilson(uint64_t exitos, uint64_t total, double z, double& inferior, double& superior) {
+        if (total == 0) {
+            inferior = 0.0;
+            superior = 1.0;
+            return;
+        }
+        double n = static_cast<double>(total);
+        double p = static_cast<double>(exitos) / n;
+        double z2 = z * z;
+        double divisor = 1.0 + z2 / n;
+        double centro = (p + z2 / (2.0 * n)) / divisor;
+        double margen = z * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / divisor;
+        inferior = std::max(0.0, centro - margen);
+        superior = std::min(1.0, centro + margen);
+    }
+
+    VeredictoBarrido veredictoDe(const ResultadoConfiguracion& resultado, double minimo, double maximo) {
+        if (resultado.superior < minimo) {
+            return VeredictoBarrido::Debajo;
+        }
+        if (resultado.inferior > maximo) {
+            return VeredictoBarrido::Encima;
+        }
+        return resultado.inferior >= minimo && resultado.superior <= maximo ? VeredictoBarrido::Dentro : VeredictoBarrido::Dudosa;
+    }
+
+    /**
+     * Índices de las configuraciones a jugar, en orden. Con una muestra más
+     * chica que la cuadrícula se eligen sin repetir con el algoritmo de Floyd,
+     * que no necesita recorrer la cuadrícula entera.
+     */
+    std::vector<uint64_t> elegirConfiguraciones(uint64_t total, uint64_t muestras, uint64_t semilla) {
+        std::vector<uint64_t> elegidas;
+        if (muestras == 0 || muestras >= total) {
+            elegidas.resize(static_cast<size_t>(total));
+            for (uint64_t i = 0; i < total; ++i) {
+                elegidas[static_cast<size_t>(i)] = i;
+            }
+            return elegidas;
+        }
+        std::unordered_set<uint64_t> vistas;
+        uint64_t sorteo = 0;
+        for (uint64_t j = total - muestras; j < total; ++j) {
+            // Módulo de 64 bits: el sesgo es despreciable para cuadrículas de este tamaño
+            uint64_t t = mezclar64(semilla ^ mezclar64(++sorteo)) % (j + 1);
+            uint64_t elegida = vistas.count(t) ? j : t;
+            vistas.insert(elegida);
+            elegidas.push_back(elegida);
+        }
+        std::sort(elegidas.begin(), elegidas.end());
+        return elegidas;
+    }
+
+    /**
+     * Valores de cada eje para una posición de la cuadrícula; el último eje es el que cambia más rápido.
+     */
+    std::vector<int> valoresDe(const std::vector<EjeBarrido>& ejes, uint64_t posicion) {
+        std::vector<int> valores(ejes.size());
+        for (size_t e = ejes.size(); e-- > 0;) {
+            uint64_t cantidad = ejes[e].valores.size();
+            valores[e] = ejes[e].valores[static_cast<size_t>(posicion % cantidad)];
+            posicion /= cantidad;
+        }
+        return valores;
+    }
+
+    /**
+     * Suma una ronda a una configuración: 'bits' tiene un bit por partida de la ronda, en 1 si ganó.
+     */
+    void sumarRonda(ResultadoConfiguracion& resultado, const uint64_t* bits, size_t palabras, uint64_t partidas) {
+        for (size_t p = 0; p < palabras; ++p) {
+            resultado.victorias += static_cast<uint64_t>(contarUnos(bits[p]));
+        }
+        resultado.partidas += partidas;
+    }
+
+    void escribirValores(std::ostream& salida, const std::vector<int>& valores) {
+        for (int valor : valores) {
+            salida << valor << ",";
+        }
+    }
+}
+
+bool leerEjeBarrido(const std::string& texto, EjeBarrido& eje, std::string& error) {
+    size_t igual = texto.find('=');
+    eje = EjeBarrido();
+    eje.parametro = texto.substr(0, igual);
+    Equilibrio prueba;
+    int valor;
+    if (!leerParametro(prueba, eje.parametro, valor)) {
+        error = "parametro desconocido: " + eje.parametro;
+        return false;
+    }
+    if (igual == std::string::npos) {
+        error = eje.parametro + " no tiene valores";
+        return false;
+    }
+
+    std::string valores = texto.substr(igual + 1);
+    try {
+        if (valores.find(':') != std::string::npos) {
+            std::istringstream partes(valores);
+            std::string parte;
+            std::vector<int> numeros;
+            while (std::getline(partes, parte, ':')) {
+                numeros.push_back(std::stoi(parte));
+            }
+            int paso = numeros.size() > 2 ? numeros[2] : 1;
+            if (numeros.size() < 2 || numeros.size() > 3 || paso <= 0 || numeros[1] < numeros[0]) {
+                error = eje.parametro + ": el rango se escribe desde:hasta o desde:hasta:paso";
+                return false;
+            }
+            for (int64_t v = numeros[0]; v <= numeros[1]; v += paso) {
+                eje.valores.push_back(static_cast<int>(v));
+            }
+        }
+        else {
+            std::istringstream lista(valores);
+            std::string parte;
+            while (std::getline(lista, parte, ',')) {
+                eje.valores.push_back(std::stoi(parte));
+            }
+        }
+    }
+    catch (const std::exception&) {
+        error = eje.parametro + ": valores no validos (" + valores + ")";
+        return false;
+    }
+    for (int v : eje.valores) {
+        if (!asignarParametro(prueba, eje.parametro, v)) {
+            error = eje.parametro + ": el valor " + std::to_string(v) + " esta fuera de rango";
+            return false;
+        }
+    }
+    if (eje.valores.empty()) {
+        error = eje.parametro + " no tiene valores";
+        return false;
+    }
+    return true;
+}
+
+uint64_t tamanoCuadricula(const std::vector<EjeBarrido>& ejes) {
+    uint64_t total = 1;
+    for (const EjeBarrido& eje : ejes) {
+        uint64_t cantidad = eje.valores.size();
+        if (cantidad != 0 && total > std::numeric_limits<uint64_t>::max() / cantidad) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        total *= cantidad;
+    }
+    return total;
+}
+
+ResumenBarrido barrerEquilibrio(const OpcionesBarrido& opciones) {
+    ResumenBarrido resumen;
+    resumen.objetivoMinimo = opciones.objetivoMinimo;
+    resumen.objetivoMaximo = opciones.objetivoMaximo;
+    resumen.tamanoCuadricula = tamanoCuadricula(opciones.ejes);
+    for (const EjeBarrido& eje : opciones.ejes) {
+        resumen.parametros.push_back(eje.parametro);
+    }
+    for (uint64_t posicion : elegirConfiguraciones(resumen.tamanoCuadricula, opciones.muestras, opciones.semilla)) {
+        ResultadoConfiguracion configuracion;
+        configuracion.valores = valoresDe(opciones.ejes, posicion);
+        configuracion.equilibrio = opciones.base;
+        for (size_t e = 0; e < opciones.ejes.size(); ++e) {
+            asignarParametro(configuracion.equilibrio, opciones.ejes[e].parametro, configuracion.valores[e]);
+        }
+        resumen.configuraciones.push_back(configuracion);
+    }
+    ResultadoConfiguracion& referencia = resumen.referencia;
+    referencia.equilibrio = opciones.base;
+    for (const EjeBarrido& eje : opciones.ejes) {
+        int valor = 0;
+        leerParametro(opciones.base, eje.parametro, valor);
+        referencia.valores.push_back(valor);
+    }
+
+    PoliticaMovimiento politica = politicaPorNombre(opciones.politica);
+    if (!politica) {
+        politica = politicaPorNombre("salida");
+    }
+    uint64_t porRonda = std::max<uint64_t>(1, opciones.partidasPorRonda);
+    uint64_t porTarea = (std::max<uint64_t>(1, opciones.partidasPorTarea) + 63) / 64 * 64; // Cada tarea escribe palabras enteras
+    size_t numConfiguraciones = resumen.configuraciones.size();
+    std::vector<uint64_t> ganaSolo(numConfiguraciones, 0);  // Partidas que gana la configuración y pierde la referencia
+    std::vector<uint64_t> pierdeSolo(numConfiguraciones, 0); // Y al revés
+    std::vector<size_t> activas(numConfiguraciones);
+    for (size_t i = 0; i < numConfiguraciones; ++i) {
+        activas[i] = i;
+    }
+
+    auto inicio = std::chrono::steady_clock::now();
+    PoolHilos pool(opciones.hilos);
+    for (uint64_t primera = 0; primera < opciones.maxPartidas && !activas.empty(); primera += porRonda) {
+        uint64_t partidas = std::min(porRonda, opciones.maxPartidas - primera);
+        size_t palabras = static_cast<size_t>((partidas + 63) / 64);
+
+        // Fila 0: la referencia; fila 1 + j: la configuración activas[j]
+        std::vector<const Equilibrio*> filas(1, &referencia.equilibrio);
+        for (size_t i : activas) {
+            filas.push_back(&resumen.configuraciones[i].equilibrio);
+        }
+        std::vector<uint64_t> victorias(filas.size() * palabras, 0);
+        for (size_t f = 0; f < filas.size(); ++f) {
+            for (uint64_t desde = 0; desde < partidas; desde += porTarea) {
+                pool.encolar([&, f, desde, primera, partidas] {
+                    uint64_t hasta = std::min(partidas, desde + porTarea);
+                    uint64_t* bits = &victorias[f * palabras];
+                    ArenaPisos arena; // Los pisos de cada partida reusan los bloques de la anterior
+                    for (uint64_t k = desde; k < hasta; ++k) {
+                        Partida partida;
+                        configurarPartidaSinTerminal(partida, opciones.semilla, primera + k, politica);
+                        partida.pisosPerezosos = opciones.pisosPerezosos;
+                        partida.arena = &arena;
+                        aplicarTablero(partida, opciones.tablero);
+                        aplicarEquilibrio(partida, *filas[f]);
+                        iniciarPartida(partida);
+                        jugarPartida(partida);
+                        if (partida.resultado == Resultado::Victoria) {
+                            bits[k / 64] |= 1ull << (k % 64);
+                        }
+                    }
+                });
+            }
+        }
+        pool.esperar();
+        ++resumen.rondas;
+        resumen.partidas += partidas * filas.size();
+
+        const uint64_t* bitsReferencia = victorias.data();
+        sumarRonda(referencia, bitsReferencia, palabras, partidas);
+        std::vector<size_t> siguen;
+        bool ultimaRonda = primera + partidas >= opciones.maxPartidas;
+        for (size_t j = 0; j < activas.size(); ++j) {
+            size_t i = activas[j];
+            ResultadoConfiguracion& configuracion = resumen.configuraciones[i];
+            const uint64_t* bits = &victorias[(j + 1) * palabras];
+            sumarRonda(configuracion, bits, palabras, partidas);
+            for (size_t p = 0; p < palabras; ++p) {
+                ganaSolo[i] += static_cast<uint64_t>(contarUnos(bits[p] & ~bitsReferencia[p]));
+                pierdeSolo[i] += static_cast<uint64_t>(contarUnos(~bits[p] & bitsReferencia[p]));
+            }
+            intervaloWilson(configuracion.victorias, configuracion.partidas, opciones.sigmas,
+                configuracion.inferior, configuracion.superior);
+            VeredictoBarrido veredicto = veredictoDe(configuracion, opciones.objetivoMinimo, opciones.objetivoMaximo);
+            if (veredicto == VeredictoBarrido::Debajo || veredicto == VeredictoBarrido::Encima) {
+                configuracion.cortada = !ultimaRonda;
+            }
+            else {
+                siguen.push_back(i);
+            }
+        }
+        activas.swap(siguen);
+    }
+    resumen.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    resumen.partidasSinCorte = (numConfiguraciones + 1) * opciones.maxPartidas;
+
+    intervaloWilson(referencia.victorias, referencia.partidas, opciones.sigmas, referencia.inferior, referencia.superior);
+    referencia.veredicto = veredictoDe(referencia, opciones.objetivoMinimo, opciones.objetivoMaximo);
+    for (size_t i = 0; i < numConfiguraciones; ++i) {
+        ResultadoConfiguracion& configuracion = resumen.configuraciones[i];
+        configuracion.veredicto = veredictoDe(configuracion, opciones.objetivoMinimo, opciones.objetivoMaximo);
+        if (configuracion.partidas > 0) {
+            // Diferencia pareada: solo cuentan las partidas en las que los dos equilibrios terminan distinto
+            double n = static_cast<double>(configuracion.partidas);
+            double mas = static_cast<double>(ganaSolo[i]) / n;
+            double menos = static_cast<double>(pierdeSolo[i]) / n;
+            configuracion.diferencia = mas - menos;
+            double varianza = std::max(0.0, mas + menos - configuracion.diferencia * configuracion.diferencia);
+            configuracion.margenDiferencia = opciones.sigmas * std::sqrt(varianza / n);
+        }
+    }
+    return resumen;
+}
+
+void imprimirBarrido(const ResumenBarrido& resumen, std::ostream& salida, size_t mostrar) {
+    double centro = 0.5 * (resumen.objetivoMinimo + resumen.objetivoMaximo);
+    salida << std::fixed << std::setprecision(2);
+    salida << "Barrido: " << resumen.configuraciones.size() << " configuraciones de una cuadricula de "
+        << resumen.tamanoCuadricula << ", banda objetivo " << 100.0 * resumen.objetivoMinimo << " - "
+        << 100.0 * resumen.objetivoMaximo << " % de victorias" << std::endl;
+    const ResultadoConfiguracion& referencia = resumen.referencia;
+    salida << "Referencia (equilibrio base): " << 100.0 * referencia.proporcion() << " % ["
+        << 100.0 * referencia.inferior << ", " << 100.0 * referencia.superior << "] en "
+        << referencia.partidas << " partidas" << std::endl;
+
+    uint64_t porVeredicto[4] = {};
+    uint64_t cortadas = 0;
+    for (const ResultadoConfiguracion& configuracion : resumen.configuraciones) {
+        ++porVeredicto[static_cast<int>(configuracion.veredicto)];
+        cortadas += configuracion.cortada ? 1 : 0;
+    }
+    salida << "Veredictos: " << porVeredicto[0] << " dentro, " << porVeredicto[1] << " dudosas, "
+        << porVeredicto[2] << " debajo, " << porVeredicto[3] << " encima (" << cortadas
+        << " cortadas antes de tiempo)" << std::endl;
+
+    // Primero las de la banda, después las dudosas; en cada grupo, las más cercanas al centro
+    std::vector<const ResultadoConfiguracion*> orden;
+    for (const ResultadoConfiguracion& configuracion : resumen.configuraciones) {
+        orden.push_back(&configuracion);
+    }
+    std::stable_sort(orden.begin(), orden.end(), [&](const ResultadoConfiguracion* a, const ResultadoConfiguracion* b) {
+        int grupoA = std::min(static_cast<int>(a->veredicto), 2);
+        int grupoB = std::min(static_cast<int>(b->veredicto), 2);
+        if (grupoA != grupoB) {
+            return grupoA < grupoB;
+        }
+        return std::fabs(a->proporcion() - centro) < std::fabs(b->proporcion() - centro);
+    });
+    orden.resize(std::min(orden.size(), mostrar));
+
+    if (!orden.empty()) {
+        salida << "Configuraciones mas cercanas al centro de la banda:" << std::endl << " ";
+        for (const std::string& parametro : resumen.parametros) {
+            salida << " " << std::setw(std::max<int>(8, static_cast<int>(parametro.size()))) << parametro;
+        }
+        salida << "   partidas   victorias        intervalo       vs. referencia   veredicto" << std::endl;
+        for (const ResultadoConfiguracion* configuracion : orden) {
+            salida << " ";
+            for (size_t e = 0; e < resumen.parametros.size(); ++e) {
+                salida << " " << std::setw(std::max<int>(8, static_cast<int>(resumen.parametros[e].size())))
+                    << configuracion->valores[e];
+            }
+            salida << std::setw(11) << configuracion->partidas << std::setw(10) << 100.0 * configuracion->proporcion()
+                << " %   [" << std::setw(6) << 100.0 * configuracion->inferior << ", " << std::setw(6)
+                << 100.0 * configuracion->superior << "]  " << std::showpos << std::setw(7)
+                << 100.0 * configuracion->diferencia << std::noshowpos << " +- " << std::setw(5)
+                << 100.0 * configuracion->margenDiferencia << " %   " << nombresVeredictos[static_cast<int>(configuracion->veredicto)]
+                << std::endl;
+        }
+    }
+
+    double ahorro = resumen.partidasSinCorte
+        ? 100.0 * (1.0 - static_cast<double>(resumen.partidas) / static_cast<double>(resumen.partidasSinCorte)) : 0.0;
+    double porSegundo = resumen.segundos > 0 ? static_cast<double>(resumen.partidas) / resumen.segundos : 0.0;
+    salida << "Partidas jugadas: " << resumen.partidas << " en " << resumen.rondas << " rondas; sin corte temprano serian "
+        << resumen.partidasSinCorte << " (" << ahorro << " % menos)" << std::endl;
+    salida << "Tiempo: " << std::setprecision(3) << resumen.segundos << " s (" << std::setprecision(0) << porSegundo
+        << " partidas/s)" << std::endl;
+}
+
+bool escribirBarrido(const ResumenBarrido& resumen, const std::string& ruta) {
+    std::ostringstream contenido;
+    contenido << "configuracion,";
+    for (const std::string& parametro : resumen.parametros) {
+        contenido << parametro << ",";
+    }
+    contenido << "partidas,victorias,proporcion,inferior,superior,diferencia,margen_diferencia,veredicto,cortada\n";
+    contenido << std::setprecision(6);
+    auto fila = [&](const std::string& nombre, const ResultadoConfiguracion& configuracion, bool conDiferencia) {
+        contenido << nombre << ",";
+        escribirValores(contenido, configuracion.valores);
+        contenido << configuracion.partidas << "," << configuracion.victorias << "," << configuracion.proporcion() << ","
+            << configuracion.inferior << "," << configuracion.superior << ",";
+        if (conDiferencia) {
+            contenido << configuracion.diferencia << "," << configuracion.margenDiferencia;
+        }
+        else {
+            contenido << ",";
+        }
+        contenido << "," << nombresVeredictos[static_cast<int>(configuracion.veredicto)] << ","
+            << (configuracion.cortada ? 1 : 0) << "\n";
+    };
+    fila("referencia", resumen.referencia, false);
+    for (size_t i = 0; i < resumen.configuraciones.size(); ++i) {
+        fila(std::to_string(i), resumen.configuraciones[i], true);
+    }
+    std::string texto = contenido.str();
+    return escribirArchivoAtomico(ruta.c_str(), texto.data(), texto.size());
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Barrido de parámetros de equilibrio: juega muchas partidas con cada
+ * configuración de una cuadrícula (o de una muestra al azar de ella) y
+ * clasifica cada una según su porcentaje de victorias caiga o no en una banda
+ * objetivo.
+ *
+ * Números aleatorios comunes: la partida n de toda configuración usa la misma
+ * semilla y el flujo n, así que todas se miden sobre los mismos calabozos y
+ * las mismas tiradas. Además de su intervalo propio, cada configuración se
+ * compara partida a partida con la de referencia (el equilibrio base); como
+ * las dos juegan las mismas partidas, la diferencia tiene mucha menos varianza
+ * que la resta de dos porcentajes medidos por separado.
+ *
+ * Corte temprano: las partidas se juegan por rondas. Al final de cada ronda,
+ * la configuración cuyo intervalo de confianza ya quedó entero por debajo o por
+ * encima de la banda deja de jugar. Las rondas de todas las configuraciones
+ * activas se reparten juntas en el pool, y la decisión solo mira rondas
+ * completas: el resultado es el mismo con cualquier cantidad de hilos.
+ */
+
+/**
+ * Un parámetro del barrido con los valores que toma.
+ */
+struct EjeBarrido {
+    std::string parametro;              // Nombre como en asignarParametro
+    std::vector<int> valores;
+};
+
+/**
+ * Opciones de un barrido.
+ */
+struct OpcionesBarrido {
+    std::vector<EjeBarrido> ejes;       // La cuadrícula es el producto de todos los ejes
+    uint64_t muestras = 0;              // 0 = toda la cuadrícula; si no, tantas configuraciones al azar y sin repetir
+    Equilibrio base;                    // Valores de los parámetros que no se barren, y la referencia
+    Tablero tablero;
+    std::string politica = "salida";    // Nombre de la política de movimiento (ver politicaPorNombre)
+    bool pisosPerezosos = false;
+    unsigned hilos = 0;                 // Hilos del pool (0 = todos los núcleos)
+    uint64_t semilla = 1;               // Semilla común; la partida n de cada configuración usa el flujo n
+    uint64_t maxPartidas = 20000;       // Partidas por configuración si nunca se corta
+    uint64_t partidasPorRonda = 1024;   // Partidas entre dos revisiones del corte
+    uint64_t partidasPorTarea = 256;    // Partidas de una configuración que juega cada tarea del pool
+    double objetivoMinimo = 0.45;       // Banda de proporción de victorias buscada
+    double objetivoMaximo = 0.55;
+    double sigmas = 3.0;                // Medio ancho de los intervalos, en desvíos estándar
+};
+
+/**
+ * Dónde quedó una configuración respecto de la banda objetivo.
+ */
+enum class VeredictoBarrido {
+    Dentro,     // El intervalo de confianza cae entero dentro de la banda
+    Dudosa,     // El intervalo toca la banda pero no cabe en ella
+    Debajo,     // El intervalo queda entero por debajo de la banda
+    Encima      // El intervalo queda entero por encima de la banda
+};
+
+/**
+ * Lo medido para una configuración.
+ */
+struct ResultadoConfiguracion {
+    std::vector<int> valores;           // Uno por eje, en el orden de los ejes
+    Equilibrio equilibrio;
+    uint64_t partidas = 0;
+    uint64_t victorias = 0;
+    double inferior = 0.0;              // Intervalo de Wilson de la proporción de victorias
+    double superior = 1.0;
+    double diferencia = 0.0;            // Proporción de victorias menos la de la referencia en las mismas partidas
+    double margenDiferencia = 0.0;      // Medio ancho del intervalo de la diferencia
+    VeredictoBarrido veredicto = VeredictoBarrido::Dudosa;
+    bool cortada = false;               // Dejó de jugar antes de maxPartidas
+
+    double proporcion() const {
+        return partidas ? static_cast<double>(victorias) / static_cast<double>(partidas) : 0.0;
+    }
+};
+
+/**
+ * Resultado de un barrido.
+ */
+struct ResumenBarrido {
+    std::vector<std::string> parametros;    // Nombres de los ejes
+    uint64_t tamanoCuadricula = 0;
+    std::vector<ResultadoConfiguracion> configuraciones; // En el orden de la cuadrícula
+    ResultadoConfiguracion referencia;      // El equilibrio base, jugado mientras quede alguna configuración activa
+    uint64_t partidas = 0;                  // Jugadas en total, incluidas las de la referencia
+    uint64_t partidasSinCorte = 0;          // Las que se habrían jugado sin corte temprano
+    uint64_t rondas = 0;
+    double segundos = 0.0;
+    double objetivoMinimo = 0.0;
+    double objetivoMaximo = 0.0;
+};
+
+/**
+ * Lee un eje escrito como "nombre=v1,v2,v3", "nombre=desde:hasta" o
+ * "nombre=desde:hasta:paso" (los extremos se incluyen).
+ * return false (con el motivo en 'error') si el nombre no existe o algún valor no vale.
+ */
+bool leerEjeBarrido(const std::string& texto, EjeBarrido& eje, std::string& error);
+
+/**
+ * Configuraciones de la cuadrícula: el producto de los valores de cada eje
+ * (UINT64_MAX si no cabe en 64 bits).
+ */
+uint64_t tamanoCuadricula(const std::vector<EjeBarrido>& ejes);
+
+/**
+ * Juega el barrido en un pool de hilos.
+ */
+ResumenBarrido barrerEquilibrio(const OpcionesBarrido& opciones);
+
+/**
+ * Muestra la referencia, las mejores configuraciones (las de la banda,
+ * ordenadas por cercanía a su centro) y cuántas partidas ahorró el corte.
+ * param mostrar Máximo de configuraciones listadas.
+ */
+void imprimirBarrido(const ResumenBarrido& resumen, std::ostream& salida, size_t mostrar = 20);
+
+/**
+ * Escribe todas las configuraciones en CSV, de forma atómica.
+ */
+bool escribirBarrido(const ResumenBarrido& resumen, const std::string& ruta);
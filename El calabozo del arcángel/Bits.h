@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+/**
+ * Cantidad de bits en 1 de una palabra (popcount).
+ */
+inline int contarUnos(uint64_t palabra) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(palabra);
+#elif defined(_MSC_VER) && defined(_M_X64) && defined(__AVX__)
+    return static_cast<int>(__popcnt64(palabra)); // POPCNT solo es seguro si se compila para AVX
+#else
+    palabra = palabra - ((palabra >> 1) & 0x5555555555555555ull);
+    palabra = (palabra & 0x3333333333333333ull) + ((palabra >> 2) & 0x3333333333333333ull);
+    palabra = (palabra + (palabra >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<int>((palabra * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/**
+ * Posición del bit en 1 más bajo de una palabra, que no debe ser 0.
+ */
+inline int primerUno(uint64_t palabra) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(palabra);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long posicion;
+    _BitScanForward64(&posicion, palabra);
+    return static_cast<int>(posicion);
+#else
+    return contarUnos((palabra & (0 - palabra)) - 1);
+#endif
+}
@@ -0,0 +1,876 @@
+#include "Calabozo.h"
+#include "Combate.h"
+#include "ConsultasPiso.h"
+#include "Diario.h"
+#include "Dimensiones.h"
+#include "Estadisticas.h"
+#include "GeneracionMasiva.h"
+#include "Guardado.h"
+#include "Instrumentacion.h"
+#include "LecturaTexto.h"
+#include "PisosCompartidos.h"
+#include "PreparadorPisos.h"
+#include "Renderizador.h"
+
+#include <algorithm> // Para std::max
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+int columnaDeEtiqueta(const std::string& etiqueta) {
+    if (etiqueta.empty() || etiqueta.size() > 4) {
+        return -1; // Cuatro letras ya superan maxLadoTablero
+    }
+    int columna = 0;
+    for (char letra : etiqueta) {
+        if (letra < 'A' || letra > 'Z') {
+            return -1;
+        }
+        columna = columna * 26 + (letra - 'A' + 1);
+    }
+    return columna - 1;
+}
+
+bool tableroValido(const Tablero& tablero) {
+    return tablero.columnas >= 1 && tablero.filas >= 1 && tablero.columnas <= maxLadoTablero
+        && tablero.filas <= maxLadoTablero && static_cast<int64_t>(tablero.columnas) * tablero.filas >= 2
+        && tablero.pisos >= 1 && tablero.pisos <= maxPisos;
+}
+
+/**
+ * Fija el tamaño del calabozo de una partida que todavía no creó su primer piso.
+ * param partida Partida a configurar.
+ * param tablero Tamaño elegido; debe cumplir tableroValido.
+ */
+void aplicarTablero(Partida& partida, const Tablero& tablero) {
+    partida.piso.columnas = tablero.columnas;
+    partida.piso.filas = tablero.filas;
+    partida.numPisos = tablero.pisos;
+}
+
+/**
+ * Fija el equilibrio de una partida que todavía no creó su primer piso. El
+ * Arcángel toma de él su salud y su ataque.
+ * param partida Partida a configurar.
+ * param equilibrio Parámetros de equilibrio (ver Equilibrio.h).
+ */
+void aplicarEquilibrio(Partida& partida, const Equilibrio& equilibrio) {
+    partida.equilibrio = equilibrio;
+    partida.arcangel.health = equilibrio.saludArcangel;
+    partida.arcangel.attackPower = equilibrio.ataqueArcangel;
+}
+
+/**
+ * Libera la memoria ocupada por las celdas de un piso. Con arena, los bloques
+ * vuelven a ella de una vez y quedan para el piso siguiente.
+ * param piso Referencia al piso a vaciar. Después de la liberación no contiene celdas.
+ */
+void liberarPiso(Piso& piso) {
+    piso.celdas.liberar();
+    piso.planos.liberar();
+    piso.modificadas.vaciar();
+    piso.tocadas.liberar();
+    piso.compartidas = nullptr;
+    piso.perezoso = false;
+    piso.generado = false;
+}
+
+/**
+ * Indica si la primera tirada de la celda pide un enemigo. Que lo tenga de verdad
+ * depende además del límite de enemigos por partida (Equilibrio::maxEnemigos).
+ * param generador Generador de la partida.
+ * param reglas Reglas de contenido de las celdas.
+ * param pisoCalabozo Número de piso.
+ * param indice Índice de la celda (fila * columnas + columna).
+ */
+bool tiradaEnemigo(const GeneradorPartida& generador, const ReglasCeldas& reglas, int pisoCalabozo, int64_t indice) {
+    return generador.uniforme(reglas.carasEnemigo, Proposito::Celda, static_cast<uint32_t>(pisoCalabozo), static_cast<uint32_t>(indice),
+        static_cast<uint32_t>(indice >> 32), 0) == 0;
+}
+
+/**
+ * Calcula el contenido de una celda. Es una función pura de la semilla, el piso
+ * y el índice de la celda; el enemigo se decide aparte por el límite de enemigos.
+ * param generador Generador de la partida.
+ * param reglas Reglas de contenido de las celdas.
+ * param pisoCalabozo Número de piso.
+ * param indice Índice de la celda (fila * columnas + columna).
+ * param conEnemigo true si la celda tiene enemigo.
+ * return La celda recién generada, sin visitar.
+ */
+Celda generarCelda(const GeneradorPartida& generador, const ReglasCeldas& reglas, int pisoCalabozo, int64_t indice, bool conEnemigo) {
+    Celda newCell;
+    newCell.piso = static_cast<int16_t>(pisoCalabozo);
+
+    // Cada tirada depende solo de (semilla, piso, celda, número de tirada)
+    auto tirar = [&](uint32_t tirada, int n) {
+        return generador.uniforme(n, Proposito::Celda, static_cast<uint32_t>(pisoCalabozo), static_cast<uint32_t>(indice),
+            static_cast<uint32_t>(indice >> 32), tirada);
+    };
+
+    if (conEnemigo) {
+        newCell.poner(CeldaEnemigo, true);
+        newCell.enemyHealth = static_cast<int16_t>(reglas.saludEnemigo + reglas.saludEnemigoPorPiso * pisoCalabozo);
+        newCell.enemyAttack = static_cast<int16_t>(reglas.ataqueEnemigo + reglas.ataqueEnemigoPorPiso * pisoCalabozo);
+    }
+
+    if (tirar(1, reglas.carasGuardado) == 0) {
+        newCell.poner(CeldaGuardado, true);
+    }
+
+    if (tirar(2, reglas.carasTaberna) == 0) {
+        newCell.poner(CeldaTaberna, true);
+    }
+
+    if (tirar(3, reglas.carasCofre) == 0) {
+        newCell.poner(CeldaCofre, true);
+        newCell.chestContent = static_cast<uint8_t>(tirar(4, 3) + 1);
+    }
+    return newCell;
+}
+
+Celda Piso::consultar(int columna, int fila) const {
+    int64_t i = indice(columna, fila);
+    if (!perezoso) {
+        return celdas[static_cast<size_t>(i)];
+    }
+    if (const CeldaModificada* modificada = modificadas.buscar(i)) {
+        return modificada->celda;
+    }
+    return celdaGenerada(i);
+}
+
+Celda Piso::celdaGenerada(int64_t i) const {
+    if (compartidas) {
+        return compartidas[i];
+    }
+    // crearCalabozo recorre columna por columna: esta es la posición de la celda en ese orden
+    int64_t orden = (i % columnas) * filas + i / columnas;
+    bool conEnemigo = orden <= ultimoEnemigo && tiradaEnemigo(generador, reglas, numero, i);
+    return generarCelda(generador, reglas, numero, i, conEnemigo);
+}
+
+Celda* Piso::materializar(int64_t i) {
+    CeldaModificada* modificada = modificadas.buscar(i);
+    if (!modificada) {
+        CeldaModificada nueva = { consultar(static_cast<int>(i % columnas), static_cast<int>(i / columnas)), i };
+        modificada = modificadas.insertar(i, nueva);
+        CONTAR_ACTIVO(Contador::CeldasCreadas, 1);
+    }
+    return &modificada->celda;
+}
+
+void Piso::reconstruirPlanos(ArenaPisos* arena) {
+    if (perezoso) {
+        planos.liberar();
+        return;
+    }
+    static const BanderaCelda banderas[numPlanos] = { CeldaVisitada, CeldaEnemigo, CeldaGuardado, CeldaTaberna, CeldaCofre };
+    size_t palabras = palabrasPorPlano();
+    planos.asignar(numPlanos * palabras, 0, arena);
+    for (size_t i = 0; i < celdas.size(); ++i) {
+        uint8_t presentes = celdas[i].banderas;
+        if (presentes == 0) {
+            continue;
+        }
+        for (int numero = 0; numero < numPlanos; ++numero) {
+            if (presentes & banderas[numero]) {
+                planos[numero * palabras + i / 64] |= 1ull << (i % 64);
+            }
+        }
+    }
+}
+
+int64_t Piso::contar(BanderaCelda bandera) const {
+    int64_t cantidad = 0;
+    if (const uint64_t* bits = plano(bandera)) {
+        for (size_t p = 0; p < palabrasPorPlano(); ++p) {
+            cantidad += contarUnos(bits[p]);
+        }
+        return cantidad;
+    }
+    paraCada(bandera, [&](int64_t, const Celda&) { ++cantidad; });
+    return cantidad;
+}
+
+namespace {
+    /**
+     * Genera la celda de índice 'indice' del piso actual en 'destino', contando su enemigo.
+     * return true si la celda quedó con enemigo.
+     */
+    inline bool generarEn(Partida& partida, Celda& destino, int64_t indice) {
+        const Equilibrio& equilibrio = partida.equilibrio;
+        bool conEnemigo = false;
+        if (tiradaEnemigo(partida.generador, equilibrio.celdas, partida.pisoCalabozo, indice)
+            && partida.numEnemies < equilibrio.maxEnemigos) {
+            conEnemigo = true;
+            ++partida.numEnemies;
+        }
+        destino = generarCelda(partida.generador, equilibrio.celdas, partida.pisoCalabozo, indice, conEnemigo);
+        return conEnemigo;
+    }
+
+    /**
+     * Etiqueta de la celda de salida del piso (J10 en el tablero estándar).
+     */
+    std::string etiquetaSalida(const Piso& piso) {
+        return etiquetaColumna(piso.columnas - 1) + std::to_string(piso.filas);
+    }
+}
+
+/**
+ * Genera el contenido de la celda (columna, fila) de un piso ya dimensionado.
+ * param partida Referencia a la partida cuyo piso se está generando.
+ * param columna Columna de la celda (0 = 'A').
+ * param fila Fila de la celda (0 = fila 1).
+ */
+void insertarCelda(Partida& partida, int columna, int fila) {
+    Piso& piso = partida.piso;
+    Celda* celda = piso.celda(columna, fila);
+    generarEn(partida, *celda, piso.indice(columna, fila));
+    for (BanderaCelda bandera : { CeldaVisitada, CeldaEnemigo, CeldaGuardado, CeldaTaberna, CeldaCofre }) {
+        piso.marcar(celda, bandera, celda->tiene(bandera)); // Llevar la celda nueva a los planos
+    }
+}
+
+/**
+ * Prepara un piso perezoso: no genera ninguna celda, solo averigua qué tiradas
+ * de enemigo caben en el límite de enemigos por partida. crearCalabozo reparte los
+ * enemigos recorriendo las celdas columna por columna; aquí se hace el mismo
+ * recorrido pero solo hasta encontrar los enemigos que faltan (unas 10 celdas
+ * por enemigo), así que el piso queda idéntico al que generaría crearCalabozo.
+ * param partida Referencia a la partida cuyo piso se crea.
+ */
+void crearPisoPerezoso(Partida& partida) {
+    Piso& piso = partida.piso;
+    piso.celdas.liberar();
+    piso.tocadas.liberar();
+    piso.modificadas.reiniciar(partida.arena);
+    piso.compartidas = nullptr;
+    piso.perezoso = true;
+    piso.generado = true;
+    piso.numero = partida.pisoCalabozo;
+    piso.generador = partida.generador;
+    piso.reglas = partida.equilibrio.celdas;
+    piso.ultimoEnemigo = -1;
+
+    int64_t total = static_cast<int64_t>(piso.columnas) * piso.filas;
+    for (int64_t orden = 0; orden < total && partida.numEnemies < partida.equilibrio.maxEnemigos; ++orden) {
+        int columna = static_cast<int>(orden / piso.filas);
+        int fila = static_cast<int>(orden % piso.filas);
+        if (tiradaEnemigo(piso.generador, piso.reglas, piso.numero, piso.indice(columna, fila))) {
+            ++partida.numEnemies;
+            piso.ultimoEnemigo = orden;
+        }
+    }
+}
+
+/**
+ * Escribe todas las celdas de un piso en el formato de 'celdas.txt'.
+ * param piso Referencia constante al piso a guardar.
+ * return El contenido del archivo.
+ */
+std::string serializarCeldas(const Piso& piso) {
+    std::ostringstream archivo;
+    for (int fila = 0; fila < piso.filas; ++fila) {
+        for (int columna = 0; columna < piso.columnas; ++columna) {
+            Celda current = piso.consultar(columna, fila);
+            archivo << current.piso << " "
+                << etiquetaColumna(columna) << " "
+                << fila + 1 << " "
+                << current.tiene(CeldaVisitada) << " "
+                << current.tiene(CeldaEnemigo) << " "
+                << current.tiene(CeldaGuardado) << " "
+                << current.tiene(CeldaTaberna) << " "
+                << current.tiene(CeldaCofre) << " "
+                << current.enemyHealth << " "
+                << current.enemyAttack << " "
+                << static_cast<int>(current.chestContent) << "\n";
+        }
+    }
+    return archivo.str();
+}
+
+/**
+ * Guarda todas las celdas de un piso en un archivo de texto. El archivo se
+ * reemplaza de forma atómica: o queda el anterior o queda el nuevo completo.
+ * param piso Referencia constante al piso a guardar.
+ * param ruta Archivo de destino.
+ */
+void guardarCeldasEnArchivo(const Piso& piso, const char* ruta) {
+    std::string contenido = serializarCeldas(piso);
+    if (!escribirArchivoAtomico(ruta, contenido.data(), contenido.size())) {
+        std::cerr << "Error: No se pudo escribir el archivo '" << ruta << "' para guardar las celdas." << std::endl;
+        return;
+    }
+    std::cout << "Lista de celdas guardada correctamente en '" << ruta << "'." << std::endl;
+}
+
+/**
+ * Carga las celdas de un piso desde un archivo de texto (ver LecturaTexto.h).
+ *        Las dimensiones del piso se deducen de la mayor columna y fila leídas.
+ * param partida Referencia a la partida cuyo piso se cargará.
+ * return true si se cargó; si el archivo falta o no es válido, el piso no cambia.
+ */
+bool cargarCeldasDesdeArchivo(Partida& partida) {
+    ArchivoMapeado archivo("celdas.txt");
+    if (!archivo.abierto()) {
+        std::cerr << "Error: No se pudo abrir el archivo 'celdas.txt' para cargar las celdas." << std::endl;
+        return false;
+    }
+
+    ErrorLectura error;
+    if (!leerCeldasTexto(reinterpret_cast<const char*>(archivo.contenido()), archivo.tamano(), partida, error)) {
+        std::cerr << "Error: " << describirError("celdas.txt", error) << std::endl;
+        return false;
+    }
+    partida.texto() << "Lista de celdas cargada correctamente desde 'celdas.txt'." << std::endl;
+    return true;
+}
+
+/**
+ * Crea un calabozo generando una cuadrícula de celdas contigua.
+ *        Cada celda tiene una probabilidad de contener enemigos, puntos de guardado, tabernas o cofres.
+ *        Con partida.pisosPerezosos el piso se crea en modo perezoso (ver crearPisoPerezoso).
+ *        Con partida.calabozoCompartido el piso, si está en él, se toma de ahí sin generar
+ *        nada y queda perezoso sobre las celdas compartidas (ver PisosCompartidos.h).
+ * param partida Referencia a la partida cuyo piso se va a generar (usa su contador de enemigos).
+ */
+void crearCalabozo(Partida& partida) {
+    MEDIR_FASE(partida, Fase::Generacion);
+    if (partida.calabozoCompartido && partida.calabozoCompartido->colocarPiso(partida)) {
+        return;
+    }
+    if (partida.pisosPerezosos) {
+        crearPisoPerezoso(partida);
+        return;
+    }
+    Piso& piso = partida.piso;
+    piso.perezoso = false;
+    piso.compartidas = nullptr;
+    piso.modificadas.reiniciar(partida.arena);
+    piso.celdas.redimensionar(static_cast<size_t>(piso.columnas) * piso.filas, partida.arena); // Las escribe todas generarPisoMasivo
+    piso.planos.asignar(Piso::numPlanos * piso.palabrasPorPlano(), 0, partida.arena);
+    piso.ultimoEnemigo = generarPisoMasivo(partida);
+    piso.generado = true;
+    piso.numero = partida.pisoCalabozo;
+    piso.generador = partida.generador;
+    piso.reglas = partida.equilibrio.celdas;
+    piso.tocadas.asignar(piso.palabrasPorPlano(), 0, partida.arena);
+    CONTAR(partida, Contador::CeldasCreadas, piso.celdas.size());
+}
+
+/**
+ * Pasa al siguiente piso del calabozo. Si la partida tiene un preparador de
+ * pisos, usa el piso que ya generó en segundo plano y encarga el próximo;
+ * si no, lo genera aquí mismo. El resultado es el mismo en los dos casos.
+ * param partida Referencia a la partida que cambia de piso.
+ */
+void avanzarPiso(Partida& partida) {
+    ++partida.pisoCalabozo; // Incrementar el número de piso
+    PreparadorPisos* preparador = partida.preparadorPisos;
+    if (!preparador || !preparador->tomar(partida)) {
+        crearCalabozo(partida); // Crear un nuevo calabozo con nuevas características
+    }
+    if (preparador) {
+        preparador->preparar(partida);
+    }
+}
+
+/**
+ * Coloca al jugador en la celda inicial del calabozo (columna 'A', fila 1).
+ *
+ * param piso Referencia al piso del calabozo.
+ * param jugador Referencia al objeto Jugador que representa al jugador del juego.
+ */
+void colocarJugador(Piso& piso, Jugador& jugador) {
+    Celda* inicio = piso.celda(0, 0);
+    if (inicio) {
+        jugador.posicion = inicio;
+        piso.marcar(inicio, CeldaVisitada, true); // Marcar la celda como visitada
+        // Se mantienen la salud actual y el poder de ataque del jugador
+    }
+}
+
+/**
+ * Escribe la información del jugador y el número de tiradas en el formato de 'jugador.txt'.
+ * param partida Referencia constante a la partida que contiene la información a guardar.
+ * return El contenido del archivo.
+ */
+std::string serializarJugador(const Partida& partida) {
+    const Piso& piso = partida.piso;
+    const Jugador& jugador = partida.jugador;
+    std::ostringstream archivo;
+
+    archivo << jugador.health << "\n";
+    archivo << jugador.attackPower << "\n";
+    archivo << etiquetaColumna(piso.columnaDe(jugador.posicion)) << piso.filaDe(jugador.posicion) + 1 << "\n";
+    archivo << jugador.equipo.size() << "\n";
+
+    for (const auto& recluta : jugador.equipo) {
+        archivo << recluta.nombre << "\n";
+        archivo << recluta.health << "\n";
+        archivo << recluta.attackPower << "\n";
+    }
+
+    archivo << partida.numDiceThrows << "\n"; // cargarInformacionJugador lo lee al final
+    return archivo.str();
+}
+
+/**
+ * Guarda la información del jugador y el número de tiradas en un archivo de texto,
+ * reemplazándolo de forma atómica.
+ * param partida Referencia constante a la partida que contiene la información a guardar.
+ * param ruta Archivo de destino.
+ */
+void guardarInformacionJugador(const Partida& partida, const char* ruta) {
+    std::string contenido = serializarJugador(partida);
+    if (!escribirArchivoAtomico(ruta, contenido.data(), contenido.size())) {
+        std::cerr << "Error: No se pudo escribir el archivo '" << ruta << "' para guardar la información." << std::endl;
+        return;
+    }
+    std::cout << "Informacion del jugador guardado correctamente en '" << ruta << "'." << std::endl;
+}
+
+/**
+ * Carga la información del jugador desde un archivo de texto (ver LecturaTexto.h).
+ * param partida Referencia a la partida con el piso ya cargado; sus datos de jugador se reemplazan.
+ * return true si la carga fue exitosa, false si el archivo falta o no es válido.
+ */
+bool cargarInformacionJugador(Partida& partida) {
+    // Son unas pocas líneas: leerlas de una vez cuesta menos que proyectar el archivo
+    std::ifstream archivo("jugador.txt", std::ios::binary);
+    if (!archivo.is_open()) {
+        return false;
+    }
+    std::string contenido((std::istreambuf_iterator<char>(archivo)), std::istreambuf_iterator<char>());
+
+    ErrorLectura error;
+    if (!leerJugadorTexto(contenido.data(), contenido.size(), partida, error)) {
+        std::cerr << "Error: " << describirError("jugador.txt", error) << std::endl;
+        return false;
+    }
+    partida.texto() << "Informacion del jugador cargado correctamente desde 'jugador.txt'." << std::endl;
+    return true;
+}
+
+/**
+ * Inicia la pelea final con el Arcangel.
+ * param partida Referencia a la partida (jugador y Arcangel).
+ */
+void pelearConArcangel(Partida& partida) {
+    MEDIR_FASE(partida, Fase::Arcangel);
+    int64_t celda = partida.piso.indice(partida.piso.columnas - 1, partida.piso.filas - 1); // La salida
+    bool victoria = resolverCombate(partida, RivalCombate::Arcangel, partida.arcangel.health, partida.arcangel.attackPower, celda);
+    partida.resultado = victoria ? Resultado::Victoria : Resultado::DerrotaArcangel;
+    partida.juego = false;
+}
+
+/**
+ * Realiza un combate con un enemigo.
+ * param partida Referencia a la partida del jugador.
+ * param enemigo Puntero a la celda que contiene al enemigo.
+ */
+void combatirEnemigo(Partida& partida, Celda* enemigo) {
+    MEDIR_FASE(partida, Fase::Combate);
+    int salud = enemigo->enemyHealth;
+    bool victoria = resolverCombate(partida, RivalCombate::Enemigo, salud, enemigo->enemyAttack, partida.piso.indiceDe(enemigo));
+    enemigo->enemyHealth = static_cast<int16_t>(std::max(salud, -1));
+    partida.piso.tocar(enemigo);
+
+    if (victoria) {
+        partida.piso.marcar(enemigo, CeldaEnemigo, false); // Eliminar al enemigo de la celda
+    }
+    else {
+        partida.juego = false; // Terminar el juego
+        partida.resultado = Resultado::DerrotaCombate;
+    }
+}
+
+/**
+ * Añade un recluta aleatorio al equipo del jugador.
+ * param partida Referencia a la partida del jugador.
+ */
+void anadirReclutaAleatorioAJugador(Partida& partida) {
+    Jugador& jugador = partida.jugador;
+    const Equilibrio& equilibrio = partida.equilibrio;
+
+    // Verificar si el jugador puede reclutar más reclutas
+    if (jugador.equipo.size() < 3) {
+        // Generar un índice aleatorio para seleccionar un recluta de las que ofrecen las tabernas
+        int64_t celda = partida.piso.indiceDe(jugador.posicion);
+        int indiceAleatorio = partida.sortear(Proposito::Taberna, celda, 0, equilibrio.numReclutas);
+        const PerfilRecluta& perfil = equilibrio.reclutas[static_cast<size_t>(indiceAleatorio)];
+
+        // Añadir el recluta seleccionado al equipo del jugador
+        jugador.equipo.push_back(Recluta{ "Recluta" + std::to_string(indiceAleatorio + 1), perfil.health, perfil.attackPower });
+
+        partida.texto() << "Has reclutado a " << jugador.equipo.back().nombre << " en tu equipo!" << std::endl;
+    }
+    else {
+        partida.texto() << "No puedes reclutar mas Reclutas. Tu equipo esta completo." << std::endl;
+    }
+}
+
+/**
+ * Verifica y procesa los eventos de una celda específica.
+ * param partida Referencia a la partida; se procesa la celda donde está el jugador.
+ */
+void verificarCelda(Partida& partida) {
+    MEDIR_FASE(partida, Fase::Eventos);
+    Jugador& jugador = partida.jugador;
+    Celda* current = jugador.posicion;
+    Piso& piso = partida.piso;
+
+    if (current->tiene(CeldaEnemigo)) {
+        // Realizar combate con el enemigo en la celda actual
+        combatirEnemigo(partida, current);
+        piso.marcar(current, CeldaEnemigo, false);
+    }
+
+    if (current->tiene(CeldaGuardado)) {
+        partida.texto() << "Has encontrado un punto de salvado. Se ha Guardado tu progreso aqui." << std::endl;
+        if (partida.guardadoHabilitado) {
+            guardarPartida(partida); // Guardar el progreso en el formato elegido
+        }
+        if (partida.diario) {
+            partida.diario->anotarGuardado(partida);
+        }
+        piso.marcar(current, CeldaVisitada, true);
+    }
+
+    if (current->tiene(CeldaTaberna)) {
+        partida.texto() << "Has encontrado una taberna. Descansa y recluta a alguien." << std::endl;
+        anadirReclutaAleatorioAJugador(partida);
+        piso.marcar(current, CeldaTaberna, false);
+    }
+
+    if (current->tiene(CeldaCofre)) {
+        partida.texto() << "Has encontrado un cofre. Quizás contenga algo útil." << std::endl;
+        if (partida.estadisticas) {
+            partida.estadisticas->anotarCofre(current->chestContent);
+        }
+        switch (current->chestContent) {
+
+        case 1: //Aumenta el ataque (jugador y reclutas)
+            partida.texto() << "Has encontrado un arma en el cofre! Aumenta tu poder de ataque." << std::endl;
+
+            jugador.attackPower += 5;
+
+            for (auto& recluta : jugador.equipo) {
+                recluta.attackPower = recluta.attackPower + 2;
+            }
+
+            break;
+
+        case 2: // Recuperar vida para todos los personajes (jugador y reclutas)
+
+            partida.texto() << "Has encontrado un aumento en los puntos de salud en el cofre!" << std::endl;
+
+            jugador.health += 1;
+            for (auto& recluta : jugador.equipo) {
+                recluta.health += 1;
+            }
+            break;
+
+        case 3: // Recuperar el 10 % de los PS, nunca menos de 1 PS.
+
+            partida.texto() << "Has encontrado un objeto para recuperar puntos de salud en el cofre!" << std::endl;
+            int recoveryAmount = static_cast<int>(jugador.health * 0.1);
+            jugador.health = std::max(jugador.health + recoveryAmount, 1);
+            break;
+        }
+        piso.marcar(current, CeldaCofre, false); // Eliminar el cofre de la celda
+    }
+}
+
+/**
+ * Muesta las caracteristicas del jugador.
+ * param partida Referencia a la partida del jugador.
+ */
+void mostrarCaracteristicas(Partida& partida) {
+    const Jugador& jugador = partida.jugador;
+
+    partida.texto() << "\nEstado del jugador:\n";
+    partida.texto() << " - Salud: " << jugador.health << std::endl;
+    partida.texto() << " - Poder de ataque: " << jugador.attackPower << std::endl;
+    partida.texto() << " - Equipo:" << std::endl;
+    for (const auto& recluta : jugador.equipo) {
+        partida.texto() << "   * Nombre: " << recluta.nombre << ", Salud: " << recluta.health << ", Poder de ataque: " << recluta.attackPower << std::endl;
+    }
+    partida.texto() << " - Tiradas de dados realizadas: " << partida.numDiceThrows << std::endl;
+}
+
+/**
+ * Muesta las caracteristicas del tablero y del jugador.
+ * param partida Referencia a la partida. Sin terminal no se dibuja nada; con
+ *        partida.renderizador se actualiza la zona fija de la pantalla.
+ */
+void mostrarEstado(Partida& partida) {
+    if (!partida.salida) {
+        return;
+    }
+    MEDIR_FASE(partida, Fase::Dibujo);
+    if (partida.renderizador) {
+        partida.renderizador->dibujar(partida); // Solo se redibuja lo que cambió
+        mostrarPistas(partida);
+        return;
+    }
+    const Piso& piso = partida.piso;
+    const Jugador& jugador = partida.jugador;
+
+    partida.texto() << "\n---------------------------------------------------------------------------------------------------" << std::endl; // AQUI PDORIAMOS LIMPIAR PANTALLA TAMBIEN
+    partida.texto() << "Calabozo - Estado del Piso " << partida.pisoCalabozo << ":" << std::endl;
+    for (int columna = 0; columna < piso.columnas; ++columna) {
+        std::string etiqueta = etiquetaColumna(columna);
+        partida.texto() << std::string(etiqueta.size() < 4 ? 4 - etiqueta.size() : 1, ' ') << etiqueta;
+    }
+    partida.texto() << std::endl;
+    int columnaJugador = jugador.posicion ? piso.columnaDe(jugador.posicion) : -1;
+    int filaJugador = jugador.posicion ? piso.filaDe(jugador.posicion) : -1;
+    CONTAR(partida, Contador::CeldasRecorridas, static_cast<uint64_t>(piso.columnas) * piso.filas);
+    for (int fila = 0; fila < piso.filas; ++fila) {
+        partida.texto() << fila + 1;
+        for (int columna = 0; columna < piso.columnas; ++columna) {
+            Celda celda = piso.consultar(columna, fila);
+            const Celda* current = &celda;
+            if (columna == columnaJugador && fila == filaJugador) {
+                partida.texto() << " [x]";
+            }
+            else if (current->tiene(CeldaVisitada)) {
+                partida.texto() << " [.]";
+            }
+            else {
+                if (current->tiene(CeldaEnemigo)) {
+                    partida.texto() << " [E]";
+                }
+                else if (current->tiene(CeldaGuardado)) {
+                    partida.texto() << " [S]";
+                }
+                else if (current->tiene(CeldaTaberna)) {
+                    partida.texto() << " [T]";
+                }
+                else if (current->tiene(CeldaCofre)) {
+                    partida.texto() << " [C]";
+                }
+                else {
+                    partida.texto() << " [ ]";
+                }
+            }
+        }
+        partida.texto() << std::endl;
+    }
+    partida.texto() << "---------------------------------------------------------------------------------------------------" << std::endl; // AQUI PDORIAMOS LIMPIAR PANTALLA TAMBIEN
+    mostrarCaracteristicas(partida); // Mostrar características del jugador
+    mostrarPistas(partida);
+}
+
+/**
+ * Con partida.pistas, muestra qué hay cerca del jugador: el punto de guardado,
+ * la taberna y el cofre más cercanos, los enemigos a una y dos tiradas y, para
+ * cada dirección, la probabilidad de caer en un enemigo o en la salida.
+ * param partida Referencia a la partida del jugador.
+ */
+void mostrarPistas(Partida& partida) {
+    if (!partida.pistas || !partida.jugador.posicion) {
+        return;
+    }
+    const Piso& piso = partida.piso;
+    ConsultasPiso consultas(piso);
+    int64_t celda = piso.indiceDe(partida.jugador.posicion);
+    int columna = piso.columnaDe(partida.jugador.posicion);
+    int fila = piso.filaDe(partida.jugador.posicion);
+
+    partida.texto() << "Pistas:" << std::endl << " - Mas cercanos:";
+    const std::pair<BanderaCelda, const char*> buscados[] = {
+        { CeldaGuardado, "guardado" }, { CeldaTaberna, "taberna" }, { CeldaCofre, "cofre" }
+    };
+    for (const auto& buscado : buscados) {
+        int64_t cercana = consultas.masCercana(celda, buscado.first);
+        partida.texto() << (buscado.first == CeldaGuardado ? " " : ", ") << buscado.second << " ";
+        if (cercana < 0) {
+            partida.texto() << "-";
+            continue;
+        }
+        int columnaCercana = static_cast<int>(cercana % piso.columnas);
+        int filaCercana = static_cast<int>(cercana / piso.columnas);
+        partida.texto() << etiquetaColumna(columnaCercana) << filaCercana + 1
+            << " (" << std::abs(columnaCercana - columna) + std::abs(filaCercana - fila) << " pasos)";
+    }
+    partida.texto() << std::endl << " - Enemigos a 1 tirada: " << consultas.contarAlAlcance(celda, 1, CeldaEnemigo)
+        << ", a 2 tiradas: " << consultas.contarAlAlcance(celda, 2, CeldaEnemigo) << std::endl;
+
+    AlcanceTurno alcance = consultas.alcanceTurno(celda);
+    std::streamsize precision = partida.texto().precision();
+    partida.texto() << " - Por direccion, enemigo / salida:" << std::fixed << std::setprecision(1);
+    for (char direccion : direccionesMovimiento) {
+        double salida = 0.0;
+        for (const DestinoTurno& destino : alcance) {
+            salida += (destino.direccion == direccion && destino.salida) ? destino.probabilidad : 0.0;
+        }
+        partida.texto() << (direccion == 'W' ? " " : ", ") << direccion << " " << 100.0 * consultas.probabilidadDeCaer(celda, direccion, CeldaEnemigo)
+            << " % / " << 100.0 * salida << " %";
+    }
+    partida.texto() << std::defaultfloat << std::setprecision(precision) << std::endl;
+}
+
+/**
+ * Mueve al jugador a través de las celdas del calabozo basado en el lanzamiento de dados.
+ * Después de lanzar los dados, el jugador puede moverse en una dirección específica (arriba, abajo, izquierda, derecha)
+ * determinada por la política de movimiento de la partida (por defecto, la entrada del usuario). El movimiento es limitado por la cantidad de pasos obtenidos en el lanzamiento.
+ * Si el jugador llega a la celda de salida (J10 en el tablero estándar) en el último piso, se inicia una pelea con el Arcángel.
+ * Si el jugador llega a la celda de salida en cualquier otro piso, avanza al siguiente piso.
+ * El movimiento se detiene en los bordes del piso y la celda de destino se obtiene directamente de la cuadrícula.
+ * La función termina si se excede el límite de tiradas de dados permitidas.
+ *
+ * param partida Referencia a la partida cuyo jugador se está moviendo.
+ */
+void moverJugador(Partida& partida) {
+    if (partida.interactivo) {
+        partida.texto() << "\nPresiona Enter para lanzar los dados...";
+        std::cin.ignore(); // Ignorar cualquier entrada anterior
+        std::cin.get(); // Esperar a que se presione Enter
+    }
+
+    int totalSteps = lanzarDados(partida);
+    char direccion = partida.politica(partida, totalSteps);
+    avanzarJugador(partida, totalSteps, direccion);
+}
+
+/**
+ * Primera mitad de un turno: lanza los dos dados y cuenta la tirada.
+ * param partida Referencia a la partida en curso.
+ * return Pasos obtenidos (2 a 12).
+ */
+int lanzarDados(Partida& partida) {
+    MEDIR_FASE(partida, Fase::Dados);
+    partida.numDiceThrows++;
+    int dice1 = partida.sortear(Proposito::Dados, 0, 0, 6) + 1;
+    int dice2 = partida.sortear(Proposito::Dados, 0, 1, 6) + 1;
+    int totalSteps = dice1 + dice2;
+
+    partida.texto() << "\nLanzaste los dados. Puedes avanzar " << totalSteps << " pasos." << std::endl;
+    return totalSteps;
+}
+
+/**
+ * Segunda mitad de un turno: mueve al jugador los pasos indicados en una dirección
+ * y resuelve lo que encuentre (salida, Arcángel, eventos de la celda, límite de tiradas).
+ * Junto con lanzarDados permite jugar un turno en dos pasos sin bloquear esperando la dirección.
+ * param partida Referencia a la partida en curso.
+ * param totalSteps Pasos obtenidos con lanzarDados.
+ * param direccion Dirección elegida (W, A, S o D).
+ */
+void avanzarJugador(Partida& partida, int totalSteps, char direccion) {
+    MEDIR_FASE(partida, Fase::Turno);
+    if (partida.diario) {
+        partida.diario->anotarDireccion(direccion);
+    }
+    Piso& piso = partida.piso;
+    Jugador& jugador = partida.jugador;
+
+    Celda* current = jugador.posicion;
+    int newRow;
+    int newColumn;
+
+    // Avanzar exactamente la cantidad de pasos determinada por los dados
+    {
+        MEDIR_FASE(partida, Fase::Movimiento);
+        CONTAR(partida, Contador::CeldasRecorridas, static_cast<uint64_t>(totalSteps));
+        if (direccion != 'W' && direccion != 'A' && direccion != 'S' && direccion != 'D') {
+            for (int paso = 0; paso < totalSteps; ++paso) {
+                partida.texto() << "Direccion de movimiento no valida." << std::endl;
+            }
+        }
+        // Los bordes detienen al jugador; la recta se resuelve de una vez (ver recorrer)
+        int64_t origen = piso.indiceDe(current);
+        Recorrido recorrido = conDimensiones(piso.columnas, piso.filas, [&](const auto& dimensiones) {
+            return recorrer(dimensiones, dimensiones.columnaDe(origen), dimensiones.filaDe(origen), totalSteps, direccion);
+        });
+        newColumn = recorrido.columna;
+        newRow = recorrido.fila;
+
+        if (recorrido.salida && partida.estadisticas) {
+            partida.estadisticas->anotarSalida(partida.pisoCalabozo, partida.numDiceThrows);
+        }
+
+        // Verificar si el jugador llega a la salida en el último piso
+        if (recorrido.salida && current->piso == partida.numPisos) {
+            pelearConArcangel(partida);
+            return;
+        }
+
+        // Verificar límite de la celda de salida
+        if (recorrido.salida) {
+            partida.texto() << "\nHas llegado a la salida del piso (" << etiquetaSalida(piso) << ")! Iniciando nuevo piso." << std::endl;
+            avanzarPiso(partida); // El piso nuevo suele estar ya generado
+            partida.numDiceThrows = 0;
+            colocarJugador(piso, jugador); // Colocar al jugador en la nueva posición inicial
+            mostrarEstado(partida); // Mostrar el estado del nuevo calabozo
+            return;
+        }
+    }
+
+    // La nueva posición siempre está dentro de los límites del calabozo
+    Celda* newCell;
+    {
+        MEDIR_FASE(partida, Fase::BusquedaCelda);
+        newCell = piso.celda(newColumn, newRow);
+    }
+    piso.marcar(jugador.posicion, CeldaJugador, false);
+    piso.marcar(newCell, CeldaJugador, true);
+    jugador.posicion = newCell;
+
+    verificarCelda(partida); // Verificar la nueva celda
+    if (partida.juego) {
+        mostrarEstado(partida);
+    }
+
+    // Restricción para perder el juego si se tiran los dados más veces que el límite (15 en el juego estándar)
+    if (partida.numDiceThrows > partida.equilibrio.limiteTiradas) {
+        partida.texto() << "Has excedido el límite de tiradas de dados permitidas. ¡Has perdido el juego!" << std::endl;
+        if (partida.resultado == Resultado::EnCurso) {
+            partida.resultado = Resultado::DerrotaTiradas;
+        }
+        partida.juego = false;
+        return;
+    }
+}
+
+/**
+ * Política de movimiento interactiva: pregunta la dirección al usuario.
+ * param partida Referencia a la partida en curso.
+ * param pasos Pasos obtenidos en los dados (no se usan, el usuario ya los vio).
+ * return La dirección escrita por el usuario.
+ */
+char leerDireccion(Partida& partida, int /*pasos*/) {
+    char direccion;
+    partida.texto() << "Elige una direccion para moverte (W, A, S, D): ";
+    std::cin >> direccion;
+    return direccion;
+}
+
+/**
+ * Prepara una partida nueva: genera el primer piso y coloca al jugador en la celda inicial.
+ * param partida Referencia a la partida a iniciar.
+ */
+void iniciarPartida(Partida& partida) {
+    crearCalabozo(partida);
+    colocarJugador(partida.piso, partida.jugador);
+    mostrarEstado(partida);
+}
+
+/**
+ * Juega turnos hasta que la partida termina.
+ * param partida Referencia a la partida en curso.
+ */
+void jugarPartida(Partida& partida) {
+    if (partida.preparadorPisos) {
+        partida.preparadorPisos->preparar(partida); // Vale igual para partidas nuevas y cargadas
+    }
+    while (partida.juego) {
+        moverJugador(partida);
+    }
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+#include "Aleatorio.h"
+#include "ArenaPisos.h"
+#include "Bits.h"
+#include "Equilibrio.h"
+
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+
+/**
+ * Banderas de una celda. Caben todas en un byte (Celda::banderas).
+ */
+enum BanderaCelda : uint8_t {
+    CeldaJugador = 1 << 0,      // La celda tiene al jugador
+    CeldaVisitada = 1 << 1,     // El jugador ya pasó por la celda
+    CeldaEnemigo = 1 << 2,      // La celda tiene un enemigo
+    CeldaGuardado = 1 << 3,     // La celda tiene un punto de guardado
+    CeldaTaberna = 1 << 4,      // La celda tiene una taberna
+    CeldaCofre = 1 << 5         // La celda tiene un cofre
+};
+
+/**
+ * Celda empaquetada en 8 bytes: las banderas en un byte y los números en campos
+ * chicos (con el equilibrio estándar los enemigos tienen salud piso + 1 y
+ * ataque piso, y hay hasta maxPisos pisos). Un piso estándar de 10x10 ocupa 800 bytes.
+ */
+struct Celda {
+    uint8_t banderas = 0;       // Combinación de BanderaCelda
+    uint8_t chestContent = 0;   // Contenido del cofre (0 si está vacío)
+    int16_t piso = 0;           // Número de piso en el que se encuentra la celda
+    int16_t enemyHealth = 0;    // Salud del enemigo presente en la celda
+    int16_t enemyAttack = 0;    // Poder de ataque del enemigo presente en la celda
+
+    bool tiene(BanderaCelda bandera) const {
+        return (banderas & bandera) != 0;
+    }
+
+    /**
+     * Cambia una bandera solo en la celda. Para las celdas de un piso conviene
+     * Piso::marcar, que también actualiza sus planos de bits.
+     */
+    void poner(BanderaCelda bandera, bool valor) {
+        banderas = static_cast<uint8_t>(valor ? (banderas | bandera) : (banderas & ~bandera));
+    }
+};
+
+static_assert(sizeof(Celda) == 8, "Cada celda ocupa 8 bytes");
+
+/**
+ * Piso del calabozo guardado como una cuadrícula contigua, fila por fila.
+ * La celda (columna, fila) vive en celdas[fila * columnas + columna], así que
+ * cualquier consulta por coordenadas es O(1). Columnas y filas empiezan en 0:
+ * la columna 0 es la 'A' y la fila 0 es la fila 1 del tablero. El tamaño se
+ * elige al crear la partida (ver Tablero).
+ *
+ * En modo perezoso no hay cuadrícula: el contenido de cada celda se calcula
+ * con generarCelda a partir de la semilla y sus coordenadas, y solo se guardan
+ * en 'modificadas' las celdas que el juego tocó. celda() materializa la celda
+ * (la copia a 'modificadas') porque quien la pide puede cambiarla; consultar()
+ * la lee sin guardar nada.
+ *
+ * La cuadrícula y las celdas modificadas viven en bloques de la ArenaPisos de
+ * la partida: liberar el piso los devuelve todos de una vez y el piso siguiente
+ * los reusa.
+ *
+ * Junto a la cuadrícula se guarda un plano de bits por bandera (visitada,
+ * enemigo, guardado, taberna y cofre), con el bit i para la celda de índice i:
+ * contar enemigos o celdas sin visitar es sumar popcounts, sin leer las celdas.
+ * Los pisos perezosos no tienen planos y esas consultas recorren el piso.
+ *
+ * Un piso salido del generador (generado) recuerda con qué se generó (número,
+ * generador, reglas y último enemigo, ver celdaGenerada) y qué celdas pudo cambiar el
+ * juego desde entonces: en la cuadrícula, el plano 'tocadas'; en modo perezoso,
+ * 'modificadas'. El guardado delta (Guardado.h) escribe solo esas celdas.
+ *
+ * Un piso perezoso puede tomar sus celdas generadas de un calabozo compartido
+ * (compartidas, ver PisosCompartidos.h) en vez de calcularlas: 'modificadas'
+ * sigue siendo la única copia propia, encima de las celdas compartidas.
+ */
+struct Piso {
+    int columnas = 10;          // Ancho del tablero (A-J en el estándar)
+    int filas = 10;             // Alto del tablero (1-10 en el estándar)
+    ArregloArena<Celda> celdas; // Celdas del piso en orden fila por fila (vacío en modo perezoso)
+    ArregloArena<uint64_t> planos; // Planos de bits uno detrás de otro (ver plano); vacío en modo perezoso
+
+    // Origen del piso
+    bool generado = false;      // Toda celda fuera de 'tocadas' o 'modificadas' es celdaGenerada
+    int numero = 0;             // Número de piso del calabozo
+    int64_t ultimoEnemigo = -1; // Posición, en el orden de generación, de la última celda que puede tener enemigo
+    GeneradorPartida generador;
+    ReglasCeldas reglas;
+    ArregloArena<uint64_t> tocadas; // Bit i en 1 si la celda i pudo cambiar; vacío en modo perezoso
+
+    // Modo perezoso
+    struct CeldaModificada {
+        Celda celda;            // Debe ser el primer miembro (ver indiceDe)
+        int64_t indice;
+    };
+    bool perezoso = false;
+    TablaArena<CeldaModificada> modificadas;
+    const Celda* compartidas = nullptr; // Si existe, las celdas generadas del piso, de solo lectura (PisosCompartidos.h)
+
+    int64_t indice(int columna, int fila) const {
+        return static_cast<int64_t>(fila) * columnas + columna;
+    }
+
+    bool dentro(int columna, int fila) const {
+        return columna >= 0 && columna < columnas && fila >= 0 && fila < filas;
+    }
+
+    Celda* celda(int columna, int fila) {
+        if (!dentro(columna, fila)) {
+            return nullptr;
+        }
+        return perezoso ? materializar(indice(columna, fila)) : &celdas[static_cast<size_t>(indice(columna, fila))];
+    }
+
+    /**
+     * Copia de la celda (columna, fila), que debe estar dentro del tablero.
+     * En modo perezoso no guarda nada nuevo.
+     */
+    Celda consultar(int columna, int fila) const;
+
+    /**
+     * Celda de índice i tal como la dejó el generador, con número, generador,
+     * reglas y último enemigo del piso (sirve en los dos modos).
+     */
+    Celda celdaGenerada(int64_t i) const;
+
+    int64_t indiceDe(const Celda* c) const {
+        if (perezoso) {
+            // Toda celda entregada en modo perezoso es el primer miembro de un CeldaModificada
+            return reinterpret_cast<const CeldaModificada*>(c)->indice;
+        }
+        return c - celdas.data();
+    }
+
+    int columnaDe(const Celda* c) const {
+        return static_cast<int>(indiceDe(c) % columnas);
+    }
+
+    int filaDe(const Celda* c) const {
+        return static_cast<int>(indiceDe(c) / columnas);
+    }
+
+    /**
+     * Devuelve la celda vecina en la dirección indicada (W, A, S, D).
+     * return nullptr si la vecina queda fuera del tablero o la dirección no es válida.
+     */
+    Celda* vecina(const Celda* c, char direccion) {
+        int columna = columnaDe(c);
+        int fila = filaDe(c);
+        switch (direccion) {
+        case 'W': return celda(columna, fila - 1);
+        case 'S': return celda(columna, fila + 1);
+        case 'A': return celda(columna - 1, fila);
+        case 'D': return celda(columna + 1, fila);
+        default:  return nullptr;
+        }
+    }
+
+    /**
+     * Celda de salida del piso (esquina inferior derecha, J10 en el tablero estándar).
+     */
+    Celda* salida() {
+        return celda(columnas - 1, filas - 1);
+    }
+
+    static const int numPlanos = 5;
+
+    /**
+     * Plano de una bandera: el bit (i % 64) de la palabra i / 64 dice si la celda de
+     * índice i la tiene. Los bits que sobran en la última palabra quedan en 0.
+     * return nullptr en modo perezoso, para CeldaJugador o si todavía no hay planos.
+     */
+    const uint64_t* plano(BanderaCelda bandera) const {
+        int numero = numeroPlano(bandera);
+        return numero < 0 || planos.empty() ? nullptr : planos.data() + static_cast<size_t>(numero) * palabrasPorPlano();
+    }
+
+    uint64_t* plano(BanderaCelda bandera) {
+        return const_cast<uint64_t*>(static_cast<const Piso*>(this)->plano(bandera));
+    }
+
+    size_t palabrasPorPlano() const {
+        return (static_cast<size_t>(columnas) * filas + 63) / 64;
+    }
+
+    /**
+     * Anota en 'tocadas' que la celda puede ya no ser la del generador. Quien
+     * cambia una celda sin marcar debe llamarla.
+     */
+    void tocar(const Celda* c) {
+        if (!tocadas.empty()) {
+            size_t i = static_cast<size_t>(indiceDe(c));
+            tocadas[i / 64] |= 1ull << (i % 64);
+        }
+    }
+
+    /**
+     * Cambia una bandera de una celda del piso manteniendo su plano al día.
+     */
+    void marcar(Celda* c, BanderaCelda bandera, bool valor) {
+        c->poner(bandera, valor);
+        tocar(c);
+        int numero = numeroPlano(bandera);
+        if (numero >= 0 && !planos.empty()) {
+            size_t i = static_cast<size_t>(indiceDe(c));
+            uint64_t& palabra = planos[static_cast<size_t>(numero) * palabrasPorPlano() + i / 64];
+            uint64_t bit = 1ull << (i % 64);
+            palabra = valor ? (palabra | bit) : (palabra & ~bit);
+        }
+    }
+
+    /**
+     * Rehace los planos a partir de las celdas. Se llama después de llenar la
+     * cuadrícula (al generarla o cargarla); en modo perezoso los libera.
+     */
+    void reconstruirPlanos(ArenaPisos* arena);
+
+    /**
+     * Cantidad de celdas del piso con una bandera.
+     */
+    int64_t contar(BanderaCelda bandera) const;
+
+    /**
+     * Llama a funcion(indice, celda) para cada celda con la bandera, en orden de
+     * índice. Con planos solo se leen las celdas que la tienen.
+     */
+    template <class Funcion>
+    void paraCada(BanderaCelda bandera, Funcion&& funcion) const {
+        if (const uint64_t* bits = plano(bandera)) {
+            for (size_t p = 0; p < palabrasPorPlano(); ++p) {
+                for (uint64_t resto = bits[p]; resto != 0; resto &= resto - 1) {
+                    size_t i = p * 64 + static_cast<size_t>(primerUno(resto));
+                    funcion(static_cast<int64_t>(i), celdas[i]);
+                }
+            }
+            return;
+        }
+        for (int fila = 0; fila < filas; ++fila) {
+            for (int columna = 0; columna < columnas; ++columna) {
+                Celda c = consultar(columna, fila);
+                if (c.tiene(bandera)) {
+                    funcion(indice(columna, fila), c);
+                }
+            }
+        }
+    }
+
+private:
+    Celda* materializar(int64_t indice);
+
+    static int numeroPlano(BanderaCelda bandera) {
+        switch (bandera) {
+        case CeldaVisitada: return 0;
+        case CeldaEnemigo:  return 1;
+        case CeldaGuardado: return 2;
+        case CeldaTaberna:  return 3;
+        case CeldaCofre:    return 4;
+        default:            return -1; // El jugador está en una sola celda: no necesita plano
+        }
+    }
+};
+
+/**
+ * Letras con las que se muestra una columna, como en una hoja de cálculo:
+ * 0 -> "A", 25 -> "Z", 26 -> "AA", 701 -> "ZZ", 702 -> "AAA".
+ */
+inline std::string etiquetaColumna(int columna) {
+    char letras[8];
+    int n = 0;
+    for (int resto = columna + 1; resto > 0 && n < 8; resto = (resto - 1) / 26) {
+        letras[n++] = static_cast<char>('A' + (resto - 1) % 26);
+    }
+    return std::string(std::reverse_iterator<char*>(letras + n), std::reverse_iterator<char*>(letras));
+}
+
+/**
+ * Columna de una etiqueta escrita por etiquetaColumna ("A" -> 0, "AA" -> 26).
+ * return -1 si la etiqueta está vacía, tiene algo que no es una mayúscula o es demasiado larga.
+ */
+int columnaDeEtiqueta(const std::string& etiqueta);
+
+/**
+ * Tamaño del calabozo: columnas y filas de cada piso y número de pisos (en la
+ * salida del último espera el Arcángel). Por defecto, el tablero estándar.
+ */
+struct Tablero {
+    int columnas = 10;
+    int filas = 10;
+    int pisos = 10;
+};
+
+const int maxLadoTablero = 46340;   // Con los dos lados al máximo, los índices caben en 31 bits
+const int maxPisos = 999;
+
+/**
+ * Indica si un tablero se puede jugar: al menos dos celdas (inicio y salida
+ * distintos), lados de hasta maxLadoTablero y de 1 a maxPisos pisos.
+ */
+bool tableroValido(const Tablero& tablero);
+
+struct Recluta {
+    std::string nombre;    // Nombre de la recluta
+    int health;            // Puntos de vida de la recluta
+    int attackPower;       // Poder de ataque de la recluta
+};
+
+struct Arcangel {
+    std::string nombre = "Arcangel";   // Nombre fijo del Arcángel
+    int health = 15;                    // Puntos de vida del Arcángel
+    int attackPower = 10;               // Poder de ataque del Arcángel
+};
+
+struct Jugador {
+    Celda* posicion;                 // Puntero a la celda donde se encuentra el jugador
+    int health;                      // Puntos de vida del jugador
+    int attackPower;                 // Poder de ataque del jugador
+    std::vector<Recluta> equipo;    // Vector que almacena las reclutas en el equipo
+
+    Jugador() : posicion(nullptr), health(3), attackPower(3) {}
+
+    /**
+     * Agrega una recluta al equipo del jugador.
+     * nuevoRecluta La recluta a agregar al equipo.
+     * return true si se pudo reclutar (espacio disponible), false si el equipo está lleno.
+     */
+    bool reclutarPersonas(const Recluta& nuevoRecluta) {
+        if (equipo.size() < 3) {
+            equipo.push_back(nuevoRecluta);
+            return true;
+        }
+        return false; // No se puede reclutar más de tres Reclutas
+    }
+};
+
+/**
+ * Forma en la que terminó (o no) una partida.
+ */
+enum class Resultado {
+    EnCurso,            // La partida sigue en juego
+    Victoria,           // El jugador derrotó al Arcángel
+    DerrotaArcangel,    // El Arcángel derrotó al jugador
+    DerrotaCombate,     // Un enemigo derrotó al jugador en combatirEnemigo
+    DerrotaTiradas      // Se superó el límite de tiradas de dados del piso
+};
+
+/**
+ * Formato en el que se guarda la partida al pisar un punto de guardado.
+ */
+enum class FormatoGuardado {
+    Texto,      // 'celdas.txt' y 'jugador.txt'
+    Binario,    // 'partida.dat' (ver Guardado.h)
+    Delta       // 'partida.delta': solo las celdas que no son las del generador (ver Guardado.h)
+};
+
+struct Partida;
+class GuardadoAsincrono;
+class PreparadorPisos;
+class RenderizadorTablero;
+class Medidor;
+class DiarioPartida;
+struct EventoCombate;
+class FranjaEstadisticas;
+class CalabozoCompartido;
+
+/**
+ * Política de movimiento: recibe la partida y los pasos obtenidos en los dados
+ * y devuelve la dirección elegida (W, A, S o D).
+ */
+using PoliticaMovimiento = std::function<char(Partida&, int)>;
+
+char leerDireccion(Partida& partida, int pasos);
+
+/**
+ * Estado completo de una partida. Cada partida es independiente de las demás,
+ * por lo que varias pueden jugarse a la vez en hilos distintos.
+ */
+struct Partida {
+    Piso piso;                          // Piso actual del calabozo
+    Jugador jugador;                    // Jugador y su equipo
+    Arcangel arcangel;                  // Jefe final, en la salida del último piso
+    int pisoCalabozo = 1;               // Número del piso actual
+    int numPisos = 10;                  // Pisos del calabozo; la salida del último lleva al Arcángel
+    int numEnemies = 0;                 // Enemigos generados hasta ahora
+    bool juego = true;                  // false cuando la partida terminó
+    int numDiceThrows = 0;              // Contador de tiradas de dados del piso
+    Equilibrio equilibrio;              // Parámetros de equilibrio (ver aplicarEquilibrio)
+    Resultado resultado = Resultado::EnCurso;
+
+    GeneradorPartida generador;         // Generador aleatorio propio de la partida
+    PoliticaMovimiento politica = leerDireccion; // Elige la dirección de cada tirada
+    std::ostream* salida = &std::cout;  // Destino de los mensajes, nullptr sin terminal
+    bool interactivo = true;            // Espera Enter antes de cada tirada
+    bool guardadoHabilitado = true;     // Guarda en disco al pisar un punto de guardado
+    bool pisosPerezosos = false;        // Genera las celdas al usarlas en vez de crear el piso entero
+    bool pistas = false;                // mostrarEstado agrega pistas de movimiento (ver mostrarPistas)
+    FormatoGuardado formatoGuardado = FormatoGuardado::Binario;
+    GuardadoAsincrono* guardadoAsincrono = nullptr; // Si existe, guarda en segundo plano
+    PreparadorPisos* preparadorPisos = nullptr;     // Si existe, genera el siguiente piso por adelantado
+    RenderizadorTablero* renderizador = nullptr;    // Si existe, mostrarEstado dibuja con él
+    Medidor* medidor = nullptr;                     // Si existe, registra tiempos y contadores (Instrumentacion.h)
+    ArenaPisos* arena = nullptr;                    // Si existe, los pisos toman su memoria de ella
+    DiarioPartida* diario = nullptr;                // Si existe, anota cada turno (Diario.h)
+    std::vector<EventoCombate>* eventosCombate = nullptr; // Si existe, recibe los hechos de cada pelea (Combate.h)
+    FranjaEstadisticas* estadisticas = nullptr;     // Si existe, anota salidas de piso, peleas y cofres (Estadisticas.h)
+    std::shared_ptr<const CalabozoCompartido> calabozoCompartido; // Si existe, los pisos salen de él sin generarse (PisosCompartidos.h)
+
+    /**
+     * Entero aleatorio uniforme en [0, n) para una decisión del turno actual.
+     * param proposito Tipo de decisión.
+     * param celda Índice de la celda donde ocurre la decisión.
+     * param contador Número de sorteo dentro de la misma decisión (0, 1, 2...).
+     */
+    int sortear(Proposito proposito, int64_t celda, int contador, int n) const {
+        return generador.uniforme(n, proposito, static_cast<uint32_t>(pisoCalabozo), static_cast<uint32_t>(celda),
+            static_cast<uint32_t>(numDiceThrows), static_cast<uint32_t>(contador));
+    }
+
+    /**
+     * Flujo donde se escriben los mensajes de la partida. Sin terminal devuelve
+     * un flujo sin buffer que descarta todo sin formatear nada.
+     */
+    std::ostream& texto() {
+        static thread_local std::ostream nulo(nullptr);
+        return salida ? *salida : nulo;
+    }
+};
+
+// Piso y celdas
+void aplicarTablero(Partida& partida, const Tablero& tablero);
+void aplicarEquilibrio(Partida& partida, const Equilibrio& equilibrio);
+void liberarPiso(Piso& piso);
+Celda generarCelda(const GeneradorPartida& generador, const ReglasCeldas& reglas, int pisoCalabozo, int64_t indice, bool conEnemigo);
+bool tiradaEnemigo(const GeneradorPartida& generador, const ReglasCeldas& reglas, int pisoCalabozo, int64_t indice);
+void insertarCelda(Partida& partida, int columna, int fila);
+void crearPisoPerezoso(Partida& partida);
+void crearCalabozo(Partida& partida);
+void avanzarPiso(Partida& partida);
+void colocarJugador(Piso& piso, Jugador& jugador);
+
+// Guardado en archivos de texto
+std::string serializarCeldas(const Piso& piso);
+std::string serializarJugador(const Partida& partida);
+void guardarCeldasEnArchivo(const Piso& piso, const char* ruta = "celdas.txt");
+bool cargarCeldasDesdeArchivo(Partida& partida);
+void guardarInformacionJugador(const Partida& partida, const char* ruta = "jugador.txt");
+bool cargarInformacionJugador(Partida& partida);
+
+// Combate y eventos
+void pelearConArcangel(Partida& partida);
+void combatirEnemigo(Partida& partida, Celda* enemigo);
+void anadirReclutaAleatorioAJugador(Partida& partida);
+void verificarCelda(Partida& partida);
+
+// Presentación y turnos
+void mostrarCaracteristicas(Partida& partida);
+void mostrarEstado(Partida& partida);
+void mostrarPistas(Partida& partida);
+void moverJugador(Partida& partida);
+int lanzarDados(Partida& partida);
+void avanzarJugador(Partida& partida, int totalSteps, char direccion);
+void iniciarPartida(Partida& partida);
+void jugarPartida(Partida& partida);
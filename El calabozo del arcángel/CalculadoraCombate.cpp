@@ -0,0 +1,266 @@
+#include "CalculadoraCombate.h"
+
+#include <algorithm>
+
+EstadoCombate CalculadoraCombate::estadoInicial(const Jugador& jugador, int enemigoHp, int enemigoAtk) {
+    EstadoCombate estado;
+    estado.jugadorHp = jugador.health;
+    estado.jugadorAtk = jugador.attackPower;
+    estado.enemigoHp = enemigoHp;
+    estado.enemigoAtk = enemigoAtk;
+    estado.numReclutas = static_cast<int>(std::min<size_t>(jugador.equipo.size(), 3));
+    for (int i = 0; i < estado.numReclutas; ++i) {
+        estado.reclutaHp[i] = jugador.equipo[i].health;
+        estado.reclutaAtk[i] = jugador.equipo[i].attackPower;
+    }
+    return estado;
+}
+
+bool CalculadoraCombate::claveDe(const EstadoCombate& e, Clave& clave) {
+    auto cabe = [](int valor, int bits) {
+        return valor >= 0 && valor < (1 << bits);
+    };
+
+    if (!cabe(e.jugadorHp, 16) || !cabe(e.jugadorAtk, 16) || !cabe(e.enemigoHp, 16) || !cabe(e.enemigoAtk, 15)) {
+        return false;
+    }
+
+    clave.alta = static_cast<uint64_t>(e.jugadorHp)
+        | static_cast<uint64_t>(e.jugadorAtk) << 16
+        | static_cast<uint64_t>(e.enemigoHp) << 32
+        | static_cast<uint64_t>(e.enemigoAtk) << 48
+        | static_cast<uint64_t>(e.turnoJugador ? 1 : 0) << 63;
+
+    clave.baja = static_cast<uint64_t>(e.numReclutas);
+    for (int i = 0; i < e.numReclutas; ++i) {
+        if (!cabe(e.reclutaHp[i], 10) || !cabe(e.reclutaAtk[i], 10)) {
+            return false;
+        }
+        clave.baja |= static_cast<uint64_t>(e.reclutaHp[i]) << (4 + 20 * i);
+        clave.baja |= static_cast<uint64_t>(e.reclutaAtk[i]) << (14 + 20 * i);
+    }
+    return true;
+}
+
+ResultadoCombate CalculadoraCombate::resolver(const EstadoCombate& estado) {
+    Clave clave;
+    bool cacheable = claveDe(estado, clave);
+    if (cacheable) {
+        auto encontrado = cache.find(clave);
+        if (encontrado != cache.end()) {
+            return encontrado->second;
+        }
+    }
+
+    ResultadoCombate resultado;
+    int totalAttack = estado.jugadorAtk;
+    for (int i = 0; i < estado.numReclutas; ++i) {
+        totalAttack += estado.reclutaAtk[i];
+    }
+
+    if (totalAttack <= 0 && estado.enemigoAtk <= 0) {
+        // Nadie puede hacer daño: el combate nunca terminaría. Se informa el estado tal cual.
+        resultado.vidaJugador = estado.jugadorHp;
+        for (int i = 0; i < estado.numReclutas; ++i) {
+            resultado.vidaReclutas[i] = estado.reclutaHp[i];
+        }
+        return resultado;
+    }
+
+    if (estado.turnoJugador) {
+        EstadoCombate siguiente = estado;
+        siguiente.enemigoHp -= totalAttack;
+        siguiente.turnoJugador = false;
+
+        if (siguiente.enemigoHp <= 0) {
+            // El enemigo cae en este ataque
+            resultado.probVictoria = 1.0;
+            resultado.vidaJugador = estado.jugadorHp;
+            for (int i = 0; i < estado.numReclutas; ++i) {
+                resultado.vidaReclutas[i] = estado.reclutaHp[i];
+            }
+        }
+        else {
+            resultado = resolver(siguiente);
+        }
+        resultado.turnos += 1.0;
+    }
+    else {
+        // El enemigo elige al jugador o a una recluta con la misma probabilidad
+        int objetivos = 1 + estado.numReclutas;
+        double peso = 1.0 / objetivos;
+
+        for (int objetivo = 0; objetivo < objetivos; ++objetivo) {
+            EstadoCombate siguiente = estado;
+            siguiente.turnoJugador = true;
+            ResultadoCombate rama;
+
+            if (objetivo == 0) {
+                siguiente.jugadorHp -= estado.enemigoAtk;
+                if (siguiente.jugadorHp <= 0) {
+                    // El jugador cae: las reclutas quedan con la salud que tenían
+                    for (int i = 0; i < estado.numReclutas; ++i) {
+                        rama.vidaReclutas[i] = estado.reclutaHp[i];
+                    }
+                }
+                else {
+                    rama = resolver(siguiente);
+                }
+            }
+            else {
+                int reclutaIndex = objetivo - 1;
+                siguiente.reclutaHp[reclutaIndex] -= estado.enemigoAtk;
+                bool derrotado = siguiente.reclutaHp[reclutaIndex] <= 0;
+
+                if (derrotado) {
+                    // Eliminar la recluta manteniendo el orden de las demás
+                    for (int i = reclutaIndex; i + 1 < estado.numReclutas; ++i) {
+                        siguiente.reclutaHp[i] = siguiente.reclutaHp[i + 1];
+                        siguiente.reclutaAtk[i] = siguiente.reclutaAtk[i + 1];
+                    }
+                    --siguiente.numReclutas;
+                    siguiente.reclutaHp[siguiente.numReclutas] = 0;
+                    siguiente.reclutaAtk[siguiente.numReclutas] = 0;
+                }
+
+                ResultadoCombate hijo = resolver(siguiente);
+                rama.probVictoria = hijo.probVictoria;
+                rama.vidaJugador = hijo.vidaJugador;
+                rama.turnos = hijo.turnos;
+                // Volver a los índices del equipo antes del ataque
+                for (int i = 0, j = 0; i < estado.numReclutas; ++i) {
+                    if (derrotado && i == reclutaIndex) {
+                        rama.vidaReclutas[i] = 0.0;
+                    }
+                    else {
+                        rama.vidaReclutas[i] = hijo.vidaReclutas[j++];
+                    }
+                }
+            }
+
+            resultado.probVictoria += peso * rama.probVictoria;
+            resultado.vidaJugador += peso * rama.vidaJugador;
+            resultado.turnos += peso * rama.turnos;
+            for (int i = 0; i < estado.numReclutas; ++i) {
+                resultado.vidaReclutas[i] += peso * rama.vidaReclutas[i];
+            }
+        }
+        resultado.turnos += 1.0;
+    }
+
+    if (cacheable) {
+        cache.emplace(clave, resultado);
+    }
+    return resultado;
+}
+
+ResultadoCombate CalculadoraCombate::resolverConInicioAleatorio(EstadoCombate estado) {
+    estado.turnoJugador = true;
+    ResultadoCombate empiezaJugador = resolver(estado);
+    estado.turnoJugador = false;
+    ResultadoCombate empiezaEnemigo = resolver(estado);
+
+    ResultadoCombate resultado;
+    resultado.probVictoria = 0.5 * (empiezaJugador.probVictoria + empiezaEnemigo.probVictoria);
+    resultado.vidaJugador = 0.5 * (empiezaJugador.vidaJugador + empiezaEnemigo.vidaJugador);
+    resultado.turnos = 0.5 * (empiezaJugador.turnos + empiezaEnemigo.turnos);
+    for (int i = 0; i < 3; ++i) {
+        resultado.vidaReclutas[i] = 0.5 * (empiezaJugador.vidaReclutas[i] + empiezaEnemigo.vidaReclutas[i]);
+    }
+    return resultado;
+}
+
+ResultadoCombate CalculadoraCombate::contraEnemigo(const Jugador& jugador, const Celda& enemigo) {
+    return resolverConInicioAleatorio(estadoInicial(jugador, enemigo.enemyHealth, enemigo.enemyAttack));
+}
+
+ResultadoCombate CalculadoraCombate::contraArcangel(const Jugador& jugador, const Arcangel& arcangel) {
+    return resolverConInicioAleatorio(estadoInicial(jugador, arcangel.health, arcangel.attackPower));
+}
+
+std::vector<double> CalculadoraCombate::distribucionDesde(const EstadoCombate& estado) {
+    Clave clave;
+    bool cacheable = claveDe(estado, clave);
+    if (cacheable) {
+        auto encontrado = cacheDistribucion.find(clave);
+        if (encontrado != cacheDistribucion.end()) {
+            return encontrado->second;
+        }
+    }
+
+    std::vector<double> distribucion(static_cast<size_t>(std::max(estado.jugadorHp, 0)) + 1, 0.0);
+    int totalAttack = estado.jugadorAtk;
+    for (int i = 0; i < estado.numReclutas; ++i) {
+        totalAttack += estado.reclutaAtk[i];
+    }
+
+    if (totalAttack <= 0 && estado.enemigoAtk <= 0) {
+        return distribucion; // El combate nunca termina: no hay victoria posible
+    }
+
+    // Mismas transiciones que resolver, acumulando probabilidades por salud final
+    auto sumar = [&](double peso, const std::vector<double>& rama) {
+        for (size_t h = 0; h < rama.size(); ++h) {
+            distribucion[h] += peso * rama[h];
+        }
+    };
+
+    if (estado.turnoJugador) {
+        EstadoCombate siguiente = estado;
+        siguiente.enemigoHp -= totalAttack;
+        siguiente.turnoJugador = false;
+        if (siguiente.enemigoHp <= 0) {
+            distribucion[static_cast<size_t>(estado.jugadorHp)] = 1.0;
+        }
+        else {
+            sumar(1.0, distribucionDesde(siguiente));
+        }
+    }
+    else {
+        int objetivos = 1 + estado.numReclutas;
+        double peso = 1.0 / objetivos;
+        for (int objetivo = 0; objetivo < objetivos; ++objetivo) {
+            EstadoCombate siguiente = estado;
+            siguiente.turnoJugador = true;
+            if (objetivo == 0) {
+                siguiente.jugadorHp -= estado.enemigoAtk;
+                if (siguiente.jugadorHp <= 0) {
+                    distribucion[0] += peso;
+                    continue;
+                }
+            }
+            else {
+                int reclutaIndex = objetivo - 1;
+                siguiente.reclutaHp[reclutaIndex] -= estado.enemigoAtk;
+                if (siguiente.reclutaHp[reclutaIndex] <= 0) {
+                    for (int i = reclutaIndex; i + 1 < estado.numReclutas; ++i) {
+                        siguiente.reclutaHp[i] = siguiente.reclutaHp[i + 1];
+                        siguiente.reclutaAtk[i] = siguiente.reclutaAtk[i + 1];
+                    }
+                    --siguiente.numReclutas;
+                    siguiente.reclutaHp[siguiente.numReclutas] = 0;
+                    siguiente.reclutaAtk[siguiente.numReclutas] = 0;
+                }
+            }
+            sumar(peso, distribucionDesde(siguiente));
+        }
+    }
+
+    if (cacheable) {
+        cacheDistribucion.emplace(clave, distribucion);
+    }
+    return distribucion;
+}
+
+std::vector<double> CalculadoraCombate::distribucionVida(EstadoCombate estado) {
+    estado.turnoJugador = true;
+    std::vector<double> empiezaJugador = distribucionDesde(estado);
+    estado.turnoJugador = false;
+    std::vector<double> empiezaEnemigo = distribucionDesde(estado);
+
+    std::vector<double> distribucion(empiezaJugador.size(), 0.0);
+    for (size_t h = 0; h < distribucion.size(); ++h) {
+        distribucion[h] = 0.5 * (empiezaJugador[h] + empiezaEnemigo[h]);
+    }
+    return distribucion;
+}
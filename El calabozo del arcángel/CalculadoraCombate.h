@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Estado de un combate en un instante dado: el jugador, sus reclutas (en el
+ * orden del equipo), el enemigo y a quién le toca atacar.
+ */
+struct EstadoCombate {
+    int jugadorHp = 0;
+    int jugadorAtk = 0;
+    int enemigoHp = 0;
+    int enemigoAtk = 0;
+    int numReclutas = 0;
+    std::array<int, 3> reclutaHp{};
+    std::array<int, 3> reclutaAtk{};
+    bool turnoJugador = true;
+};
+
+/**
+ * Resultado exacto (valores esperados) de un combate.
+ */
+struct ResultadoCombate {
+    double probVictoria = 0.0;              // Probabilidad de que el enemigo caiga primero
+    double vidaJugador = 0.0;               // Salud esperada del jugador al terminar (0 si cae)
+    std::array<double, 3> vidaReclutas{};   // Salud esperada de cada recluta inicial (0 si cae)
+    double turnos = 0.0;                    // Cantidad esperada de turnos (ataques) del combate
+};
+
+/**
+ * Calcula el resultado exacto de combatirEnemigo y pelearConArcangel sin tirar dados.
+ *
+ * El combate es un proceso de Markov: en el turno del jugador el enemigo recibe la
+ * suma del ataque del jugador y de sus reclutas; en el turno del enemigo el objetivo
+ * se elige de manera uniforme entre el jugador y cada recluta, y el recluta que llega
+ * a 0 sale del equipo. Cada estado se resuelve una sola vez con programación dinámica
+ * y queda en caché, así que las consultas repetidas (y los subestados compartidos
+ * entre consultas) no cuestan nada.
+ *
+ * No es segura entre hilos: cada hilo de análisis debe tener su propia calculadora.
+ */
+class CalculadoraCombate {
+public:
+    /**
+     * Resuelve el combate a partir de un estado en el que ya se sabe a quién le toca.
+     */
+    ResultadoCombate resolver(const EstadoCombate& estado);
+
+    /**
+     * Resuelve el combate promediando los dos posibles primeros turnos (50 % cada uno),
+     * como hacen combatirEnemigo y pelearConArcangel.
+     */
+    ResultadoCombate resolverConInicioAleatorio(EstadoCombate estado);
+
+    /**
+     * Distribución exacta de la salud final del jugador, con inicio aleatorio.
+     * return Vector de estado.jugadorHp + 1 probabilidades: [0] es la de perder
+     *        y [h] la de ganar con salud h.
+     */
+    std::vector<double> distribucionVida(EstadoCombate estado);
+
+    /**
+     * Combate del jugador contra el enemigo de una celda.
+     */
+    ResultadoCombate contraEnemigo(const Jugador& jugador, const Celda& enemigo);
+
+    /**
+     * Pelea final del jugador contra el Arcángel.
+     */
+    ResultadoCombate contraArcangel(const Jugador& jugador, const Arcangel& arcangel);
+
+    size_t estadosEnCache() const {
+        return cache.size();
+    }
+
+    void limpiarCache() {
+        cache.clear();
+        cacheDistribucion.clear();
+    }
+
+    /**
+     * Estado inicial de un combate del jugador contra un enemigo con esa salud y ataque.
+     */
+    static EstadoCombate estadoInicial(const Jugador& jugador, int enemigoHp, int enemigoAtk);
+
+private:
+    struct Clave {
+        uint64_t alta;
+        uint64_t baja;
+        bool operator==(const Clave& otra) const {
+            return alta == otra.alta && baja == otra.baja;
+        }
+    };
+
+    struct HashClave {
+        size_t operator()(const Clave& clave) const {
+            uint64_t h = clave.alta * 0x9E3779B97F4A7C15ull ^ (clave.baja + 0x632BE59BD9B4E019ull);
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    /**
+     * Empaqueta un estado en 128 bits.
+     * return false si algún valor no cabe; ese estado se resuelve sin caché.
+     */
+    static bool claveDe(const EstadoCombate& estado, Clave& clave);
+
+    std::vector<double> distribucionDesde(const EstadoCombate& estado);
+
+    std::unordered_map<Clave, ResultadoCombate, HashClave> cache;
+    std::unordered_map<Clave, std::vector<double>, HashClave> cacheDistribucion;
+};
@@ -0,0 +1,157 @@
+#include "Combate.h"
+#include "Estadisticas.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+    int16_t recortar(int valor) {
+        return static_cast<int16_t>(std::min<int>(std::max<int>(valor, std::numeric_limits<int16_t>::min()),
+            std::numeric_limits<int16_t>::max()));
+    }
+
+    void anotar(Partida& partida, RivalCombate rival, TipoEventoCombate tipo, int objetivo, int valor, int salud) {
+        EventoCombate evento = { tipo, rival, static_cast<int8_t>(objetivo), 0, recortar(valor), recortar(salud) };
+        if (partida.eventosCombate) {
+            partida.eventosCombate->push_back(evento);
+        }
+        if (partida.salida) {
+            narrarEventoCombate(partida, evento);
+        }
+    }
+
+    void mostrarSaludes(Partida& partida) {
+        const Arcangel& arcangel = partida.arcangel;
+        const Jugador& jugador = partida.jugador;
+        partida.texto() << "Arcangel - Salud: " << arcangel.health << " | Poder de Ataque: " << arcangel.attackPower << std::endl;
+        partida.texto() << "Jugador - Salud: " << jugador.health << " | Poder de Ataque: " << jugador.attackPower << std::endl;
+    }
+}
+
+bool resolverCombate(Partida& partida, RivalCombate rival, int& salud, int ataque, int64_t celda) {
+    Jugador& jugador = partida.jugador;
+    anotar(partida, rival, TipoEventoCombate::Inicio, -1, salud, jugador.health);
+
+    // El ataque del jugador con su equipo solo cambia cuando cae una recluta
+    int totalAttack = jugador.attackPower;
+    for (const auto& recluta : jugador.equipo) {
+        totalAttack += recluta.attackPower;
+    }
+
+    int perdidas = 0; // Reclutas caídas en esta pelea
+    int sorteo = 0; // Número de sorteo dentro de esta pelea
+    // Decidir aleatoriamente quién comienza (cada rival usa su propio valor del sorteo)
+    bool turnoJugador = (partida.sortear(Proposito::Combate, celda, sorteo++, 2) == (rival == RivalCombate::Arcangel ? 0 : 1));
+    int turnos = 1;
+
+    while (jugador.health > 0 && salud > 0) {
+        anotar(partida, rival, TipoEventoCombate::Ronda, -1, turnos++, 0);
+
+        if (turnoJugador) {
+            salud -= totalAttack;
+            anotar(partida, rival, TipoEventoCombate::Ataque, -1, totalAttack, salud);
+        }
+        else {
+            // El objetivo es el jugador (0) o una de sus reclutas (1 a 3)
+            int objetivo = partida.sortear(Proposito::Combate, celda, sorteo++, static_cast<int>(jugador.equipo.size()) + 1);
+            if (objetivo == 0) {
+                jugador.health -= ataque;
+                anotar(partida, rival, TipoEventoCombate::Ataque, 0, ataque, jugador.health);
+            }
+            else {
+                Recluta& recluta = jugador.equipo[objetivo - 1];
+                recluta.health -= ataque;
+                anotar(partida, rival, TipoEventoCombate::Ataque, objetivo, ataque, recluta.health);
+                if (recluta.health <= 0) {
+                    anotar(partida, rival, TipoEventoCombate::ReclutaDerrotado, objetivo, 0, recluta.health);
+                    totalAttack -= recluta.attackPower;
+                    ++perdidas;
+                    jugador.equipo.erase(jugador.equipo.begin() + (objetivo - 1)); // Mover no pide memoria
+                }
+            }
+        }
+
+        anotar(partida, rival, TipoEventoCombate::FinRonda, -1, salud, jugador.health);
+        turnoJugador = !turnoJugador; // Cambiar turno
+    }
+
+    bool victoria = jugador.health > 0;
+    anotar(partida, rival, victoria ? TipoEventoCombate::Victoria : TipoEventoCombate::Derrota, -1, salud, jugador.health);
+    if (partida.estadisticas) {
+        partida.estadisticas->anotarPelea(rival, victoria, perdidas, jugador.health);
+    }
+    return victoria;
+}
+
+void narrarEventoCombate(Partida& partida, const EventoCombate& evento) {
+    std::ostream& texto = partida.texto();
+    bool arcangel = evento.rival == RivalCombate::Arcangel;
+    switch (evento.tipo) {
+    case TipoEventoCombate::Inicio:
+        if (arcangel) {
+            texto << "\nHas encontrado al Arcangel! Preparate para la batalla final!" << std::endl;
+            mostrarSaludes(partida);
+        }
+        else {
+            texto << "Te has encontrado con un enemigo! ¡Preparate para el combate!" << std::endl;
+        }
+        break;
+    case TipoEventoCombate::Ronda:
+        if (arcangel) {
+            texto << "\n--- Turno " << evento.valor << " ---" << std::endl;
+        }
+        break;
+    case TipoEventoCombate::Ataque:
+        if (evento.objetivo < 0) {
+            if (arcangel) {
+                texto << "Atacas al Arcangel causando " << evento.valor << " puntos de dano." << std::endl;
+            }
+            else {
+                texto << "Has infligido " << evento.valor << " puntos de dano al enemigo." << std::endl;
+            }
+        }
+        else if (evento.objetivo == 0) {
+            if (arcangel) {
+                texto << "El Arcangel te ataca y causa " << evento.valor << " puntos de dano." << std::endl;
+            }
+            else {
+                texto << "El enemigo te ha infligido " << evento.valor << " puntos de dano." << std::endl;
+            }
+        }
+        else {
+            const std::string& nombre = partida.jugador.equipo[evento.objetivo - 1].nombre;
+            if (arcangel) {
+                texto << "El Arcangel ataca a " << nombre << " y causa " << evento.valor << " puntos de dano." << std::endl;
+            }
+            else {
+                texto << "El enemigo ha infligido " << evento.valor << " puntos de dano a " << nombre << "." << std::endl;
+            }
+        }
+        break;
+    case TipoEventoCombate::ReclutaDerrotado:
+        texto << partida.jugador.equipo[evento.objetivo - 1].nombre << " ha sido derrotado." << std::endl;
+        break;
+    case TipoEventoCombate::FinRonda:
+        if (arcangel) {
+            mostrarSaludes(partida);
+        }
+        break;
+    case TipoEventoCombate::Victoria:
+        if (arcangel) {
+            texto << "\nHas derrotado al Arcangel! Felicidades, has completado el calabozo." << std::endl;
+        }
+        else {
+            texto << "Has derrotado al enemigo!" << std::endl;
+        }
+        break;
+    case TipoEventoCombate::Derrota:
+        if (arcangel) {
+            texto << "\nEl Arcangel te ha derrotado! Intenta nuevamente." << std::endl;
+        }
+        else {
+            texto << "El enemigo te ha derrotado! ¡Intenta nuevamente!" << std::endl;
+        }
+        break;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdint>
+
+/**
+ * Contra quién es una pelea.
+ */
+enum class RivalCombate : uint8_t {
+    Enemigo,    // Un enemigo de una celda (combatirEnemigo)
+    Arcangel    // El jefe final (pelearConArcangel)
+};
+
+enum class TipoEventoCombate : uint8_t {
+    Inicio,             // valor = salud del rival, salud = salud del jugador
+    Ronda,              // Empieza el turno número 'valor' de la pelea
+    Ataque,             // Alguien recibe 'valor' de daño y le queda 'salud'
+    ReclutaDerrotado,   // La recluta 'objetivo' cae; se quita del equipo después del evento
+    FinRonda,           // Terminó el turno: valor = salud del rival, salud = salud del jugador
+    Victoria,           // El jugador ganó la pelea
+    Derrota             // El jugador cayó
+};
+
+/**
+ * Un hecho de una pelea, en 8 bytes. En los ataques, objetivo -1 es el rival
+ * (ataca el jugador con su equipo), 0 el jugador y 1 a 3 una recluta (índice
+ * en el equipo más 1). Las saludes se recortan al rango de int16_t.
+ */
+struct EventoCombate {
+    TipoEventoCombate tipo;
+    RivalCombate rival;
+    int8_t objetivo;
+    uint8_t reservado;
+    int16_t valor;
+    int16_t salud;
+};
+
+static_assert(sizeof(EventoCombate) == 8, "Los eventos deben ocupar 8 bytes");
+
+/**
+ * Resuelve una pelea por turnos entre el jugador (con su equipo) y un rival,
+ * sin pedir memoria. Cada hecho se anota como EventoCombate: se agrega a
+ * partida.eventosCombate si existe y, si la partida tiene terminal, se narra
+ * enseguida con narrarEventoCombate. Sin ninguno de los dos la pelea solo
+ * cambia la partida.
+ * param salud Salud del rival; se actualiza con cada ataque.
+ * param ataque Poder de ataque del rival.
+ * param celda Índice de la celda de la pelea (decide los sorteos).
+ * return true si ganó el jugador.
+ */
+bool resolverCombate(Partida& partida, RivalCombate rival, int& salud, int ataque, int64_t celda);
+
+/**
+ * Escribe en partida.texto() el mensaje de un evento. Usa la partida tal como
+ * está al anotarse el evento (por ejemplo, el nombre de una recluta que cae).
+ */
+void narrarEventoCombate(Partida& partida, const EventoCombate& evento);
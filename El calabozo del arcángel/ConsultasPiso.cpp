@@ -0,0 +1,292 @@
+#include "ConsultasPiso.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+    /**
+     * Indica si la celda de índice 'celda' tiene la bandera, con el plano si lo hay.
+     */
+    bool tieneBandera(const Piso& piso, const uint64_t* plano, int64_t celda, BanderaCelda bandera) {
+        if (plano) {
+            return (plano[celda / 64] >> (celda % 64)) & 1;
+        }
+        return piso.consultar(static_cast<int>(celda % piso.columnas), static_cast<int>(celda / piso.columnas)).tiene(bandera);
+    }
+
+    size_t posicionTabla(int linea, int lado, int pasos) {
+        return (static_cast<size_t>(linea) * 2 + lado) * resultadosDados + (pasos - 2);
+    }
+}
+
+ConsultasPiso::ConsultasPiso(const Piso& piso)
+    : piso(&piso), columnas(piso.columnas), filas(piso.filas),
+    enFila(static_cast<size_t>(piso.columnas) * 2 * resultadosDados),
+    enColumna(static_cast<size_t>(piso.filas) * 2 * resultadosDados) {
+    for (int pasos = 2; pasos <= 12; ++pasos) {
+        for (int columna = 0; columna < columnas; ++columna) {
+            enFila[posicionTabla(columna, 0, pasos)] = std::max(columna - pasos, 0);
+            enFila[posicionTabla(columna, 1, pasos)] = std::min(columna + pasos, columnas - 1);
+        }
+        for (int fila = 0; fila < filas; ++fila) {
+            enColumna[posicionTabla(fila, 0, pasos)] = std::max(fila - pasos, 0);
+            enColumna[posicionTabla(fila, 1, pasos)] = std::min(fila + pasos, filas - 1);
+        }
+    }
+    if (chico()) {
+        for (int linea = 0; linea < 64; ++linea) {
+            mascaraFila[linea] = 0;
+            mascaraColumna[linea] = 0;
+            for (int lado = 0; lado < 2; ++lado) {
+                for (int pasos = 2; pasos <= 12; ++pasos) {
+                    if (linea < columnas) {
+                        mascaraFila[linea] |= 1ull << enFila[posicionTabla(linea, lado, pasos)];
+                    }
+                    if (linea < filas) {
+                        mascaraColumna[linea] |= 1ull << enColumna[posicionTabla(linea, lado, pasos)];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ConsultasPiso::alcancePorFilas(int64_t celda, int tiradas, uint64_t* alcanzadas) const {
+    uint64_t frente[64] = {};
+    uint64_t nuevas[64];
+    std::fill(alcanzadas, alcanzadas + filas, 0);
+    frente[celda / columnas] = 1ull << (celda % columnas);
+    for (int tirada = 0; tirada < tiradas; ++tirada) {
+        std::fill(nuevas, nuevas + filas, 0);
+        for (int fila = 0; fila < filas; ++fila) {
+            uint64_t origenes = frente[fila];
+            if (tirada > 0 && fila == filas - 1) {
+                origenes &= ~(1ull << (columnas - 1)); // Desde la salida no se sigue
+            }
+            if (origenes == 0) {
+                continue;
+            }
+            // Por la fila, cada origen llega a las columnas de su máscara; por las
+            // columnas, toda la fila de orígenes llega junta a cada fila de destino
+            for (uint64_t resto = origenes; resto != 0; resto &= resto - 1) {
+                nuevas[fila] |= mascaraFila[primerUno(resto)];
+            }
+            for (uint64_t destinos = mascaraColumna[fila]; destinos != 0; destinos &= destinos - 1) {
+                nuevas[primerUno(destinos)] |= origenes;
+            }
+        }
+        bool quedan = false;
+        for (int fila = 0; fila < filas; ++fila) {
+            frente[fila] = nuevas[fila] & ~alcanzadas[fila];
+            alcanzadas[fila] |= nuevas[fila];
+            quedan = quedan || frente[fila] != 0;
+        }
+        if (!quedan) {
+            break;
+        }
+    }
+}
+
+int64_t ConsultasPiso::destino(int64_t celda, int direccion, int pasos) const {
+    int indice = static_cast<int>(celda); // Cabe en 31 bits (ver maxLadoTablero): la división de 32 bits es más rápida
+    int columna = indice % columnas;
+    int fila = indice / columnas;
+    switch (direccion) {
+    case 0: fila = enColumna[posicionTabla(fila, 0, pasos)]; break;
+    case 1: columna = enFila[posicionTabla(columna, 0, pasos)]; break;
+    case 2: fila = enColumna[posicionTabla(fila, 1, pasos)]; break;
+    case 3: columna = enFila[posicionTabla(columna, 1, pasos)]; break;
+    default: break;
+    }
+    return static_cast<int64_t>(fila) * columnas + columna;
+}
+
+AlcanceTurno ConsultasPiso::alcanceTurno(int64_t celda) const {
+    AlcanceTurno alcance;
+    for (int d = 0; d < 4; ++d) {
+        int primero = alcance.cantidad;
+        for (int pasos = 2; pasos <= 12; ++pasos) {
+            int64_t llegada = destino(celda, d, pasos);
+            int i = primero;
+            while (i < alcance.cantidad && alcance.destinos[i].celda != llegada) {
+                ++i;
+            }
+            if (i == alcance.cantidad) {
+                alcance.destinos[i] = DestinoTurno{ llegada, direccionesMovimiento[d], 0.0, llegada == salida() };
+                ++alcance.cantidad;
+            }
+            alcance.destinos[i].probabilidad += probabilidadDados(pasos);
+        }
+    }
+    return alcance;
+}
+
+double ConsultasPiso::probabilidadDeCaer(int64_t celda, char direccion, BanderaCelda bandera) const {
+    const char* encontrada = std::find(direccionesMovimiento, direccionesMovimiento + 4, direccion);
+    if (encontrada == direccionesMovimiento + 4) {
+        return 0.0;
+    }
+    const uint64_t* plano = piso->plano(bandera);
+    double probabilidad = 0.0;
+    for (int pasos = 2; pasos <= 12; ++pasos) {
+        int64_t llegada = destino(celda, static_cast<int>(encontrada - direccionesMovimiento), pasos);
+        // En la salida se cambia de piso sin mirar la celda
+        if (llegada != salida() && tieneBandera(*piso, plano, llegada, bandera)) {
+            probabilidad += probabilidadDados(pasos);
+        }
+    }
+    return probabilidad;
+}
+
+int64_t ConsultasPiso::masCercana(int64_t celda, BanderaCelda bandera) const {
+    int columna = static_cast<int>(celda % columnas);
+    int fila = static_cast<int>(celda / columnas);
+    const uint64_t* plano = piso->plano(bandera);
+
+    // Anillos de celdas a distancia 1, 2, 3... Con planos, si el anillo ya
+    // costó más que leer el plano entero, conviene recorrer sus bits en 1
+    int64_t presupuesto = static_cast<int64_t>(piso->palabrasPorPlano());
+    int64_t revisadas = 0;
+    for (int distancia = 1; distancia <= columnas + filas - 2; ++distancia) {
+        int64_t mejor = -1;
+        for (int dy = -distancia; dy <= distancia; ++dy) {
+            int f = fila + dy;
+            if (f < 0 || f >= filas) {
+                continue;
+            }
+            int dx = distancia - std::abs(dy);
+            for (int c : { columna - dx, columna + dx }) {
+                if (c >= 0 && c < columnas && (c == columna - dx || dx > 0)) {
+                    int64_t candidata = static_cast<int64_t>(f) * columnas + c;
+                    ++revisadas;
+                    if (tieneBandera(*piso, plano, candidata, bandera) && (mejor < 0 || candidata < mejor)) {
+                        mejor = candidata;
+                    }
+                }
+            }
+        }
+        if (mejor >= 0) {
+            return mejor;
+        }
+        if (plano && revisadas > presupuesto) {
+            break;
+        }
+    }
+    if (!plano || revisadas <= presupuesto) {
+        return -1; // Se revisó todo el piso
+    }
+
+    int64_t mejor = -1;
+    int64_t mejorDistancia = 0;
+    piso->paraCada(bandera, [&](int64_t candidata, const Celda&) {
+        int64_t distancia = std::abs(static_cast<int64_t>(candidata % columnas) - columna)
+            + std::abs(static_cast<int64_t>(candidata / columnas) - fila);
+        if (candidata != celda && (mejor < 0 || distancia < mejorDistancia)) {
+            mejor = candidata;
+            mejorDistancia = distancia;
+        }
+    });
+    return mejor;
+}
+
+template <class Marcar>
+void ConsultasPiso::expandir(int64_t celda, int tiradas, Marcar&& marcar) const {
+    std::vector<int64_t> frente(1, celda);
+    std::vector<int64_t> siguiente;
+    for (int tirada = 0; tirada < tiradas && !frente.empty(); ++tirada) {
+        siguiente.clear();
+        for (int64_t origen : frente) {
+            if (tirada > 0 && origen == salida()) {
+                continue;
+            }
+            for (int d = 0; d < 4; ++d) {
+                for (int pasos = 2; pasos <= 12; ++pasos) {
+                    int64_t llegada = destino(origen, d, pasos);
+                    if (marcar(llegada)) {
+                        siguiente.push_back(llegada);
+                    }
+                }
+            }
+        }
+        frente.swap(siguiente);
+    }
+}
+
+std::vector<uint64_t> ConsultasPiso::alcanceEnTiradas(int64_t celda, int tiradas) const {
+    std::vector<uint64_t> alcanzadas((static_cast<size_t>(columnas) * filas + 63) / 64, 0);
+    if (chico()) {
+        uint64_t filasAlcanzadas[64];
+        alcancePorFilas(celda, tiradas, filasAlcanzadas);
+        for (int fila = 0; fila < filas; ++fila) {
+            for (uint64_t resto = filasAlcanzadas[fila]; resto != 0; resto &= resto - 1) {
+                int64_t i = static_cast<int64_t>(fila) * columnas + primerUno(resto);
+                alcanzadas[static_cast<size_t>(i / 64)] |= 1ull << (i % 64);
+            }
+        }
+        return alcanzadas;
+    }
+    expandir(celda, tiradas, [&](int64_t llegada) {
+        uint64_t& palabra = alcanzadas[static_cast<size_t>(llegada / 64)];
+        uint64_t bit = 1ull << (llegada % 64);
+        bool nueva = !(palabra & bit);
+        palabra |= bit;
+        return nueva;
+    });
+    return alcanzadas;
+}
+
+int64_t ConsultasPiso::contarAlAlcance(int64_t celda, int tiradas, BanderaCelda bandera) const {
+    int64_t cantidad = 0;
+    const uint64_t* plano = piso->plano(bandera);
+    if (!plano) {
+        // Sin planos el piso puede ser enorme: se anotan solo las celdas alcanzadas
+        std::unordered_set<int64_t> alcanzadas;
+        expandir(celda, tiradas, [&](int64_t llegada) {
+            if (!alcanzadas.insert(llegada).second) {
+                return false;
+            }
+            cantidad += tieneBandera(*piso, nullptr, llegada, bandera) ? 1 : 0;
+            return true;
+        });
+        return cantidad;
+    }
+
+    if (chico()) {
+        uint64_t filasAlcanzadas[64];
+        alcancePorFilas(celda, tiradas, filasAlcanzadas);
+        uint64_t todas = columnas == 64 ? ~0ull : (1ull << columnas) - 1;
+        for (int fila = 0; fila < filas; ++fila) {
+            // Bits de la fila dentro del plano, que pueden caer entre dos palabras
+            size_t inicio = static_cast<size_t>(fila) * columnas;
+            size_t p = inicio / 64;
+            unsigned corrimiento = static_cast<unsigned>(inicio % 64);
+            uint64_t enPlano = plano[p] >> corrimiento;
+            if (corrimiento > 0 && p + 1 < piso->palabrasPorPlano()) {
+                enPlano |= plano[p + 1] << (64 - corrimiento);
+            }
+            cantidad += contarUnos(filasAlcanzadas[fila] & enPlano & todas);
+        }
+        return cantidad;
+    }
+
+    // Las marcas se limpian borrando solo las palabras tocadas: el costo no depende del tamaño del piso
+    marcas.resize(piso->palabrasPorPlano(), 0);
+    tocadas.clear();
+    expandir(celda, tiradas, [&](int64_t llegada) {
+        uint64_t& palabra = marcas[static_cast<size_t>(llegada / 64)];
+        uint64_t bit = 1ull << (llegada % 64);
+        if (palabra & bit) {
+            return false;
+        }
+        if (palabra == 0) {
+            tocadas.push_back(static_cast<size_t>(llegada / 64));
+        }
+        palabra |= bit;
+        return true;
+    });
+    for (size_t p : tocadas) {
+        cantidad += contarUnos(marcas[p] & plano[p]);
+        marcas[p] = 0;
+    }
+    return cantidad;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdlib>
+#include <vector>
+
+const int resultadosDados = 11;         // Sumas posibles de dos dados: 2 a 12
+const char direccionesMovimiento[] = { 'W', 'A', 'S', 'D' };
+
+/**
+ * Probabilidad de sacar 'pasos' con dos dados de seis caras.
+ */
+inline double probabilidadDados(int pasos) {
+    return (6 - std::abs(pasos - 7)) / 36.0;
+}
+
+/**
+ * Celda en la que puede terminar el turno: con una dirección, la suma de las
+ * tiradas que llevan a ella.
+ */
+struct DestinoTurno {
+    int64_t celda;
+    char direccion;
+    double probabilidad;
+    bool salida;        // Es la salida: el turno termina el piso
+};
+
+/**
+ * Todos los destinos de un turno, sin pedir memoria. Como mucho hay uno por
+ * dirección y tirada.
+ */
+struct AlcanceTurno {
+    DestinoTurno destinos[4 * resultadosDados];
+    int cantidad = 0;
+
+    const DestinoTurno* begin() const { return destinos; }
+    const DestinoTurno* end() const { return destinos + cantidad; }
+};
+
+/**
+ * Preguntas sobre un piso que no hace falta contestar recorriendo sus celdas.
+ *
+ * Un turno mueve de 2 a 12 celdas por una fila o una columna, recortando en los
+ * bordes, así que a dónde se llega depende solo de la columna (o la fila) de
+ * partida. Al construirse guarda esos destinos por columna y por fila, O(columnas
+ * + filas); en tableros de hasta 64x64 también como máscaras de bits, con las
+ * que lo alcanzable en varias tiradas se calcula fila por fila con una palabra
+ * por fila. Con eso y los planos de bits del piso contesta:
+ *   - a qué celdas se puede llegar este turno y con qué probabilidad, O(1);
+ *   - qué punto de guardado, taberna o cofre queda más cerca, revisando anillos de
+ *     celdas alrededor y, si está lejos, los bits en 1 del plano;
+ *   - qué celdas (y cuántos enemigos) quedan a N tiradas o menos, O(celdas alcanzadas).
+ *
+ * Lee el piso en cada pregunta, así que sigue valiendo después de que el juego
+ * cambie sus celdas, e incluso después de cambiar de piso mientras el tamaño sea
+ * el mismo. En los pisos perezosos, que no tienen planos, las respuestas son las
+ * mismas pero algunas recorren el piso. Una instancia no debe usarse desde dos
+ * hilos a la vez.
+ */
+class ConsultasPiso {
+public:
+    explicit ConsultasPiso(const Piso& piso);
+
+    /**
+     * Celda en la que termina un movimiento.
+     * param direccion Índice en direccionesMovimiento (0 = W, 1 = A, 2 = S, 3 = D).
+     * param pasos Suma de los dados, de 2 a 12.
+     */
+    int64_t destino(int64_t celda, int direccion, int pasos) const;
+
+    int64_t salida() const {
+        return static_cast<int64_t>(columnas) * filas - 1;
+    }
+
+    /**
+     * Destinos posibles del próximo turno desde 'celda', agrupados por dirección
+     * y celda. Las probabilidades de cada dirección suman 1.
+     */
+    AlcanceTurno alcanceTurno(int64_t celda) const;
+
+    /**
+     * Probabilidad de terminar el turno en una celda con 'bandera' si se elige
+     * 'direccion' (W, A, S o D) antes de tirar los dados.
+     */
+    double probabilidadDeCaer(int64_t celda, char direccion, BanderaCelda bandera) const;
+
+    /**
+     * Celda con 'bandera' más cercana a 'celda' en pasos (columnas más filas), sin
+     * contar la propia 'celda'; entre dos igual de cerca, la de menor índice.
+     * return -1 si ninguna celda del piso la tiene.
+     */
+    int64_t masCercana(int64_t celda, BanderaCelda bandera) const;
+
+    /**
+     * Celdas a las que se puede llegar desde 'celda' en 1 a 'tiradas' turnos, como
+     * plano de bits (mismo formato que Piso::plano). La salida se cuenta pero
+     * no se sigue desde ella, porque termina el piso.
+     */
+    std::vector<uint64_t> alcanceEnTiradas(int64_t celda, int tiradas) const;
+
+    /**
+     * Cantidad de celdas con 'bandera' a 'tiradas' turnos o menos (las de
+     * alcanceEnTiradas), sin recorrer el plano entero.
+     */
+    int64_t contarAlAlcance(int64_t celda, int tiradas, BanderaCelda bandera) const;
+
+private:
+    /**
+     * Recorre por tiradas lo alcanzable desde 'celda'. marcar(llegada) anota la
+     * celda y devuelve false si ya estaba anotada.
+     */
+    template <class Marcar>
+    void expandir(int64_t celda, int tiradas, Marcar&& marcar) const;
+
+    /**
+     * Lo mismo que alcanceEnTiradas con una palabra por fila (bit c = columna c).
+     * Solo para tableros chicos.
+     */
+    void alcancePorFilas(int64_t celda, int tiradas, uint64_t* alcanzadas) const;
+
+    bool chico() const {
+        return columnas <= 64 && filas <= 64;
+    }
+
+    const Piso* piso;
+    int columnas;
+    int filas;
+    std::vector<int> enFila;       // Columna de llegada por (columna, izquierda/derecha, tirada)
+    std::vector<int> enColumna;    // Fila de llegada por (fila, arriba/abajo, tirada)
+    uint64_t mascaraFila[64];       // Columnas a las que se llega por la fila desde cada columna (tableros chicos)
+    uint64_t mascaraColumna[64];    // Filas a las que se llega por la columna desde cada fila (tableros chicos)
+    mutable std::vector<uint64_t> marcas;   // Celdas ya alcanzadas en contarAlAlcance, en 0 entre consultas
+    mutable std::vector<size_t> tocadas;    // Palabras de 'marcas' a limpiar
+};
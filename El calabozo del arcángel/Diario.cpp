@@ -0,0 +1,188 @@
+#include "Diario.h"
+#include "Guardado.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const char firmaDiario[4] = { 'C', 'D', 'I', 'A' };
+    const uint16_t versionDiario = 1;
+    const char anotacionGuardado = 'G';
+
+    struct CabeceraDiario {
+        char firma[4];
+        uint16_t version;
+        uint16_t tamanoCabecera;
+        uint64_t semilla;
+        uint64_t flujo;
+        int32_t columnas;
+        int32_t filas;
+        int32_t pisos;
+        uint32_t bytesEstadoInicial;    // 0 si la partida es nueva
+    };
+
+    static_assert(sizeof(CabeceraDiario) == 40, "La cabecera no debe tener relleno");
+}
+
+bool DiarioPartida::abrir(const std::string& ruta, const Partida& partida, bool cargada) {
+    std::vector<unsigned char> estado;
+    if (cargada) {
+        estado = serializarPartidaBinaria(partida);
+    }
+
+    CabeceraDiario cabecera = {};
+    std::memcpy(cabecera.firma, firmaDiario, sizeof(firmaDiario));
+    cabecera.version = versionDiario;
+    cabecera.tamanoCabecera = sizeof(CabeceraDiario);
+    cabecera.semilla = partida.generador.obtenerSemilla();
+    cabecera.flujo = partida.generador.obtenerFlujo();
+    cabecera.columnas = partida.piso.columnas;
+    cabecera.filas = partida.piso.filas;
+    cabecera.pisos = partida.numPisos;
+    cabecera.bytesEstadoInicial = static_cast<uint32_t>(estado.size());
+
+    archivo.open(ruta, std::ios::binary | std::ios::trunc);
+    archivo.write(reinterpret_cast<const char*>(&cabecera), sizeof(cabecera));
+    archivo.write(reinterpret_cast<const char*>(estado.data()), static_cast<std::streamsize>(estado.size()));
+    archivo.flush();
+    if (!archivo) {
+        std::cerr << "Error: No se pudo escribir el diario '" << ruta << "'." << std::endl;
+        archivo.close();
+        return false;
+    }
+    return true;
+}
+
+void DiarioPartida::anotarDireccion(char direccion) {
+    ++numTurnos;
+    if (archivo.is_open()) {
+        bool valida = direccion == 'W' || direccion == 'A' || direccion == 'S' || direccion == 'D';
+        archivo.put(valida ? direccion : '?'); // Cualquier otra dirección hace lo mismo: no mover
+        archivo.flush();
+    }
+}
+
+void DiarioPartida::anotarGuardado(const Partida& partida) {
+    ++numGuardados;
+    if (capturando) {
+        guardado = serializarPartidaBinaria(partida);
+    }
+    if (archivo.is_open()) {
+        archivo.put(anotacionGuardado);
+        archivo.flush();
+    }
+}
+
+void DiarioPartida::restaurar(uint64_t guardadosHechos, const std::vector<unsigned char>& ultimo) {
+    numGuardados = guardadosHechos;
+    guardado = ultimo;
+}
+
+bool leerDiario(const std::string& ruta, DiarioLeido& diario) {
+    ArchivoMapeado archivo(ruta.c_str());
+    if (!archivo.abierto()) {
+        std::cerr << "Error: No se pudo abrir el diario '" << ruta << "'." << std::endl;
+        return false;
+    }
+
+    CabeceraDiario cabecera;
+    if (archivo.tamano() < sizeof(cabecera)) {
+        std::cerr << "Error: '" << ruta << "' no es un diario de partida." << std::endl;
+        return false;
+    }
+    std::memcpy(&cabecera, archivo.contenido(), sizeof(cabecera));
+    if (std::memcmp(cabecera.firma, firmaDiario, sizeof(firmaDiario)) != 0 || cabecera.version != versionDiario
+        || cabecera.tamanoCabecera != sizeof(CabeceraDiario)
+        || archivo.tamano() - sizeof(cabecera) < cabecera.bytesEstadoInicial) {
+        std::cerr << "Error: '" << ruta << "' no es un diario de partida compatible." << std::endl;
+        return false;
+    }
+
+    diario.semilla = cabecera.semilla;
+    diario.flujo = cabecera.flujo;
+    diario.tablero.columnas = cabecera.columnas;
+    diario.tablero.filas = cabecera.filas;
+    diario.tablero.pisos = cabecera.pisos;
+    if (cabecera.bytesEstadoInicial == 0 && !tableroValido(diario.tablero)) {
+        std::cerr << "Error: '" << ruta << "' tiene un tablero fuera de rango." << std::endl;
+        return false;
+    }
+
+    const unsigned char* estado = archivo.contenido() + sizeof(cabecera);
+    diario.estadoInicial.assign(estado, estado + cabecera.bytesEstadoInicial);
+    diario.direcciones.clear();
+    diario.guardados = 0;
+    for (const unsigned char* c = estado + cabecera.bytesEstadoInicial; c < archivo.contenido() + archivo.tamano(); ++c) {
+        if (*c == anotacionGuardado) {
+            ++diario.guardados;
+        }
+        else {
+            diario.direcciones.push_back(static_cast<char>(*c));
+        }
+    }
+    return true;
+}
+
+ReproductorDiario::ReproductorDiario(const DiarioLeido& diario, uint64_t intervalo)
+    : diario(diario), intervalo(std::max<uint64_t>(1, intervalo)) {
+    actual.salida = nullptr;
+    actual.interactivo = false;
+    actual.guardadoHabilitado = false;
+    captura.capturarGuardados();
+    actual.diario = &captura;
+    actual.politica = [this](Partida&, int) { return this->diario.direcciones[static_cast<size_t>(turnoActual)]; };
+
+    if (diario.estadoInicial.empty()) {
+        aplicarTablero(actual, diario.tablero);
+        actual.generador = GeneradorPartida(diario.semilla, diario.flujo);
+        iniciarPartida(actual);
+    }
+    else if (!deserializarPartidaBinaria(actual, diario.estadoInicial.data(), diario.estadoInicial.size(), "el estado inicial del diario")) {
+        actual.juego = false;
+    }
+    anotarPunto();
+}
+
+void ReproductorDiario::anotarPunto() {
+    if (!actual.juego || (!puntos.empty() && puntos.back().turno >= turnoActual)) {
+        return;
+    }
+    PuntoControl punto;
+    punto.turno = turnoActual;
+    punto.estado = serializarPartidaBinaria(actual);
+    punto.guardados = captura.guardados();
+    punto.ultimoGuardado = captura.ultimoGuardado();
+    puntos.push_back(std::move(punto));
+}
+
+bool ReproductorDiario::volverA(const PuntoControl& punto) {
+    if (!deserializarPartidaBinaria(actual, punto.estado.data(), punto.estado.size(), "un punto de control")) {
+        return false;
+    }
+    actual.juego = true;
+    actual.resultado = Resultado::EnCurso;
+    captura.restaurar(punto.guardados, punto.ultimoGuardado);
+    turnoActual = punto.turno;
+    return true;
+}
+
+uint64_t ReproductorDiario::irA(uint64_t objetivo) {
+    if (objetivo < turnoActual) {
+        // El último punto de control que no pasa del objetivo (el del turno 0 siempre sirve)
+        auto siguiente = std::upper_bound(puntos.begin(), puntos.end(), objetivo,
+            [](uint64_t turno, const PuntoControl& punto) { return turno < punto.turno; });
+        if (siguiente == puntos.begin() || !volverA(*(siguiente - 1))) {
+            return turnoActual;
+        }
+    }
+    while (turnoActual < objetivo && turnoActual < totalTurnos() && actual.juego) {
+        moverJugador(actual);
+        ++turnoActual;
+        ++jugados;
+        if (turnoActual % intervalo == 0) {
+            anotarPunto();
+        }
+    }
+    return turnoActual;
+}
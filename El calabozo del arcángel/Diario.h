@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Diario de una partida: la semilla, el tamaño del calabozo y, turno por turno,
+ * la dirección elegida. Todo lo aleatorio sale de la semilla (ver
+ * GeneradorPartida), así que con eso se reconstruye la partida exacta
+ * guardando un byte por turno en vez del estado completo.
+ *
+ * El archivo es una cabecera fija, el contenido de 'partida.dat' si la partida
+ * empezó cargando un guardado (si no, sale de la semilla) y después las
+ * anotaciones, de un byte y siempre al final: 'W', 'A', 'S', 'D' o '?' (una
+ * dirección no válida) por turno, y 'G' cuando ese turno pisó un punto de
+ * guardado. Cada anotación se vacía al disco enseguida, así que un corte solo
+ * pierde el turno en curso.
+ */
+class DiarioPartida {
+public:
+    /**
+     * Empieza un diario nuevo en 'ruta' (reemplaza el que hubiera). La partida
+     * ya debe tener su primer piso y al jugador en él.
+     * param cargada true si la partida salió de un guardado: el diario incluye ese estado.
+     * return false si no se pudo escribir el archivo.
+     */
+    bool abrir(const std::string& ruta, const Partida& partida, bool cargada);
+
+    /**
+     * Hace que anotarGuardado se quede con una copia binaria de la partida en
+     * cada punto de guardado, sin escribir ningún archivo. La usa la
+     * reproducción para comparar con 'partida.dat'.
+     */
+    void capturarGuardados() { capturando = true; }
+
+    void anotarDireccion(char direccion);
+    void anotarGuardado(const Partida& partida);
+
+    uint64_t turnos() const { return numTurnos; }
+    uint64_t guardados() const { return numGuardados; }
+
+    /**
+     * Contenido de 'partida.dat' en el último punto de guardado capturado.
+     */
+    const std::vector<unsigned char>& ultimoGuardado() const { return guardado; }
+    void restaurar(uint64_t guardadosHechos, const std::vector<unsigned char>& ultimo);
+
+private:
+    std::ofstream archivo;
+    bool capturando = false;
+    uint64_t numTurnos = 0;
+    uint64_t numGuardados = 0;
+    std::vector<unsigned char> guardado;
+};
+
+/**
+ * Diario leído de un archivo.
+ */
+struct DiarioLeido {
+    uint64_t semilla = 0;
+    uint64_t flujo = 0;
+    Tablero tablero;
+    std::vector<unsigned char> estadoInicial;   // 'partida.dat' de una partida cargada; vacío si es nueva
+    std::string direcciones;                    // Una por turno ('W', 'A', 'S', 'D' o '?')
+    uint64_t guardados = 0;                     // Anotaciones 'G'
+};
+
+/**
+ * Lee un diario escrito por DiarioPartida.
+ * return false (con un mensaje) si el archivo no existe o no es un diario válido.
+ */
+bool leerDiario(const std::string& ruta, DiarioLeido& diario);
+
+/**
+ * Reproduce un diario sin terminal, con el mismo moverJugador que la partida
+ * original. Cada 'intervalo' turnos guarda un punto de control (el estado en
+ * binario), así que volver a un turno anterior solo rehace los turnos desde
+ * el punto más cercano.
+ */
+class ReproductorDiario {
+public:
+    explicit ReproductorDiario(const DiarioLeido& diario, uint64_t intervalo = 4096);
+
+    /**
+     * Lleva la partida al final del turno 'objetivo' (0 = antes del primer turno).
+     * Se detiene antes si la partida termina o se acaba el diario.
+     * return El turno alcanzado.
+     */
+    uint64_t irA(uint64_t objetivo);
+
+    const Partida& partida() const { return actual; }
+    uint64_t turno() const { return turnoActual; }
+    uint64_t totalTurnos() const { return diario.direcciones.size(); }
+
+    /**
+     * Guardados hechos hasta el turno actual y estado binario del último (para --verificar).
+     */
+    uint64_t guardados() const { return captura.guardados(); }
+    const std::vector<unsigned char>& ultimoGuardado() const { return captura.ultimoGuardado(); }
+
+    size_t puntosDeControl() const { return puntos.size(); }
+    uint64_t turnosJugados() const { return jugados; }  // Incluye los que se rehicieron al volver atrás
+
+private:
+    struct PuntoControl {
+        uint64_t turno;
+        std::vector<unsigned char> estado;
+        uint64_t guardados;
+        std::vector<unsigned char> ultimoGuardado;
+    };
+
+    void anotarPunto();
+    bool volverA(const PuntoControl& punto);
+
+    const DiarioLeido& diario;
+    uint64_t intervalo;
+    Partida actual;
+    DiarioPartida captura;
+    uint64_t turnoActual = 0;
+    uint64_t jugados = 0;
+    std::vector<PuntoControl> puntos;  // Ordenados por turno
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Tamaño de un tablero conocido al compilar. Las cuentas con índices (división,
+ * módulo, bordes) quedan como constantes y los bucles por fila o columna se
+ * pueden desenrollar por completo.
+ */
+template <int Columnas, int Filas>
+struct DimensionesFijas {
+    static_assert(Columnas > 0 && Filas > 0, "El tablero necesita al menos una celda");
+
+    static constexpr int columnas() { return Columnas; }
+    static constexpr int filas() { return Filas; }
+    static constexpr int64_t indice(int columna, int fila) { return static_cast<int64_t>(fila) * Columnas + columna; }
+    static constexpr int columnaDe(int64_t indice) { return static_cast<int>(indice % Columnas); }
+    static constexpr int filaDe(int64_t indice) { return static_cast<int>(indice / Columnas); }
+};
+
+/**
+ * Tamaño de un tablero elegido al ejecutar; la misma interfaz que DimensionesFijas.
+ */
+struct DimensionesVariables {
+    int numColumnas;
+    int numFilas;
+
+    DimensionesVariables(int columnas, int filas) : numColumnas(columnas), numFilas(filas) {}
+
+    int columnas() const { return numColumnas; }
+    int filas() const { return numFilas; }
+    int64_t indice(int columna, int fila) const { return static_cast<int64_t>(fila) * numColumnas + columna; }
+    int columnaDe(int64_t indice) const { return static_cast<int>(indice % numColumnas); }
+    int filaDe(int64_t indice) const { return static_cast<int>(indice / numColumnas); }
+};
+
+/**
+ * Llama a 'funcion' con las dimensiones del tablero: fijas para los tamaños
+ * comunes (el estándar de 10x10 primero) y variables para cualquier otro.
+ * return Lo que devuelva 'funcion'.
+ */
+template <class Funcion>
+auto conDimensiones(int columnas, int filas, Funcion&& funcion) -> decltype(funcion(DimensionesVariables(columnas, filas))) {
+    if (columnas == filas) {
+        switch (columnas) {
+        case 10: return funcion(DimensionesFijas<10, 10>());
+        case 8:  return funcion(DimensionesFijas<8, 8>());
+        case 16: return funcion(DimensionesFijas<16, 16>());
+        case 20: return funcion(DimensionesFijas<20, 20>());
+        default: break;
+        }
+    }
+    return funcion(DimensionesVariables(columnas, filas));
+}
+
+/**
+ * Resultado de avanzar en línea recta por el tablero.
+ */
+struct Recorrido {
+    int columna;
+    int fila;
+    bool salida;    // Algún paso cayó en la celda de salida (esquina inferior derecha)
+};
+
+/**
+ * Avanza 'pasos' celdas en una dirección (W, A, S, D) deteniéndose en los bordes.
+ * El camino es una recta recortada al tablero, así que no hace falta recorrerlo
+ * paso a paso: solo se acerca a la salida yendo a la derecha o hacia abajo, y una
+ * vez en ella se queda ahí, de modo que pasa por la salida si y solo si termina en
+ * ella. Con una dirección no válida el jugador no se mueve.
+ */
+template <class Dimensiones>
+Recorrido recorrer(const Dimensiones& dimensiones, int columna, int fila, int pasos, char direccion) {
+    int dx = (direccion == 'D') - (direccion == 'A');
+    int dy = (direccion == 'S') - (direccion == 'W');
+    int ultimaColumna = dimensiones.columnas() - 1;
+    int ultimaFila = dimensiones.filas() - 1;
+
+    Recorrido recorrido;
+    recorrido.columna = std::min(std::max(columna + dx * pasos, 0), ultimaColumna);
+    recorrido.fila = std::min(std::max(fila + dy * pasos, 0), ultimaFila);
+    recorrido.salida = pasos > 0 && recorrido.columna == ultimaColumna && recorrido.fila == ultimaFila;
+    return recorrido;
+}
@@ -1,793 +1,658 @@
+#include "Barrido.h"
+#include "Calabozo.h"
+#include "Diario.h"
+#include "Simulacion.h"
+#include "Guardado.h"
+#include "PreparadorPisos.h"
+#include "Renderizador.h"
+#include "Servidor.h"
+#include "GeneradorCarga.h"
+#include "PoliticaOptima.h"
+#include "PoolHilos.h"
+#include "Instrumentacion.h"
+
+#include <algorithm>
 #include <iostream>
-#include <cstdlib>
+#include <chrono>
+#include <cmath>
 #include <ctime>
-#include <vector>
-#include <algorithm> // Para std::max
 #include <fstream>
-#include <string>  
-
-int pisoCalabozo = 1;
-int numEnemies = 0;
-bool juego = true;
-int numDiceThrows = 0; // Contador de tiradas de dados
-
-struct Celda {
-    int piso;              // Número de piso en el que se encuentra la celda
-    char column;           // Columna de la celda (A-J)
-    int row;               // Fila de la celda (1-10)
-    bool hasPlayer;        // Indica si la celda tiene un jugador
-    bool visited;          // Indica si la celda ha sido visitada por el jugador
-    bool hasEnemy;         // Indica si la celda tiene un enemigo
-    bool hasSavePoint;     // Indica si la celda tiene un punto de guardado
-    bool hasTavern;        // Indica si la celda tiene una taberna
-    bool hasChest;         // Indica si la celda tiene un cofre
-    int enemyHealth;       // Salud del enemigo presente en la celda
-    int enemyAttack;       // Poder de ataque del enemigo presente en la celda
-    int chestContent;      // Contenido del cofre (0 si está vacío)
-    Celda* siguiente;      // Puntero a la siguiente celda en la lista
-};
-
-struct Recluta {
-    std::string nombre;    // Nombre de la recluta
-    int health;            // Puntos de vida de la recluta
-    int attackPower;       // Poder de ataque de la recluta
-};
-
-struct Arcangel {
-    std::string nombre = "Arcangel";   // Nombre fijo del Arcángel
-    int health = 15;                    // Puntos de vida del Arcángel
-    int attackPower = 10;               // Poder de ataque del Arcángel
-};
-
-struct Jugador {
-    Celda* posicion;                 // Puntero a la celda donde se encuentra el jugador
-    int health;                      // Puntos de vida del jugador
-    int attackPower;                 // Poder de ataque del jugador
-    std::vector<Recluta> equipo;    // Vector que almacena las reclutas en el equipo
-
-    Jugador() : posicion(nullptr), health(3), attackPower(3) {}
-
-    /**
-     * Agrega una recluta al equipo del jugador.
-     * nuevoRecluta La recluta a agregar al equipo.
-     * return true si se pudo reclutar (espacio disponible), false si el equipo está lleno.
-     */
-    bool reclutarPersonas(const Recluta& nuevoRecluta) {
-        if (equipo.size() < 3) {
-            equipo.push_back(nuevoRecluta);
-            return true;
-        }
-        return false; // No se puede reclutar más de tres Reclutas
-    }
-};
+#include <limits>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
 
+void mostrarTexto() {
+    std::cout << "-------------------------------------------------------------------------------" << std::endl;
+    std::cout << "                  Nueva Aventura" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------" << std::endl;
+    std::cout << "En las tierras ancestrales de Erresire, un joven orco valiente y decidido," << std::endl;
+    std::cout << "comienza su odisea hacia el misterioso Calabozo del Arcangel." << std::endl;
+    std::cout << "Su objetivo: derrotar al legendario Arcangel y reclamar su poder," << std::endl;
+    std::cout << "que lo convertira en el senor supremo del continente." << std::endl;
+    std::cout << "Con su libro de hechizos para principiantes en una mano y la determinacion" << std::endl;
+    std::cout << "ardiente en su corazón, Erresire se adentra en las profundidades del calabozo," << std::endl;
+    std::cout << "con la esperanza de forjar su destino y alcanzar la gloria." << std::endl;
+    std::cout << "Que comience la epica aventura de Erresire en su busqueda de poder y redencion!" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------" << std::endl;
 
-/**
- * Crea una nueva instancia de la estructura Celda con valores iniciales especificados.
- * param col Carácter que representa la columna de la celda.
- * param r Entero que representa la fila de la celda.
- * return Puntero a la nueva instancia de Celda creada dinámicamente.
- */
-Celda* crearCelda(char col, int r) {
-    Celda* newCell = new Celda;
-    newCell->piso = pisoCalabozo;
-    newCell->column = col;
-    newCell->row = r;
-    newCell->visited = false;
-    newCell->hasEnemy = false;
-    newCell->hasSavePoint = false;
-    newCell->hasTavern = false;
-    newCell->hasChest = false;
-    newCell->enemyHealth = 0;
-    newCell->enemyAttack = 0;
-    newCell->chestContent = 0;
-    newCell->siguiente = nullptr;
-    return newCell;
+    std::cout << "Presiona Enter para continuar...";
+    std::cin.ignore(); // Ignorar cualquier entrada anterior
+    std::cin.get(); // Esperar a que se presione Enter
 }
 
-/**
- * Libera la memoria ocupada por una lista enlazada de celdas.
- * param cabeza Referencia al puntero que apunta al inicio de la lista.
- * Después de la liberación, este puntero se establece en nullptr.
- */
-void liberarLista(Celda*& cabeza) {
-    Celda* current = cabeza;
-    while (current) {
-        Celda* temp = current;
-        current = current->siguiente;
-        delete temp;
-    }
-    cabeza = nullptr;
+void mostrarMenu() {
+    std::cout << "Bienvenido al juego del Calabozo!" << std::endl;
+    std::cout << "1. Iniciar nueva partida" << std::endl;
+    std::cout << "2. Cargar partida guardada" << std::endl;
+    std::cout << "3. Salir" << std::endl;
 }
 
-/**
- * Inserta una nueva celda al final de una lista enlazada de celdas.
- * param cabeza Referencia al puntero que apunta al inicio de la lista.
- * param col Columna de la nueva celda.
- * param row Fila de la nueva celda.
- * param numEnemies Referencia al contador de enemigos para controlar la cantidad máxima.
- */
-void insertarCelda(Celda*& cabeza, char col, int row, int& numEnemies) {
-    Celda* newCell = crearCelda(col, row);
-
-    if (rand() % 10 == 0 && numEnemies < 10) {
-        newCell->hasEnemy = true;
-        newCell->enemyHealth = newCell->piso + 1;
-        newCell->enemyAttack = newCell->piso;
-        ++numEnemies;
-    }
-
-    if (rand() % 10 == 0) {
-        newCell->hasSavePoint = true;
-    }
-
-    if (rand() % 10 == 0) {
-        newCell->hasTavern = true;
-    }
-
-    if (rand() % 4 == 0) {
-        newCell->hasChest = true;
-        newCell->chestContent = rand() % 3 + 1;
-    }
-
-    if (!cabeza) {
-        cabeza = newCell;
-    }
-    else {
-        Celda* current = cabeza;
-        while (current->siguiente) {
-            current = current->siguiente;
-        }
-        current->siguiente = newCell;
-    }
+void limpiarPantalla() {
+    std::cout << "\033[2J\033[1;1H"; // Código ANSI para limpiar la pantalla
 }
 
 /**
- * Guarda una lista de celdas en un archivo de texto.
- * param cabeza Puntero al inicio de la lista de celdas a guardar.
+ * Opciones recibidas por la línea de comandos.
  */
-void guardarCeldasEnArchivo(const Celda* cabeza) {
-    std::ofstream archivo("celdas.txt");
-    if (!archivo.is_open()) {
-        std::cerr << "Error: No se pudo abrir el archivo 'celdas.txt' para guardar las celdas." << std::endl;
-        return;
-    }
-
-    const Celda* current = cabeza;
-    while (current) {
-        archivo << current->piso << " "
-            << current->column << " "
-            << current->row << " "
-            << current->visited << " "
-            << current->hasEnemy << " "
-            << current->hasSavePoint << " "
-            << current->hasTavern << " "
-            << current->hasChest << " "
-            << current->enemyHealth << " "
-            << current->enemyAttack << " "
-            << current->chestContent << std::endl;
-        current = current->siguiente;
-    }
-
-    archivo.close();
-    std::cout << "Lista de celdas guardada correctamente en 'celdas.txt'." << std::endl;
-}
+struct OpcionesLinea {
+    bool simular = false;               // Se pidió una simulación sin terminal
+    bool semillaIndicada = false;       // Se pasó --semilla
+    FormatoGuardado formato = FormatoGuardado::Binario;
+    bool pantallaAnsi = false;          // --pantalla ansi
+    int columnasVista = 0;              // --vista CxF (0 = lo que quepa)
+    int filasVista = 0;
+    bool pistas = false;                // --pistas 1
+    bool servidor = false;              // --servidor
+    bool carga = false;                 // --carga
+    std::string ruta;                   // Socket de --servidor o --carga
+    std::string rutaCompartidos;        // --compartir
+    OpcionesCarga opcionesCarga;
+    bool resolver = false;              // --resolver
+    uint64_t partidasResolver = 1;
+    bool soloLlegar = false;            // --objetivo llegar
+    std::string rutaTabla;              // --tabla
+    std::string rutaMetricas;           // --metricas
+    std::string rutaTraza;              // --traza
+    size_t memoria = 0;                 // --memoria, en bytes (0 = sin límite)
+    std::string rutaDiario;             // --diario
+    std::string rutaReproducir;         // --reproducir
+    std::vector<uint64_t> hasta;        // --hasta, turnos a visitar en orden
+    std::string rutaVerificar;          // --verificar
+    uint64_t intervaloPuntos = 4096;    // --puntos
+    std::string equilibrio;             // --equilibrio, sin leer todavía
+    bool barrido = false;               // --barrido
+    std::vector<std::string> ejes;      // --parametro, uno por eje, sin leer todavía
+    std::string rutaInforme;            // --informe
+    OpcionesSimulacion simulacion;
+    OpcionesBarrido opcionesBarrido;
+};
 
 /**
- * Carga una lista de celdas desde un archivo de texto.
- * param cabeza Referencia al puntero que apunta al inicio de la lista de celdas a cargar.
+ * Lee el número de una opción: todo el texto tiene que ser el número.
+ * return false si no es un número o no cabe en el tipo.
  */
-void cargarCeldasDesdeArchivo(Celda*& cabeza) {
-    std::ifstream archivo("celdas.txt");
-    if (!archivo.is_open()) {
-        std::cerr << "Error: No se pudo abrir el archivo 'celdas.txt' para cargar las celdas." << std::endl;
-        return;
-    }
-
-    liberarLista(cabeza); // Liberar la lista actual de celdas
-
-    int piso, row, enemyHealth, enemyAttack, chestContent;
-    char column;
-    bool visited, hasEnemy, hasSavePoint, hasTavern, hasChest;
-
-    while (archivo >> piso >> column >> row >> visited >> hasEnemy
-        >> hasSavePoint >> hasTavern >> hasChest >> enemyHealth >> enemyAttack >> chestContent) {
-        pisoCalabozo = piso;
-        Celda* newCell = crearCelda(column, row);
-        newCell->piso = piso;
-        newCell->hasPlayer = false;
-        newCell->visited = visited;
-        newCell->hasEnemy = hasEnemy;
-        newCell->hasSavePoint = hasSavePoint;
-        newCell->hasTavern = hasTavern;
-        newCell->hasChest = hasChest;
-        newCell->enemyHealth = enemyHealth;
-        newCell->enemyAttack = enemyAttack;
-        newCell->chestContent = chestContent;
-        newCell->siguiente = nullptr;
-
-        if (!cabeza) {
-            cabeza = newCell;
-        }
-        else {
-            Celda* current = cabeza;
-            while (current->siguiente) {
-                current = current->siguiente;
-            }
-            current->siguiente = newCell;
+bool leerNumero(const std::string& texto, uint64_t& valor) {
+    size_t leidos = 0;
+    try {
+        // std::stoull acepta un signo menos y da la vuelta al número
+        if (texto.find('-') == std::string::npos) {
+            valor = std::stoull(texto, &leidos);
         }
     }
-
-    archivo.close();
-    std::cout << "Lista de celdas cargada correctamente desde 'celdas.txt'." << std::endl;
-}
-
-/**
- * Crea un calabozo generando una cuadrícula de celdas y las inserta en una lista enlazada.
- *        Cada celda tiene una probabilidad de contener enemigos, puntos de guardado, tabernas o cofres.
- * param cabeza Referencia al puntero que apunta al inicio de la lista de celdas del calabozo.
- * param numEnemies Referencia al contador de enemigos generados en el calabozo.
- */
-void crearCalabozo(Celda*& cabeza, int& numEnemies) {
-    for (char col = 'A'; col <= 'J'; ++col) {
-        for (int row = 1; row <= 10; ++row) {
-            insertarCelda(cabeza, col, row, numEnemies);
-        }
+    catch (const std::exception&) {
+        return false;
     }
+    return leidos > 0 && leidos == texto.size();
 }
 
-/**
- * Coloca al jugador en una celda específica del calabozo.
- *        La celda inicial del jugador se encuentra en la columna 'A' y fila 1.
- *
- * param cabeza Referencia al puntero que apunta al inicio de la lista de celdas del calabozo.
- * param jugador Referencia al objeto Jugador que representa al jugador del juego.
- */
-void colocarJugador(Celda*& cabeza, Jugador& jugador) {
-    Celda* current = cabeza;
-    while (current) {
-        if (current->column == 'A' && current->row == 1) {
-            jugador.posicion = current;
-            current->visited = true; // Marcar la celda como visitada
-            // Mantener la salud actual y el poder de ataque del jugador
-            jugador.health = jugador.health;
-            jugador.attackPower = jugador.attackPower;
-            break;
-        }
-        current = current->siguiente;
+bool leerNumero(const std::string& texto, unsigned& valor) {
+    uint64_t leido = 0;
+    if (!leerNumero(texto, leido) || leido > std::numeric_limits<unsigned>::max()) {
+        return false;
     }
+    valor = static_cast<unsigned>(leido);
+    return true;
 }
 
-/**
- * Guarda la información del jugador en un archivo de texto.
- * param jugador Referencia constante al objeto Jugador que contiene la información a guardar.
- */
-void guardarInformacionJugador(const Jugador& jugador) {
-    std::ofstream archivo("jugador.txt");
-
-    if (archivo.is_open()) {
-        archivo << jugador.health << std::endl;
-        archivo << jugador.attackPower << std::endl;
-        archivo << jugador.posicion->column << jugador.posicion->row << std::endl;
-        archivo << jugador.equipo.size() << std::endl;
-
-        for (const auto& recluta : jugador.equipo) {
-            archivo << recluta.nombre << std::endl;
-            archivo << recluta.health << std::endl;
-            archivo << recluta.attackPower << std::endl;
-        }
-
-        archivo.close();
-        std::cout << "Informacion del jugador guardado correctamente en 'jugador.txt'." << std::endl;
+bool leerNumero(const std::string& texto, int& valor) {
+    size_t leidos = 0;
+    try {
+        valor = std::stoi(texto, &leidos);
     }
-    else {
-        std::cerr << "Error: No se pudo abrir el archivo 'jugador.txt' para guardar la información." << std::endl;
-    }
-}
-
-/**
- * Carga la información del jugador desde un archivo de texto.
- * param jugador Referencia al objeto Jugador donde se cargarán los datos.
- * param cabeza Puntero a la cabeza de la lista de celdas del calabozo.
- * return true si la carga fue exitosa, false si hubo algún error al abrir el archivo.
- */
-bool cargarInformacionJugador(Jugador& jugador, Celda*& cabeza) {
-    std::ifstream archivo("jugador.txt");
-    if (!archivo.is_open()) {
+    catch (const std::exception&) {
         return false;
     }
+    return leidos > 0 && leidos == texto.size();
+}
 
-    archivo >> jugador.health;
-    archivo >> jugador.attackPower;
-
-    char col;
-    int row;
-    archivo >> col >> row;
-
-    // Buscar la celda correspondiente en la lista, aquí colocamos de una vez al jugador en la casilla
-    Celda* current = cabeza;
-    while (current) {
-        if (current->column == col && current->row == row) {
-            jugador.posicion = current;
-
-            current->hasPlayer = true; // Marcar la celda con el jugador
-            current->visited = true;   // Marcar la celda como visitada
-            break;
-        }
-        current = current->siguiente;
+bool leerNumero(const std::string& texto, double& valor) {
+    size_t leidos = 0;
+    try {
+        valor = std::stod(texto, &leidos);
     }
-
-    int numReclutas;
-    archivo >> numReclutas;
-    jugador.equipo.clear();
-
-    for (int i = 0; i < numReclutas; ++i) {
-        Recluta recluta;
-        archivo >> recluta.nombre;
-        archivo >> recluta.health;
-        archivo >> recluta.attackPower;
-        jugador.equipo.push_back(recluta);
+    catch (const std::exception&) {
+        return false;
     }
-
-    archivo >> numDiceThrows; // Cargar el número de tiradas de dados
-
-    archivo.close();
-    std::cout << "Informacion del jugador cargado correctamente desde 'jugador.txt'." << std::endl;
-    return true;
+    return leidos > 0 && leidos == texto.size() && std::isfinite(valor);
 }
 
 /**
- * Inicia la pelea final con el Arcangel.
- * param jugador Referencia al objeto Jugador.
- * param arcangel Referencia al objeto Arcangel.
+ * Lee las opciones de la línea de comandos.
+ *        --simular N     Juega N partidas sin terminal y muestra las estadísticas.
+ *        --hilos H       Hilos a usar (por defecto, todos los núcleos).
+ *        --semilla S     Semilla de la partida, o semilla común de las partidas simuladas.
+ *        --politica P    Política de movimiento: "salida", "aleatoria" u "optima".
+ *        --formato F     Formato de guardado: "binario" (partida.dat), "delta" (partida.delta, solo lo que
+ *                        cambió respecto del generador) o "texto" (celdas.txt y jugador.txt).
+ *        --generacion G  "completa" crea cada piso entero; "perezosa" genera cada celda al usarla.
+ *        --pantalla P    "texto" reimprime el tablero cada turno; "ansi" lo deja fijo arriba y solo redibuja lo que cambia.
+ *        --vista CxF     Con --pantalla ansi, máximo de columnas y filas visibles (p. ej. 20x10).
+ *        --pistas 1      Debajo del tablero muestra lo más cercano y las probabilidades de cada dirección.
+ *        --tablero CxF   Columnas y filas de cada piso (por defecto 10x10). Pasadas las 26 columnas
+ *                        las etiquetas siguen con AA, AB...
+ *        --pisos N       Pisos del calabozo; el Arcángel espera en la salida del último (por defecto 10).
+ *        --servidor R    Atiende partidas por el socket Unix R, o por stdin/stdout si R es "-" (ver Servidor.h).
+ *        --compartir D   Con --servidor, publica los pisos de cada semilla en el directorio D y las sesiones
+ *                        los comparten de solo lectura (ver PisosCompartidos.h).
+ *        --carga R       Genera carga contra el servidor en R y muestra turnos/s y latencias.
+ *        --sesiones N    Partidas simultáneas de --carga.
+ *        --conexiones C  Conexiones de --carga.
+ *        --turnos T      Turnos totales de --carga.
+ *        --apagar 1      Al terminar --carga, apaga el servidor.
+ *        --resolver N    Calcula la política óptima de N partidas y las ordena por dificultad;
+ *                        con N = 1 muestra el detalle por piso.
+ *        --objetivo O    Con --resolver: "victoria" (vencer al Arcángel) o "llegar" (alcanzarlo).
+ *        --tabla R       Con --resolver 1, escribe la tabla de la política en el archivo R.
+ *        --metricas R    Al terminar escribe los tiempos por fase y los contadores en R (Prometheus si
+ *                        termina en .prom, si no JSON). Vale para la partida, --simular y --servidor.
+ *        --traza R       Escribe la línea de tiempo de la partida (o de la partida 0 de --simular)
+ *                        en el formato de trazas de Chrome.
+ *        --memoria K     Límite en KiB de la memoria de los pisos de la partida (o de cada sesión de
+ *                        --servidor). Si se supera, la partida termina con un error.
+ *        --diario R      Anota la partida, turno por turno, en el archivo R (ver Diario.h).
+ *        --reproducir R  Reproduce sin terminal el diario R y muestra cómo terminó.
+ *        --hasta T1,T2   Con --reproducir, se detiene en cada turno de la lista (en cualquier orden)
+ *                        y muestra el estado; volver atrás parte del punto de control más cercano.
+ *        --verificar R   Con --reproducir, compara el último guardado de la reproducción con el
+ *                        archivo R ('partida.dat' de la partida original).
+ *        --puntos N      Con --reproducir, turnos entre puntos de control (por defecto 4096).
+ *        --estadisticas R  Con --simular, anota estadísticas por piso, pelea y cofre, las muestra al
+ *                        final y las escribe en R (CSV si termina en .csv, si no JSON); "-" solo las muestra.
+ *        --instantaneas S  Con --estadisticas, reescribe R cada S segundos mientras se simula.
+ *        --mejores N     Con --estadisticas, tamaño de la tabla de victorias con menos tiradas (por defecto 10).
+ *        --equilibrio L  Con --simular o --barrido, cambia parámetros de equilibrio: "nombre=valor,nombre=valor"
+ *                        (p. ej. saludArcangel=20,limiteTiradas=12; ver Equilibrio.h).
+ *        --barrido N     Barre parámetros de equilibrio jugando hasta N partidas por configuración (ver Barrido.h).
+ *        --parametro E   Con --barrido, un eje de la cuadrícula: "nombre=v1,v2", "nombre=desde:hasta" o
+ *                        "nombre=desde:hasta:paso". Se repite una vez por parámetro.
+ *        --muestras M    Con --barrido, juega M configuraciones al azar de la cuadrícula en vez de todas.
+ *        --banda A:B     Con --barrido, porcentaje de victorias buscado (por defecto 45:55).
+ *        --sigmas Z      Con --barrido, medio ancho de los intervalos en desvíos estándar (por defecto 3).
+ *        --ronda N       Con --barrido, partidas entre dos revisiones del corte temprano (por defecto 1024).
+ *        --informe R     Con --barrido, escribe todas las configuraciones en el CSV R.
+ * return false si hay una opción desconocida, sin valor o con un valor no válido (se explica en 'error').
  */
-void pelearConArcangel(Jugador& jugador, Arcangel& arcangel) {
-    std::cout << "\nHas encontrado al Arcangel! Preparate para la batalla final!" << std::endl;
-
-    // Mostrar información inicial de la pelea
-    std::cout << "Arcangel - Salud: " << arcangel.health << " | Poder de Ataque: " << arcangel.attackPower << std::endl;
-    std::cout << "Jugador - Salud: " << jugador.health << " | Poder de Ataque: " << jugador.attackPower << std::endl;
-
-    bool turnoJugador = (rand() % 2 == 0); // Decidir aleatoriamente quién comienza primero
-    int turnos = 1;
-
-    while (jugador.health > 0 && arcangel.health > 0) {
-        std::cout << "\n--- Turno " << turnos++ << " ---" << std::endl;
-
-        if (turnoJugador) {
-            // Turno del jugador y sus reclutas
-            int totalAttack = jugador.attackPower;
-
-            // Sumar el ataque de todos los reclutas en el equipo del jugador
-            for (const auto& recluta : jugador.equipo) {
-                totalAttack += recluta.attackPower;
+bool leerOpciones(int argc, char* argv[], OpcionesLinea& opciones, std::string& error) {
+    for (int i = 1; i < argc; i += 2) {
+        std::string opcion = argv[i];
+        if (i + 1 == argc) {
+            error = "Falta el valor de " + opcion;
+            return false;
+        }
+        std::string valor = argv[i + 1];
+        bool correcto = true;
+        if (opcion == "--simular") {
+            correcto = leerNumero(valor, opciones.simulacion.partidas);
+            opciones.simular = true;
+        }
+        else if (opcion == "--hilos") {
+            correcto = leerNumero(valor, opciones.simulacion.hilos);
+        }
+        else if (opcion == "--semilla") {
+            correcto = leerNumero(valor, opciones.simulacion.semilla);
+            opciones.semillaIndicada = true;
+        }
+        else if (opcion == "--politica") {
+            opciones.simulacion.politica = valor;
+        }
+        else if (opcion == "--formato") {
+            correcto = valor == "binario" || valor == "delta" || valor == "texto";
+            opciones.formato = (valor == "texto") ? FormatoGuardado::Texto
+                : (valor == "delta") ? FormatoGuardado::Delta : FormatoGuardado::Binario;
+        }
+        else if (opcion == "--pantalla") {
+            opciones.pantallaAnsi = (valor == "ansi");
+        }
+        else if (opcion == "--vista") {
+            size_t x = valor.find('x');
+            opciones.filasVista = 0;
+            correcto = leerNumero(valor.substr(0, x), opciones.columnasVista)
+                && (x == std::string::npos || leerNumero(valor.substr(x + 1), opciones.filasVista));
+        }
+        else if (opcion == "--pistas") {
+            opciones.pistas = (valor == "1");
+        }
+        else if (opcion == "--tablero") {
+            size_t x = valor.find('x');
+            correcto = leerNumero(valor.substr(0, x), opciones.simulacion.tablero.columnas)
+                && leerNumero(x == std::string::npos ? valor : valor.substr(x + 1), opciones.simulacion.tablero.filas);
+        }
+        else if (opcion == "--pisos") {
+            correcto = leerNumero(valor, opciones.simulacion.tablero.pisos);
+        }
+        else if (opcion == "--generacion") {
+            correcto = valor == "completa" || valor == "perezosa";
+            opciones.simulacion.pisosPerezosos = (valor == "perezosa");
+        }
+        else if (opcion == "--servidor") {
+            opciones.servidor = true;
+            opciones.ruta = valor;
+        }
+        else if (opcion == "--compartir") {
+            opciones.rutaCompartidos = valor;
+        }
+        else if (opcion == "--carga") {
+            opciones.carga = true;
+            opciones.ruta = valor;
+        }
+        else if (opcion == "--sesiones") {
+            correcto = leerNumero(valor, opciones.opcionesCarga.sesiones);
+        }
+        else if (opcion == "--conexiones") {
+            correcto = leerNumero(valor, opciones.opcionesCarga.conexiones);
+        }
+        else if (opcion == "--turnos") {
+            correcto = leerNumero(valor, opciones.opcionesCarga.turnos);
+        }
+        else if (opcion == "--apagar") {
+            opciones.opcionesCarga.apagarAlTerminar = (valor == "1");
+        }
+        else if (opcion == "--resolver") {
+            opciones.resolver = true;
+            correcto = leerNumero(valor, opciones.partidasResolver);
+        }
+        else if (opcion == "--objetivo") {
+            opciones.soloLlegar = (valor == "llegar");
+        }
+        else if (opcion == "--tabla") {
+            opciones.rutaTabla = valor;
+        }
+        else if (opcion == "--metricas") {
+            opciones.rutaMetricas = valor;
+        }
+        else if (opcion == "--traza") {
+            opciones.rutaTraza = valor;
+        }
+        else if (opcion == "--memoria") {
+            uint64_t kib = 0;
+            correcto = leerNumero(valor, kib) && kib <= std::numeric_limits<size_t>::max() / 1024;
+            opciones.memoria = static_cast<size_t>(kib) * 1024;
+        }
+        else if (opcion == "--diario") {
+            opciones.rutaDiario = valor;
+        }
+        else if (opcion == "--reproducir") {
+            opciones.rutaReproducir = valor;
+        }
+        else if (opcion == "--hasta") {
+            std::istringstream lista(valor);
+            std::string turno;
+            while (correcto && std::getline(lista, turno, ',')) {
+                uint64_t numero = 0;
+                correcto = leerNumero(turno, numero);
+                opciones.hasta.push_back(numero);
             }
-
-            arcangel.health -= totalAttack; // Atacar al Arcángel
-            std::cout << "Atacas al Arcangel causando " << totalAttack << " puntos de dano." << std::endl;
+        }
+        else if (opcion == "--verificar") {
+            opciones.rutaVerificar = valor;
+        }
+        else if (opcion == "--puntos") {
+            correcto = leerNumero(valor, opciones.intervaloPuntos);
+        }
+        else if (opcion == "--estadisticas") {
+            opciones.simulacion.estadisticas = true;
+            opciones.simulacion.rutaEstadisticas = (valor == "-") ? std::string() : valor;
+        }
+        else if (opcion == "--instantaneas") {
+            correcto = leerNumero(valor, opciones.simulacion.segundosEntreInstantaneas);
+        }
+        else if (opcion == "--mejores") {
+            uint64_t mejores = 0;
+            correcto = leerNumero(valor, mejores) && mejores <= std::numeric_limits<size_t>::max();
+            opciones.simulacion.mejores = static_cast<size_t>(mejores);
+        }
+        else if (opcion == "--equilibrio") {
+            opciones.equilibrio = valor;
+        }
+        else if (opcion == "--barrido") {
+            opciones.barrido = true;
+            correcto = leerNumero(valor, opciones.opcionesBarrido.maxPartidas);
+        }
+        else if (opcion == "--parametro") {
+            opciones.ejes.push_back(valor);
+        }
+        else if (opcion == "--muestras") {
+            correcto = leerNumero(valor, opciones.opcionesBarrido.muestras);
+        }
+        else if (opcion == "--banda") {
+            size_t separador = valor.find(':');
+            double minimo = 0.0;
+            double maximo = 0.0;
+            correcto = leerNumero(valor.substr(0, separador), minimo)
+                && leerNumero(separador == std::string::npos ? valor : valor.substr(separador + 1), maximo);
+            opciones.opcionesBarrido.objetivoMinimo = minimo / 100.0;
+            opciones.opcionesBarrido.objetivoMaximo = maximo / 100.0;
+        }
+        else if (opcion == "--sigmas") {
+            correcto = leerNumero(valor, opciones.opcionesBarrido.sigmas);
+        }
+        else if (opcion == "--ronda") {
+            correcto = leerNumero(valor, opciones.opcionesBarrido.partidasPorRonda);
+        }
+        else if (opcion == "--informe") {
+            opciones.rutaInforme = valor;
         }
         else {
-            // Turno del Arcángel
-            std::vector<int> objetivos; // Índices para seleccionar objetivo
-            objetivos.push_back(0); // El objetivo puede ser el jugador primero
-            for (int i = 0; i < jugador.equipo.size(); ++i) {
-                objetivos.push_back(i + 1); // Agregar reclutas como objetivos
-            }
-
-            int objetivoSeleccionado = objetivos[rand() % objetivos.size()]; // Elegir aleatoriamente un objetivo
-
-            if (objetivoSeleccionado == 0) {
-                // El Arcángel ataca al jugador
-                int damage = arcangel.attackPower;
-                jugador.health -= damage;
-                std::cout << "El Arcangel te ataca y causa " << damage << " puntos de dano." << std::endl;
-            }
-            else {
-                // El Arcángel ataca a un recluta
-                int reclutaIndex = objetivoSeleccionado - 1;
-                int damage = arcangel.attackPower;
-                jugador.equipo[reclutaIndex].health -= damage;
-                std::cout << "El Arcangel ataca a " << jugador.equipo[reclutaIndex].nombre << " y causa " << damage << " puntos de dano." << std::endl;
-
-                // Verificar si el recluta ha sido derrotado
-                if (jugador.equipo[reclutaIndex].health <= 0) {
-                    std::cout << jugador.equipo[reclutaIndex].nombre << " ha sido derrotado." << std::endl;
-                    jugador.equipo.erase(jugador.equipo.begin() + reclutaIndex); // Eliminar recluta derrotado
-                }
-            }
+            error = "Opcion desconocida: " + opcion;
+            return false;
+        }
+        if (!correcto) {
+            error = "Valor no valido para " + opcion + ": " + valor;
+            return false;
         }
-
-        // Mostrar estado actual después del turno
-        std::cout << "Arcangel - Salud: " << arcangel.health << " | Poder de Ataque: " << arcangel.attackPower << std::endl;
-        std::cout << "Jugador - Salud: " << jugador.health << " | Poder de Ataque: " << jugador.attackPower << std::endl;
-
-        turnoJugador = !turnoJugador; // Cambiar turno
     }
+    return true;
+}
 
-    // Mostrar resultado final de la pelea
-    if (jugador.health > 0) {
-        std::cout << "\nHas derrotado al Arcangel! Felicidades, has completado el calabozo." << std::endl;
-    }
-    else {
-        std::cout << "\nEl Arcangel te ha derrotado! Intenta nuevamente." << std::endl;
+/**
+ * Resuelve la política óptima de la partida de flujo 0 con todos los hilos y
+ * muestra la probabilidad desde el inicio de cada piso, con la salud y el ataque iniciales.
+ * return 0 si se pudo resolver (y guardar la tabla, si se pidió).
+ */
+int resolverUnaPartida(const OpcionesLinea& opciones) {
+    Partida partida;
+    configurarPartidaSinTerminal(partida, opciones.simulacion.semilla, 0, PoliticaMovimiento());
+    aplicarTablero(partida, opciones.simulacion.tablero);
+    iniciarPartida(partida);
+
+    OpcionesPolitica politica;
+    politica.soloLlegar = opciones.soloLlegar;
+    TablaPolitica tabla;
+    auto inicio = std::chrono::steady_clock::now();
+    bool resuelta;
+    {
+        PoolHilos pool(opciones.simulacion.hilos);
+        resuelta = resolverPolitica(partida, tabla, politica, &pool);
+    }
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    liberarPiso(partida.piso);
+    if (!resuelta) {
+        std::cerr << "La partida tiene demasiados estados para resolverla." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Estados: " << tabla.estados() << " (" << tabla.bytes() / 1024 << " KiB) resueltos en " << segundos << " s" << std::endl;
+    std::cout << "Probabilidad con la politica optima: " << 100.0 * tabla.probabilidadInicial() << " %" << std::endl;
+    for (int piso = tabla.primerPiso(); piso <= tabla.ultimoPiso(); ++piso) {
+        std::cout << "  Desde el inicio del piso " << piso << " (" << tabla.enemigosEnPiso(piso) << " enemigos, "
+            << tabla.armasEnPiso(piso) << " armas): "
+            << 100.0 * tabla.probabilidad(piso, 0, 0, partida.jugador.health, tabla.ataqueInicial(), 0) << " %" << std::endl;
+    }
+
+    if (!opciones.rutaTabla.empty()) {
+        if (!tabla.guardar(opciones.rutaTabla.c_str())) {
+            std::cerr << "No se pudo escribir " << opciones.rutaTabla << std::endl;
+            return 1;
+        }
+        std::cout << "Tabla escrita en " << opciones.rutaTabla << std::endl;
     }
-
-    juego = false;
+    return 0;
 }
 
 /**
- * Realiza un combate con un enemigo.
- * param jugador Referencia al objeto Jugador.
- * param enemigo Puntero a la celda que contiene al enemigo.
+ * Barre los parámetros de --parametro sobre el equilibrio de --equilibrio y
+ * muestra las configuraciones que caen en la banda de --banda.
+ * return 0 si los ejes son válidos (y el informe se pudo escribir, si se pidió).
  */
-void combatirEnemigo(Jugador& jugador, Celda* enemigo) {
-    std::cout << "Te has encontrado con un enemigo! ¡Preparate para el combate!" << std::endl;
-
-    bool turnoJugador = (rand() % 2 == 1); // Decidir aleatoriamente si el jugador comienza primero
-
-    while (jugador.health > 0 && enemigo->enemyHealth > 0) {
-        if (turnoJugador) {
-            // Turno del jugador y sus reclutas
-            int totalAttack = jugador.attackPower;
-
-            // Sumar el ataque de todos los reclutas en el equipo del jugador
-            for (const auto& recluta : jugador.equipo) {
-                totalAttack += recluta.attackPower;
-            }
-
-            enemigo->enemyHealth -= totalAttack;
-            std::cout << "Has infligido " << totalAttack << " puntos de dano al enemigo." << std::endl;
-
-            if (enemigo->enemyHealth <= 0) {
-                std::cout << "Has derrotado al enemigo!" << std::endl;
-                enemigo->hasEnemy = false; // Eliminar al enemigo de la celda
-                return;
-            }
+int barrerParametros(OpcionesLinea& opciones) {
+    OpcionesBarrido& barrido = opciones.opcionesBarrido;
+    for (const std::string& texto : opciones.ejes) {
+        EjeBarrido eje;
+        std::string error;
+        if (!leerEjeBarrido(texto, eje, error)) {
+            std::cerr << "Parametro de --barrido no valido: " << error << std::endl << "Parametros:" << std::endl
+                << nombresParametros();
+            return 1;
         }
-        else {
-            // Turno del enemigo
-            // Seleccionar aleatoriamente un objetivo dentro de la party del jugador
-            std::vector<int> objetivos;
-            objetivos.push_back(0); // El objetivo puede ser el jugador primero
-            for (int i = 0; i < jugador.equipo.size(); ++i) {
-                objetivos.push_back(i + 1); // Agregar reclutas como objetivos
-            }
-
-            int objetivoSeleccionado = objetivos[rand() % objetivos.size()]; // Elegir aleatoriamente un objetivo
-            int damage = enemigo->enemyAttack;
-
-            if (objetivoSeleccionado == 0) {
-                // El enemigo ataca al jugador
-                jugador.health -= damage;
-                std::cout << "El enemigo te ha infligido " << damage << " puntos de dano." << std::endl;
-            }
-            else {
-                // El enemigo ataca a un recluta
-                int reclutaIndex = objetivoSeleccionado - 1;
-                jugador.equipo[reclutaIndex].health -= damage;
-                std::cout << "El enemigo ha infligido " << damage << " puntos de dano a " << jugador.equipo[reclutaIndex].nombre << "." << std::endl;
-
-                // Verificar si el recluta ha sido derrotado
-                if (jugador.equipo[reclutaIndex].health <= 0) {
-                    std::cout << jugador.equipo[reclutaIndex].nombre << " ha sido derrotado." << std::endl;
-                    jugador.equipo.erase(jugador.equipo.begin() + reclutaIndex); // Eliminar recluta derrotado
-                }
-            }
-
-            if (jugador.health <= 0) {
-                std::cout << "El enemigo te ha derrotado! ¡Intenta nuevamente!" << std::endl;
-                juego = false; // Terminar el juego
-
-                return;
-            }
+        barrido.ejes.push_back(eje);
+    }
+    if (tamanoCuadricula(barrido.ejes) > 1000000 && (barrido.muestras == 0 || barrido.muestras > 1000000)) {
+        std::cerr << "La cuadricula tiene mas de 1000000 configuraciones: elige una muestra con --muestras." << std::endl;
+        return 1;
+    }
+    barrido.base = opciones.simulacion.equilibrio;
+    barrido.tablero = opciones.simulacion.tablero;
+    barrido.politica = opciones.simulacion.politica;
+    barrido.pisosPerezosos = opciones.simulacion.pisosPerezosos;
+    barrido.hilos = opciones.simulacion.hilos;
+    barrido.semilla = opciones.simulacion.semilla;
+    ResumenBarrido resumen = barrerEquilibrio(barrido);
+    imprimirBarrido(resumen, std::cout);
+    if (!opciones.rutaInforme.empty()) {
+        if (!escribirBarrido(resumen, opciones.rutaInforme)) {
+            std::cerr << "No se pudo escribir " << opciones.rutaInforme << std::endl;
+            return 1;
         }
-
-        turnoJugador = !turnoJugador; // Cambiar turno
+        std::cout << "Informe escrito en " << opciones.rutaInforme << std::endl;
     }
+    return 0;
 }
 
 /**
- * Añade un recluta aleatorio al equipo del jugador.
- * param jugador Referencia al objeto Jugador.
+ * Muestra en qué quedó la partida reproducida en el turno alcanzado.
  */
-void anadirReclutaAleatorioAJugador(Jugador& jugador) {
-    // Lista de reclutas disponibles
-    std::vector<Recluta> reclutasDisponibles = {
-        {"Recluta1", 5, 5},
-        {"Recluta2", 6, 4},
-        {"Recluta3", 1, 1},
-        {"Recluta4", 4, 6},
-        {"Recluta5", 2, 4}
-    };
-
-    // Verificar si el jugador puede reclutar más reclutas
-    if (jugador.equipo.size() < 3) {
-        // Generar un índice aleatorio para seleccionar un recluta
-        int indiceAleatorio = rand() % reclutasDisponibles.size();
-
-        // Añadir el recluta seleccionado al equipo del jugador
-        jugador.equipo.push_back(reclutasDisponibles[indiceAleatorio]);
-
-        std::cout << "Has reclutado a " << reclutasDisponibles[indiceAleatorio].nombre << " en tu equipo!" << std::endl;
-    }
-    else {
-        std::cout << "No puedes reclutar mas Reclutas. Tu equipo esta completo." << std::endl;
-    }
+void mostrarReproduccion(const ReproductorDiario& reproductor) {
+    const Partida& partida = reproductor.partida();
+    const Jugador& jugador = partida.jugador;
+    int64_t posicion = jugador.posicion ? partida.piso.indiceDe(jugador.posicion) : -1;
+    std::cout << "Turno " << reproductor.turno() << ": piso " << partida.pisoCalabozo
+        << ", celda " << posicion << ", salud " << jugador.health << ", ataque " << jugador.attackPower
+        << ", reclutas " << jugador.equipo.size() << ", tiradas del piso " << partida.numDiceThrows
+        << ", guardados " << reproductor.guardados() << (partida.juego ? "" : " (terminada)") << std::endl;
 }
 
 /**
- * Verifica y procesa los eventos de una celda específica.
- * param cabeza Puntero a la cabeza de la lista de celdas.
- * param jugador Referencia al objeto Jugador.
- * param arcangel Referencia al objeto Arcangel.
+ * Reproduce el diario de --reproducir: visita los turnos de --hasta, llega al
+ * final y, con --verificar, compara el último guardado con el de la partida original.
+ * return 0 si el diario se pudo reproducir (y coincide, si se verificó).
  */
-void verificarCelda(Celda*& cabeza, Jugador& jugador, Arcangel& arcangel) {
-    Celda* current = jugador.posicion;
-
-    if (current->hasEnemy) {
-        // Realizar combate con el enemigo en la celda actual
-        combatirEnemigo(jugador, current);
-        current->hasEnemy = false;
-    }
-
-    if (current->hasSavePoint) {
-        std::cout << "Has encontrado un punto de salvado. Se ha Guardado tu progreso aqui." << std::endl;
-        guardarInformacionJugador(jugador); // Guardar la información del jugador en un archivo
-        guardarCeldasEnArchivo(current);
-        current->visited = true;
-    }
-
-    if (current->hasTavern) {
-        std::cout << "Has encontrado una taberna. Descansa y recluta a alguien." << std::endl;
-        anadirReclutaAleatorioAJugador(jugador);
-        current->hasTavern = false;
+int reproducirDiario(const OpcionesLinea& opciones) {
+    DiarioLeido diario;
+    if (!leerDiario(opciones.rutaReproducir, diario)) {
+        return 1;
+    }
+    std::cout << "Diario: " << diario.direcciones.size() << " turnos y " << diario.guardados << " guardados, "
+        << (diario.estadoInicial.empty() ? "partida nueva con semilla " + std::to_string(diario.semilla)
+            : std::string("partida cargada")) << std::endl;
+
+    auto inicio = std::chrono::steady_clock::now();
+    ReproductorDiario reproductor(diario, opciones.intervaloPuntos);
+    std::vector<uint64_t> turnos = opciones.hasta;
+    turnos.push_back(reproductor.totalTurnos());
+    for (size_t i = 0; i < turnos.size(); ++i) {
+        reproductor.irA(turnos[i]);
+        if (i + 1 < turnos.size()) {
+            mostrarReproduccion(reproductor);
+        }
     }
-
-    if (current->hasChest) {
-        std::cout << "Has encontrado un cofre. Quizás contenga algo útil." << std::endl;
-        switch (current->chestContent) {
-
-        case 1: //Aumenta el ataque (jugador y reclutas)
-            std::cout << "Has encontrado un arma en el cofre! Aumenta tu poder de ataque." << std::endl;
-
-            jugador.attackPower += 5;
-
-            for (auto& recluta : jugador.equipo) {
-                recluta.attackPower = recluta.attackPower + 2;
-            }
-
-            break;
-
-        case 2: // Recuperar vida para todos los personajes (jugador y reclutas)
-
-            std::cout << "Has encontrado un aumento en los puntos de salud en el cofre!" << std::endl;
-
-            jugador.health += 1;
-            for (auto& recluta : jugador.equipo) {
-                recluta.health += 1;
-            }
-            break;
-
-        case 3: // Recuperar el 10 % de los PS, nunca menos de 1 PS.
-
-            std::cout << "Has encontrado un objeto para recuperar puntos de salud en el cofre!" << std::endl;
-            int recoveryAmount = static_cast<int>(jugador.health * 0.1);
-            jugador.health = std::max(jugador.health + recoveryAmount, 1);
-            break;
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+    const Partida& partida = reproductor.partida();
+    mostrarReproduccion(reproductor);
+    const char* resultados[] = { "en curso", "victoria", "derrota ante el Arcangel", "derrota en combate", "derrota por tiradas" };
+    std::cout << "Resultado: " << resultados[static_cast<int>(partida.resultado)] << std::endl;
+    std::cout << "Turnos reproducidos: " << reproductor.turnosJugados() << " en " << segundos << " s ("
+        << (segundos > 0 ? reproductor.turnosJugados() / segundos : 0.0) << " turnos/s), " << reproductor.puntosDeControl()
+        << " puntos de control" << std::endl;
+    if (reproductor.turno() < reproductor.totalTurnos()) {
+        std::cerr << "La partida termino en el turno " << reproductor.turno() << " pero el diario sigue: no corresponde a esta version del juego." << std::endl;
+        return 1;
+    }
+    if (reproductor.guardados() != diario.guardados) {
+        std::cerr << "La reproduccion paso por " << reproductor.guardados() << " guardados y el diario anota "
+            << diario.guardados << "." << std::endl;
+        return 1;
+    }
+
+    if (!opciones.rutaVerificar.empty()) {
+        ArchivoMapeado original(opciones.rutaVerificar.c_str());
+        if (!original.abierto()) {
+            std::cerr << "No se pudo abrir " << opciones.rutaVerificar << std::endl;
+            return 1;
         }
-        current->hasChest = false; // Eliminar el cofre de la celda
+        const std::vector<unsigned char>& ultimo = reproductor.ultimoGuardado();
+        bool coincide = ultimo.size() == original.tamano()
+            && std::equal(ultimo.begin(), ultimo.end(), original.contenido());
+        std::cout << "Verificacion con " << opciones.rutaVerificar << ": "
+            << (ultimo.empty() ? "la reproduccion no paso por ningun guardado" : coincide ? "coincide" : "NO coincide") << std::endl;
+        return coincide ? 0 : 1;
     }
+    return 0;
 }
 
 /**
- * Muesta las caracteristicas del jugador.
- * param jugador Referencia al objeto Jugador.
- */
-void mostrarCaracteristicas(const Jugador& jugador) {
-    std::cout << "\nEstado del jugador:\n";
-    std::cout << " - Salud: " << jugador.health << std::endl;
-    std::cout << " - Poder de ataque: " << jugador.attackPower << std::endl;
-    std::cout << " - Equipo:" << std::endl;
-    for (const auto& recluta : jugador.equipo) {
-        std::cout << "   * Nombre: " << recluta.nombre << ", Salud: " << recluta.health << ", Poder de ataque: " << recluta.attackPower << std::endl;
-    }
-    std::cout << " - Tiradas de dados realizadas: " << numDiceThrows << std::endl;
-}
-
-/**
- * Muesta las caracteristicas del tablero y del jugador.
- * param cabeza Puntero a la cabeza de la lista de celdas.
- * param jugador Referencia al objeto Jugador.
+ * Escribe las métricas y la traza pedidas con --metricas y --traza.
+ * param medidor Suma de lo medido (nullptr si no se midió).
+ * param traza Medidor con la línea de tiempo (nullptr si no se trazó).
+ * return false si algún archivo no se pudo escribir.
  */
-void mostrarEstado(Celda* cabeza, const Jugador& jugador) {
-    std::cout << "\n---------------------------------------------------------------------------------------------------" << std::endl; // AQUI PDORIAMOS LIMPIAR PANTALLA TAMBIEN
-    std::cout << "Calabozo - Estado del Piso " << pisoCalabozo << ":" << std::endl;
-    std::cout << "   A   B   C   D   E   F   G   H   I   J" << std::endl;
-    for (int row = 1; row <= 10; ++row) {
-        std::cout << row;
-        for (char col = 'A'; col <= 'J'; ++col) {
-            Celda* current = cabeza;
-            while (current) {
-                if (current->column == col && current->row == row) {
-                    if (current == jugador.posicion) {
-                        std::cout << " [x]";
-                    }
-                    else if (current->visited) {
-                        std::cout << " [.]";
-                    }
-                    else {
-                        if (current->hasEnemy) {
-                            std::cout << " [E]";
-                        }
-                        else if (current->hasSavePoint) {
-                            std::cout << " [S]";
-                        }
-                        else if (current->hasTavern) {
-                            std::cout << " [T]";
-                        }
-                        else if (current->hasChest) {
-                            std::cout << " [C]";
-                        }
-                        else {
-                            std::cout << " [ ]";
-                        }
-                    }
-                    break;
-                }
-                current = current->siguiente;
-            }
+bool escribirMedicion(const OpcionesLinea& opciones, const Medidor* medidor, const Medidor* traza) {
+    bool correcto = true;
+    if (medidor && !opciones.rutaMetricas.empty() && !escribirMetricas(*medidor, opciones.rutaMetricas)) {
+        std::cerr << "No se pudo escribir " << opciones.rutaMetricas << std::endl;
+        correcto = false;
+    }
+    if (traza && !opciones.rutaTraza.empty()) {
+        std::ofstream archivo(opciones.rutaTraza);
+        if (!traza->escribirTraza(archivo) || !archivo) {
+            std::cerr << "No se pudo escribir " << opciones.rutaTraza << std::endl;
+            correcto = false;
         }
-        std::cout << std::endl;
     }
-    std::cout << "---------------------------------------------------------------------------------------------------" << std::endl; // AQUI PDORIAMOS LIMPIAR PANTALLA TAMBIEN
-    mostrarCaracteristicas(jugador); // Mostrar características del jugador
+    return correcto;
 }
 
 /**
- * Mueve al jugador a través de las celdas del calabozo basado en el lanzamiento de dados.
- * Después de lanzar los dados, el jugador puede moverse en una dirección específica (arriba, abajo, izquierda, derecha)
- * determinada por la entrada del usuario. El movimiento es limitado por la cantidad de pasos obtenidos en el lanzamiento.
- * Si el jugador llega a la celda 'J10' en el último piso (piso 10), se inicia una pelea con el Arcángel.
- * Si el jugador llega a la celda 'J10' en cualquier otro piso, avanza al siguiente piso.
- * Se verifica si la nueva posición del jugador está dentro de los límites del calabozo y se actualiza la posición del jugador.
- * La función termina si se excede el límite de tiradas de dados permitidas.
- *
- * param cabeza Puntero a la cabeza de la lista de celdas del calabozo.
- * param jugador Referencia al objeto Jugador que se está moviendo.
- * param arcangel Referencia al objeto Arcangel para iniciar la pelea si se llega a la celda 'J10' en el piso 10.
+ * Avisa que los pisos superaron el límite de --memoria.
+ * return Código de salida del programa.
  */
-void moverJugador(Celda*& cabeza, Jugador& jugador, Arcangel& arcangel) {
-
-    std::cout << "\nPresiona Enter para lanzar los dados...";
-    std::cin.ignore(); // Ignorar cualquier entrada anterior
-    std::cin.get(); // Esperar a que se presione Enter
-
-    int dice1 = rand() % 6 + 1;
-    int dice2 = rand() % 6 + 1;
-    int totalSteps = dice1 + dice2;
-    numDiceThrows++;
-
-    std::cout << "\nLanzaste los dados. Puedes avanzar " << totalSteps << " pasos." << std::endl;
-
-    char direccion;
-    std::cout << "Elige una direccion para moverte (W, A, S, D): ";
-    std::cin >> direccion;
-
-    Celda* current = jugador.posicion;
-    int newRow = current->row;
-    char newColumn = current->column;
-
-    // Avanzar exactamente la cantidad de pasos determinada por los dados
-    while (totalSteps > 0) {
-        switch (direccion) {
-        case 'W':  // Mover hacia arriba
-            if (newRow > 1) {
-                --newRow;
-            }
-            break;
-        case 'S':  // Mover hacia abajo
-            if (newRow < 10) {
-                ++newRow;
-            }
-            break;
-        case 'A':  // Mover hacia la izquierda
-            if (newColumn > 'A') {
-                --newColumn;
-            }
-            break;
-        case 'D':  // Mover hacia la derecha
-            if (newColumn < 'J') {
-                ++newColumn;
-            }
-            break;
-        default:
-            std::cout << "Direccion de movimiento no valida." << std::endl;
-            break;
-        }
-
-        // Verificar si el jugador llega a la celda J10 en el piso 10
-        if (newColumn == 'J' && newRow == 10 && current->piso == 10) {
-            pelearConArcangel(jugador, arcangel);
-            return;
-        }
+int memoriaAgotada(const ArenaPisos& arena) {
+    std::cerr << "La partida supero el limite de memoria de los pisos (" << arena.limite() / 1024 << " KiB)." << std::endl;
+    return 1;
+}
 
-        // Verificar límite de la celda J10
-        if (newColumn == 'J' && newRow == 10) {
-            std::cout << "\nHas llegado a la salida del piso (J10)! Iniciando nuevo piso." << std::endl;
-            ++pisoCalabozo; // Incrementar el número de piso
-            liberarLista(cabeza); // Liberar la memoria del calabozo actual
-            crearCalabozo(cabeza, numEnemies); // Crear un nuevo calabozo con nuevas características
-            numDiceThrows = 0;
-            colocarJugador(cabeza, jugador); // Colocar al jugador en la nueva posición inicial
-            mostrarEstado(cabeza, jugador); // Mostrar el estado del nuevo calabozo
-            return;
+int main(int argc, char* argv[]) {
+    OpcionesLinea opciones;
+    std::string errorOpciones;
+    if (!leerOpciones(argc, argv, opciones, errorOpciones)) {
+        std::cerr << errorOpciones << std::endl;
+        return 1;
+    }
+    if ((!opciones.rutaMetricas.empty() || !opciones.rutaTraza.empty()) && !instrumentacionCompilada()) {
+        std::cerr << "Esta compilacion no incluye la instrumentacion (CALABOZO_INSTRUMENTACION)." << std::endl;
+        return 1;
+    }
+    if (!tableroValido(opciones.simulacion.tablero)) {
+        std::cerr << "Tablero no valido: hacen falta al menos 2 celdas, lados de hasta " << maxLadoTablero
+            << " y de 1 a " << maxPisos << " pisos." << std::endl;
+        return 1;
+    }
+    if ((opciones.simular || opciones.barrido) && !politicaPorNombre(opciones.simulacion.politica)) {
+        std::cerr << "Politica desconocida: " << opciones.simulacion.politica << std::endl;
+        return 1;
+    }
+    std::string errorEquilibrio;
+    if (!leerEquilibrio(opciones.equilibrio, opciones.simulacion.equilibrio, errorEquilibrio)) {
+        std::cerr << "Equilibrio no valido: " << errorEquilibrio << std::endl << "Parametros:" << std::endl << nombresParametros();
+        return 1;
+    }
+    if (opciones.barrido) {
+        return barrerParametros(opciones);
+    }
+    if (opciones.simular) {
+        opciones.simulacion.medir = !opciones.rutaMetricas.empty();
+        opciones.simulacion.trazar = !opciones.rutaTraza.empty();
+        ResumenSimulacion resumen = simularPartidas(opciones.simulacion);
+        imprimirResumen(resumen, std::cout);
+        return escribirMedicion(opciones, resumen.medidor.get(), resumen.traza.get()) ? 0 : 1;
+    }
+    if (opciones.resolver) {
+        if (opciones.partidasResolver <= 1) {
+            return resolverUnaPartida(opciones);
         }
-
-        --totalSteps;
+        OpcionesClasificacion clasificacion;
+        clasificacion.partidas = opciones.partidasResolver;
+        clasificacion.hilos = opciones.simulacion.hilos;
+        clasificacion.semilla = opciones.simulacion.semilla;
+        clasificacion.tablero = opciones.simulacion.tablero;
+        clasificacion.politica.soloLlegar = opciones.soloLlegar;
+        imprimirClasificacion(clasificarPartidas(clasificacion), std::cout);
+        return 0;
     }
-
-    // Verificar si la nueva posición está dentro de los límites del calabozo
-    Celda* newCell = cabeza;
-    while (newCell) {
-        if (newCell->column == newColumn && newCell->row == newRow) {
-            jugador.posicion->hasPlayer = false;
-            newCell->hasPlayer = true;
-            jugador.posicion = newCell;
-
-            verificarCelda(cabeza, jugador, arcangel); // Verificar la nueva celda
-            if (juego) {
-                mostrarEstado(cabeza, jugador);
-            }
-            break;
-        }
-        newCell = newCell->siguiente;
+    if (opciones.servidor) {
+        OpcionesServidor servidor;
+        servidor.ruta = opciones.ruta;
+        servidor.hilos = opciones.simulacion.hilos;
+        servidor.pisosPerezosos = opciones.simulacion.pisosPerezosos;
+        servidor.rutaMetricas = opciones.rutaMetricas;
+        servidor.memoriaSesion = opciones.memoria;
+        servidor.tablero = opciones.simulacion.tablero;
+        servidor.rutaCompartidos = opciones.rutaCompartidos;
+        return ejecutarServidor(servidor) ? 0 : 1;
+    }
+    if (!opciones.rutaReproducir.empty()) {
+        return reproducirDiario(opciones);
+    }
+    if (opciones.carga) {
+        opciones.opcionesCarga.ruta = opciones.ruta;
+        opciones.opcionesCarga.semilla = opciones.simulacion.semilla;
+        imprimirCarga(generarCarga(opciones.opcionesCarga), std::cout);
+        return 0;
     }
 
-    // Restricción para perder el juego si se tiran los dados más de 15 veces
-    if (numDiceThrows > 15) {
-        std::cout << "Has excedido el límite de tiradas de dados permitidas. ¡Has perdido el juego!" << std::endl;
-        juego = false;
-        return;
+    // Con la misma semilla (--semilla) se repite exactamente la misma partida
+    uint64_t semilla = opciones.semillaIndicada
+        ? opciones.simulacion.semilla
+        : static_cast<uint64_t>(time(nullptr));
+    // La arena vive más que la partida y que los hilos que guardan y preparan sus pisos
+    ArenaPisos arena(opciones.memoria);
+    Partida partida;
+    partida.arena = &arena;
+    aplicarTablero(partida, opciones.simulacion.tablero);
+    partida.generador = GeneradorPartida(semilla);
+    partida.formatoGuardado = opciones.formato;
+    partida.pisosPerezosos = opciones.simulacion.pisosPerezosos;
+    partida.pistas = opciones.pistas;
+
+    // Se crea antes del menú para que también dibuje el primer estado de la partida
+    std::unique_ptr<RenderizadorTablero> renderizador;
+    if (opciones.pantallaAnsi) {
+        renderizador.reset(new RenderizadorTablero(opciones.columnasVista, opciones.filasVista));
+        partida.renderizador = renderizador.get();
+    }
+
+    // Con --metricas o --traza se mide la partida, también lo que escribe en la terminal
+    Medidor medidor(!opciones.rutaTraza.empty());
+    BufferMedido terminalMedida(std::cout.rdbuf(), medidor);
+    std::ostream salidaMedida(&terminalMedida);
+    bool medir = !opciones.rutaMetricas.empty() || !opciones.rutaTraza.empty();
+    if (medir) {
+        partida.medidor = &medidor;
+        partida.salida = &salidaMedida;
     }
-}
-
-void mostrarTexto() {
-    std::cout << "-------------------------------------------------------------------------------" << std::endl;
-    std::cout << "                  Nueva Aventura" << std::endl;
-    std::cout << "-------------------------------------------------------------------------------" << std::endl;
-    std::cout << "En las tierras ancestrales de Erresire, un joven orco valiente y decidido," << std::endl;
-    std::cout << "comienza su odisea hacia el misterioso Calabozo del Arcangel." << std::endl;
-    std::cout << "Su objetivo: derrotar al legendario Arcangel y reclamar su poder," << std::endl;
-    std::cout << "que lo convertira en el senor supremo del continente." << std::endl;
-    std::cout << "Con su libro de hechizos para principiantes en una mano y la determinacion" << std::endl;
-    std::cout << "ardiente en su corazón, Erresire se adentra en las profundidades del calabozo," << std::endl;
-    std::cout << "con la esperanza de forjar su destino y alcanzar la gloria." << std::endl;
-    std::cout << "Que comience la epica aventura de Erresire en su busqueda de poder y redencion!" << std::endl;
-    std::cout << "-------------------------------------------------------------------------------" << std::endl;
-
-    std::cout << "Presiona Enter para continuar...";
-    std::cin.ignore(); // Ignorar cualquier entrada anterior
-    std::cin.get(); // Esperar a que se presione Enter
-}
-
-void mostrarMenu() {
-    std::cout << "Bienvenido al juego del Calabozo!" << std::endl;
-    std::cout << "1. Iniciar nueva partida" << std::endl;
-    std::cout << "2. Cargar partida guardada" << std::endl;
-    std::cout << "3. Salir" << std::endl;
-}
-
-void limpiarPantalla() {
-    std::cout << "\033[2J\033[1;1H"; // Código ANSI para limpiar la pantalla
-}
-
-int main() {
-    srand(time(nullptr));
-
-    Celda* cabeza = nullptr;
-    Jugador jugador;
-    Arcangel arcangel;
-
 
     mostrarMenu();
 
@@ -802,17 +667,30 @@ int main() {
         mostrarTexto();
         limpiarPantalla();
 
-        crearCalabozo(cabeza, numEnemies);
-        colocarJugador(cabeza, jugador);
-        mostrarEstado(cabeza, jugador);
+        std::cout << "Semilla de la partida: " << semilla << std::endl;
+        try {
+            iniciarPartida(partida);
+        }
+        catch (const std::bad_alloc&) {
+            return memoriaAgotada(arena);
+        }
 
         break;
     case 2: // Cargar partida guardada
 
         limpiarPantalla();
-        cargarCeldasDesdeArchivo(cabeza);
-        cargarInformacionJugador(jugador, cabeza); //tambien se coloca de una vez el jugador
-        mostrarEstado(cabeza, jugador);
+        bool cargada;
+        try {
+            cargada = cargarPartida(partida); //tambien se coloca de una vez el jugador
+        }
+        catch (const std::bad_alloc&) {
+            return memoriaAgotada(arena);
+        }
+        if (!cargada) {
+            std::cout << "No se encontro ninguna partida guardada." << std::endl;
+            return 0;
+        }
+        mostrarEstado(partida);
 
         break;
     case 3: // Salir del juego
@@ -825,13 +703,37 @@ int main() {
         return 0;
     }
 
-    // JUEGO
-    while (juego) {
-        moverJugador(cabeza, jugador, arcangel);
+    // El diario empieza con la partida ya creada o cargada
+    DiarioPartida diario;
+    if (!opciones.rutaDiario.empty()) {
+        if (!diario.abrir(opciones.rutaDiario, partida, opcion == 2)) {
+            return 1;
+        }
+        partida.diario = &diario;
     }
 
+    // JUEGO
+    // Los puntos de guardado escriben en un hilo aparte; al salir de main se
+    // termina de escribir lo pendiente.
+    GuardadoAsincrono guardado;
+    partida.guardadoAsincrono = &guardado;
+    // El piso siguiente se genera mientras se juega el actual
+    PreparadorPisos preparador;
+    partida.preparadorPisos = &preparador;
+    try {
+        jugarPartida(partida);
+    }
+    catch (const std::bad_alloc&) {
+        return memoriaAgotada(arena);
+    }
+    partida.guardadoAsincrono = nullptr;
+    partida.preparadorPisos = nullptr;
+
     // liberacion de memoria
-    liberarLista(cabeza);
+    liberarPiso(partida.piso);
 
+    if (medir && !escribirMedicion(opciones, &medidor, &medidor)) {
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,131 @@
+#include "Equilibrio.h"
+
+#include <exception>
+#include <sstream>
+
+namespace {
+    /**
+     * Un parámetro con nombre: dónde vive en el equilibrio y qué valores acepta.
+     * Los rangos mantienen la salud y el ataque de los enemigos dentro de los
+     * 16 bits de la celda incluso en el piso maxPisos.
+     */
+    struct Parametro {
+        const char* nombre;
+        int minimo;
+        int maximo;
+        int& (*campo)(Equilibrio&);
+    };
+
+    const Parametro parametros[] = {
+        { "carasEnemigo", 1, 1000, [](Equilibrio& e) -> int& { return e.celdas.carasEnemigo; } },
+        { "carasGuardado", 1, 1000, [](Equilibrio& e) -> int& { return e.celdas.carasGuardado; } },
+        { "carasTaberna", 1, 1000, [](Equilibrio& e) -> int& { return e.celdas.carasTaberna; } },
+        { "carasCofre", 1, 1000, [](Equilibrio& e) -> int& { return e.celdas.carasCofre; } },
+        { "saludEnemigo", 1, 1000, [](Equilibrio& e) -> int& { return e.celdas.saludEnemigo; } },
+        { "saludEnemigoPorPiso", 0, 30, [](Equilibrio& e) -> int& { return e.celdas.saludEnemigoPorPiso; } },
+        { "ataqueEnemigo", 0, 1000, [](Equilibrio& e) -> int& { return e.celdas.ataqueEnemigo; } },
+        { "ataqueEnemigoPorPiso", 0, 30, [](Equilibrio& e) -> int& { return e.celdas.ataqueEnemigoPorPiso; } },
+        { "maxEnemigos", 0, 1000000, [](Equilibrio& e) -> int& { return e.maxEnemigos; } },
+        { "saludArcangel", 1, 1000000, [](Equilibrio& e) -> int& { return e.saludArcangel; } },
+        { "ataqueArcangel", 0, 1000000, [](Equilibrio& e) -> int& { return e.ataqueArcangel; } },
+        { "limiteTiradas", 0, 10000, [](Equilibrio& e) -> int& { return e.limiteTiradas; } },
+        { "reclutas", 1, maxReclutasTaberna, [](Equilibrio& e) -> int& { return e.numReclutas; } },
+    };
+
+    const Parametro saludRecluta = { "reclutaN.salud", 1, 1000, nullptr };
+    const Parametro ataqueRecluta = { "reclutaN.ataque", 0, 1000, nullptr };
+
+    /**
+     * Busca un parámetro por su nombre. Los de cada recluta ("recluta1.salud"
+     * a "recluta8.ataque") no están en la tabla: se devuelve su rango y en
+     * 'recluta' su posición (-1 para los demás).
+     * return nullptr si el nombre no existe.
+     */
+    const Parametro* buscar(const std::string& nombre, int& recluta) {
+        recluta = -1;
+        for (const Parametro& parametro : parametros) {
+            if (nombre == parametro.nombre) {
+                return &parametro;
+            }
+        }
+        if (nombre.size() < 10 || nombre.compare(0, 7, "recluta") != 0 || nombre[8] != '.'
+            || nombre[7] < '1' || nombre[7] >= '1' + maxReclutasTaberna) {
+            return nullptr;
+        }
+        std::string campo = nombre.substr(9);
+        if (campo != "salud" && campo != "ataque") {
+            return nullptr;
+        }
+        recluta = nombre[7] - '1';
+        return campo == "salud" ? &saludRecluta : &ataqueRecluta;
+    }
+
+    int& campoDe(Equilibrio& equilibrio, const Parametro& parametro, int recluta) {
+        if (recluta < 0) {
+            return parametro.campo(equilibrio);
+        }
+        PerfilRecluta& perfil = equilibrio.reclutas[static_cast<size_t>(recluta)];
+        return &parametro == &saludRecluta ? perfil.health : perfil.attackPower;
+    }
+}
+
+bool asignarParametro(Equilibrio& equilibrio, const std::string& nombre, int valor) {
+    int recluta;
+    const Parametro* parametro = buscar(nombre, recluta);
+    if (!parametro || valor < parametro->minimo || valor > parametro->maximo) {
+        return false;
+    }
+    campoDe(equilibrio, *parametro, recluta) = valor;
+    return true;
+}
+
+bool leerParametro(const Equilibrio& equilibrio, const std::string& nombre, int& valor) {
+    int recluta;
+    const Parametro* parametro = buscar(nombre, recluta);
+    if (!parametro) {
+        return false;
+    }
+    valor = campoDe(const_cast<Equilibrio&>(equilibrio), *parametro, recluta);
+    return true;
+}
+
+bool leerEquilibrio(const std::string& texto, Equilibrio& equilibrio, std::string& error) {
+    std::istringstream lista(texto);
+    std::string par;
+    while (std::getline(lista, par, ',')) {
+        size_t igual = par.find('=');
+        std::string nombre = par.substr(0, igual);
+        int recluta;
+        const Parametro* parametro = buscar(nombre, recluta);
+        if (!parametro) {
+            error = "parametro desconocido: " + nombre;
+            return false;
+        }
+        size_t leidos = 0;
+        int valor = 0;
+        try {
+            valor = igual == std::string::npos ? 0 : std::stoi(par.substr(igual + 1), &leidos);
+        }
+        catch (const std::exception&) {
+            leidos = 0;
+        }
+        if (leidos == 0 || igual + 1 + leidos != par.size() || !asignarParametro(equilibrio, nombre, valor)) {
+            error = nombre + " necesita un entero de " + std::to_string(parametro->minimo) + " a "
+                + std::to_string(parametro->maximo);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string nombresParametros() {
+    std::ostringstream salida;
+    for (const Parametro& parametro : parametros) {
+        salida << "  " << parametro.nombre << " (" << parametro.minimo << " a " << parametro.maximo << ")\n";
+    }
+    for (const Parametro* parametro : { &saludRecluta, &ataqueRecluta }) {
+        salida << "  " << parametro->nombre << " (" << parametro->minimo << " a " << parametro->maximo
+            << "; N de 1 a " << maxReclutasTaberna << ")\n";
+    }
+    return salida.str();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+/**
+ * Lo que decide el contenido de cada celda al generar un piso. Cada cosa
+ * aparece si un dado de tantas caras sale 0 (1 cara: siempre).
+ */
+struct ReglasCeldas {
+    int carasEnemigo = 10;
+    int carasGuardado = 10;
+    int carasTaberna = 10;
+    int carasCofre = 4;
+    int saludEnemigo = 1;           // Salud del enemigo: saludEnemigo + saludEnemigoPorPiso * piso
+    int saludEnemigoPorPiso = 1;
+    int ataqueEnemigo = 0;          // Ataque del enemigo: ataqueEnemigo + ataqueEnemigoPorPiso * piso
+    int ataqueEnemigoPorPiso = 1;
+
+    bool operator==(const ReglasCeldas& otras) const {
+        return carasEnemigo == otras.carasEnemigo && carasGuardado == otras.carasGuardado
+            && carasTaberna == otras.carasTaberna && carasCofre == otras.carasCofre
+            && saludEnemigo == otras.saludEnemigo && saludEnemigoPorPiso == otras.saludEnemigoPorPiso
+            && ataqueEnemigo == otras.ataqueEnemigo && ataqueEnemigoPorPiso == otras.ataqueEnemigoPorPiso;
+    }
+};
+
+/**
+ * Salud y ataque de una de las reclutas que ofrecen las tabernas.
+ */
+struct PerfilRecluta {
+    int health;
+    int attackPower;
+};
+
+const int maxReclutasTaberna = 8;
+
+/**
+ * Parámetros de equilibrio del juego. Los valores por defecto son los del
+ * juego original; con ellos las partidas son idénticas a las de siempre.
+ *
+ * Los guardados no lo incluyen: una partida cargada juega con el equilibrio
+ * estándar. Por eso solo --simular y --barrido permiten cambiarlo.
+ */
+struct Equilibrio {
+    ReglasCeldas celdas;
+    int maxEnemigos = 10;           // Enemigos de toda la partida, sumando todos los pisos
+    int saludArcangel = 15;
+    int ataqueArcangel = 10;
+    int limiteTiradas = 15;         // Tiradas de dados por piso; la siguiente pierde la partida
+    int numReclutas = 5;            // Reclutas distintas que ofrecen las tabernas (Recluta1, Recluta2...)
+    std::array<PerfilRecluta, maxReclutasTaberna> reclutas = { { { 5, 5 }, { 6, 4 }, { 1, 1 }, { 4, 6 }, { 2, 4 } } };
+};
+
+/**
+ * Cambia un parámetro por su nombre (ver nombresParametros), por ejemplo
+ * "saludArcangel", "carasEnemigo" o "recluta2.salud".
+ * return false si el nombre no existe o el valor queda fuera de su rango.
+ */
+bool asignarParametro(Equilibrio& equilibrio, const std::string& nombre, int valor);
+
+/**
+ * Valor de un parámetro por su nombre.
+ * return false si el nombre no existe.
+ */
+bool leerParametro(const Equilibrio& equilibrio, const std::string& nombre, int& valor);
+
+/**
+ * Aplica una lista "nombre=valor,nombre=valor" sobre el equilibrio.
+ * return false (con el motivo en 'error') al primer nombre o valor no válido.
+ */
+bool leerEquilibrio(const std::string& texto, Equilibrio& equilibrio, std::string& error);
+
+/**
+ * Nombres de todos los parámetros con su rango, uno por línea.
+ */
+std::string nombresParametros();
@@ -0,0 +1,301 @@
+#include "Estadisticas.h"
+#include "Guardado.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    const char* nombresResultados[5] = { "en_curso", "victoria", "derrota_arcangel", "derrota_combate", "derrota_tiradas" };
+    const char* nombresRivales[2] = { "enemigo", "arcangel" };
+    const char* nombresCofres[cubetasCofres] = { "arma", "salud", "curacion" };
+
+    template <class Contenedor>
+    void escribirListaJson(std::ostream& salida, const Contenedor& valores) {
+        salida << "[";
+        for (size_t i = 0; i < valores.size(); ++i) {
+            salida << (i ? ", " : "") << valores[i];
+        }
+        salida << "]";
+    }
+
+    void filaCsv(std::ostream& salida, const char* serie, const std::string& piso, const std::string& clave, uint64_t valor) {
+        if (valor != 0) {
+            salida << serie << "," << piso << "," << clave << "," << valor << ",\n";
+        }
+    }
+
+    /**
+     * Menor cantidad de tiradas con la que llega a la salida al menos la fracción p de quienes la alcanzan.
+     */
+    int percentilTiradas(const std::vector<uint64_t>& cubetas, double p) {
+        uint64_t total = 0;
+        for (uint64_t cantidad : cubetas) {
+            total += cantidad;
+        }
+        uint64_t acumulado = 0;
+        for (size_t i = 0; i < cubetas.size(); ++i) {
+            acumulado += cubetas[i];
+            if (total > 0 && static_cast<double>(acumulado) >= p * static_cast<double>(total)) {
+                return static_cast<int>(i);
+            }
+        }
+        return 0;
+    }
+
+    double porcentaje(uint64_t parte, uint64_t total) {
+        return total ? 100.0 * static_cast<double>(parte) / static_cast<double>(total) : 0.0;
+    }
+}
+
+FranjaEstadisticas::FranjaEstadisticas(int numPisos, int limiteTiradas, size_t capacidad)
+    : pisos(static_cast<size_t>(std::max(numPisos, 0)) + 1), capacidadMejores(capacidad) {
+    size_t cubetas = static_cast<size_t>(std::max(limiteTiradas, 0)) + 2;
+    for (PorPiso& porPiso : pisos) {
+        porPiso.tiradas = std::vector<CuentaCompartida>(cubetas);
+    }
+    mejores.reserve(capacidad);
+}
+
+void FranjaEstadisticas::anotarSalida(int piso, int tiradas) {
+    tiradasPartida += static_cast<uint64_t>(std::max(tiradas, 0));
+    if (piso < 1 || static_cast<size_t>(piso) >= pisos.size()) {
+        return;
+    }
+    PorPiso& porPiso = pisos[static_cast<size_t>(piso)];
+    porPiso.superaron.sumar();
+    size_t cubeta = std::min(static_cast<size_t>(std::max(tiradas, 0)), porPiso.tiradas.size() - 1);
+    porPiso.tiradas[cubeta].sumar();
+}
+
+void FranjaEstadisticas::anotarPelea(RivalCombate rival, bool victoria, int reclutasPerdidas, int saludJugador) {
+    int perdidas = std::min(std::max(reclutasPerdidas, 0), cubetasReclutas - 1);
+    this->reclutasPerdidas[static_cast<size_t>(rival)][static_cast<size_t>(perdidas)].sumar();
+    if (!victoria) {
+        int cubeta = std::min(std::max(-saludJugador, 0), cubetasSalud - 1);
+        saludAlMorir[static_cast<size_t>(cubeta)].sumar();
+    }
+}
+
+void FranjaEstadisticas::anotarCofre(int contenido) {
+    if (contenido >= 1 && contenido <= cubetasCofres) {
+        cofres[static_cast<size_t>(contenido - 1)].sumar();
+    }
+}
+
+void FranjaEstadisticas::anotarPartida(const Partida& partida) {
+    partidas.sumar();
+    resultados[static_cast<size_t>(partida.resultado)].sumar();
+    size_t ultimo = std::min(static_cast<size_t>(std::max(partida.pisoCalabozo, 0)), pisos.size() - 1);
+    for (size_t piso = 1; piso <= ultimo; ++piso) {
+        pisos[piso].llegaron.sumar();
+    }
+
+    if (partida.resultado == Resultado::Victoria && capacidadMejores > 0) {
+        MarcaPartida marca;
+        marca.flujo = partida.generador.obtenerFlujo();
+        marca.tiradas = static_cast<uint32_t>(tiradasPartida);
+        marca.salud = partida.jugador.health;
+        // Solo este hilo cambia la tabla: leerla sin el candado es seguro
+        if (mejores.size() < capacidadMejores || marca < mejores.front()) {
+            std::lock_guard<std::mutex> candado(mutexMejores);
+            if (mejores.size() == capacidadMejores) {
+                std::pop_heap(mejores.begin(), mejores.end());
+                mejores.pop_back();
+            }
+            mejores.push_back(marca);
+            std::push_heap(mejores.begin(), mejores.end());
+        }
+    }
+    tiradasPartida = 0;
+}
+
+void FranjaEstadisticas::sumarA(InstantaneaEstadisticas& instantanea) const {
+    instantanea.partidas += partidas.leer();
+    for (size_t i = 0; i < resultados.size(); ++i) {
+        instantanea.resultados[i] += resultados[i].leer();
+    }
+    if (instantanea.llegaron.size() < pisos.size()) {
+        instantanea.llegaron.resize(pisos.size(), 0);
+        instantanea.superaron.resize(pisos.size(), 0);
+        instantanea.tiradas.resize(pisos.size());
+    }
+    for (size_t piso = 1; piso < pisos.size(); ++piso) {
+        instantanea.llegaron[piso] += pisos[piso].llegaron.leer();
+        instantanea.superaron[piso] += pisos[piso].superaron.leer();
+        const std::vector<CuentaCompartida>& cubetas = pisos[piso].tiradas;
+        std::vector<uint64_t>& suma = instantanea.tiradas[piso];
+        if (suma.size() < cubetas.size()) {
+            suma.resize(cubetas.size(), 0);
+        }
+        for (size_t t = 0; t < cubetas.size(); ++t) {
+            suma[t] += cubetas[t].leer();
+        }
+    }
+    for (size_t i = 0; i < saludAlMorir.size(); ++i) {
+        instantanea.saludAlMorir[i] += saludAlMorir[i].leer();
+    }
+    for (size_t rival = 0; rival < reclutasPerdidas.size(); ++rival) {
+        for (size_t i = 0; i < cubetasReclutas; ++i) {
+            instantanea.reclutasPerdidas[rival][i] += reclutasPerdidas[rival][i].leer();
+        }
+    }
+    for (size_t i = 0; i < cofres.size(); ++i) {
+        instantanea.cofres[i] += cofres[i].leer();
+    }
+    std::lock_guard<std::mutex> candado(mutexMejores);
+    instantanea.mejores.insert(instantanea.mejores.end(), mejores.begin(), mejores.end());
+}
+
+EstadisticasSimulacion::EstadisticasSimulacion(size_t numFranjas, int pisos, int limiteTiradas, size_t capacidad)
+    : mejores(capacidad) {
+    for (size_t i = 0; i < numFranjas; ++i) {
+        franjas.emplace_back(new FranjaEstadisticas(pisos, limiteTiradas, capacidad));
+    }
+}
+
+InstantaneaEstadisticas EstadisticasSimulacion::instantanea() const {
+    InstantaneaEstadisticas instantanea;
+    for (const auto& franja : franjas) {
+        franja->sumarA(instantanea);
+    }
+    // Cada franja guarda sus mejores; las de todas juntas se recortan aquí
+    std::sort(instantanea.mejores.begin(), instantanea.mejores.end());
+    if (instantanea.mejores.size() > mejores) {
+        instantanea.mejores.resize(mejores);
+    }
+    return instantanea;
+}
+
+void InstantaneaEstadisticas::escribirJson(std::ostream& salida) const {
+    salida << "{\"partidas\": " << partidas << ", \"resultados\": {";
+    for (size_t i = 0; i < resultados.size(); ++i) {
+        salida << (i ? ", " : "") << "\"" << nombresResultados[i] << "\": " << resultados[i];
+    }
+    salida << "}, \"pisos\": [";
+    for (size_t piso = 1; piso < llegaron.size(); ++piso) {
+        salida << (piso > 1 ? ", " : "") << "{\"piso\": " << piso << ", \"llegaron\": " << llegaron[piso]
+            << ", \"superaron\": " << superaron[piso] << ", \"tiradas\": ";
+        escribirListaJson(salida, tiradas[piso]);
+        salida << "}";
+    }
+    salida << "], \"salud_al_morir\": ";
+    escribirListaJson(salida, saludAlMorir);
+    salida << ", \"reclutas_perdidas\": {";
+    for (size_t rival = 0; rival < reclutasPerdidas.size(); ++rival) {
+        salida << (rival ? ", " : "") << "\"" << nombresRivales[rival] << "\": ";
+        escribirListaJson(salida, reclutasPerdidas[rival]);
+    }
+    salida << "}, \"cofres\": {";
+    for (size_t i = 0; i < cofres.size(); ++i) {
+        salida << (i ? ", " : "") << "\"" << nombresCofres[i] << "\": " << cofres[i];
+    }
+    salida << "}, \"mejores\": [";
+    for (size_t i = 0; i < mejores.size(); ++i) {
+        salida << (i ? ", " : "") << "{\"partida\": " << mejores[i].flujo << ", \"tiradas\": " << mejores[i].tiradas
+            << ", \"salud\": " << mejores[i].salud << "}";
+    }
+    salida << "]}";
+}
+
+void InstantaneaEstadisticas::escribirCsv(std::ostream& salida) const {
+    salida << "serie,piso,clave,valor,partida\n";
+    salida << "partidas,,," << partidas << ",\n";
+    for (size_t i = 0; i < resultados.size(); ++i) {
+        filaCsv(salida, "resultado", "", nombresResultados[i], resultados[i]);
+    }
+    for (size_t piso = 1; piso < llegaron.size(); ++piso) {
+        std::string numero = std::to_string(piso);
+        filaCsv(salida, "llegaron", numero, "", llegaron[piso]);
+        filaCsv(salida, "superaron", numero, "", superaron[piso]);
+        for (size_t t = 0; t < tiradas[piso].size(); ++t) {
+            filaCsv(salida, "tiradas", numero, std::to_string(t), tiradas[piso][t]);
+        }
+    }
+    for (size_t i = 0; i < saludAlMorir.size(); ++i) {
+        filaCsv(salida, "salud_al_morir", "", std::to_string(-static_cast<int>(i)), saludAlMorir[i]);
+    }
+    for (size_t rival = 0; rival < reclutasPerdidas.size(); ++rival) {
+        std::string serie = std::string("reclutas_perdidas_") + nombresRivales[rival];
+        for (size_t i = 0; i < cubetasReclutas; ++i) {
+            filaCsv(salida, serie.c_str(), "", std::to_string(i), reclutasPerdidas[rival][i]);
+        }
+    }
+    for (size_t i = 0; i < cofres.size(); ++i) {
+        filaCsv(salida, "cofre", "", nombresCofres[i], cofres[i]);
+    }
+    for (size_t i = 0; i < mejores.size(); ++i) {
+        salida << "mejor,," << (i + 1) << "," << mejores[i].tiradas << "," << mejores[i].flujo << "\n";
+    }
+}
+
+bool escribirEstadisticas(const InstantaneaEstadisticas& instantanea, const std::string& ruta) {
+    std::ostringstream contenido;
+    const std::string extension = ".csv";
+    if (ruta.size() >= extension.size() && ruta.compare(ruta.size() - extension.size(), extension.size(), extension) == 0) {
+        instantanea.escribirCsv(contenido);
+    }
+    else {
+        instantanea.escribirJson(contenido);
+        contenido << "\n";
+    }
+    std::string texto = contenido.str();
+    return escribirArchivoAtomico(ruta.c_str(), texto.data(), texto.size()); // Quien lo lee nunca ve una instantánea a medias
+}
+
+void imprimirEstadisticas(const InstantaneaEstadisticas& instantanea, std::ostream& salida) {
+    uint64_t victorias = instantanea.resultados[static_cast<size_t>(Resultado::Victoria)];
+    salida << "Por piso:           llegaron   superaron   victoria si llega   tiradas p50/p90" << std::endl;
+    for (size_t piso = 1; piso < instantanea.llegaron.size(); ++piso) {
+        uint64_t llegaron = instantanea.llegaron[piso];
+        if (llegaron == 0) {
+            continue;
+        }
+        salida << "  Piso " << std::left << std::setw(8) << piso << std::right << std::setw(12) << llegaron
+            << std::setw(12) << instantanea.superaron[piso] << std::setw(18) << std::fixed << std::setprecision(2)
+            << porcentaje(victorias, llegaron) << " %" << std::setw(10) << percentilTiradas(instantanea.tiradas[piso], 0.5)
+            << "/" << percentilTiradas(instantanea.tiradas[piso], 0.9) << std::endl;
+    }
+
+    uint64_t muertes = 0;
+    uint64_t sumaSalud = 0;
+    for (size_t i = 0; i < instantanea.saludAlMorir.size(); ++i) {
+        muertes += instantanea.saludAlMorir[i];
+        sumaSalud += i * instantanea.saludAlMorir[i];
+    }
+    if (muertes > 0) {
+        salida << "Salud al morir en una pelea: -" << std::setprecision(2)
+            << static_cast<double>(sumaSalud) / static_cast<double>(muertes) << " de media (" << muertes << " muertes)" << std::endl;
+    }
+
+    for (size_t rival = 0; rival < instantanea.reclutasPerdidas.size(); ++rival) {
+        const auto& cubetas = instantanea.reclutasPerdidas[rival];
+        uint64_t peleas = 0;
+        for (uint64_t cantidad : cubetas) {
+            peleas += cantidad;
+        }
+        if (peleas == 0) {
+            continue;
+        }
+        salida << "Reclutas perdidas por pelea (" << nombresRivales[rival] << ", " << peleas << " peleas):";
+        for (size_t i = 0; i < cubetas.size(); ++i) {
+            salida << "  " << i << ": " << std::setprecision(2) << porcentaje(cubetas[i], peleas) << " %";
+        }
+        salida << std::endl;
+    }
+
+    salida << "Cofres abiertos:";
+    for (size_t i = 0; i < instantanea.cofres.size(); ++i) {
+        salida << "  " << nombresCofres[i] << " " << instantanea.cofres[i];
+    }
+    salida << std::endl;
+
+    if (!instantanea.mejores.empty()) {
+        salida << "Victorias con menos tiradas:" << std::endl;
+        for (size_t i = 0; i < instantanea.mejores.size(); ++i) {
+            const MarcaPartida& marca = instantanea.mejores[i];
+            salida << "  " << std::setw(3) << (i + 1) << ". partida " << marca.flujo << ": " << marca.tiradas
+                << " tiradas, salud " << marca.salud << std::endl;
+        }
+    }
+}
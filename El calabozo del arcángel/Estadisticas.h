@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Calabozo.h"
+#include "Combate.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Estadísticas de resultados de muchas partidas jugadas en paralelo. Cada hilo
+ * anota en su propia FranjaEstadisticas y nadie más escribe en ella: anotar es
+ * sumar a un contador propio, sin candados ni instrucciones atómicas de
+ * lectura-modificación-escritura, así que los hilos no se estorban. Los
+ * contadores son atómicos solo para que otro hilo pueda sumar las franjas
+ * (EstadisticasSimulacion::instantanea) mientras se sigue jugando.
+ */
+
+/**
+ * Contador con un único escritor que cualquier hilo puede leer en cualquier momento.
+ */
+class CuentaCompartida {
+public:
+    void sumar(uint64_t n = 1) {
+        valor.store(valor.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint64_t leer() const {
+        return valor.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> valor{ 0 };
+};
+
+const int cubetasSalud = 64;    // Salud 0, -1, ..., -62 y la última para -63 o menos
+const int cubetasReclutas = 4;  // 0 a 3 reclutas perdidas en una pelea
+const int cubetasCofres = 3;    // chestContent 1 (arma), 2 (salud) y 3 (curación)
+
+/**
+ * Una partida de la tabla de mejores: la que venció al Arcángel con menos
+ * tiradas de dados; a igual tiradas, la de más salud y después la de flujo menor.
+ */
+struct MarcaPartida {
+    uint64_t flujo = 0;     // Número de la partida en la simulación
+    uint32_t tiradas = 0;   // Tiradas de dados de toda la partida
+    int32_t salud = 0;      // Salud del jugador al terminar
+
+    /**
+     * return true si esta marca va antes (es mejor) que la otra.
+     */
+    bool operator<(const MarcaPartida& otra) const {
+        if (tiradas != otra.tiradas) {
+            return tiradas < otra.tiradas;
+        }
+        if (salud != otra.salud) {
+            return salud > otra.salud;
+        }
+        return flujo < otra.flujo;
+    }
+};
+
+/**
+ * Suma de todas las franjas en un momento dado. Los vectores por piso empiezan
+ * en el piso 1 (la posición 0 no se usa). Cada piso tiene limiteTiradas + 2
+ * cubetas de tiradas: 0 a limiteTiradas, y la siguiente con la que se pierde la partida.
+ */
+struct InstantaneaEstadisticas {
+    uint64_t partidas = 0;
+    std::array<uint64_t, 5> resultados{};   // Por Resultado, en el orden del enum
+    std::vector<uint64_t> llegaron;         // Partidas que llegaron a cada piso
+    std::vector<uint64_t> superaron;        // Partidas que llegaron a la salida de cada piso
+    std::vector<std::vector<uint64_t>> tiradas; // Tiradas usadas para llegar a la salida de cada piso
+    std::array<uint64_t, cubetasSalud> saludAlMorir{};         // Cubeta i = salud -i al perder una pelea
+    std::array<std::array<uint64_t, cubetasReclutas>, 2> reclutasPerdidas{}; // Por RivalCombate: peleas según las reclutas caídas
+    std::array<uint64_t, cubetasCofres> cofres{};
+    std::vector<MarcaPartida> mejores;      // De mejor a peor
+
+    /**
+     * Todo en JSON, en una sola línea.
+     */
+    void escribirJson(std::ostream& salida) const;
+
+    /**
+     * Todo en CSV con columnas serie,piso,clave,valor,partida; una fila por
+     * contador o cubeta distinta de cero ('partida' solo en la tabla de mejores).
+     */
+    void escribirCsv(std::ostream& salida) const;
+};
+
+/**
+ * Contadores de un hilo. Solo ese hilo llama a los métodos anotar*, y juega
+ * sus partidas de a una: anotarPartida cierra la partida en curso.
+ */
+class FranjaEstadisticas {
+public:
+    /**
+     * param pisos Pisos del calabozo (los pisos mayores no se anotan).
+     * param limiteTiradas Equilibrio::limiteTiradas de las partidas (da las cubetas de tiradas).
+     * param mejores Tamaño de la tabla de mejores.
+     */
+    FranjaEstadisticas(int pisos, int limiteTiradas, size_t mejores);
+
+    FranjaEstadisticas(const FranjaEstadisticas&) = delete;
+    FranjaEstadisticas& operator=(const FranjaEstadisticas&) = delete;
+
+    /**
+     * El jugador llegó a la salida del piso con esas tiradas.
+     */
+    void anotarSalida(int piso, int tiradas);
+
+    /**
+     * Terminó una pelea. Si el jugador perdió, su salud va al histograma de salud al morir.
+     */
+    void anotarPelea(RivalCombate rival, bool victoria, int reclutasPerdidas, int saludJugador);
+
+    void anotarCofre(int contenido);
+
+    /**
+     * Terminó la partida: su resultado, los pisos a los que llegó y, si ganó,
+     * su lugar en la tabla de mejores.
+     */
+    void anotarPartida(const Partida& partida);
+
+    /**
+     * Suma esta franja a una instantánea. Se puede llamar desde cualquier hilo.
+     */
+    void sumarA(InstantaneaEstadisticas& instantanea) const;
+
+private:
+    struct PorPiso {
+        CuentaCompartida llegaron;
+        CuentaCompartida superaron;
+        std::vector<CuentaCompartida> tiradas;  // limiteTiradas + 2 cubetas
+    };
+
+    CuentaCompartida partidas;
+    std::array<CuentaCompartida, 5> resultados;
+    std::vector<PorPiso> pisos;
+    std::array<CuentaCompartida, cubetasSalud> saludAlMorir;
+    std::array<std::array<CuentaCompartida, cubetasReclutas>, 2> reclutasPerdidas;
+    std::array<CuentaCompartida, cubetasCofres> cofres;
+
+    uint64_t tiradasPartida = 0;        // Tiradas de los pisos ya superados en la partida en curso
+    size_t capacidadMejores;
+    std::vector<MarcaPartida> mejores;  // Montículo con la peor marca arriba
+    mutable std::mutex mutexMejores;    // Solo lo toman quien cambia la tabla y quien la lee
+};
+
+/**
+ * Las franjas de una simulación, una por hilo.
+ */
+class EstadisticasSimulacion {
+public:
+    EstadisticasSimulacion(size_t franjas, int pisos, int limiteTiradas, size_t mejores);
+
+    FranjaEstadisticas& franja(size_t i) {
+        return *franjas[i];
+    }
+
+    size_t numFranjas() const {
+        return franjas.size();
+    }
+
+    /**
+     * Suma todas las franjas. Se puede llamar mientras los hilos siguen anotando;
+     * cada contador sale consistente, aunque no todos del mismo instante.
+     */
+    InstantaneaEstadisticas instantanea() const;
+
+private:
+    std::vector<std::unique_ptr<FranjaEstadisticas>> franjas;
+    size_t mejores;
+};
+
+/**
+ * Escribe una instantánea en un archivo, de forma atómica: CSV si la ruta
+ * termina en ".csv" y JSON en cualquier otro caso.
+ */
+bool escribirEstadisticas(const InstantaneaEstadisticas& instantanea, const std::string& ruta);
+
+void imprimirEstadisticas(const InstantaneaEstadisticas& instantanea, std::ostream& salida);
@@ -0,0 +1,315 @@
+#include "GeneracionMasiva.h"
+#include "Bits.h"
+
+#include <cstddef>
+
+// El recorrido AVX2 se compila aunque el resto del programa no sea para AVX2 y
+// se elige al ejecutar, si el procesador lo tiene (generacionVectorial)
+#if defined(__AVX2__)
+#define CON_AVX2 1
+#define FUNCION_AVX2
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CON_AVX2 1
+#define FUNCION_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CON_AVX2 1
+#define FUNCION_AVX2        // MSVC acepta las instrucciones AVX2 sin /arch:AVX2
+#include <intrin.h>
+#endif
+
+#if defined(CON_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * Un sorteo uniforme(n) del generador. umbral es el de rechazo del método
+     * de Lemire ((2^32 - n) % n): si la parte baja del producto queda por
+     * debajo, uniforme() sortearía de nuevo.
+     */
+    struct Sorteo {
+        uint32_t caras;
+        uint32_t umbral;
+
+        explicit Sorteo(int n) : caras(static_cast<uint32_t>(n)), umbral((0u - static_cast<uint32_t>(n)) % static_cast<uint32_t>(n)) {}
+
+        /**
+         * Resultado del sorteo para 64 bits del generador.
+         * return false si uniforme() habría tenido que reintentar.
+         */
+        bool resolver(uint64_t bits, uint32_t& valor) const {
+            uint64_t producto = (bits >> 32) * caras;
+            valor = static_cast<uint32_t>(producto >> 32);
+            return static_cast<uint32_t>(producto) >= umbral;
+        }
+    };
+
+    /**
+     * Lo que comparten todas las celdas del piso.
+     */
+    struct GeneradorMasivo {
+        const GeneradorPartida& generador;
+        const ReglasCeldas& reglas;
+        int numero;             // Número de piso
+        uint64_t clave;         // GeneradorPartida::clavePiso de las celdas del piso
+        Sorteo enemigo, guardado, taberna, cofre, contenido;
+        Celda* celdas;
+        uint64_t* tiradasEnemigo;   // Plano de enemigos, con todas las tiradas antes del límite
+        uint64_t* guardados;
+        uint64_t* tabernas;
+        uint64_t* cofres;
+
+        explicit GeneradorMasivo(Partida& partida)
+            : generador(partida.generador), reglas(partida.equilibrio.celdas), numero(partida.pisoCalabozo),
+            clave(partida.generador.clavePiso(Proposito::Celda, static_cast<uint32_t>(partida.pisoCalabozo))),
+            enemigo(reglas.carasEnemigo), guardado(reglas.carasGuardado), taberna(reglas.carasTaberna),
+            cofre(reglas.carasCofre), contenido(3), celdas(partida.piso.celdas.data()),
+            tiradasEnemigo(partida.piso.plano(CeldaEnemigo)), guardados(partida.piso.plano(CeldaGuardado)),
+            tabernas(partida.piso.plano(CeldaTaberna)), cofres(partida.piso.plano(CeldaCofre)) {}
+
+        void anotar(uint64_t* plano, size_t i, bool valor) {
+            plano[i / 64] |= static_cast<uint64_t>(valor) << (i % 64);
+        }
+
+        /**
+         * Celda i con generarCelda, para cuando algún sorteo habría reintentado.
+         */
+        void generarExacta(size_t i) {
+            int64_t indice = static_cast<int64_t>(i);
+            Celda celda = generarCelda(generador, reglas, numero, indice, false);
+            celdas[i] = celda;
+            anotar(tiradasEnemigo, i, tiradaEnemigo(generador, reglas, numero, indice));
+            anotar(guardados, i, celda.tiene(CeldaGuardado));
+            anotar(tabernas, i, celda.tiene(CeldaTaberna));
+            anotar(cofres, i, celda.tiene(CeldaCofre));
+        }
+
+        /**
+         * Celdas [desde, hasta) de a una. Los índices caben en 32 bits (maxLadoTablero),
+         * así que el turno de los sorteos es siempre 0 y el contador es el número de tirada.
+         */
+        void generarEscalar(size_t desde, size_t hasta) {
+            for (size_t i = desde; i < hasta; ++i) {
+                uint64_t mezcla = mezclar64(clave ^ i);
+                uint32_t tiroEnemigo, tiroGuardado, tiroTaberna, tiroCofre, tiroContenido;
+                bool exacta = enemigo.resolver(mezclar64(mezcla), tiroEnemigo)
+                    & guardado.resolver(mezclar64(mezcla ^ 1), tiroGuardado)
+                    & taberna.resolver(mezclar64(mezcla ^ 2), tiroTaberna)
+                    & cofre.resolver(mezclar64(mezcla ^ 3), tiroCofre)
+                    & contenido.resolver(mezclar64(mezcla ^ 4), tiroContenido);
+                if (!exacta) {
+                    generarExacta(i);
+                    continue;
+                }
+                bool conGuardado = tiroGuardado == 0;
+                bool conTaberna = tiroTaberna == 0;
+                bool conCofre = tiroCofre == 0;
+                Celda celda;
+                celda.banderas = static_cast<uint8_t>(CeldaGuardado * conGuardado | CeldaTaberna * conTaberna | CeldaCofre * conCofre);
+                celda.chestContent = static_cast<uint8_t>(conCofre * (tiroContenido + 1));
+                celda.piso = static_cast<int16_t>(numero);
+                celdas[i] = celda;
+                anotar(tiradasEnemigo, i, tiroEnemigo == 0);
+                anotar(guardados, i, conGuardado);
+                anotar(tabernas, i, conTaberna);
+                anotar(cofres, i, conCofre);
+            }
+        }
+
+#if defined(CON_AVX2)
+        /**
+         * Parte baja del producto de 64 bits de cada carril (AVX2 solo multiplica de a 32 bits).
+         */
+        FUNCION_AVX2 static __m256i multiplicar(__m256i a, __m256i b) {
+            __m256i bajos = _mm256_mul_epu32(a, b);
+            __m256i cruzados = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+            return _mm256_add_epi64(bajos, _mm256_slli_epi64(cruzados, 32));
+        }
+
+        /**
+         * mezclar64 en cada carril.
+         */
+        FUNCION_AVX2 static __m256i mezclar(__m256i x) {
+            x = _mm256_add_epi64(x, _mm256_set1_epi64x(static_cast<long long>(0x9E3779B97F4A7C15ull)));
+            x = multiplicar(_mm256_xor_si256(x, _mm256_srli_epi64(x, 30)), _mm256_set1_epi64x(static_cast<long long>(0xBF58476D1CE4E5B9ull)));
+            x = multiplicar(_mm256_xor_si256(x, _mm256_srli_epi64(x, 27)), _mm256_set1_epi64x(static_cast<long long>(0x94D049BB133111EBull)));
+            return _mm256_xor_si256(x, _mm256_srli_epi64(x, 31));
+        }
+
+        /**
+         * Sorteo en cada carril: devuelve su valor y acumula en 'rechazos' los
+         * carriles en los que uniforme() habría reintentado.
+         */
+        FUNCION_AVX2 static __m256i sortear(__m256i bits, const Sorteo& sorteo, __m256i& rechazos) {
+            __m256i producto = _mm256_mul_epu32(_mm256_srli_epi64(bits, 32), _mm256_set1_epi64x(sorteo.caras));
+            __m256i bajo = _mm256_and_si256(producto, _mm256_set1_epi64x(0xFFFFFFFFll));
+            rechazos = _mm256_or_si256(rechazos, _mm256_cmpgt_epi64(_mm256_set1_epi64x(sorteo.umbral), bajo));
+            return _mm256_srli_epi64(producto, 32);
+        }
+
+        FUNCION_AVX2 static unsigned mascara(__m256i carriles) {
+            return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(carriles)));
+        }
+
+        /**
+         * Celdas [desde, hasta) de a cuatro; desde debe ser múltiplo de 4 para que
+         * los cuatro bits de cada grupo caigan en la misma palabra de los planos.
+         * return La primera celda que quedó sin generar.
+         */
+        FUNCION_AVX2 size_t generarVectorial(size_t desde, size_t hasta) {
+            static_assert(sizeof(Celda) == 8 && offsetof(Celda, chestContent) == 1 && offsetof(Celda, piso) == 2,
+                "Cada carril arma una celda como entero de 64 bits");
+            const __m256i cero = _mm256_setzero_si256();
+            const __m256i pasos = _mm256_set_epi64x(3, 2, 1, 0);
+            const __m256i fijos = _mm256_set1_epi64x(static_cast<long long>(static_cast<uint64_t>(static_cast<uint16_t>(numero)) << 16));
+            const __m256i uno = _mm256_set1_epi64x(1);
+            const __m256i bitCofre = _mm256_set1_epi64x(CeldaCofre);
+            size_t i = desde;
+            for (; i + 4 <= hasta; i += 4) {
+                __m256i indices = _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>(i)), pasos);
+                __m256i mezcla = mezclar(_mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(clave)), indices));
+                __m256i rechazos = cero;
+                __m256i conEnemigo = _mm256_cmpeq_epi64(sortear(mezclar(mezcla), enemigo, rechazos), cero);
+                __m256i conGuardado = _mm256_cmpeq_epi64(sortear(mezclar(_mm256_xor_si256(mezcla, uno)), guardado, rechazos), cero);
+                __m256i conTaberna = _mm256_cmpeq_epi64(
+                    sortear(mezclar(_mm256_xor_si256(mezcla, _mm256_set1_epi64x(2))), taberna, rechazos), cero);
+                __m256i conCofre = _mm256_cmpeq_epi64(
+                    sortear(mezclar(_mm256_xor_si256(mezcla, _mm256_set1_epi64x(3))), cofre, rechazos), cero);
+                __m256i tiroContenido = sortear(mezclar(_mm256_xor_si256(mezcla, _mm256_set1_epi64x(4))), contenido, rechazos);
+
+                __m256i celda = _mm256_or_si256(fijos, _mm256_and_si256(conGuardado, _mm256_set1_epi64x(CeldaGuardado)));
+                celda = _mm256_or_si256(celda, _mm256_and_si256(conTaberna, _mm256_set1_epi64x(CeldaTaberna)));
+                celda = _mm256_or_si256(celda, _mm256_and_si256(conCofre,
+                    _mm256_or_si256(bitCofre, _mm256_slli_epi64(_mm256_add_epi64(tiroContenido, uno), 8))));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(celdas + i), celda);
+
+                size_t palabra = i / 64;
+                unsigned desplazamiento = static_cast<unsigned>(i % 64);
+                tiradasEnemigo[palabra] |= static_cast<uint64_t>(mascara(conEnemigo)) << desplazamiento;
+                guardados[palabra] |= static_cast<uint64_t>(mascara(conGuardado)) << desplazamiento;
+                tabernas[palabra] |= static_cast<uint64_t>(mascara(conTaberna)) << desplazamiento;
+                cofres[palabra] |= static_cast<uint64_t>(mascara(conCofre)) << desplazamiento;
+
+                if (unsigned exactas = mascara(rechazos)) {
+                    for (size_t carril = 0; carril < 4; ++carril) {
+                        if (exactas & (1u << carril)) {
+                            uint64_t bit = ~(1ull << ((i + carril) % 64));
+                            tiradasEnemigo[palabra] &= bit;
+                            guardados[palabra] &= bit;
+                            tabernas[palabra] &= bit;
+                            cofres[palabra] &= bit;
+                            generarExacta(i + carril);
+                        }
+                    }
+                }
+            }
+            _mm256_zeroupper(); // Lo que sigue puede ser SSE sin VEX
+            return i;
+        }
+#endif
+    };
+
+    /**
+     * true si el procesador y el sistema permiten usar AVX2.
+     */
+    bool procesadorConAvx2() {
+#if defined(__AVX2__)
+        return true;
+#elif defined(CON_AVX2) && (defined(__GNUC__) || defined(__clang__))
+        return __builtin_cpu_supports("avx2");
+#elif defined(CON_AVX2)
+        int registros[4];
+        __cpuid(registros, 0);
+        if (registros[0] < 7) {
+            return false;
+        }
+        __cpuid(registros, 1);
+        bool avx = (registros[2] >> 27 & 1) && (registros[2] >> 28 & 1); // OSXSAVE y AVX
+        if (!avx || (_xgetbv(0) & 6) != 6) {
+            return false; // El sistema no guarda los registros de 256 bits
+        }
+        __cpuidex(registros, 7, 0);
+        return (registros[1] >> 5 & 1) != 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Aplica el límite de enemigos por partida al plano de tiradas de enemigo,
+     * que queda como el plano de enemigos del piso, y pone salud y ataque a los
+     * enemigos que quedan.
+     * return La posición, en el orden columna por columna, del último enemigo (-1 si no hay).
+     */
+    int64_t repartirEnemigos(Partida& partida, uint64_t* enemigos) {
+        Piso& piso = partida.piso;
+        const ReglasCeldas& reglas = partida.equilibrio.celdas;
+        size_t palabras = piso.palabrasPorPlano();
+        int64_t tiradas = 0;
+        for (size_t p = 0; p < palabras; ++p) {
+            tiradas += contarUnos(enemigos[p]);
+        }
+        int64_t quedan = partida.equilibrio.maxEnemigos - partida.numEnemies;
+
+        // Última posición que puede tener enemigo: si no caben todos, se buscan los primeros
+        // en el orden de crearCalabozo (unas caras de enemigo celdas por enemigo)
+        int64_t limite = static_cast<int64_t>(piso.columnas) * piso.filas;
+        if (tiradas > quedan) {
+            limite = -1;
+            int64_t elegidos = 0;
+            for (int64_t orden = 0; elegidos < quedan; ++orden) {
+                size_t i = static_cast<size_t>(piso.indice(static_cast<int>(orden / piso.filas), static_cast<int>(orden % piso.filas)));
+                if (enemigos[i / 64] >> (i % 64) & 1) {
+                    ++elegidos;
+                    limite = orden;
+                }
+            }
+        }
+
+        int64_t ultimoEnemigo = -1;
+        int16_t salud = static_cast<int16_t>(reglas.saludEnemigo + reglas.saludEnemigoPorPiso * partida.pisoCalabozo);
+        int16_t ataque = static_cast<int16_t>(reglas.ataqueEnemigo + reglas.ataqueEnemigoPorPiso * partida.pisoCalabozo);
+        for (size_t p = 0; p < palabras; ++p) {
+            for (uint64_t resto = enemigos[p]; resto != 0; resto &= resto - 1) {
+                int bit = primerUno(resto);
+                size_t i = p * 64 + static_cast<size_t>(bit);
+                int64_t orden = static_cast<int64_t>(i % static_cast<size_t>(piso.columnas)) * piso.filas
+                    + static_cast<int64_t>(i / static_cast<size_t>(piso.columnas));
+                if (orden > limite) {
+                    enemigos[p] &= ~(1ull << bit);
+                    continue;
+                }
+                Celda& celda = piso.celdas[i];
+                celda.poner(CeldaEnemigo, true);
+                celda.enemyHealth = salud;
+                celda.enemyAttack = ataque;
+                ++partida.numEnemies;
+                if (orden > ultimoEnemigo) {
+                    ultimoEnemigo = orden;
+                }
+            }
+        }
+        return ultimoEnemigo;
+    }
+}
+
+int64_t generarPisoMasivo(Partida& partida, bool vectorial) {
+    GeneradorMasivo masivo(partida);
+    size_t total = partida.piso.celdas.size();
+    size_t desde = 0;
+#if defined(CON_AVX2)
+    if (vectorial && generacionVectorial()) {
+        desde = masivo.generarVectorial(0, total);
+    }
+#else
+    (void)vectorial;
+#endif
+    masivo.generarEscalar(desde, total);
+    return repartirEnemigos(partida, masivo.tiradasEnemigo);
+}
+
+bool generacionVectorial() {
+    static const bool disponible = procesadorConAvx2();
+    return disponible;
+}
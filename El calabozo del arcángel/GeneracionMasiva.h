@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdint>
+
+/**
+ * Generación de un piso completo en un solo recorrido, para crearCalabozo.
+ *
+ * Da exactamente las mismas celdas que generarCelda celda por celda, pero:
+ * - La primera ronda de mezcla del generador (GeneradorPartida::mezclaCelda)
+ *   se calcula una vez por celda y la comparten sus cinco sorteos.
+ * - Los sorteos "uno en n" se resuelven con comparaciones, sin saltos, y la
+ *   celda se arma de una vez junto con sus bits en los planos de guardado,
+ *   taberna y cofre.
+ * - Si el procesador tiene AVX2 se generan cuatro celdas por instrucción; si
+ *   no, el mismo recorrido se hace de a una celda. El recorrido AVX2 se compila
+ *   siempre en x86 (no hace falta /arch:AVX2 ni -mavx2) y se elige al ejecutar.
+ *
+ * Las celdas cuyo sorteo necesitaría un reintento del método de Lemire (una
+ * en cientos de millones) se vuelven a generar con generarCelda.
+ *
+ * El límite de enemigos por partida se aplica después, sobre el plano de
+ * tiradas de enemigo: si todas caben se quedan todas; si no, solo las primeras
+ * en el orden columna por columna de crearCalabozo.
+ */
+
+/**
+ * Llena la cuadrícula de partida.piso (ya dimensionada, con cualquier
+ * contenido) y sus planos (ya dimensionados y en 0), y suma los enemigos
+ * nuevos a partida.numEnemies.
+ * param vectorial false para usar el recorrido de a una celda aunque haya AVX2.
+ * return La posición, en el orden columna por columna, de la última celda con enemigo (-1 si no hay).
+ */
+int64_t generarPisoMasivo(Partida& partida, bool vectorial = true);
+
+/**
+ * true si se usa el recorrido con AVX2: se compiló y el procesador lo tiene.
+ */
+bool generacionVectorial();
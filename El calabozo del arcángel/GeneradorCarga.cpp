@@ -0,0 +1,246 @@
+#include "GeneradorCarga.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ResultadoCarga generarCarga(const OpcionesCarga& opciones) {
+    std::cerr << "El generador de carga necesita sockets Unix y no esta disponible en Windows." << std::endl;
+    return ResultadoCarga();
+}
+
+#else
+
+namespace {
+    using Reloj = std::chrono::steady_clock;
+
+    struct SesionCarga {
+        int columnas = 10;
+        int filas = 10;
+        int columna = 0;
+        int fila = 0;
+        Reloj::time_point inicioTurno;
+        uint64_t partidas = 0;      // Partidas empezadas por esta sesión
+    };
+
+    struct ResultadoHilo {
+        uint64_t turnos = 0;
+        uint64_t partidas = 0;
+        uint64_t errores = 0;
+        std::vector<double> latencias;
+    };
+
+    int conectar(const std::string& ruta) {
+        int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un direccion = {};
+        direccion.sun_family = AF_UNIX;
+        if (descriptor < 0 || ruta.size() >= sizeof(direccion.sun_path)) {
+            return -1;
+        }
+        ruta.copy(direccion.sun_path, ruta.size());
+        if (connect(descriptor, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0) {
+            close(descriptor);
+            return -1;
+        }
+        return descriptor;
+    }
+
+    bool enviarTodo(int descriptor, const std::string& datos) {
+        size_t enviados = 0;
+        while (enviados < datos.size()) {
+            ssize_t n = send(descriptor, datos.data() + enviados, datos.size() - enviados, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            enviados += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * Dirección hacia la salida por el eje más lejano, como la política "salida".
+     */
+    char haciaLaSalida(const SesionCarga& sesion) {
+        int faltanColumnas = sesion.columnas - 1 - sesion.columna;
+        int faltanFilas = sesion.filas - 1 - sesion.fila;
+        return faltanColumnas >= faltanFilas ? 'D' : 'S';
+    }
+
+    /**
+     * Una conexión con sus sesiones. primera es el id de la primera sesión.
+     */
+    void cargarConexion(const OpcionesCarga& opciones, uint64_t primera, uint64_t cantidad,
+        std::atomic<uint64_t>& turnosRestantes, ResultadoHilo& resultado) {
+        int descriptor = conectar(opciones.ruta);
+        if (descriptor < 0) {
+            ++resultado.errores;
+            return;
+        }
+
+        std::vector<SesionCarga> sesiones(static_cast<size_t>(cantidad));
+        std::string salida;
+        for (uint64_t i = 0; i < cantidad; ++i) {
+            salida += std::to_string(primera + i) + " NUEVA " + std::to_string(opciones.semilla + primera + i) + "\n";
+        }
+        uint64_t enVuelo = cantidad;    // Comandos enviados sin respuesta
+        bool conectado = enviarTodo(descriptor, salida);
+
+        std::vector<char> buffer(64 * 1024);
+        std::string entrada;
+        while (conectado && enVuelo > 0) {
+            ssize_t leidos = read(descriptor, buffer.data(), buffer.size());
+            if (leidos <= 0) {
+                ++resultado.errores;
+                break;
+            }
+            entrada.append(buffer.data(), static_cast<size_t>(leidos));
+
+            // Todas las respuestas completas de esta lectura se contestan con un solo envío
+            salida.clear();
+            size_t inicio = 0;
+            size_t fin;
+            while ((fin = entrada.find('\n', inicio)) != std::string::npos) {
+                std::istringstream linea(entrada.substr(inicio, fin - inicio));
+                inicio = fin + 1;
+                --enVuelo;
+
+                uint64_t id = 0;
+                std::string tipo;
+                linea >> id >> tipo;
+                if (id < primera || id >= primera + cantidad) {
+                    ++resultado.errores;
+                    continue;
+                }
+                SesionCarga& sesion = sesiones[static_cast<size_t>(id - primera)];
+                std::string prefijo = std::to_string(id) + " ";
+
+                if (tipo == "OK") {
+                    linea >> sesion.columnas >> sesion.filas;
+                    sesion.columna = sesion.fila = 0;
+                }
+                else if (tipo == "PASOS") {
+                    salida += prefijo + "MOVER " + haciaLaSalida(sesion) + "\n";
+                    ++enVuelo;
+                    continue;
+                }
+                else if (tipo == "ESTADO") {
+                    int piso, salud;
+                    std::string estado;
+                    linea >> piso >> sesion.columna >> sesion.fila >> salud >> estado;
+                    double ms = std::chrono::duration<double, std::milli>(Reloj::now() - sesion.inicioTurno).count();
+                    resultado.latencias.push_back(ms);
+                    ++resultado.turnos;
+                    if (estado != "jugando") {
+                        ++resultado.partidas;
+                        ++sesion.partidas;
+                        if (turnosRestantes.load(std::memory_order_relaxed) > 0) {
+                            // Otra partida en la misma sesión, con otra semilla
+                            salida += prefijo + "NUEVA " + std::to_string(opciones.semilla + id + sesion.partidas * opciones.sesiones) + "\n";
+                            ++enVuelo;
+                        }
+                        continue;
+                    }
+                }
+                else {
+                    ++resultado.errores;
+                    continue;
+                }
+
+                // Siguiente turno de esta sesión, si todavía quedan turnos por jugar
+                uint64_t restantes = turnosRestantes.load(std::memory_order_relaxed);
+                while (restantes > 0 && !turnosRestantes.compare_exchange_weak(restantes, restantes - 1, std::memory_order_relaxed)) {
+                }
+                if (restantes > 0) {
+                    sesion.inicioTurno = Reloj::now();
+                    salida += prefijo + "TIRAR\n";
+                    ++enVuelo;
+                }
+            }
+            entrada.erase(0, inicio);
+            if (!salida.empty()) {
+                conectado = enviarTodo(descriptor, salida);
+            }
+        }
+        close(descriptor);
+    }
+}
+
+ResultadoCarga generarCarga(const OpcionesCarga& opciones) {
+    unsigned conexiones = std::max(1u, opciones.conexiones);
+    uint64_t sesiones = std::max<uint64_t>(opciones.sesiones, conexiones);
+    std::atomic<uint64_t> turnosRestantes{ opciones.turnos };
+    std::vector<ResultadoHilo> parciales(conexiones);
+    std::vector<std::thread> hilos;
+
+    auto inicio = Reloj::now();
+    uint64_t primera = 1;
+    for (unsigned c = 0; c < conexiones; ++c) {
+        uint64_t cantidad = sesiones / conexiones + (c < sesiones % conexiones ? 1 : 0);
+        hilos.emplace_back(cargarConexion, std::cref(opciones), primera, cantidad, std::ref(turnosRestantes), std::ref(parciales[c]));
+        primera += cantidad;
+    }
+    for (auto& hilo : hilos) {
+        hilo.join();
+    }
+
+    ResultadoCarga resultado;
+    resultado.segundos = std::chrono::duration<double>(Reloj::now() - inicio).count();
+    std::vector<double> latencias;
+    for (const ResultadoHilo& parcial : parciales) {
+        resultado.turnos += parcial.turnos;
+        resultado.partidas += parcial.partidas;
+        resultado.errores += parcial.errores;
+        latencias.insert(latencias.end(), parcial.latencias.begin(), parcial.latencias.end());
+    }
+
+    if (!latencias.empty()) {
+        std::sort(latencias.begin(), latencias.end());
+        double suma = 0.0;
+        for (double ms : latencias) {
+            suma += ms;
+        }
+        auto percentil = [&](double p) { return latencias[static_cast<size_t>(p * (latencias.size() - 1))]; };
+        resultado.latenciaMedia = suma / latencias.size();
+        resultado.latenciaP50 = percentil(0.50);
+        resultado.latenciaP99 = percentil(0.99);
+        resultado.latenciaMaxima = latencias.back();
+    }
+
+    if (opciones.apagarAlTerminar) {
+        int descriptor = conectar(opciones.ruta);
+        if (descriptor >= 0) {
+            enviarTodo(descriptor, "0 APAGAR\n");
+            char respuesta[64];
+            ssize_t leidos = read(descriptor, respuesta, sizeof(respuesta)); // Esperar el ADIOS
+            (void)leidos;
+            close(descriptor);
+        }
+    }
+    return resultado;
+}
+
+#endif
+
+void imprimirCarga(const ResultadoCarga& resultado, std::ostream& salida) {
+    double porSegundo = resultado.segundos > 0.0 ? resultado.turnos / resultado.segundos : 0.0;
+    salida << std::fixed << std::setprecision(3);
+    salida << "Turnos jugados: " << resultado.turnos << " en " << resultado.segundos << " s ("
+        << std::setprecision(0) << porSegundo << " turnos/s)" << std::endl;
+    salida << "Partidas terminadas: " << resultado.partidas << ", errores: " << resultado.errores << std::endl;
+    salida << std::setprecision(3);
+    salida << "Latencia por turno (ms): media " << resultado.latenciaMedia << ", p50 " << resultado.latenciaP50
+        << ", p99 " << resultado.latenciaP99 << ", max " << resultado.latenciaMaxima << std::endl;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Opciones del generador de carga para el servidor (ver Servidor.h).
+ */
+struct OpcionesCarga {
+    std::string ruta;               // Socket Unix del servidor
+    unsigned conexiones = 8;        // Conexiones abiertas, cada una en su hilo
+    uint64_t sesiones = 1000;       // Partidas simultáneas, repartidas entre las conexiones
+    uint64_t turnos = 200000;       // Turnos a jugar en total
+    uint64_t semilla = 1;           // Semilla base de las partidas
+    bool apagarAlTerminar = false;  // Enviar APAGAR al servidor al final
+};
+
+struct ResultadoCarga {
+    uint64_t turnos = 0;
+    uint64_t partidas = 0;          // Partidas terminadas (y reemplazadas por otras)
+    uint64_t errores = 0;
+    double segundos = 0.0;
+    double latenciaMedia = 0.0;     // Milisegundos desde TIRAR hasta la respuesta de MOVER
+    double latenciaP50 = 0.0;
+    double latenciaP99 = 0.0;
+    double latenciaMaxima = 0.0;
+};
+
+/**
+ * Juega turnos contra el servidor con todas las sesiones siempre ocupadas: en
+ * cuanto una sesión recibe su respuesta envía el siguiente comando, y cuando una
+ * partida termina empieza otra. Cada turno es TIRAR + MOVER hacia la salida.
+ */
+ResultadoCarga generarCarga(const OpcionesCarga& opciones);
+
+void imprimirCarga(const ResultadoCarga& resultado, std::ostream& salida);
@@ -0,0 +1,829 @@
+#include "Guardado.h"
+#include "Instrumentacion.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t calcularSuma(const unsigned char* datos, size_t bytes) {
+    uint64_t suma = 0xCBF29CE484222325ull ^ bytes;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t palabra;
+        std::memcpy(&palabra, datos + i, 8);
+        suma = (suma ^ palabra) * 0x100000001B3ull;
+        suma ^= suma >> 29;
+    }
+    for (; i < bytes; ++i) {
+        suma = (suma ^ datos[i]) * 0x100000001B3ull;
+    }
+    return mezclar64(suma);
+}
+
+namespace {
+    const char firmaGuardado[4] = { 'C', 'A', 'L', 'B' };
+    const uint16_t versionGuardado = 1;
+
+    /**
+     * Cabecera del archivo binario. La suma de verificación cubre todo lo que va después.
+     */
+    struct CabeceraGuardado {
+        char firma[4];
+        uint16_t version;
+        uint16_t tamanoCabecera;
+        uint32_t columnas;
+        uint32_t filas;
+        uint64_t bytesDatos;        // Tamaño de RegistroPartida + celdas
+        uint64_t sumaVerificacion;
+    };
+
+    struct RegistroRecluta {
+        char nombre[24];
+        int32_t health;
+        int32_t attackPower;
+    };
+
+    /**
+     * Todo lo que no es el piso: jugador, equipo, contadores y generador.
+     */
+    struct RegistroPartida {
+        uint64_t semilla;
+        uint64_t flujo;
+        int32_t pisoCalabozo;
+        int32_t numEnemies;
+        int32_t numDiceThrows;
+        int32_t posicion;           // Índice de la celda del jugador
+        int32_t health;
+        int32_t attackPower;
+        int32_t numReclutas;
+        int32_t numPisos;           // 0 en los guardados anteriores a que fuera configurable: 10
+        RegistroRecluta reclutas[3];
+    };
+
+    struct RegistroCelda {
+        uint8_t banderas;           // BanderaCelda
+        uint8_t chestContent;
+        int16_t piso;
+        int16_t enemyHealth;
+        int16_t enemyAttack;
+    };
+
+    const char firmaDelta[4] = { 'C', 'D', 'E', 'L' };
+    const uint16_t versionDelta = 1;
+
+    /**
+     * Cabecera del guardado delta. El piso base es el que da el generador con
+     * semillaBase, flujoBase, pisoBase y ultimoEnemigo (ver Piso::celdaGenerada);
+     * detrás van el RegistroPartida y las celdas que no coinciden con él.
+     */
+    struct CabeceraDelta {
+        char firma[4];
+        uint16_t version;
+        uint16_t tamanoCabecera;
+        uint32_t columnas;
+        uint32_t filas;
+        uint64_t semillaBase;
+        uint64_t flujoBase;
+        int64_t ultimoEnemigo;
+        int32_t pisoBase;
+        uint32_t numDiferentes;     // Celdas escritas
+        uint64_t bytesDatos;        // Tamaño de RegistroPartida + celdas
+        uint64_t sumaVerificacion;
+    };
+
+    static_assert(sizeof(CabeceraGuardado) == 32, "La cabecera no debe tener relleno");
+    static_assert(sizeof(CabeceraDelta) == 64, "La cabecera no debe tener relleno");
+    static_assert(sizeof(RegistroCelda) == 8, "Cada celda ocupa 8 bytes");
+    static_assert(std::is_trivially_copyable<RegistroPartida>::value, "El registro se copia byte a byte");
+
+    // Copian un campo en la dirección de guardado (partida -> registro) o de carga (registro -> partida).
+    struct HaciaRegistro {
+        template <class A, class B>
+        void operator()(A& registro, const B& partida) const { registro = static_cast<A>(partida); }
+        void operator()(char (&registro)[24], const std::string& partida) const {
+            std::memset(registro, 0, sizeof(registro));
+            std::memcpy(registro, partida.data(), std::min(partida.size(), sizeof(registro) - 1));
+        }
+    };
+
+    struct DesdeRegistro {
+        template <class A, class B>
+        void operator()(const A& registro, B& partida) const { partida = static_cast<B>(registro); }
+        void operator()(const char (&registro)[24], std::string& partida) const {
+            partida.assign(registro, strnlen(registro, sizeof(registro)));
+        }
+    };
+
+    /**
+     * Lista única de campos del registro de partida. La usan tanto el guardado como la
+     * carga, así que es imposible guardar un campo y olvidarse de leerlo (o al revés).
+     * param P Partida o const Partida, según la dirección.
+     */
+    template <class P, class R, class Copiar>
+    void transferirCampos(P& partida, R& registro, int& posicion, Copiar copiar) {
+        copiar(registro.pisoCalabozo, partida.pisoCalabozo);
+        copiar(registro.numEnemies, partida.numEnemies);
+        copiar(registro.numDiceThrows, partida.numDiceThrows);
+        copiar(registro.numPisos, partida.numPisos);
+        copiar(registro.posicion, posicion);
+        copiar(registro.health, partida.jugador.health);
+        copiar(registro.attackPower, partida.jugador.attackPower);
+        for (size_t i = 0; i < partida.jugador.equipo.size() && i < 3; ++i) {
+            copiar(registro.reclutas[i].nombre, partida.jugador.equipo[i].nombre);
+            copiar(registro.reclutas[i].health, partida.jugador.equipo[i].health);
+            copiar(registro.reclutas[i].attackPower, partida.jugador.equipo[i].attackPower);
+        }
+    }
+
+    RegistroPartida registroDe(const Partida& partida) {
+        RegistroPartida registro = {};
+        registro.semilla = partida.generador.obtenerSemilla();
+        registro.flujo = partida.generador.obtenerFlujo();
+        registro.numReclutas = static_cast<int32_t>(std::min<size_t>(partida.jugador.equipo.size(), 3));
+        int posicion = partida.jugador.posicion ? static_cast<int>(partida.piso.indiceDe(partida.jugador.posicion)) : -1;
+        transferirCampos(partida, registro, posicion, HaciaRegistro());
+        return registro;
+    }
+
+    bool registroValido(const RegistroPartida& registro, uint64_t numCeldas) {
+        int numPisos = registro.numPisos > 0 ? registro.numPisos : 10; // Como aplicarRegistro
+        return registro.numReclutas >= 0 && registro.numReclutas <= 3 && registro.numPisos >= 0 && registro.numPisos <= maxPisos
+            && registro.pisoCalabozo >= 1 && registro.pisoCalabozo <= numPisos
+            && registro.posicion >= 0 && static_cast<uint64_t>(registro.posicion) < numCeldas;
+    }
+
+    /**
+     * Pasa a la partida todo lo que no es el piso.
+     * return Índice de la celda del jugador.
+     */
+    int aplicarRegistro(Partida& partida, const RegistroPartida& registro) {
+        partida.generador = GeneradorPartida(registro.semilla, registro.flujo);
+        partida.jugador.equipo.assign(static_cast<size_t>(registro.numReclutas), Recluta());
+        int posicion = 0;
+        transferirCampos(partida, registro, posicion, DesdeRegistro());
+        if (partida.numPisos <= 0) {
+            partida.numPisos = 10;
+        }
+        return posicion;
+    }
+
+    RegistroCelda celdaARegistro(const Celda& celda) {
+        RegistroCelda registro;
+        registro.banderas = celda.banderas;
+        registro.chestContent = celda.chestContent;
+        registro.piso = celda.piso;
+        registro.enemyHealth = celda.enemyHealth;
+        registro.enemyAttack = celda.enemyAttack;
+        return registro;
+    }
+
+    Celda registroACelda(const RegistroCelda& registro) {
+        Celda celda;
+        celda.banderas = static_cast<uint8_t>(registro.banderas & (CeldaJugador | CeldaVisitada | CeldaEnemigo | CeldaGuardado | CeldaTaberna | CeldaCofre));
+        celda.chestContent = registro.chestContent;
+        celda.piso = registro.piso;
+        celda.enemyHealth = registro.enemyHealth;
+        celda.enemyAttack = registro.enemyAttack;
+        return celda;
+    }
+
+    /**
+     * Escribe 'ruta.tmp' y no vuelve hasta que sus datos están en disco.
+     */
+    bool escribirTemporal(const std::string& temporal, const void* datos, size_t bytes) {
+        const char* origen = static_cast<const char*>(datos);
+#ifdef _WIN32
+        HANDLE manejador = CreateFileA(temporal.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (manejador == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        bool correcto = true;
+        while (correcto && bytes > 0) {
+            DWORD escritos = 0;
+            DWORD bloque = static_cast<DWORD>(std::min<size_t>(bytes, 1u << 30));
+            correcto = WriteFile(manejador, origen, bloque, &escritos, nullptr) && escritos > 0;
+            origen += escritos;
+            bytes -= escritos;
+        }
+        correcto = correcto && FlushFileBuffers(manejador);
+        CloseHandle(manejador);
+#else
+        int descriptor = open(temporal.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (descriptor < 0) {
+            return false;
+        }
+        bool correcto = true;
+        while (correcto && bytes > 0) {
+            ssize_t escritos = write(descriptor, origen, bytes);
+            correcto = escritos > 0;
+            if (correcto) {
+                origen += escritos;
+                bytes -= static_cast<size_t>(escritos);
+            }
+        }
+        correcto = correcto && fsync(descriptor) == 0;
+        correcto = close(descriptor) == 0 && correcto;
+#endif
+        if (!correcto) {
+            std::remove(temporal.c_str());
+        }
+        return correcto;
+    }
+
+    /**
+     * Renombra el temporal sobre el archivo definitivo. En POSIX también fuerza a
+     * disco el directorio para que el cambio de nombre sobreviva a un corte.
+     */
+    bool reemplazarArchivo(const std::string& temporal, const char* ruta) {
+#ifdef _WIN32
+        return MoveFileExA(temporal.c_str(), ruta, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        if (std::rename(temporal.c_str(), ruta) != 0) {
+            return false;
+        }
+        std::string directorio(ruta);
+        size_t barra = directorio.find_last_of('/');
+        directorio = (barra == std::string::npos) ? "." : directorio.substr(0, barra + 1);
+        int descriptor = open(directorio.c_str(), O_RDONLY);
+        if (descriptor >= 0) {
+            fsync(descriptor);
+            close(descriptor);
+        }
+        return true;
+#endif
+    }
+
+    void escribirVarint(std::vector<unsigned char>& destino, uint64_t valor) {
+        while (valor >= 0x80) {
+            destino.push_back(static_cast<unsigned char>(valor | 0x80));
+            valor >>= 7;
+        }
+        destino.push_back(static_cast<unsigned char>(valor));
+    }
+
+    bool leerVarint(const unsigned char*& actual, const unsigned char* fin, uint64_t& valor) {
+        valor = 0;
+        for (int desplazamiento = 0; desplazamiento < 64 && actual < fin; desplazamiento += 7) {
+            unsigned char byte = *actual++;
+            valor |= static_cast<uint64_t>(byte & 0x7F) << desplazamiento;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Piso perezoso vacío que solo sirve para pedirle celdaGenerada.
+     */
+    Piso pisoBase(int columnas, int filas, const GeneradorPartida& generador, int numero, int64_t ultimoEnemigo) {
+        Piso base;
+        base.columnas = columnas;
+        base.filas = filas;
+        base.perezoso = true;
+        base.generado = true;
+        base.generador = generador;
+        base.numero = numero;
+        base.ultimoEnemigo = ultimoEnemigo;
+        return base;
+    }
+
+    /**
+     * Valida el contenido de un 'partida.delta' y, si está bien, rehace con él
+     * el piso completo (o perezoso, con partida.pisosPerezosos) y la partida.
+     */
+    bool deserializarPartidaDelta(Partida& partida, const unsigned char* contenido, size_t tamano, const char* ruta) {
+        CabeceraDelta cabecera;
+        if (tamano < sizeof(cabecera)) {
+            return false;
+        }
+        std::memcpy(&cabecera, contenido, sizeof(cabecera));
+        if (std::memcmp(cabecera.firma, firmaDelta, sizeof(firmaDelta)) != 0 || cabecera.version != versionDelta
+            || cabecera.tamanoCabecera != sizeof(CabeceraDelta)) {
+            std::cerr << "Error: '" << ruta << "' no es una partida guardada compatible." << std::endl;
+            return false;
+        }
+        if (cabecera.bytesDatos < sizeof(RegistroPartida) || tamano - sizeof(CabeceraDelta) != cabecera.bytesDatos) {
+            std::cerr << "Error: '" << ruta << "' está incompleto." << std::endl;
+            return false;
+        }
+        const unsigned char* datos = contenido + sizeof(CabeceraDelta);
+        if (calcularSuma(datos, static_cast<size_t>(cabecera.bytesDatos)) != cabecera.sumaVerificacion) {
+            std::cerr << "Error: '" << ruta << "' está dañado (la suma de verificación no coincide)." << std::endl;
+            return false;
+        }
+
+        Tablero tablero;
+        tablero.columnas = static_cast<int>(std::min<uint32_t>(cabecera.columnas, maxLadoTablero + 1));
+        tablero.filas = static_cast<int>(std::min<uint32_t>(cabecera.filas, maxLadoTablero + 1));
+        tablero.pisos = 1;
+        uint64_t numCeldas = static_cast<uint64_t>(cabecera.columnas) * cabecera.filas;
+        RegistroPartida registro;
+        std::memcpy(&registro, datos, sizeof(registro));
+        if (!tableroValido(tablero) || !registroValido(registro, numCeldas) || cabecera.numDiferentes > numCeldas) {
+            std::cerr << "Error: '" << ruta << "' contiene datos fuera de rango." << std::endl;
+            return false;
+        }
+
+        // Las celdas se leen enteras antes de tocar la partida
+        std::vector<std::pair<int64_t, Celda>> diferentes(cabecera.numDiferentes);
+        const unsigned char* actual = datos + sizeof(RegistroPartida);
+        const unsigned char* fin = datos + cabecera.bytesDatos;
+        uint64_t siguiente = 0; // Primer índice que puede tener la próxima celda
+        for (auto& diferente : diferentes) {
+            uint64_t salto;
+            if (!leerVarint(actual, fin, salto) || salto >= numCeldas - siguiente
+                || static_cast<size_t>(fin - actual) < sizeof(RegistroCelda)) {
+                std::cerr << "Error: '" << ruta << "' contiene datos fuera de rango." << std::endl;
+                return false;
+            }
+            RegistroCelda celda;
+            std::memcpy(&celda, actual, sizeof(celda));
+            actual += sizeof(celda);
+            diferente.first = static_cast<int64_t>(siguiente + salto);
+            diferente.second = registroACelda(celda);
+            siguiente += salto + 1;
+        }
+        if (actual != fin) {
+            std::cerr << "Error: '" << ruta << "' contiene datos fuera de rango." << std::endl;
+            return false;
+        }
+
+        Piso& piso = partida.piso;
+        liberarPiso(piso);
+        piso = pisoBase(tablero.columnas, tablero.filas, GeneradorPartida(cabecera.semillaBase, cabecera.flujoBase),
+            cabecera.pisoBase, cabecera.ultimoEnemigo);
+        if (partida.pisosPerezosos) {
+            piso.modificadas.reiniciar(partida.arena);
+            for (const auto& diferente : diferentes) {
+                Piso::CeldaModificada modificada = { diferente.second, diferente.first };
+                piso.modificadas.insertar(diferente.first, modificada);
+            }
+        }
+        else {
+            piso.perezoso = false;
+            piso.celdas.asignar(static_cast<size_t>(numCeldas), Celda(), partida.arena);
+            for (size_t i = 0; i < piso.celdas.size(); ++i) {
+                piso.celdas[i] = piso.celdaGenerada(static_cast<int64_t>(i));
+            }
+            piso.tocadas.asignar(piso.palabrasPorPlano(), 0, partida.arena);
+            for (const auto& diferente : diferentes) {
+                piso.celdas[static_cast<size_t>(diferente.first)] = diferente.second;
+                piso.tocar(&piso.celdas[static_cast<size_t>(diferente.first)]);
+            }
+            piso.reconstruirPlanos(partida.arena);
+        }
+
+        int posicion = aplicarRegistro(partida, registro);
+        partida.jugador.posicion = piso.celda(posicion % piso.columnas, posicion / piso.columnas);
+        piso.marcar(partida.jugador.posicion, CeldaJugador, true);
+        piso.marcar(partida.jugador.posicion, CeldaVisitada, true);
+        return true;
+    }
+
+    bool existeArchivo(const std::string& ruta) {
+        std::ifstream archivo(ruta);
+        return archivo.is_open();
+    }
+
+    const char* rutaCeldas = "celdas.txt";
+    const char* rutaJugador = "jugador.txt";
+}
+
+bool escribirArchivoAtomico(const char* ruta, const void* datos, size_t bytes) {
+    CONTAR_ACTIVO(Contador::BytesEscritos, bytes);
+    CONTAR_ACTIVO(Contador::Vaciados, 1); // El fsync del temporal
+    std::string temporal = std::string(ruta) + ".tmp";
+    return escribirTemporal(temporal, datos, bytes) && reemplazarArchivo(temporal, ruta);
+}
+
+bool publicarArchivoAtomico(const char* ruta, const void* datos, size_t bytes) {
+    CONTAR_ACTIVO(Contador::BytesEscritos, bytes);
+    CONTAR_ACTIVO(Contador::Vaciados, 1);
+#ifdef _WIN32
+    unsigned long proceso = GetCurrentProcessId();
+#else
+    unsigned long proceso = static_cast<unsigned long>(getpid());
+#endif
+    std::string temporal = std::string(ruta) + "." + std::to_string(proceso) + "-"
+        + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    if (escribirTemporal(temporal, datos, bytes) && reemplazarArchivo(temporal, ruta)) {
+        return true;
+    }
+    std::remove(temporal.c_str());
+    return false;
+}
+
+ArchivoMapeado::ArchivoMapeado(const char* ruta) {
+#ifdef _WIN32
+    HANDLE manejador = CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (manejador == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    archivo = manejador;
+
+    LARGE_INTEGER tam;
+    if (!GetFileSizeEx(manejador, &tam) || tam.QuadPart == 0) {
+        return;
+    }
+    mapeo = CreateFileMappingA(manejador, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapeo) {
+        return;
+    }
+    datos = static_cast<const unsigned char*>(MapViewOfFile(mapeo, FILE_MAP_READ, 0, 0, 0));
+    bytes = datos ? static_cast<size_t>(tam.QuadPart) : 0;
+#else
+    int descriptor = open(ruta, O_RDONLY);
+    if (descriptor < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+        void* mapa = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapa != MAP_FAILED) {
+            datos = static_cast<const unsigned char*>(mapa);
+            bytes = static_cast<size_t>(info.st_size);
+        }
+    }
+    close(descriptor); // El mapeo sigue válido sin el descriptor
+#endif
+}
+
+ArchivoMapeado::~ArchivoMapeado() {
+#ifdef _WIN32
+    if (datos) {
+        UnmapViewOfFile(datos);
+    }
+    if (mapeo) {
+        CloseHandle(mapeo);
+    }
+    if (archivo) {
+        CloseHandle(archivo);
+    }
+#else
+    if (datos) {
+        munmap(const_cast<unsigned char*>(datos), bytes);
+    }
+#endif
+}
+
+std::vector<unsigned char> serializarPartidaBinaria(const Partida& partida) {
+    const Piso& piso = partida.piso;
+    size_t numCeldas = static_cast<size_t>(piso.columnas) * piso.filas;
+    size_t bytesDatos = sizeof(RegistroPartida) + numCeldas * sizeof(RegistroCelda);
+    std::vector<unsigned char> buffer(sizeof(CabeceraGuardado) + bytesDatos);
+
+    RegistroPartida registro = registroDe(partida);
+    std::memcpy(buffer.data() + sizeof(CabeceraGuardado), &registro, sizeof(registro));
+
+    unsigned char* destino = buffer.data() + sizeof(CabeceraGuardado) + sizeof(RegistroPartida);
+    for (int fila = 0; fila < piso.filas; ++fila) {
+        for (int columna = 0; columna < piso.columnas; ++columna) {
+            RegistroCelda celda = celdaARegistro(piso.consultar(columna, fila));
+            std::memcpy(destino + static_cast<size_t>(piso.indice(columna, fila)) * sizeof(RegistroCelda), &celda, sizeof(celda));
+        }
+    }
+
+    CabeceraGuardado cabecera = {};
+    std::memcpy(cabecera.firma, firmaGuardado, sizeof(firmaGuardado));
+    cabecera.version = versionGuardado;
+    cabecera.tamanoCabecera = sizeof(CabeceraGuardado);
+    cabecera.columnas = static_cast<uint32_t>(piso.columnas);
+    cabecera.filas = static_cast<uint32_t>(piso.filas);
+    cabecera.bytesDatos = bytesDatos;
+    cabecera.sumaVerificacion = calcularSuma(buffer.data() + sizeof(CabeceraGuardado), bytesDatos);
+    std::memcpy(buffer.data(), &cabecera, sizeof(cabecera));
+    return buffer;
+}
+
+bool guardarPartidaBinaria(const Partida& partida, const char* ruta) {
+    std::vector<unsigned char> buffer = serializarPartidaBinaria(partida);
+    if (!escribirArchivoAtomico(ruta, buffer.data(), buffer.size())) {
+        std::cerr << "Error: No se pudo escribir el archivo '" << ruta << "' para guardar la partida." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool cargarPartidaBinaria(Partida& partida, const char* ruta) {
+    ArchivoMapeado archivo(ruta);
+    if (!archivo.abierto()) {
+        return false;
+    }
+    return deserializarPartidaBinaria(partida, archivo.contenido(), archivo.tamano(), ruta);
+}
+
+bool deserializarPartidaBinaria(Partida& partida, const unsigned char* contenido, size_t tamano, const char* ruta) {
+    if (tamano < sizeof(CabeceraGuardado)) {
+        return false;
+    }
+
+    CabeceraGuardado cabecera;
+    std::memcpy(&cabecera, contenido, sizeof(cabecera));
+    if (std::memcmp(cabecera.firma, firmaGuardado, sizeof(firmaGuardado)) != 0 || cabecera.version != versionGuardado
+        || cabecera.tamanoCabecera != sizeof(CabeceraGuardado)) {
+        std::cerr << "Error: '" << ruta << "' no es una partida guardada compatible." << std::endl;
+        return false;
+    }
+
+    // Con lados fuera de rango el tamaño esperado podría dar la vuelta y pasar la comprobación
+    Tablero tablero;
+    tablero.columnas = static_cast<int>(std::min<uint32_t>(cabecera.columnas, maxLadoTablero + 1));
+    tablero.filas = static_cast<int>(std::min<uint32_t>(cabecera.filas, maxLadoTablero + 1));
+    tablero.pisos = 1;
+    if (!tableroValido(tablero)) {
+        std::cerr << "Error: '" << ruta << "' contiene datos fuera de rango." << std::endl;
+        return false;
+    }
+    uint64_t numCeldas = static_cast<uint64_t>(cabecera.columnas) * cabecera.filas;
+    if (cabecera.bytesDatos != sizeof(RegistroPartida) + numCeldas * sizeof(RegistroCelda)
+        || tamano != sizeof(CabeceraGuardado) + cabecera.bytesDatos) {
+        std::cerr << "Error: '" << ruta << "' está incompleto." << std::endl;
+        return false;
+    }
+
+    const unsigned char* datos = contenido + sizeof(CabeceraGuardado);
+    if (calcularSuma(datos, static_cast<size_t>(cabecera.bytesDatos)) != cabecera.sumaVerificacion) {
+        std::cerr << "Error: '" << ruta << "' está dañado (la suma de verificación no coincide)." << std::endl;
+        return false;
+    }
+
+    RegistroPartida registro;
+    std::memcpy(&registro, datos, sizeof(registro));
+    if (!registroValido(registro, numCeldas)) {
+        std::cerr << "Error: '" << ruta << "' contiene datos fuera de rango." << std::endl;
+        return false;
+    }
+
+    Piso& piso = partida.piso;
+    liberarPiso(piso); // Un piso cargado siempre es una cuadrícula completa
+    piso.columnas = static_cast<int>(cabecera.columnas);
+    piso.filas = static_cast<int>(cabecera.filas);
+    piso.celdas.asignar(static_cast<size_t>(numCeldas), Celda(), partida.arena);
+    const unsigned char* origen = datos + sizeof(RegistroPartida);
+    for (size_t i = 0; i < piso.celdas.size(); ++i) {
+        RegistroCelda celda;
+        std::memcpy(&celda, origen + i * sizeof(RegistroCelda), sizeof(celda));
+        piso.celdas[i] = registroACelda(celda);
+    }
+
+    int posicion = aplicarRegistro(partida, registro);
+    partida.jugador.posicion = &piso.celdas[static_cast<size_t>(posicion)];
+    partida.jugador.posicion->poner(CeldaJugador, true);
+    partida.jugador.posicion->poner(CeldaVisitada, true);
+    piso.reconstruirPlanos(partida.arena);
+    return true;
+}
+
+std::vector<unsigned char> serializarPartidaDelta(const Partida& partida) {
+    const Piso& piso = partida.piso;
+    // Un piso que no salió del generador (uno cargado de texto o de 'partida.dat')
+    // se compara entero con el que daría la semilla de la partida
+    Piso base = piso.generado
+        ? pisoBase(piso.columnas, piso.filas, piso.generador, piso.numero, piso.ultimoEnemigo)
+        : pisoBase(piso.columnas, piso.filas, partida.generador, partida.pisoCalabozo, -1);
+
+    std::vector<int64_t> candidatas;
+    if (!piso.generado) {
+        candidatas.resize(static_cast<size_t>(piso.columnas) * piso.filas);
+        for (size_t i = 0; i < candidatas.size(); ++i) {
+            candidatas[i] = static_cast<int64_t>(i);
+        }
+    }
+    else if (piso.perezoso) {
+        candidatas.reserve(piso.modificadas.size());
+        piso.modificadas.paraCada([&](int64_t indice, const Piso::CeldaModificada&) { candidatas.push_back(indice); });
+        std::sort(candidatas.begin(), candidatas.end());
+    }
+    else {
+        for (size_t p = 0; p < piso.tocadas.size(); ++p) {
+            for (uint64_t resto = piso.tocadas[p]; resto != 0; resto &= resto - 1) {
+                candidatas.push_back(static_cast<int64_t>(p * 64 + static_cast<size_t>(primerUno(resto))));
+            }
+        }
+    }
+
+    std::vector<unsigned char> buffer(sizeof(CabeceraDelta) + sizeof(RegistroPartida));
+    RegistroPartida registro = registroDe(partida);
+    std::memcpy(buffer.data() + sizeof(CabeceraDelta), &registro, sizeof(registro));
+
+    uint32_t numDiferentes = 0;
+    int64_t siguiente = 0;
+    for (int64_t indice : candidatas) {
+        RegistroCelda actual = celdaARegistro(piso.consultar(static_cast<int>(indice % piso.columnas), static_cast<int>(indice / piso.columnas)));
+        RegistroCelda generada = celdaARegistro(base.celdaGenerada(indice));
+        if (std::memcmp(&actual, &generada, sizeof(actual)) == 0) {
+            continue; // Se tocó pero quedó como la dejó el generador
+        }
+        escribirVarint(buffer, static_cast<uint64_t>(indice - siguiente));
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&actual);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(actual));
+        siguiente = indice + 1;
+        ++numDiferentes;
+    }
+
+    CabeceraDelta cabecera = {};
+    std::memcpy(cabecera.firma, firmaDelta, sizeof(firmaDelta));
+    cabecera.version = versionDelta;
+    cabecera.tamanoCabecera = sizeof(CabeceraDelta);
+    cabecera.columnas = static_cast<uint32_t>(piso.columnas);
+    cabecera.filas = static_cast<uint32_t>(piso.filas);
+    cabecera.semillaBase = base.generador.obtenerSemilla();
+    cabecera.flujoBase = base.generador.obtenerFlujo();
+    cabecera.ultimoEnemigo = base.ultimoEnemigo;
+    cabecera.pisoBase = base.numero;
+    cabecera.numDiferentes = numDiferentes;
+    cabecera.bytesDatos = buffer.size() - sizeof(CabeceraDelta);
+    cabecera.sumaVerificacion = calcularSuma(buffer.data() + sizeof(CabeceraDelta), static_cast<size_t>(cabecera.bytesDatos));
+    std::memcpy(buffer.data(), &cabecera, sizeof(cabecera));
+    return buffer;
+}
+
+bool guardarPartidaDelta(const Partida& partida, const char* ruta) {
+    std::vector<unsigned char> buffer = serializarPartidaDelta(partida);
+    if (!escribirArchivoAtomico(ruta, buffer.data(), buffer.size())) {
+        std::cerr << "Error: No se pudo escribir el archivo '" << ruta << "' para guardar la partida." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool cargarPartidaDelta(Partida& partida, const char* ruta) {
+    ArchivoMapeado archivo(ruta);
+    if (!archivo.abierto()) {
+        return false;
+    }
+    return deserializarPartidaDelta(partida, archivo.contenido(), archivo.tamano(), ruta);
+}
+
+bool guardarPartidaTexto(const Partida& partida) {
+    std::string celdas = serializarCeldas(partida.piso);
+    std::string jugador = serializarJugador(partida);
+    std::string temporalCeldas = std::string(rutaCeldas) + ".tmp";
+    std::string temporalJugador = std::string(rutaJugador) + ".tmp";
+
+    // Orden fijo que usa recuperarGuardadoTexto: temporal de celdas, temporal del
+    // jugador, y solo con los dos en disco se renombran celdas y luego jugador.
+    if (!escribirTemporal(temporalCeldas, celdas.data(), celdas.size())
+        || !escribirTemporal(temporalJugador, jugador.data(), jugador.size())) {
+        std::remove(temporalCeldas.c_str());
+        std::cerr << "Error: No se pudieron escribir los archivos de la partida." << std::endl;
+        return false;
+    }
+    if (!reemplazarArchivo(temporalCeldas, rutaCeldas) || !reemplazarArchivo(temporalJugador, rutaJugador)) {
+        std::cerr << "Error: No se pudieron reemplazar los archivos de la partida." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void recuperarGuardadoTexto() {
+    std::string temporalCeldas = std::string(rutaCeldas) + ".tmp";
+    std::string temporalJugador = std::string(rutaJugador) + ".tmp";
+    if (existeArchivo(temporalCeldas)) {
+        // Corte antes del primer cambio de nombre: los archivos viejos siguen siendo pareja
+        std::remove(temporalCeldas.c_str());
+        std::remove(temporalJugador.c_str());
+    }
+    else if (existeArchivo(temporalJugador)) {
+        // 'celdas.txt' ya es el nuevo; falta el jugador que va con él
+        reemplazarArchivo(temporalJugador, rutaJugador);
+    }
+}
+
+bool escribirGuardado(const Partida& partida) {
+    switch (partida.formatoGuardado) {
+    case FormatoGuardado::Binario: return guardarPartidaBinaria(partida);
+    case FormatoGuardado::Delta:   return guardarPartidaDelta(partida);
+    default:                       return guardarPartidaTexto(partida);
+    }
+}
+
+void guardarPartida(const Partida& partida) {
+    MEDIR_FASE(partida, Fase::Guardado);
+    if (partida.guardadoAsincrono) {
+        partida.guardadoAsincrono->solicitar(partida);
+        return;
+    }
+    if (!escribirGuardado(partida)) {
+        return;
+    }
+    if (partida.formatoGuardado == FormatoGuardado::Binario) {
+        std::cout << "Partida guardada correctamente en 'partida.dat'." << std::endl;
+    }
+    else if (partida.formatoGuardado == FormatoGuardado::Delta) {
+        std::cout << "Partida guardada correctamente en 'partida.delta'." << std::endl;
+    }
+    else {
+        std::cout << "Partida guardada correctamente en 'celdas.txt' y 'jugador.txt'." << std::endl;
+    }
+}
+
+bool cargarPartida(Partida& partida) {
+    if (partida.formatoGuardado == FormatoGuardado::Delta) {
+        if (cargarPartidaDelta(partida)) {
+            std::cout << "Partida cargada correctamente desde 'partida.delta'." << std::endl;
+            return true;
+        }
+        std::cout << "No hay una partida delta valida; se intenta con 'partida.dat'." << std::endl;
+    }
+    if (partida.formatoGuardado != FormatoGuardado::Texto) {
+        if (cargarPartidaBinaria(partida)) {
+            std::cout << "Partida cargada correctamente desde 'partida.dat'." << std::endl;
+            return true;
+        }
+        std::cout << "No hay una partida binaria valida; se intenta con 'celdas.txt' y 'jugador.txt'." << std::endl;
+    }
+    recuperarGuardadoTexto();
+    // El jugador también se coloca de una vez en su celda
+    return cargarCeldasDesdeArchivo(partida) && cargarInformacionJugador(partida);
+}
+
+GuardadoAsincrono::GuardadoAsincrono() : hilo(&GuardadoAsincrono::trabajar, this) {}
+
+GuardadoAsincrono::~GuardadoAsincrono() {
+    {
+        std::lock_guard<std::mutex> candado(mutex);
+        detener = true;
+    }
+    hayTrabajo.notify_one();
+    hilo.join();
+}
+
+void GuardadoAsincrono::solicitar(const Partida& partida) {
+    // La copia es lo único que se hace en el hilo del juego
+    std::unique_ptr<Partida> copia(new Partida(partida));
+    if (partida.jugador.posicion) {
+        const Celda* posicion = partida.jugador.posicion;
+        copia->jugador.posicion = copia->piso.celda(partida.piso.columnaDe(posicion), partida.piso.filaDe(posicion));
+    }
+    copia->guardadoAsincrono = nullptr;
+    copia->medidor = nullptr; // El medidor es del hilo del juego
+    copia->salida = nullptr;
+    copia->politica = nullptr;
+    {
+        std::lock_guard<std::mutex> candado(mutex);
+        pendiente = std::move(copia); // Reemplaza una solicitud anterior aún no escrita
+        ++numSolicitudes;
+    }
+    hayTrabajo.notify_one();
+}
+
+void GuardadoAsincrono::esperar() {
+    std::unique_lock<std::mutex> candado(mutex);
+    terminado.wait(candado, [this] { return !pendiente && !escribiendo; });
+}
+
+uint64_t GuardadoAsincrono::solicitudes() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numSolicitudes;
+}
+
+uint64_t GuardadoAsincrono::escrituras() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numEscrituras;
+}
+
+uint64_t GuardadoAsincrono::fallos() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numFallos;
+}
+
+void GuardadoAsincrono::trabajar() {
+    std::unique_lock<std::mutex> candado(mutex);
+    while (true) {
+        hayTrabajo.wait(candado, [this] { return pendiente || detener; });
+        if (!pendiente) {
+            break; // Detener sin nada pendiente
+        }
+        std::unique_ptr<Partida> copia = std::move(pendiente);
+        escribiendo = true;
+        candado.unlock();
+
+        bool correcto = escribirGuardado(*copia);
+        copia.reset();
+
+        candado.lock();
+        escribiendo = false;
+        ++numEscrituras;
+        if (!correcto) {
+            ++numFallos;
+        }
+        terminado.notify_all();
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Archivo de solo lectura proyectado en memoria (mmap en POSIX, MapViewOfFile en Windows).
+ */
+class ArchivoMapeado {
+public:
+    explicit ArchivoMapeado(const char* ruta);
+    ~ArchivoMapeado();
+
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+
+    bool abierto() const { return datos != nullptr; }
+    const unsigned char* contenido() const { return datos; }
+    size_t tamano() const { return bytes; }
+
+private:
+    const unsigned char* datos = nullptr;
+    size_t bytes = 0;
+#ifdef _WIN32
+    void* archivo = nullptr;
+    void* mapeo = nullptr;
+#endif
+};
+
+/**
+ * Escribe un archivo de forma atómica: primero en 'ruta.tmp', lo fuerza a disco y
+ * después lo renombra sobre 'ruta'. Un corte a mitad deja el archivo anterior intacto.
+ * return true si el archivo nuevo quedó en su sitio.
+ */
+bool escribirArchivoAtomico(const char* ruta, const void* datos, size_t bytes);
+
+/**
+ * Como escribirArchivoAtomico, pero con un temporal propio del proceso y del hilo
+ * ('ruta.<proceso>-<hilo>.tmp'), para archivos que varios procesos pueden
+ * publicar a la vez: cada uno escribe el suyo y el último renombre gana entero.
+ * Si falla, borra su temporal.
+ * return true si el archivo nuevo quedó en su sitio.
+ */
+bool publicarArchivoAtomico(const char* ruta, const void* datos, size_t bytes);
+
+/**
+ * Suma de verificación de 64 bits que procesa 8 bytes por paso (la de los
+ * archivos binarios).
+ */
+uint64_t calcularSuma(const unsigned char* datos, size_t bytes);
+
+/**
+ * Contenido completo de 'partida.dat' para la partida (cabecera incluida).
+ */
+std::vector<unsigned char> serializarPartidaBinaria(const Partida& partida);
+
+/**
+ * Guarda piso, jugador, equipo, contadores y semilla en un único archivo binario.
+ * return true si se escribió completo.
+ */
+bool guardarPartidaBinaria(const Partida& partida, const char* ruta = "partida.dat");
+
+/**
+ * Carga una partida guardada con guardarPartidaBinaria. El archivo se proyecta en memoria
+ * y se valida (firma, versión, tamaños y suma de verificación) antes de tocar la partida.
+ * return true si la carga fue exitosa; si no, la partida queda como estaba.
+ */
+bool cargarPartidaBinaria(Partida& partida, const char* ruta = "partida.dat");
+
+/**
+ * Como cargarPartidaBinaria, pero desde el contenido de un 'partida.dat' que ya está en memoria.
+ * param ruta Nombre con el que se menciona el contenido en los mensajes de error.
+ */
+bool deserializarPartidaBinaria(Partida& partida, const unsigned char* contenido, size_t tamano, const char* ruta);
+
+/**
+ * Contenido completo de 'partida.delta': cabecera, el registro de la partida y
+ * solo las celdas del piso que no son las que daría el generador, en orden de
+ * índice. Cada celda ocupa el salto desde la anterior (entero de 7 bits por
+ * byte, casi siempre uno o dos bytes) más sus 8 bytes. En un piso generado solo
+ * se miran las celdas que el juego tocó (Piso::tocadas o modificadas); uno
+ * cargado de otro formato se compara entero con la semilla de la partida.
+ */
+std::vector<unsigned char> serializarPartidaDelta(const Partida& partida);
+
+/**
+ * Guarda la partida con serializarPartidaDelta.
+ * return true si se escribió completo.
+ */
+bool guardarPartidaDelta(const Partida& partida, const char* ruta = "partida.delta");
+
+/**
+ * Carga una partida guardada con guardarPartidaDelta: valida el archivo, vuelve
+ * a generar el piso base y le aplica las celdas guardadas, así que el piso
+ * siempre queda completo. Con partida.pisosPerezosos el piso queda perezoso y
+ * las celdas guardadas pasan a ser sus modificadas.
+ * return true si la carga fue exitosa; si no, la partida queda como estaba.
+ */
+bool cargarPartidaDelta(Partida& partida, const char* ruta = "partida.delta");
+
+/**
+ * Guarda 'celdas.txt' y 'jugador.txt' como una pareja: o se reemplazan los dos o
+ * ninguno. Ambos se escriben y fuerzan a disco como temporales antes de renombrar.
+ * return true si los dos archivos quedaron en su sitio.
+ */
+bool guardarPartidaTexto(const Partida& partida);
+
+/**
+ * Termina o descarta un guardado de texto que se cortó a medias, para que
+ * 'celdas.txt' y 'jugador.txt' siempre sean de la misma partida.
+ */
+void recuperarGuardadoTexto();
+
+/**
+ * Escribe la partida en el formato de partida.formatoGuardado sin mostrar mensajes.
+ * return true si se guardó.
+ */
+bool escribirGuardado(const Partida& partida);
+
+/**
+ * Guarda la partida en el formato elegido en partida.formatoGuardado. Si la
+ * partida tiene un guardadoAsincrono, solo toma una copia y vuelve enseguida.
+ */
+void guardarPartida(const Partida& partida);
+
+/**
+ * Carga la partida guardada en el formato elegido. En formato delta, si no hay
+ * 'partida.delta' se intenta con 'partida.dat'; en formato binario, si no
+ * existe 'partida.dat' se intenta con los archivos de texto.
+ * return true si se cargó alguna partida.
+ */
+bool cargarPartida(Partida& partida);
+
+/**
+ * Guardado en segundo plano. solicitar() copia la partida y vuelve sin tocar el
+ * disco; un hilo propio escribe la copia con escribirGuardado. Si llegan varias
+ * solicitudes mientras se escribe, solo se guarda la más reciente.
+ */
+class GuardadoAsincrono {
+public:
+    GuardadoAsincrono();
+    ~GuardadoAsincrono(); // Termina de escribir lo pendiente antes de salir
+
+    GuardadoAsincrono(const GuardadoAsincrono&) = delete;
+    GuardadoAsincrono& operator=(const GuardadoAsincrono&) = delete;
+
+    void solicitar(const Partida& partida);
+
+    /**
+     * Bloquea hasta que no quede ningún guardado pendiente ni en curso.
+     */
+    void esperar();
+
+    uint64_t solicitudes() const;
+    uint64_t escrituras() const;   // Solicitudes agrupadas cuentan una sola vez
+    uint64_t fallos() const;
+
+private:
+    void trabajar();
+
+    mutable std::mutex mutex;
+    std::condition_variable hayTrabajo;
+    std::condition_variable terminado;
+    std::unique_ptr<Partida> pendiente; // Última copia sin escribir
+    bool escribiendo = false;
+    bool detener = false;
+    uint64_t numSolicitudes = 0;
+    uint64_t numEscrituras = 0;
+    uint64_t numFallos = 0;
+    std::thread hilo;
+};
@@ -0,0 +1,225 @@
+#include "Instrumentacion.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+    const char* nombresFases[] = {
+        "turno", "dados", "movimiento", "busqueda_celda", "eventos",
+        "combate", "arcangel", "guardado", "dibujo", "generacion"
+    };
+    static_assert(sizeof(nombresFases) / sizeof(nombresFases[0]) == static_cast<size_t>(Fase::Cantidad), "Falta el nombre de una fase");
+
+    const char* nombresContadores[] = {
+        "celdas_recorridas", "celdas_creadas", "bytes_escritos", "vaciados"
+    };
+    static_assert(sizeof(nombresContadores) / sizeof(nombresContadores[0]) == static_cast<size_t>(Contador::Cantidad), "Falta el nombre de un contador");
+
+    const double cuantiles[] = { 0.5, 0.9, 0.99 };
+
+    /**
+     * Posición del bit más alto de un valor distinto de 0 (búsqueda binaria,
+     * igual en x86 y x64).
+     */
+    int bitMasAlto(uint64_t valor) {
+        int bit = 0;
+        for (int paso = 32; paso > 0; paso /= 2) {
+            if (valor >> paso) {
+                valor >>= paso;
+                bit += paso;
+            }
+        }
+        return bit;
+    }
+}
+
+const char* nombreFase(Fase fase) {
+    return nombresFases[static_cast<size_t>(fase)];
+}
+
+const char* nombreContador(Contador contador) {
+    return nombresContadores[static_cast<size_t>(contador)];
+}
+
+int Histograma::cubeta(uint64_t ns) {
+    if (ns < Exactas) {
+        return static_cast<int>(ns);
+    }
+    int potencia = bitMasAlto(ns); // 4 o más
+    int indice = Exactas + (potencia - 4) * PorPotencia + static_cast<int>((ns >> (potencia - 3)) & (PorPotencia - 1));
+    return std::min(indice, Cubetas - 1);
+}
+
+uint64_t Histograma::limiteSuperior(int indice) {
+    if (indice < Exactas) {
+        return static_cast<uint64_t>(indice);
+    }
+    int potencia = 4 + (indice - Exactas) / PorPotencia;
+    uint64_t parte = static_cast<uint64_t>((indice - Exactas) % PorPotencia);
+    uint64_t ancho = uint64_t(1) << (potencia - 3);
+    return ((PorPotencia + parte) << (potencia - 3)) + ancho - 1;
+}
+
+void Histograma::registrar(uint64_t ns) {
+    ++cubetas[static_cast<size_t>(cubeta(ns))];
+    ++numRegistros;
+    suma += ns;
+    mayor = std::max(mayor, ns);
+}
+
+void Histograma::sumar(const Histograma& otro) {
+    for (size_t i = 0; i < cubetas.size(); ++i) {
+        cubetas[i] += otro.cubetas[i];
+    }
+    numRegistros += otro.numRegistros;
+    suma += otro.suma;
+    mayor = std::max(mayor, otro.mayor);
+}
+
+uint64_t Histograma::percentil(double p) const {
+    if (numRegistros == 0) {
+        return 0;
+    }
+    uint64_t buscado = static_cast<uint64_t>(std::max(1.0, p * static_cast<double>(numRegistros) + 0.5));
+    uint64_t acumulado = 0;
+    for (int i = 0; i < Cubetas; ++i) {
+        acumulado += cubetas[static_cast<size_t>(i)];
+        if (acumulado >= buscado) {
+            return std::min(limiteSuperior(i), mayor);
+        }
+    }
+    return mayor;
+}
+
+Medidor::Medidor(bool trazar, size_t limiteTraza) : trazar(trazar), limiteTraza(limiteTraza), origen(ahora()) {}
+
+void Medidor::registrar(Fase fase, uint64_t inicio, uint64_t ns) {
+    histogramas[static_cast<size_t>(fase)].registrar(ns);
+    if (!trazar) {
+        return;
+    }
+    if (traza.size() < limiteTraza) {
+        traza.push_back({ fase, inicio - origen, ns });
+    }
+    else {
+        ++descartados;
+    }
+}
+
+void Medidor::sumar(const Medidor& otro) {
+    for (size_t i = 0; i < histogramas.size(); ++i) {
+        histogramas[i].sumar(otro.histogramas[i]);
+    }
+    for (size_t i = 0; i < contadores.size(); ++i) {
+        contadores[i] += otro.contadores[i];
+    }
+}
+
+void Medidor::escribirJson(std::ostream& salida) const {
+    salida << "{\"fases\": {";
+    for (size_t i = 0; i < histogramas.size(); ++i) {
+        const Histograma& h = histogramas[i];
+        salida << (i ? ", " : "") << "\"" << nombresFases[i] << "\": {\"cantidad\": " << h.cantidad()
+            << ", \"total_ns\": " << h.total() << ", \"p50_ns\": " << h.percentil(0.5)
+            << ", \"p90_ns\": " << h.percentil(0.9) << ", \"p99_ns\": " << h.percentil(0.99)
+            << ", \"max_ns\": " << h.maximo() << "}";
+    }
+    salida << "}, \"contadores\": {";
+    for (size_t i = 0; i < contadores.size(); ++i) {
+        salida << (i ? ", " : "") << "\"" << nombresContadores[i] << "\": " << contadores[i];
+    }
+    salida << "}}";
+}
+
+void Medidor::escribirPrometheus(std::ostream& salida, const std::string& etiquetas) const {
+    std::string separador = etiquetas.empty() ? "" : ",";
+    std::ios::fmtflags formato = salida.flags();
+    salida << std::setprecision(9);
+
+    salida << "# HELP calabozo_fase_segundos Duracion de cada fase del juego (inclusiva).\n";
+    salida << "# TYPE calabozo_fase_segundos summary\n";
+    for (size_t i = 0; i < histogramas.size(); ++i) {
+        const Histograma& h = histogramas[i];
+        std::string serie = "fase=\"" + std::string(nombresFases[i]) + "\"" + separador + etiquetas;
+        for (double q : cuantiles) {
+            salida << "calabozo_fase_segundos{" << serie << ",quantile=\"" << q << "\"} " << h.percentil(q) * 1e-9 << "\n";
+        }
+        salida << "calabozo_fase_segundos_sum{" << serie << "} " << h.total() * 1e-9 << "\n";
+        salida << "calabozo_fase_segundos_count{" << serie << "} " << h.cantidad() << "\n";
+    }
+    salida << "# HELP calabozo_fase_maximo_segundos Duracion maxima de cada fase.\n";
+    salida << "# TYPE calabozo_fase_maximo_segundos gauge\n";
+    for (size_t i = 0; i < histogramas.size(); ++i) {
+        salida << "calabozo_fase_maximo_segundos{fase=\"" << nombresFases[i] << "\"" << separador << etiquetas << "} "
+            << histogramas[i].maximo() * 1e-9 << "\n";
+    }
+    for (size_t i = 0; i < contadores.size(); ++i) {
+        std::string nombre = std::string("calabozo_") + nombresContadores[i] + "_total";
+        salida << "# TYPE " << nombre << " counter\n";
+        salida << nombre;
+        if (!etiquetas.empty()) {
+            salida << "{" << etiquetas << "}";
+        }
+        salida << " " << contadores[i] << "\n";
+    }
+    salida.flags(formato);
+}
+
+bool Medidor::escribirTraza(std::ostream& salida) const {
+    if (!trazar) {
+        return false;
+    }
+    // Las fases se registran al terminar; el visor prefiere los eventos por inicio
+    std::vector<EventoTraza> ordenada(traza);
+    std::stable_sort(ordenada.begin(), ordenada.end(), [](const EventoTraza& a, const EventoTraza& b) {
+        return a.inicio < b.inicio;
+    });
+
+    std::ios::fmtflags formato = salida.flags();
+    salida << std::fixed << std::setprecision(3);
+    salida << "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"descartados\": " << descartados << "}, \"traceEvents\": [\n";
+    for (size_t i = 0; i < ordenada.size(); ++i) {
+        const EventoTraza& e = ordenada[i];
+        salida << "{\"name\": \"" << nombreFase(e.fase) << "\", \"cat\": \"calabozo\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": "
+            << e.inicio / 1000.0 << ", \"dur\": " << e.duracion / 1000.0 << "}" << (i + 1 < ordenada.size() ? ",\n" : "\n");
+    }
+    salida << "]}\n";
+    salida.flags(formato);
+    return true;
+}
+
+bool escribirMetricas(const Medidor& medidor, const std::string& ruta) {
+    std::ofstream archivo(ruta);
+    if (!archivo.is_open()) {
+        return false;
+    }
+    const std::string extension = ".prom";
+    bool prometheus = ruta.size() >= extension.size() && ruta.compare(ruta.size() - extension.size(), extension.size(), extension) == 0;
+    if (prometheus) {
+        medidor.escribirPrometheus(archivo);
+    }
+    else {
+        medidor.escribirJson(archivo);
+        archivo << "\n";
+    }
+    return static_cast<bool>(archivo);
+}
+
+int BufferMedido::overflow(int caracter) {
+    if (traits_type::eq_int_type(caracter, traits_type::eof())) {
+        return traits_type::not_eof(caracter);
+    }
+    medidor.contar(Contador::BytesEscritos, 1);
+    return destino->sputc(traits_type::to_char_type(caracter));
+}
+
+std::streamsize BufferMedido::xsputn(const char* datos, std::streamsize cantidad) {
+    medidor.contar(Contador::BytesEscritos, static_cast<uint64_t>(cantidad));
+    return destino->sputn(datos, cantidad);
+}
+
+int BufferMedido::sync() {
+    medidor.contar(Contador::Vaciados, 1);
+    return destino->pubsync();
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * Fases del juego que se cronometran. Los tiempos son inclusivos: un turno
+ * incluye el combate, el guardado y el dibujo que ocurran en él.
+ */
+enum class Fase : int {
+    Turno,          // avanzarJugador completo (lo que tarda el juego después de elegir la dirección)
+    Dados,          // lanzarDados
+    Movimiento,     // Bucle de pasos, salida incluida
+    BusquedaCelda,  // Obtener la celda de destino del piso
+    Eventos,        // verificarCelda
+    Combate,        // combatirEnemigo
+    Arcangel,       // pelearConArcangel
+    Guardado,       // guardarPartida (con guardado asíncrono, solo la copia)
+    Dibujo,         // mostrarEstado
+    Generacion,     // crearCalabozo
+    Cantidad
+};
+
+enum class Contador : int {
+    CeldasRecorridas,   // Celdas pisadas al moverse o leídas al dibujar
+    CeldasCreadas,      // Celdas generadas (pisos completos o materializadas en pisos perezosos)
+    BytesEscritos,      // Bytes a la terminal y a los archivos de guardado
+    Vaciados,           // Vaciados de la terminal y fsync de los guardados
+    Cantidad
+};
+
+const char* nombreFase(Fase fase);
+const char* nombreContador(Contador contador);
+
+/**
+ * Histograma de duraciones en nanosegundos con cubetas log-lineales: exactas
+ * hasta 16 ns y después 8 cubetas por potencia de 2 (error < 12,5 %). Registrar
+ * es O(1) y no reserva memoria.
+ */
+class Histograma {
+public:
+    void registrar(uint64_t ns);
+    void sumar(const Histograma& otro);
+
+    uint64_t cantidad() const { return numRegistros; }
+    uint64_t total() const { return suma; }
+    uint64_t maximo() const { return mayor; }
+
+    /**
+     * Duración por debajo de la cual queda la fracción p de los registros (cota
+     * superior de su cubeta, nunca mayor que el máximo).
+     * param p Entre 0 y 1.
+     */
+    uint64_t percentil(double p) const;
+
+private:
+    static const int Exactas = 16;
+    static const int PorPotencia = 8;
+    static const int Cubetas = Exactas + (40 - 4) * PorPotencia; // Hasta 2^40 ns (unos 18 minutos)
+
+    static int cubeta(uint64_t ns);
+    static uint64_t limiteSuperior(int cubeta);
+
+    std::array<uint64_t, Cubetas> cubetas{};
+    uint64_t numRegistros = 0;
+    uint64_t suma = 0;
+    uint64_t mayor = 0;
+};
+
+/**
+ * Tiempos y contadores de una partida (o de varias, sumadas). No es seguro entre
+ * hilos: cada partida registra en el suyo y se suman al final.
+ *
+ * Las mediciones del juego se hacen con las macros MEDIR_FASE, CONTAR y
+ * CONTAR_ACTIVO, que desaparecen si el proyecto no define
+ * CALABOZO_INSTRUMENTACION. Compiladas, una partida sin medidor solo paga leer
+ * y comparar un puntero por fase.
+ */
+class Medidor {
+public:
+    /**
+     * param trazar Guarda además cada fase como evento para escribirTraza (una sola partida).
+     * param limiteTraza Eventos máximos de la traza; los siguientes se descartan.
+     */
+    explicit Medidor(bool trazar = false, size_t limiteTraza = 1u << 20);
+
+    void registrar(Fase fase, uint64_t inicio, uint64_t ns);
+
+    void contar(Contador contador, uint64_t n) {
+        contadores[static_cast<size_t>(contador)] += n;
+    }
+
+    const Histograma& histograma(Fase fase) const {
+        return histogramas[static_cast<size_t>(fase)];
+    }
+
+    uint64_t contador(Contador contador) const {
+        return contadores[static_cast<size_t>(contador)];
+    }
+
+    /**
+     * Suma los histogramas y contadores de otro medidor (la traza no).
+     */
+    void sumar(const Medidor& otro);
+
+    /**
+     * Instantánea en JSON, en una sola línea.
+     */
+    void escribirJson(std::ostream& salida) const;
+
+    /**
+     * Instantánea en el formato de texto de Prometheus (resúmenes con cuantiles y contadores).
+     * param etiquetas Etiquetas para todas las series, p. ej. sesion="4"; puede estar vacío.
+     */
+    void escribirPrometheus(std::ostream& salida, const std::string& etiquetas = std::string()) const;
+
+    /**
+     * Línea de tiempo en el formato de trazas de Chrome (chrome://tracing, Perfetto).
+     * return false si el medidor no se creó con trazar.
+     */
+    bool escribirTraza(std::ostream& salida) const;
+
+    /**
+     * Medidor en el que registra el código que no tiene la partida a mano
+     * (archivos, celdas de pisos perezosos). Lo fija TemporizadorFase.
+     */
+    static Medidor*& activo() {
+        static thread_local Medidor* medidor = nullptr;
+        return medidor;
+    }
+
+    static uint64_t ahora() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    struct EventoTraza {
+        Fase fase;
+        uint64_t inicio;    // ns desde la creación del medidor
+        uint64_t duracion;
+    };
+
+    std::array<Histograma, static_cast<size_t>(Fase::Cantidad)> histogramas;
+    std::array<uint64_t, static_cast<size_t>(Contador::Cantidad)> contadores{};
+    bool trazar;
+    size_t limiteTraza;
+    uint64_t origen;
+    uint64_t descartados = 0;
+    std::vector<EventoTraza> traza;
+};
+
+/**
+ * Escribe una instantánea en un archivo: formato Prometheus si la ruta termina
+ * en ".prom" y JSON en cualquier otro caso.
+ */
+bool escribirMetricas(const Medidor& medidor, const std::string& ruta);
+
+/**
+ * Cronometra una fase mientras existe y deja su medidor como Medidor::activo().
+ * Con medidor nullptr no mide, pero igual deja el activo en nullptr para que una
+ * partida auxiliar (p. ej. la del preparador) no registre en la de afuera.
+ */
+class TemporizadorFase {
+public:
+    TemporizadorFase(Medidor* medidor, Fase fase)
+        : medidor(medidor), fase(fase), anterior(Medidor::activo()), inicio(medidor ? Medidor::ahora() : 0) {
+        if (anterior != medidor) {
+            Medidor::activo() = medidor;
+        }
+    }
+
+    ~TemporizadorFase() {
+        if (medidor) {
+            medidor->registrar(fase, inicio, Medidor::ahora() - inicio);
+        }
+        if (anterior != medidor) {
+            Medidor::activo() = anterior;
+        }
+    }
+
+    TemporizadorFase(const TemporizadorFase&) = delete;
+    TemporizadorFase& operator=(const TemporizadorFase&) = delete;
+
+private:
+    Medidor* medidor;
+    Fase fase;
+    Medidor* anterior;
+    uint64_t inicio;
+};
+
+/**
+ * Buffer que reenvía todo a otro y cuenta los bytes y los vaciados en un medidor.
+ * Se pone delante de la terminal de una partida (partida.salida) para medirla.
+ */
+class BufferMedido : public std::streambuf {
+public:
+    BufferMedido(std::streambuf* destino, Medidor& medidor) : destino(destino), medidor(medidor) {}
+
+protected:
+    int overflow(int caracter) override;
+    std::streamsize xsputn(const char* datos, std::streamsize cantidad) override;
+    int sync() override;
+
+private:
+    std::streambuf* destino;
+    Medidor& medidor;
+};
+
+/**
+ * Medidor que varios hilos pueden sumar a la vez (p. ej. las sesiones que cierra el servidor).
+ */
+class MedidorCompartido {
+public:
+    void sumar(const Medidor& medidor) {
+        std::lock_guard<std::mutex> candado(mutex);
+        total.sumar(medidor);
+    }
+
+    Medidor copia() const {
+        std::lock_guard<std::mutex> candado(mutex);
+        return total;
+    }
+
+private:
+    mutable std::mutex mutex;
+    Medidor total;
+};
+
+/**
+ * Indica si esta compilación registra algo (CALABOZO_INSTRUMENTACION definido).
+ */
+inline bool instrumentacionCompilada() {
+#ifdef CALABOZO_INSTRUMENTACION
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef CALABOZO_INSTRUMENTACION
+#define CALABOZO_CONCATENAR_(a, b) a##b
+#define CALABOZO_CONCATENAR(a, b) CALABOZO_CONCATENAR_(a, b)
+// Cronometra el resto del bloque como 'fase' en el medidor de la partida
+#define MEDIR_FASE(partida, fase) TemporizadorFase CALABOZO_CONCATENAR(temporizadorFase, __LINE__)((partida).medidor, fase)
+// Suma n al contador en el medidor de la partida
+#define CONTAR(partida, contador, n) do { if ((partida).medidor) { (partida).medidor->contar(contador, n); } } while (false)
+// Suma n al contador en el medidor de la fase en curso de este hilo
+#define CONTAR_ACTIVO(contador, n) do { if (Medidor* medidorActivo = Medidor::activo()) { medidorActivo->contar(contador, n); } } while (false)
+#else
+#define MEDIR_FASE(partida, fase) ((void)0)
+#define CONTAR(partida, contador, n) ((void)0)
+#define CONTAR_ACTIVO(contador, n) ((void)0)
+#endif
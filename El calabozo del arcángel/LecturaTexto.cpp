@@ -0,0 +1,588 @@
+#include "LecturaTexto.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+    const size_t bytesPorTrozo = 1 << 20;  // Con menos, repartir cuesta más que leer
+
+    /**
+     * Posición de lectura dentro de una línea (o de todo el archivo, en 'jugador.txt').
+     */
+    struct Cursor {
+        const char* inicio;     // Principio del archivo, para los desplazamientos
+        const char* p;
+        const char* fin;
+    };
+
+    bool esEspacio(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    /**
+     * Salta espacios. return false si no queda nada antes de 'fin'.
+     */
+    bool saltarEspacios(Cursor& cursor) {
+        while (cursor.p < cursor.fin && esEspacio(*cursor.p)) {
+            ++cursor.p;
+        }
+        return cursor.p < cursor.fin;
+    }
+
+    void fallar(ErrorLectura& error, const Cursor& cursor, const char* donde, const std::string& mensaje) {
+        error.desplazamiento = static_cast<size_t>(donde - cursor.inicio);
+        error.mensaje = mensaje;
+    }
+
+    bool esDigito(char c) {
+        return static_cast<unsigned>(c - '0') < 10;
+    }
+
+    /**
+     * Arma el error de un campo que no se pudo leer, a partir de 'cursor.p'. Queda
+     * aparte para que la lectura de cada número sea corta.
+     */
+    bool fallarCampo(const Cursor& cursor, const char* campo, const std::string& esperado, int minimo, int maximo, ErrorLectura& error) {
+        if (cursor.p == cursor.fin) {
+            fallar(error, cursor, cursor.p, std::string("registro incompleto: falta ") + campo);
+            return false;
+        }
+        const char* fin = std::find_if(cursor.p, cursor.fin, esEspacio);
+        const char* digitos = cursor.p + (*cursor.p == '-');
+        if (minimo <= maximo && digitos < fin && std::all_of(digitos, fin, esDigito)) {
+            fallar(error, cursor, cursor.p, std::string(campo) + ": fuera de rango (" + std::to_string(minimo)
+                + " a " + std::to_string(maximo) + ")");
+        }
+        else {
+            fallar(error, cursor, cursor.p, std::string(campo) + ": se esperaba " + esperado + ", no '"
+                + std::string(cursor.p, std::min<size_t>(static_cast<size_t>(fin - cursor.p), 20)) + "'");
+        }
+        return false;
+    }
+
+    /**
+     * Lee un entero en [minimo, maximo] y deja el cursor después de él.
+     * return false (con el error) si falta, no es un número o está fuera de rango.
+     */
+    inline bool leerEntero(Cursor& cursor, const char* campo, int minimo, int maximo, int& valor, ErrorLectura& error) {
+        saltarEspacios(cursor);
+        const char* p = cursor.p;
+        bool negativo = p < cursor.fin && *p == '-';
+        p += negativo ? 1 : 0;
+        const char* digitos = p;
+        int64_t acumulado = 0;
+        while (p < cursor.fin && esDigito(*p) && p - digitos < 10) { // Diez dígitos no desbordan
+            acumulado = acumulado * 10 + (*p - '0');
+            ++p;
+        }
+        acumulado = negativo ? -acumulado : acumulado;
+        if (p == digitos || (p < cursor.fin && !esEspacio(*p)) || acumulado < minimo || acumulado > maximo) {
+            return fallarCampo(cursor, campo, "un número", minimo, maximo, error);
+        }
+        valor = static_cast<int>(acumulado);
+        cursor.p = p;
+        return true;
+    }
+
+    /**
+     * Lee las letras de una columna ("A", "AB"...) y deja el cursor después de ellas.
+     */
+    inline bool leerColumna(Cursor& cursor, const char* campo, int& columna, ErrorLectura& error) {
+        saltarEspacios(cursor);
+        const char* p = cursor.p;
+        int valor = 0;
+        while (p < cursor.fin && *p >= 'A' && *p <= 'Z' && p - cursor.p < 4) { // Cuatro letras ya superan maxLadoTablero
+            valor = valor * 26 + (*p - 'A' + 1);
+            ++p;
+        }
+        if (p == cursor.p || (p < cursor.fin && *p >= 'A' && *p <= 'Z') || valor > maxLadoTablero) {
+            return fallarCampo(cursor, campo, "una columna como A, B... AA", 1, 0, error); // Rango vacío: no es un número
+        }
+        columna = valor - 1;
+        cursor.p = p;
+        return true;
+    }
+
+    /**
+     * Lee una posición como "J10": letras de la columna seguidas del número de fila.
+     */
+    bool leerPosicion(Cursor& cursor, int& columna, int& fila, ErrorLectura& error) {
+        if (!saltarEspacios(cursor)) {
+            fallar(error, cursor, cursor.p, "registro incompleto: falta posición");
+            return false;
+        }
+        const char* finPosicion = std::find_if(cursor.p, cursor.fin, esEspacio);
+        Cursor letras = { cursor.inicio, cursor.p, finPosicion };
+        if (!leerColumna(letras, "posición", columna, error)) {
+            return false;
+        }
+        Cursor numero = { cursor.inicio, letras.p, finPosicion };
+        if (numero.p == finPosicion) {
+            fallar(error, cursor, cursor.p, "posición: falta la fila, se esperaba una celda como J10");
+            return false;
+        }
+        if (!leerEntero(numero, "fila de la posición", 1, maxLadoTablero, fila, error)) {
+            return false;
+        }
+        cursor.p = finPosicion;
+        return true;
+    }
+
+    /**
+     * Celda de 'celdas.txt' con sus coordenadas.
+     */
+    struct RegistroTexto {
+        int columna;
+        int fila;
+        Celda celda;
+    };
+
+    /**
+     * Tamaño del piso según la última línea del archivo, que el juego escribe
+     * siempre con la última celda. 0 columnas si no se pudo leer.
+     */
+    struct Referencia {
+        int columnas = 0;
+        int filas = 0;
+    };
+
+    /**
+     * Lo leído de un trozo del archivo. El juego escribe las celdas fila por
+     * fila, así que mientras vengan seguidas (con el tamaño de la referencia)
+     * solo se guarda la celda; desde la primera que no siga, el resto del trozo
+     * va a 'sueltas' con sus coordenadas. Si falla, 'error' es el primero del trozo.
+     */
+    struct Trozo {
+        size_t desde = 0;                       // Byte donde empieza el trozo
+        size_t hasta = 0;
+        int64_t primera = 0;                    // Índice de la primera celda seguida
+        std::vector<Celda> seguidas;
+        std::vector<RegistroTexto> sueltas;
+        int columnas = 0;
+        int filas = 0;
+        int piso = 0;                           // Piso del primer registro (0 si no hay ninguno)
+        bool fallo = false;
+        ErrorLectura error;
+
+        size_t registros() const { return seguidas.size() + sueltas.size(); }
+    };
+
+    bool leerRegistro(Cursor& cursor, RegistroTexto& registro, int& numeroPiso, ErrorLectura& error) {
+        const char* banderas[] = { "visitada", "enemigo", "guardado", "taberna", "cofre" };
+        const BanderaCelda deBandera[] = { CeldaVisitada, CeldaEnemigo, CeldaGuardado, CeldaTaberna, CeldaCofre };
+        int fila, valor;
+        if (!leerEntero(cursor, "piso", 1, maxPisos, numeroPiso, error)
+            || !leerColumna(cursor, "columna", registro.columna, error)
+            || !leerEntero(cursor, "fila", 1, maxLadoTablero, fila, error)) {
+            return false;
+        }
+        registro.fila = fila - 1;
+        registro.celda = Celda();
+        registro.celda.piso = static_cast<int16_t>(numeroPiso);
+        for (int b = 0; b < 5; ++b) {
+            if (!leerEntero(cursor, banderas[b], 0, 1, valor, error)) {
+                return false;
+            }
+            registro.celda.poner(deBandera[b], valor != 0);
+        }
+        if (!leerEntero(cursor, "salud del enemigo", std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max(), valor, error)) {
+            return false;
+        }
+        registro.celda.enemyHealth = static_cast<int16_t>(valor);
+        if (!leerEntero(cursor, "ataque del enemigo", std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max(), valor, error)) {
+            return false;
+        }
+        registro.celda.enemyAttack = static_cast<int16_t>(valor);
+        if (!leerEntero(cursor, "contenido del cofre", 0, 255, valor, error)) {
+            return false;
+        }
+        registro.celda.chestContent = static_cast<uint8_t>(valor);
+        if (saltarEspacios(cursor)) {
+            fallar(error, cursor, cursor.p, "datos de más al final del registro");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Lectura de un registro bien formado, sin mensajes y con punteros locales.
+     * Si algo no cuadra devuelve false y leerRegistro vuelve a leer la línea,
+     * que es quien decide si es válida y, si no, qué falló.
+     */
+    bool leerRegistroRapido(const char* p, const char* fin, RegistroTexto& registro, int& numeroPiso) {
+        int valores[10];    // Todos los campos menos la columna, en orden
+        int leidos = 0;
+        int columna = 0;
+        for (int campo = 0; campo < 11; ++campo) {
+            while (p < fin && esEspacio(*p)) {
+                ++p;
+            }
+            const char* inicio = p;
+            if (campo == 1) {
+                while (p < fin && *p >= 'A' && *p <= 'Z') {
+                    columna = columna * 26 + (*p - 'A' + 1);
+                    ++p;
+                }
+                if (p == inicio || p - inicio > 4) {
+                    return false;
+                }
+            }
+            else {
+                bool negativo = p < fin && *p == '-';
+                p += negativo ? 1 : 0;
+                const char* digitos = p;
+                int valor = 0;
+                while (p < fin && esDigito(*p)) {
+                    valor = valor * 10 + (*p - '0');
+                    ++p;
+                }
+                if (p == digitos || p - digitos > 6) { // Ningún campo válido tiene más de 5 cifras
+                    return false;
+                }
+                valores[leidos++] = negativo ? -valor : valor;
+            }
+            if (p < fin && !esEspacio(*p)) {
+                return false;
+            }
+        }
+        while (p < fin && esEspacio(*p)) {
+            ++p;
+        }
+        unsigned banderas = static_cast<unsigned>(valores[2] | valores[3] | valores[4] | valores[5] | valores[6]);
+        if (p != fin || valores[0] < 1 || valores[0] > maxPisos || columna > maxLadoTablero || valores[1] < 1
+            || valores[1] > maxLadoTablero || banderas > 1 || valores[7] != static_cast<int16_t>(valores[7])
+            || valores[8] != static_cast<int16_t>(valores[8]) || valores[9] < 0 || valores[9] > 255) {
+            return false;
+        }
+
+        numeroPiso = valores[0];
+        registro.columna = columna - 1;
+        registro.fila = valores[1] - 1;
+        registro.celda = Celda();
+        registro.celda.piso = static_cast<int16_t>(valores[0]);
+        registro.celda.poner(CeldaVisitada, valores[2] != 0);
+        registro.celda.poner(CeldaEnemigo, valores[3] != 0);
+        registro.celda.poner(CeldaGuardado, valores[4] != 0);
+        registro.celda.poner(CeldaTaberna, valores[5] != 0);
+        registro.celda.poner(CeldaCofre, valores[6] != 0);
+        registro.celda.enemyHealth = static_cast<int16_t>(valores[7]);
+        registro.celda.enemyAttack = static_cast<int16_t>(valores[8]);
+        registro.celda.chestContent = static_cast<uint8_t>(valores[9]);
+        return true;
+    }
+
+    /**
+     * Recorre las líneas no vacías de [desde, hasta). leerLinea(inicio, fin)
+     * devuelve false para detenerse.
+     */
+    template <class Funcion>
+    void recorrerLineas(const char* contenido, size_t desde, size_t hasta, Funcion&& leerLinea) {
+        const char* p = contenido + desde;
+        const char* fin = contenido + hasta;
+        while (p < fin) {
+            const char* finLinea = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(fin - p)));
+            if (!finLinea) {
+                finLinea = fin;
+            }
+            const char* q = p;
+            while (q < finLinea && esEspacio(*q)) {
+                ++q;
+            }
+            if (q < finLinea && !leerLinea(p, finLinea)) {
+                return;
+            }
+            p = finLinea + 1;
+        }
+    }
+
+    void leerTrozo(const char* contenido, size_t desde, size_t hasta, Referencia referencia, Trozo& trozo) {
+        trozo.desde = desde;
+        trozo.hasta = hasta;
+        const char* actual = contenido + desde;     // Línea en curso, para informar si falta memoria
+        try {
+            bool enOrden = referencia.columnas > 0;
+            if (enOrden) {
+                trozo.seguidas.reserve((hasta - desde) / 20 + 1); // Las líneas ocupan unos 25 bytes
+            }
+            recorrerLineas(contenido, desde, hasta, [&](const char* linea, const char* finLinea) {
+                actual = linea;
+                RegistroTexto registro;
+                int numeroPiso;
+                Cursor cursor = { contenido, linea, finLinea };
+                if (!leerRegistroRapido(linea, finLinea, registro, numeroPiso) && !leerRegistro(cursor, registro, numeroPiso, trozo.error)) {
+                    trozo.fallo = true;
+                    return false;
+                }
+                if (trozo.piso == 0) {
+                    trozo.piso = numeroPiso;
+                }
+                else if (numeroPiso != trozo.piso) {
+                    fallar(trozo.error, cursor, linea, "la celda es del piso " + std::to_string(numeroPiso)
+                        + " pero las anteriores son del piso " + std::to_string(trozo.piso));
+                    trozo.fallo = true;
+                    return false;
+                }
+                trozo.columnas = std::max(trozo.columnas, registro.columna + 1);
+                trozo.filas = std::max(trozo.filas, registro.fila + 1);
+
+                if (enOrden && registro.columna < referencia.columnas && registro.fila < referencia.filas) {
+                    int64_t indice = static_cast<int64_t>(registro.fila) * referencia.columnas + registro.columna;
+                    if (trozo.seguidas.empty()) {
+                        trozo.primera = indice;
+                    }
+                    if (indice == trozo.primera + static_cast<int64_t>(trozo.seguidas.size())) {
+                        trozo.seguidas.push_back(registro.celda);
+                        return true;
+                    }
+                }
+                enOrden = false;
+                trozo.sueltas.push_back(registro);
+                return true;
+            });
+        }
+        catch (const std::bad_alloc&) {
+            // En un hilo trabajador la excepción terminaría el programa: se informa como cualquier error del trozo
+            std::vector<Celda>().swap(trozo.seguidas);
+            std::vector<RegistroTexto>().swap(trozo.sueltas);
+            trozo.error.desplazamiento = static_cast<size_t>(actual - contenido);
+            trozo.error.mensaje = "no hay memoria suficiente para leer las celdas";
+            trozo.fallo = true;
+        }
+    }
+
+    /**
+     * Byte donde empieza el registro número 'k' de un trozo. Solo se usa para
+     * informar un error, así que vuelve a recorrer las líneas.
+     */
+    size_t desplazamientoDeRegistro(const char* contenido, const Trozo& trozo, size_t k) {
+        size_t desplazamiento = trozo.desde;
+        recorrerLineas(contenido, trozo.desde, trozo.hasta, [&](const char* linea, const char*) {
+            desplazamiento = static_cast<size_t>(linea - contenido);
+            return k-- > 0;
+        });
+        return desplazamiento;
+    }
+
+    /**
+     * Lee la última línea no vacía para conocer el tamaño del piso de antemano.
+     */
+    Referencia leerReferencia(const char* contenido, size_t tamano) {
+        Referencia referencia;
+        size_t fin = tamano;
+        while (fin > 0 && esEspacio(contenido[fin - 1])) {
+            --fin;
+        }
+        size_t inicio = fin;
+        while (inicio > 0 && contenido[inicio - 1] != '\n') {
+            --inicio;
+        }
+        RegistroTexto registro;
+        int numeroPiso;
+        if (fin > inicio && leerRegistroRapido(contenido + inicio, contenido + fin, registro, numeroPiso)) {
+            referencia.columnas = registro.columna + 1;
+            referencia.filas = registro.fila + 1;
+        }
+        return referencia;
+    }
+
+    void completarLinea(const char* contenido, ErrorLectura& error) {
+        error.linea = 1 + static_cast<size_t>(std::count(contenido, contenido + error.desplazamiento, '\n'));
+    }
+
+    std::string nombreCelda(int columna, int fila) {
+        return etiquetaColumna(columna) + std::to_string(fila + 1);
+    }
+}
+
+bool leerCeldasTexto(const char* contenido, size_t tamano, Partida& partida, ErrorLectura& error, unsigned hilos) {
+    // Trozos que terminan en un salto de línea, uno por hilo en archivos grandes
+    size_t numTrozos = 1;
+    if (tamano >= 2 * bytesPorTrozo) {
+        size_t nucleos = hilos ? hilos : std::max(1u, std::thread::hardware_concurrency());
+        numTrozos = std::min(nucleos, tamano / bytesPorTrozo);
+    }
+    std::vector<size_t> limites(numTrozos + 1, tamano);
+    limites[0] = 0;
+    for (size_t t = 1; t < numTrozos; ++t) {
+        size_t desde = std::max(t * tamano / numTrozos, limites[t - 1]);
+        const void* salto = std::memchr(contenido + desde, '\n', tamano - desde);
+        limites[t] = salto ? static_cast<size_t>(static_cast<const char*>(salto) - contenido) + 1 : tamano;
+    }
+
+    Referencia referencia = leerReferencia(contenido, tamano);
+    std::vector<Trozo> trozos(numTrozos);
+    {
+        std::vector<std::thread> trabajadores;
+        for (size_t t = 1; t < numTrozos; ++t) {
+            trabajadores.emplace_back(leerTrozo, contenido, limites[t], limites[t + 1], referencia, std::ref(trozos[t]));
+        }
+        leerTrozo(contenido, limites[0], limites[1], referencia, trozos[0]);
+        for (auto& trabajador : trabajadores) {
+            trabajador.join();
+        }
+    }
+
+    // El primer error del archivo es el del primer trozo que falló
+    int columnas = 0, filas = 0, numeroPiso = 0;
+    for (const Trozo& trozo : trozos) {
+        if (trozo.fallo) {
+            error = trozo.error;
+            completarLinea(contenido, error);
+            return false;
+        }
+        if (trozo.piso != 0 && numeroPiso != 0 && trozo.piso != numeroPiso) {
+            error.desplazamiento = desplazamientoDeRegistro(contenido, trozo, 0);
+            error.mensaje = "la celda es del piso " + std::to_string(trozo.piso) + " pero las anteriores son del piso "
+                + std::to_string(numeroPiso);
+            completarLinea(contenido, error);
+            return false;
+        }
+        numeroPiso = numeroPiso ? numeroPiso : trozo.piso;
+        columnas = std::max(columnas, trozo.columnas);
+        filas = std::max(filas, trozo.filas);
+    }
+
+    Tablero tablero;
+    tablero.columnas = columnas;
+    tablero.filas = filas;
+    if (!tableroValido(tablero)) {
+        error.desplazamiento = tamano;
+        error.mensaje = "el piso necesita al menos 2 celdas";
+        completarLinea(contenido, error);
+        return false;
+    }
+    size_t numCeldas = static_cast<size_t>(columnas) * filas;
+    ArregloArena<Celda> celdas;
+    celdas.asignar(numCeldas, Celda(), partida.arena);
+
+    // Lo normal: cada trozo sigue donde terminó el anterior y entre todos
+    // cubren el piso una vez, así que alcanza con copiar las celdas
+    bool enOrden = columnas == referencia.columnas && filas == referencia.filas;
+    int64_t siguiente = 0;
+    for (const Trozo& trozo : trozos) {
+        enOrden = enOrden && trozo.sueltas.empty() && (trozo.seguidas.empty() || trozo.primera == siguiente);
+        siguiente += static_cast<int64_t>(trozo.seguidas.size());
+    }
+    if (enOrden && siguiente == static_cast<int64_t>(numCeldas)) {
+        for (const Trozo& trozo : trozos) {
+            std::copy(trozo.seguidas.begin(), trozo.seguidas.end(), celdas.data() + trozo.primera);
+        }
+    }
+    else {
+        // Cada celda una sola vez: con eso y el total, no falta ninguna
+        std::vector<uint64_t> vistas((numCeldas + 63) / 64, 0);
+        size_t total = 0;
+        for (const Trozo& trozo : trozos) {
+            for (size_t k = 0; k < trozo.registros(); ++k) {
+                RegistroTexto registro;
+                if (k < trozo.seguidas.size()) {
+                    int64_t indice = trozo.primera + static_cast<int64_t>(k);
+                    registro.columna = static_cast<int>(indice % referencia.columnas);
+                    registro.fila = static_cast<int>(indice / referencia.columnas);
+                    registro.celda = trozo.seguidas[k];
+                }
+                else {
+                    registro = trozo.sueltas[k - trozo.seguidas.size()];
+                }
+                size_t i = static_cast<size_t>(registro.fila) * columnas + registro.columna;
+                uint64_t bit = 1ull << (i % 64);
+                if (vistas[i / 64] & bit) {
+                    error.desplazamiento = desplazamientoDeRegistro(contenido, trozo, k);
+                    error.mensaje = "la celda " + nombreCelda(registro.columna, registro.fila) + " está repetida";
+                    completarLinea(contenido, error);
+                    return false;
+                }
+                vistas[i / 64] |= bit;
+                celdas[i] = registro.celda;
+                ++total;
+            }
+        }
+        if (total != numCeldas) {
+            size_t i = 0;
+            while (vistas[i / 64] & (1ull << (i % 64))) {
+                ++i;
+            }
+            error.desplazamiento = tamano;
+            size_t faltan = numCeldas - total;
+            error.mensaje = (faltan == 1 ? "falta 1 celda" : "faltan " + std::to_string(faltan) + " celdas") + " de un piso de "
+                + std::to_string(columnas) + "x" + std::to_string(filas) + ", la primera es "
+                + nombreCelda(static_cast<int>(i % columnas), static_cast<int>(i / columnas));
+            completarLinea(contenido, error);
+            return false;
+        }
+    }
+
+    Piso& piso = partida.piso;
+    liberarPiso(piso);
+    piso.columnas = columnas;
+    piso.filas = filas;
+    piso.celdas = std::move(celdas);
+    piso.reconstruirPlanos(partida.arena);
+    partida.pisoCalabozo = numeroPiso;
+    return true;
+}
+
+bool leerJugadorTexto(const char* contenido, size_t tamano, Partida& partida, ErrorLectura& error) {
+    Cursor cursor = { contenido, contenido, contenido + tamano };
+    const int menor = std::numeric_limits<int>::min();
+    const int mayor = std::numeric_limits<int>::max();
+    Jugador jugador;
+    int columna = 0, fila = 0, numReclutas = 0, tiradas = 0;
+    bool correcto = leerEntero(cursor, "salud", menor, mayor, jugador.health, error)
+        && leerEntero(cursor, "ataque", menor, mayor, jugador.attackPower, error);
+
+    const char* posicion = cursor.p;
+    correcto = correcto && leerPosicion(cursor, columna, fila, error);
+    if (correcto && (columna >= partida.piso.columnas || fila > partida.piso.filas)) {
+        posicion += std::find_if_not(posicion, cursor.p, esEspacio) - posicion;
+        fallar(error, cursor, posicion, "posición: " + nombreCelda(columna, fila - 1) + " está fuera del piso de "
+            + std::to_string(partida.piso.columnas) + "x" + std::to_string(partida.piso.filas));
+        correcto = false;
+    }
+
+    correcto = correcto && leerEntero(cursor, "cantidad de reclutas", 0, 3, numReclutas, error);
+    for (int i = 0; correcto && i < numReclutas; ++i) {
+        Recluta recluta;
+        if (!saltarEspacios(cursor)) {
+            fallar(error, cursor, cursor.p, "registro incompleto: falta el nombre de la recluta " + std::to_string(i + 1));
+            correcto = false;
+            break;
+        }
+        const char* nombre = cursor.p;
+        while (cursor.p < cursor.fin && !esEspacio(*cursor.p)) {
+            ++cursor.p;
+        }
+        recluta.nombre.assign(nombre, cursor.p);
+        correcto = leerEntero(cursor, "salud de la recluta", menor, mayor, recluta.health, error)
+            && leerEntero(cursor, "ataque de la recluta", menor, mayor, recluta.attackPower, error);
+        jugador.equipo.push_back(recluta);
+    }
+    correcto = correcto && leerEntero(cursor, "tiradas de dados", 0, mayor, tiradas, error);
+    if (correcto && saltarEspacios(cursor)) {
+        fallar(error, cursor, cursor.p, "datos de más al final del archivo");
+        correcto = false;
+    }
+    if (!correcto) {
+        completarLinea(contenido, error);
+        return false;
+    }
+
+    // Todo es válido: recién ahora cambia la partida
+    Piso& piso = partida.piso;
+    Celda* current = piso.celda(columna, fila - 1);
+    jugador.posicion = current;
+    piso.marcar(current, CeldaJugador, true);   // Marcar la celda con el jugador
+    piso.marcar(current, CeldaVisitada, true);  // Marcar la celda como visitada
+    partida.jugador = jugador;
+    partida.numDiceThrows = tiradas;
+    return true;
+}
+
+std::string describirError(const char* ruta, const ErrorLectura& error) {
+    return "'" + std::string(ruta) + "', línea " + std::to_string(error.linea) + " (byte " + std::to_string(error.desplazamiento)
+        + "): " + error.mensaje;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Lectura de 'celdas.txt' y 'jugador.txt' sin flujos: el contenido llega
+ * entero (proyectado en memoria, ver ArchivoMapeado) y los números se leen a
+ * mano, sin locale ni memoria por campo. Cada línea de 'celdas.txt' es una
+ * celda, así que un archivo grande se parte en trozos por saltos de línea y
+ * los trozos se leen en paralelo.
+ *
+ * Se rechaza todo lo que el juego no pudo haber escrito: registros
+ * incompletos o con datos de más, banderas que no son 0 o 1, coordenadas
+ * fuera de rango, celdas repetidas o faltantes, celdas de otro piso y, en el
+ * jugador, una posición fuera del piso o más de tres reclutas. Si algo falla,
+ * la partida no se toca.
+ */
+
+/**
+ * Dónde y por qué falló una lectura.
+ */
+struct ErrorLectura {
+    size_t desplazamiento = 0;  // Byte del archivo donde empieza el dato que falló
+    size_t linea = 0;           // Línea de ese byte, desde 1
+    std::string mensaje;
+};
+
+/**
+ * Lee el contenido de 'celdas.txt' y, si es válido, lo pone como piso de la
+ * partida (con sus planos) y toma de él el número de piso. Las dimensiones se
+ * deducen de la mayor columna y fila.
+ * param hilos Hilos para archivos grandes; 0 usa todos los núcleos.
+ * return false si el contenido no es válido; 'error' dice dónde.
+ */
+bool leerCeldasTexto(const char* contenido, size_t tamano, Partida& partida, ErrorLectura& error, unsigned hilos = 0);
+
+/**
+ * Lee el contenido de 'jugador.txt' sobre una partida que ya tiene su piso y,
+ * si es válido, reemplaza al jugador y lo coloca en su celda.
+ * return false si el contenido no es válido; 'error' dice dónde.
+ */
+bool leerJugadorTexto(const char* contenido, size_t tamano, Partida& partida, ErrorLectura& error);
+
+/**
+ * Mensaje para el usuario: "'ruta', línea L (byte B): ...".
+ */
+std::string describirError(const char* ruta, const ErrorLectura& error);
@@ -0,0 +1,328 @@
+#include "PisosCompartidos.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace {
+    const char firmaCompartido[4] = { 'C', 'P', 'I', 'S' };
+    const uint16_t versionCompartido = 1;
+
+    /**
+     * Calabozos más grandes que esto no se comparten (cada partida genera los suyos).
+     */
+    const uint64_t maxCeldasCompartidas = 1ull << 24;
+
+    /**
+     * Cabecera de un archivo de pisos compartidos: la clave completa y la suma
+     * de verificación de todo lo que va después. Detrás van una EntradaPiso
+     * por piso y las celdas de todos los pisos, piso por piso y fila por fila.
+     */
+    struct CabeceraCompartido {
+        char firma[4];
+        uint16_t version;
+        uint16_t tamanoCelda;
+        uint32_t columnas;
+        uint32_t filas;
+        uint32_t pisos;
+        int32_t maxEnemigos;
+        uint64_t semilla;
+        uint64_t flujo;
+        int32_t reglas[8];          // ReglasCeldas en el orden de sus campos
+        uint64_t bytesDatos;        // Entradas + celdas
+        uint64_t sumaVerificacion;
+    };
+
+    static_assert(sizeof(CabeceraCompartido) == 88, "La cabecera no debe tener relleno");
+    static_assert(sizeof(CabeceraCompartido) % alignof(Celda) == 0, "Las celdas del archivo deben quedar alineadas");
+    static_assert(std::is_trivially_copyable<Celda>::value, "Las celdas se leen directo del archivo");
+
+    void copiarReglas(const ReglasCeldas& reglas, int32_t (&destino)[8]) {
+        const int valores[8] = { reglas.carasEnemigo, reglas.carasGuardado, reglas.carasTaberna, reglas.carasCofre,
+            reglas.saludEnemigo, reglas.saludEnemigoPorPiso, reglas.ataqueEnemigo, reglas.ataqueEnemigoPorPiso };
+        for (int i = 0; i < 8; ++i) {
+            destino[i] = valores[i];
+        }
+    }
+
+    uint64_t celdasPorPiso(const ClaveCalabozo& clave) {
+        return static_cast<uint64_t>(clave.columnas) * static_cast<uint64_t>(clave.filas);
+    }
+}
+
+/**
+ * Lo que hace falta saber de un piso para ponerlo sin generarlo.
+ */
+struct CalabozoCompartido::EntradaPiso {
+    int64_t ultimoEnemigo;      // Como Piso::ultimoEnemigo
+    int32_t enemigosAntes;      // Partida::numEnemies antes de crear el piso
+    int32_t enemigosDespues;    // Y después
+};
+
+static_assert(sizeof(CalabozoCompartido::EntradaPiso) == 16, "La entrada no debe tener relleno");
+
+ClaveCalabozo ClaveCalabozo::de(const Partida& partida) {
+    ClaveCalabozo clave;
+    clave.semilla = partida.generador.obtenerSemilla();
+    clave.flujo = partida.generador.obtenerFlujo();
+    clave.columnas = partida.piso.columnas;
+    clave.filas = partida.piso.filas;
+    clave.pisos = partida.numPisos;
+    clave.maxEnemigos = partida.equilibrio.maxEnemigos;
+    clave.reglas = partida.equilibrio.celdas;
+    return clave;
+}
+
+uint64_t ClaveCalabozo::resumen() const {
+    int32_t reglasPlanas[8];
+    copiarReglas(reglas, reglasPlanas);
+    uint64_t resumen = mezclar64(semilla ^ mezclar64(flujo));
+    for (int64_t valor : { int64_t(columnas), int64_t(filas), int64_t(pisos), int64_t(maxEnemigos) }) {
+        resumen = mezclar64(resumen ^ static_cast<uint64_t>(valor));
+    }
+    for (int32_t valor : reglasPlanas) {
+        resumen = mezclar64(resumen ^ static_cast<uint32_t>(valor));
+    }
+    return resumen;
+}
+
+const unsigned char* CalabozoCompartido::contenido() const {
+    return datos;
+}
+
+size_t CalabozoCompartido::tamano() const {
+    return bytes;
+}
+
+/**
+ * Valida el contenido (datos, bytes) contra la clave y deja listos los punteros
+ * a las entradas y a las celdas.
+ * return false si el contenido no es un calabozo válido de esa clave.
+ */
+bool CalabozoCompartido::enlazar(const ClaveCalabozo& clave) {
+    if (!datos || bytes < sizeof(CabeceraCompartido)) {
+        return false;
+    }
+    CabeceraCompartido cabecera;
+    std::memcpy(&cabecera, datos, sizeof(cabecera));
+    int32_t reglas[8];
+    copiarReglas(clave.reglas, reglas);
+    uint64_t bytesEsperados = sizeof(EntradaPiso) * static_cast<uint64_t>(clave.pisos)
+        + sizeof(Celda) * celdasPorPiso(clave) * static_cast<uint64_t>(clave.pisos);
+    if (std::memcmp(cabecera.firma, firmaCompartido, sizeof(firmaCompartido)) != 0 || cabecera.version != versionCompartido
+        || cabecera.tamanoCelda != sizeof(Celda) || cabecera.columnas != static_cast<uint32_t>(clave.columnas)
+        || cabecera.filas != static_cast<uint32_t>(clave.filas) || cabecera.pisos != static_cast<uint32_t>(clave.pisos)
+        || cabecera.maxEnemigos != clave.maxEnemigos || cabecera.semilla != clave.semilla || cabecera.flujo != clave.flujo
+        || std::memcmp(cabecera.reglas, reglas, sizeof(reglas)) != 0
+        || cabecera.bytesDatos != bytesEsperados || bytes - sizeof(cabecera) != bytesEsperados) {
+        return false;
+    }
+    const unsigned char* resto = datos + sizeof(cabecera);
+    if (calcularSuma(resto, static_cast<size_t>(cabecera.bytesDatos)) != cabecera.sumaVerificacion) {
+        return false;
+    }
+
+    entradas = reinterpret_cast<const EntradaPiso*>(resto);
+    celdas = reinterpret_cast<const Celda*>(resto + sizeof(EntradaPiso) * static_cast<size_t>(clave.pisos));
+    int64_t total = static_cast<int64_t>(celdasPorPiso(clave));
+    int32_t enemigos = 0;
+    for (int p = 0; p < clave.pisos; ++p) {
+        const EntradaPiso& entrada = entradas[p];
+        if (entrada.enemigosAntes != enemigos || entrada.enemigosDespues < enemigos
+            || entrada.enemigosDespues > clave.maxEnemigos || entrada.ultimoEnemigo < -1 || entrada.ultimoEnemigo >= total) {
+            return false;
+        }
+        enemigos = entrada.enemigosDespues;
+    }
+    claveCalabozo = clave;
+    return true;
+}
+
+std::shared_ptr<const CalabozoCompartido> CalabozoCompartido::abrir(const std::string& ruta, const ClaveCalabozo& clave) {
+    std::shared_ptr<CalabozoCompartido> calabozo(new CalabozoCompartido());
+    calabozo->archivo.reset(new ArchivoMapeado(ruta.c_str()));
+    calabozo->datos = calabozo->archivo->contenido();
+    calabozo->bytes = calabozo->archivo->tamano();
+    if (!calabozo->enlazar(clave)) {
+        return nullptr;
+    }
+    return calabozo;
+}
+
+std::shared_ptr<const CalabozoCompartido> CalabozoCompartido::generar(const ClaveCalabozo& clave) {
+    uint64_t porPiso = celdasPorPiso(clave);
+    if (clave.pisos < 1 || porPiso == 0 || porPiso * static_cast<uint64_t>(clave.pisos) > maxCeldasCompartidas) {
+        return nullptr;
+    }
+    size_t bytesEntradas = sizeof(EntradaPiso) * static_cast<size_t>(clave.pisos);
+    size_t bytesPiso = sizeof(Celda) * static_cast<size_t>(porPiso);
+    size_t total = sizeof(CabeceraCompartido) + bytesEntradas + bytesPiso * static_cast<size_t>(clave.pisos);
+
+    std::shared_ptr<CalabozoCompartido> calabozo(new CalabozoCompartido());
+    calabozo->propio.assign((total + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    unsigned char* buffer = reinterpret_cast<unsigned char*>(calabozo->propio.data());
+    unsigned char* resto = buffer + sizeof(CabeceraCompartido);
+
+    // Partida auxiliar con lo único que usa crearCalabozo, que genera piso tras piso
+    Partida auxiliar;
+    auxiliar.salida = nullptr;
+    auxiliar.generador = GeneradorPartida(clave.semilla, clave.flujo);
+    auxiliar.equilibrio.maxEnemigos = clave.maxEnemigos;
+    auxiliar.equilibrio.celdas = clave.reglas;
+    auxiliar.piso.columnas = clave.columnas;
+    auxiliar.piso.filas = clave.filas;
+    for (int p = 0; p < clave.pisos; ++p) {
+        EntradaPiso entrada;
+        entrada.enemigosAntes = auxiliar.numEnemies;
+        auxiliar.pisoCalabozo = p + 1;
+        crearCalabozo(auxiliar);
+        entrada.ultimoEnemigo = auxiliar.piso.ultimoEnemigo;
+        entrada.enemigosDespues = auxiliar.numEnemies;
+        std::memcpy(resto + sizeof(EntradaPiso) * static_cast<size_t>(p), &entrada, sizeof(entrada));
+        std::memcpy(resto + bytesEntradas + bytesPiso * static_cast<size_t>(p), auxiliar.piso.celdas.data(), bytesPiso);
+    }
+    liberarPiso(auxiliar.piso);
+
+    CabeceraCompartido cabecera;
+    std::memcpy(cabecera.firma, firmaCompartido, sizeof(firmaCompartido));
+    cabecera.version = versionCompartido;
+    cabecera.tamanoCelda = sizeof(Celda);
+    cabecera.columnas = static_cast<uint32_t>(clave.columnas);
+    cabecera.filas = static_cast<uint32_t>(clave.filas);
+    cabecera.pisos = static_cast<uint32_t>(clave.pisos);
+    cabecera.maxEnemigos = clave.maxEnemigos;
+    cabecera.semilla = clave.semilla;
+    cabecera.flujo = clave.flujo;
+    copiarReglas(clave.reglas, cabecera.reglas);
+    cabecera.bytesDatos = total - sizeof(CabeceraCompartido);
+    cabecera.sumaVerificacion = calcularSuma(resto, static_cast<size_t>(cabecera.bytesDatos));
+    std::memcpy(buffer, &cabecera, sizeof(cabecera));
+
+    calabozo->datos = buffer;
+    calabozo->bytes = total;
+    calabozo->enlazar(clave);
+    return calabozo;
+}
+
+bool CalabozoCompartido::colocarPiso(Partida& partida) const {
+    int numero = partida.pisoCalabozo;
+    if (numero < 1 || numero > claveCalabozo.pisos || !(ClaveCalabozo::de(partida) == claveCalabozo)) {
+        return false;
+    }
+    const EntradaPiso& entrada = entradas[numero - 1];
+    if (partida.numEnemies != entrada.enemigosAntes) {
+        return false; // La partida no viene de los pisos anteriores de este calabozo
+    }
+
+    Piso& piso = partida.piso;
+    piso.celdas.liberar();
+    piso.planos.liberar();
+    piso.tocadas.liberar();
+    piso.modificadas.reiniciar(partida.arena);
+    piso.perezoso = true;
+    piso.generado = true;
+    piso.numero = numero;
+    piso.generador = partida.generador;
+    piso.reglas = claveCalabozo.reglas;
+    piso.ultimoEnemigo = entrada.ultimoEnemigo;
+    piso.compartidas = celdas + static_cast<size_t>(celdasPorPiso(claveCalabozo)) * static_cast<size_t>(numero - 1);
+    partida.numEnemies = entrada.enemigosDespues;
+    return true;
+}
+
+CatalogoPisos::CatalogoPisos(std::string directorio) : directorio(std::move(directorio)) {}
+
+std::string CatalogoPisos::rutaDe(const ClaveCalabozo& clave) const {
+    std::ostringstream ruta;
+    ruta << directorio << "/calabozo-" << std::hex << std::setw(16) << std::setfill('0') << clave.resumen() << ".cpis";
+    return ruta.str();
+}
+
+std::shared_ptr<const CalabozoCompartido> CatalogoPisos::obtener(const Partida& partida) {
+    ClaveCalabozo clave = ClaveCalabozo::de(partida);
+    uint64_t resumen = clave.resumen();
+    std::unique_lock<std::mutex> candado(mutex);
+    for (;;) {
+        auto encontrado = enUso.find(resumen);
+        if (encontrado != enUso.end()) {
+            std::shared_ptr<const CalabozoCompartido> calabozo = encontrado->second.lock();
+            if (calabozo && calabozo->clave() == clave) {
+                ++numReusados;
+                return calabozo;
+            }
+        }
+        // Si otro hilo ya lo está abriendo o generando se espera a que termine
+        if (enPreparacion.count(resumen) == 0) {
+            break;
+        }
+        preparado.wait(candado);
+    }
+    enPreparacion.insert(resumen);
+    candado.unlock();
+
+    // Abrir, generar y escribir van sin el candado: las demás claves no esperan
+    bool abierto = false;
+    bool publicado = false;
+    std::shared_ptr<const CalabozoCompartido> calabozo;
+    try {
+        // Otro proceso (o este mismo, antes) pudo haberlo publicado ya
+        std::string ruta = rutaDe(clave);
+        calabozo = CalabozoCompartido::abrir(ruta, clave);
+        abierto = calabozo != nullptr;
+        std::shared_ptr<const CalabozoCompartido> generado;
+        if (!calabozo) {
+            generado = CalabozoCompartido::generar(clave);
+        }
+        // Se proyecta el archivo recién escrito para que todos compartan sus páginas
+        if (generado && publicarArchivoAtomico(ruta.c_str(), generado->contenido(), generado->tamano())) {
+            publicado = true;
+            calabozo = CalabozoCompartido::abrir(ruta, clave);
+        }
+        if (!calabozo) {
+            calabozo = generado;
+        }
+    }
+    catch (...) {
+        candado.lock();
+        enPreparacion.erase(resumen);
+        preparado.notify_all();
+        throw;
+    }
+
+    candado.lock();
+    enPreparacion.erase(resumen);
+    preparado.notify_all();
+    numAbiertos += abierto ? 1 : 0;
+    numPublicados += publicado ? 1 : 0;
+    if (!calabozo) {
+        return nullptr;
+    }
+    // Las entradas vencidas se limpian cuando el mapa duplica su tamaño, para que no crezca sin límite
+    if (enUso.size() >= limpiarEn) {
+        for (auto entrada = enUso.begin(); entrada != enUso.end();) {
+            entrada = entrada->second.expired() ? enUso.erase(entrada) : std::next(entrada);
+        }
+        limpiarEn = std::max<size_t>(64, 2 * enUso.size());
+    }
+    enUso[resumen] = calabozo;
+    return calabozo;
+}
+
+uint64_t CatalogoPisos::publicados() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numPublicados;
+}
+
+uint64_t CatalogoPisos::abiertos() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numAbiertos;
+}
+
+uint64_t CatalogoPisos::reusados() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numReusados;
+}
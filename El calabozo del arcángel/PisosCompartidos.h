@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Calabozo.h"
+#include "Guardado.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Pisos generados una sola vez y compartidos de solo lectura entre todas las
+ * partidas que juegan la misma semilla.
+ *
+ * Un CalabozoCompartido tiene todos los pisos de un calabozo tal como los deja
+ * crearCalabozo, uno detrás de otro, en un archivo 'calabozo-<clave>.cpis' que
+ * se proyecta en memoria. Una partida que lo usa (Partida::calabozoCompartido)
+ * no genera nada al empezar ni al cambiar de piso: su piso queda en modo
+ * perezoso con Piso::compartidas apuntando al archivo, y solo guarda en
+ * 'modificadas' las celdas que su juego cambia (visitadas, enemigos vencidos,
+ * cofres abiertos, tabernas usadas y la del jugador). Las páginas del archivo
+ * las comparten todas las partidas del proceso y, a través del sistema, todos
+ * los procesos que abren el mismo archivo.
+ */
+
+/**
+ * Lo que determina el contenido de todos los pisos de un calabozo.
+ */
+struct ClaveCalabozo {
+    uint64_t semilla = 0;
+    uint64_t flujo = 0;
+    int columnas = 0;
+    int filas = 0;
+    int pisos = 0;
+    int maxEnemigos = 0;
+    ReglasCeldas reglas;
+
+    bool operator==(const ClaveCalabozo& otra) const {
+        return semilla == otra.semilla && flujo == otra.flujo && columnas == otra.columnas && filas == otra.filas
+            && pisos == otra.pisos && maxEnemigos == otra.maxEnemigos && reglas == otra.reglas;
+    }
+
+    /**
+     * Clave de los pisos que jugaría una partida nueva con ese generador, tablero y equilibrio.
+     */
+    static ClaveCalabozo de(const Partida& partida);
+
+    /**
+     * 64 bits que resumen la clave (dan el nombre del archivo).
+     */
+    uint64_t resumen() const;
+};
+
+/**
+ * Todos los pisos de un calabozo, de solo lectura. Vive mientras alguna partida
+ * lo use (se reparte con shared_ptr).
+ */
+class CalabozoCompartido {
+public:
+    /**
+     * Proyecta un archivo publicado y lo valida (firma, versión, tamaños, suma
+     * de verificación y clave).
+     * return nullptr si no existe, está dañado o es de otra clave.
+     */
+    static std::shared_ptr<const CalabozoCompartido> abrir(const std::string& ruta, const ClaveCalabozo& clave);
+
+    /**
+     * Genera los pisos de la clave en memoria, como lo haría una partida nueva.
+     */
+    static std::shared_ptr<const CalabozoCompartido> generar(const ClaveCalabozo& clave);
+
+    CalabozoCompartido(const CalabozoCompartido&) = delete;
+    CalabozoCompartido& operator=(const CalabozoCompartido&) = delete;
+
+    const ClaveCalabozo& clave() const { return claveCalabozo; }
+
+    /**
+     * Contenido completo del archivo (para escribirlo).
+     */
+    const unsigned char* contenido() const;
+    size_t tamano() const;
+
+    /**
+     * Pone en el piso de la partida el piso número partida.pisoCalabozo sin
+     * generar nada. Solo lo hace si el piso es justo el que generaría
+     * crearCalabozo: mismo tablero, reglas y enemigos generados hasta ahora.
+     * return false si no corresponde; la partida queda como estaba.
+     */
+    bool colocarPiso(Partida& partida) const;
+
+public:
+    struct EntradaPiso;
+
+private:
+
+    CalabozoCompartido() = default;
+    bool enlazar(const ClaveCalabozo& clave);
+
+    ClaveCalabozo claveCalabozo;
+    std::unique_ptr<ArchivoMapeado> archivo;    // Con abrir
+    std::vector<uint64_t> propio;               // Con generar (uint64_t para que las celdas queden alineadas)
+    const unsigned char* datos = nullptr;
+    size_t bytes = 0;
+    const EntradaPiso* entradas = nullptr;
+    const Celda* celdas = nullptr;
+};
+
+/**
+ * Calabozos publicados en un directorio. obtener() entrega el de una partida:
+ * el que ya está abierto en el proceso, o el archivo si otro proceso ya lo
+ * publicó, o lo genera y lo publica (publicarArchivoAtomico). Es seguro entre
+ * hilos; el candado solo protege el mapa, y mientras un hilo prepara una clave
+ * los que piden esa misma clave lo esperan en vez de generarla otra vez.
+ */
+class CatalogoPisos {
+public:
+    explicit CatalogoPisos(std::string directorio);
+
+    CatalogoPisos(const CatalogoPisos&) = delete;
+    CatalogoPisos& operator=(const CatalogoPisos&) = delete;
+
+    /**
+     * Calabozo de la partida, que todavía no creó su primer piso. Si no se pudo
+     * escribir el archivo se usa igual la copia generada en memoria.
+     */
+    std::shared_ptr<const CalabozoCompartido> obtener(const Partida& partida);
+
+    std::string rutaDe(const ClaveCalabozo& clave) const;
+
+    uint64_t publicados() const;    // Calabozos generados y escritos por este proceso
+    uint64_t abiertos() const;      // Calabozos proyectados desde un archivo ya publicado
+    uint64_t reusados() const;      // Pedidos resueltos con un calabozo ya abierto en el proceso
+
+private:
+    std::string directorio;
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, std::weak_ptr<const CalabozoCompartido>> enUso;
+    std::unordered_set<uint64_t> enPreparacion;   // Claves que algún hilo está abriendo o generando
+    std::condition_variable preparado;            // Se avisa al terminar cada preparación
+    size_t limpiarEn = 64;          // Tamaño del mapa al que se quitan las entradas vencidas
+    uint64_t numPublicados = 0;
+    uint64_t numAbiertos = 0;
+    uint64_t numReusados = 0;
+};
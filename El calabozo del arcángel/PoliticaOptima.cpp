@@ -0,0 +1,591 @@
+#include "PoliticaOptima.h"
+#include "CalculadoraCombate.h"
+#include "ConsultasPiso.h"
+#include "Guardado.h"
+#include "PoolHilos.h"
+#include "Simulacion.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+
+namespace {
+    /**
+     * Dirección por el eje en el que falta más distancia hasta la salida, para
+     * los estados que la tabla no cubre.
+     */
+    char haciaLaSalida(const Partida& partida) {
+        const Piso& piso = partida.piso;
+        int faltanColumnas = piso.columnas - 1 - piso.columnaDe(partida.jugador.posicion);
+        int faltanFilas = piso.filas - 1 - piso.filaDe(partida.jugador.posicion);
+        return faltanColumnas >= faltanFilas ? 'D' : 'S';
+    }
+
+    /**
+     * Lo que le importa al modelo de cada celda de un piso.
+     */
+    struct ContenidoPiso {
+        std::vector<int8_t> enemigo;        // Índice en 'tipos' o -1
+        std::vector<int8_t> cofre;          // chestContent, 0 sin cofre
+        std::vector<std::pair<int, int>> tipos; // Salud y ataque de cada tipo de enemigo
+        int enemigos = 0;
+        int armas = 0;
+    };
+
+    ContenidoPiso contenidoDe(const Piso& piso) {
+        ContenidoPiso contenido;
+        size_t celdas = static_cast<size_t>(piso.columnas) * piso.filas;
+        contenido.enemigo.assign(celdas, -1);
+        contenido.cofre.assign(celdas, 0);
+        // Solo se leen las celdas con enemigo o cofre (con planos, sin recorrer el piso)
+        piso.paraCada(CeldaEnemigo, [&](int64_t i, const Celda& celda) {
+            std::pair<int, int> tipo(celda.enemyHealth, celda.enemyAttack);
+            auto encontrado = std::find(contenido.tipos.begin(), contenido.tipos.end(), tipo);
+            if (encontrado == contenido.tipos.end()) {
+                encontrado = contenido.tipos.insert(contenido.tipos.end(), tipo);
+            }
+            contenido.enemigo[static_cast<size_t>(i)] = static_cast<int8_t>(encontrado - contenido.tipos.begin());
+            ++contenido.enemigos;
+        });
+        piso.paraCada(CeldaCofre, [&](int64_t i, const Celda& celda) {
+            contenido.cofre[static_cast<size_t>(i)] = static_cast<int8_t>(celda.chestContent);
+            contenido.armas += (celda.chestContent == 1) ? 1 : 0;
+        });
+        return contenido;
+    }
+
+    /**
+     * Celda en la que termina cada (celda, dirección, pasos), o -1 si el camino
+     * pasa por la salida. Igual que avanzarJugador (ver ConsultasPiso::destino).
+     */
+    std::vector<int64_t> calcularDestinos(const Piso& piso) {
+        ConsultasPiso consultas(piso);
+        int64_t celdas = static_cast<int64_t>(piso.columnas) * piso.filas;
+        std::vector<int64_t> destinos(static_cast<size_t>(celdas) * 4 * resultadosDados);
+        for (int64_t origen = 0; origen < celdas; ++origen) {
+            for (int d = 0; d < 4; ++d) {
+                for (int pasos = 2; pasos <= 12; ++pasos) {
+                    int64_t destino = consultas.destino(origen, d, pasos);
+                    size_t i = (static_cast<size_t>(origen) * 4 + d) * resultadosDados + (pasos - 2);
+                    destinos[i] = destino == consultas.salida() ? -1 : destino;
+                }
+            }
+        }
+        return destinos;
+    }
+
+    /**
+     * Cabecera del archivo de la tabla. Le siguen, por piso, su número, sus
+     * enemigos y cofres con arma, las decisiones y los valores.
+     */
+    struct CabeceraPolitica {
+        char firma[4];
+        uint16_t version;
+        uint16_t tamanoCabecera;
+        int32_t columnas;
+        int32_t filas;
+        int32_t limiteTiradas;
+        int32_t saludModelo;
+        int32_t ataqueBase;
+        int32_t nivelesAtaque;
+        int32_t pisoInicial;
+        int32_t numPisos;
+        double inicial;
+    };
+
+    static_assert(sizeof(CabeceraPolitica) == 48, "La cabecera no debe tener relleno");
+
+    const char firmaPolitica[4] = { 'C', 'P', 'O', 'L' };
+    const uint16_t versionPolitica = 1;
+
+    void agregar(std::vector<unsigned char>& buffer, const void* datos, size_t bytes) {
+        const unsigned char* origen = static_cast<const unsigned char*>(datos);
+        buffer.insert(buffer.end(), origen, origen + bytes);
+    }
+
+    /**
+     * El jugador con el ataque de un nivel: cada arma da +5 al jugador y +2 a cada recluta.
+     */
+    Jugador conNivel(Jugador jugador, int salud, int nivel) {
+        jugador.health = salud;
+        jugador.attackPower += 5 * nivel;
+        for (auto& recluta : jugador.equipo) {
+            recluta.attackPower += 2 * nivel;
+        }
+        return jugador;
+    }
+}
+
+uint64_t TablaPolitica::estadosPorPiso() const {
+    return static_cast<uint64_t>(limiteTiradas + 1) * saludModelo * nivelesAtaque * (columnas + filas - 1)
+        * static_cast<uint64_t>(columnas) * filas;
+}
+
+size_t TablaPolitica::posicion(int64_t celda, int tiradas, int salud, int nivel, int progreso) const {
+    int64_t celdas = static_cast<int64_t>(columnas) * filas;
+    int64_t i = (static_cast<int64_t>(tiradas) * saludModelo + (salud - 1)) * nivelesAtaque + nivel;
+    return static_cast<size_t>((i * (columnas + filas - 1) + progreso) * celdas + celda);
+}
+
+const TablaPolitica::PisoPolitica* TablaPolitica::pisoNumero(int numero) const {
+    int i = numero - pisoInicial;
+    if (i < 0 || i >= static_cast<int>(pisos.size())) {
+        return nullptr;
+    }
+    return &pisos[static_cast<size_t>(i)];
+}
+
+bool TablaPolitica::dentro(const PisoPolitica* piso, int64_t celda, int tiradas, int salud, int progreso) const {
+    return piso && celda >= 0 && celda < static_cast<int64_t>(columnas) * filas && tiradas >= 0 && tiradas <= limiteTiradas
+        && salud >= 1 && progreso >= 0 && progreso < columnas + filas - 1;
+}
+
+int TablaPolitica::nivelAtaque(int ataque) const {
+    return std::min(std::max((ataque - ataqueBase) / 5, 0), nivelesAtaque - 1);
+}
+
+int TablaPolitica::enemigosEnPiso(int piso) const {
+    const PisoPolitica* datos = pisoNumero(piso);
+    return datos ? datos->enemigos : 0;
+}
+
+int TablaPolitica::armasEnPiso(int piso) const {
+    const PisoPolitica* datos = pisoNumero(piso);
+    return datos ? datos->armas : 0;
+}
+
+char TablaPolitica::direccion(int piso, int64_t celda, int tiradas, int salud, int ataque, int progreso, int pasos) const {
+    const PisoPolitica* datos = pisoNumero(piso);
+    if (!dentro(datos, celda, tiradas, salud, progreso) || pasos < 2 || pasos > 12) {
+        return 0;
+    }
+    uint32_t decision = datos->decisiones[posicion(celda, tiradas, std::min(salud, saludModelo), nivelAtaque(ataque), progreso)];
+    return direccionesMovimiento[(decision >> (2 * (pasos - 2))) & 3];
+}
+
+double TablaPolitica::probabilidad(int piso, int64_t celda, int tiradas, int salud, int ataque, int progreso) const {
+    const PisoPolitica* datos = pisoNumero(piso);
+    if (!dentro(datos, celda, tiradas, salud, progreso)) {
+        return 0.0;
+    }
+    return datos->valores[posicion(celda, tiradas, std::min(salud, saludModelo), nivelAtaque(ataque), progreso)];
+}
+
+char TablaPolitica::direccion(const Partida& partida, int progreso, int pasos) const {
+    const Piso& piso = partida.piso;
+    if (!partida.jugador.posicion) {
+        return 'D';
+    }
+    char elegida = 0;
+    if (piso.columnas == columnas && piso.filas == filas) {
+        // lanzarDados ya contó la tirada de este turno
+        elegida = direccion(partida.pisoCalabozo, piso.indiceDe(partida.jugador.posicion), partida.numDiceThrows - 1,
+            partida.jugador.health, partida.jugador.attackPower, progreso, pasos);
+    }
+    return elegida ? elegida : haciaLaSalida(partida);
+}
+
+uint64_t TablaPolitica::estados() const {
+    uint64_t total = 0;
+    for (const PisoPolitica& piso : pisos) {
+        total += piso.valores.size();
+    }
+    return total;
+}
+
+size_t TablaPolitica::bytes() const {
+    size_t total = 0;
+    for (const PisoPolitica& piso : pisos) {
+        total += piso.decisiones.size() * sizeof(uint32_t) + piso.valores.size() * sizeof(float);
+    }
+    return total;
+}
+
+bool TablaPolitica::guardar(const char* ruta) const {
+    CabeceraPolitica cabecera = {};
+    std::memcpy(cabecera.firma, firmaPolitica, sizeof(firmaPolitica));
+    cabecera.version = versionPolitica;
+    cabecera.tamanoCabecera = sizeof(CabeceraPolitica);
+    cabecera.columnas = columnas;
+    cabecera.filas = filas;
+    cabecera.limiteTiradas = limiteTiradas;
+    cabecera.saludModelo = saludModelo;
+    cabecera.ataqueBase = ataqueBase;
+    cabecera.nivelesAtaque = nivelesAtaque;
+    cabecera.pisoInicial = pisoInicial;
+    cabecera.numPisos = static_cast<int32_t>(pisos.size());
+    cabecera.inicial = inicial;
+
+    std::vector<unsigned char> buffer;
+    buffer.reserve(sizeof(cabecera) + bytes() + pisos.size() * 12);
+    agregar(buffer, &cabecera, sizeof(cabecera));
+    for (const PisoPolitica& piso : pisos) {
+        int32_t datos[3] = { piso.numero, piso.enemigos, piso.armas };
+        agregar(buffer, datos, sizeof(datos));
+        agregar(buffer, piso.decisiones.data(), piso.decisiones.size() * sizeof(uint32_t));
+        agregar(buffer, piso.valores.data(), piso.valores.size() * sizeof(float));
+    }
+    return escribirArchivoAtomico(ruta, buffer.data(), buffer.size());
+}
+
+bool TablaPolitica::cargar(const char* ruta) {
+    ArchivoMapeado archivo(ruta);
+    if (!archivo.abierto() || archivo.tamano() < sizeof(CabeceraPolitica)) {
+        return false;
+    }
+
+    CabeceraPolitica cabecera;
+    std::memcpy(&cabecera, archivo.contenido(), sizeof(cabecera));
+    if (std::memcmp(cabecera.firma, firmaPolitica, sizeof(firmaPolitica)) != 0 || cabecera.version != versionPolitica
+        || cabecera.tamanoCabecera != sizeof(CabeceraPolitica) || cabecera.columnas < 1 || cabecera.filas < 1
+        || cabecera.limiteTiradas < 0 || cabecera.saludModelo < 1 || cabecera.nivelesAtaque < 1
+        || cabecera.numPisos < 0 || cabecera.numPisos > maxPisos) {
+        return false;
+    }
+
+    TablaPolitica leida;
+    leida.columnas = cabecera.columnas;
+    leida.filas = cabecera.filas;
+    leida.limiteTiradas = cabecera.limiteTiradas;
+    leida.saludModelo = cabecera.saludModelo;
+    leida.ataqueBase = cabecera.ataqueBase;
+    leida.nivelesAtaque = cabecera.nivelesAtaque;
+    leida.pisoInicial = cabecera.pisoInicial;
+    leida.inicial = cabecera.inicial;
+
+    const unsigned char* datos = archivo.contenido() + sizeof(cabecera);
+    size_t restantes = archivo.tamano() - sizeof(cabecera);
+    auto leer = [&](void* destino, size_t bytesPedidos) {
+        if (bytesPedidos > restantes) {
+            return false;
+        }
+        std::memcpy(destino, datos, bytesPedidos);
+        datos += bytesPedidos;
+        restantes -= bytesPedidos;
+        return true;
+    };
+
+    uint64_t estadosPiso = leida.estadosPorPiso();
+    for (int32_t p = 0; p < cabecera.numPisos; ++p) {
+        int32_t numeros[3];
+        if (!leer(numeros, sizeof(numeros)) || estadosPiso * (sizeof(uint32_t) + sizeof(float)) > restantes) {
+            return false;
+        }
+        PisoPolitica piso;
+        piso.numero = numeros[0];
+        piso.enemigos = numeros[1];
+        piso.armas = numeros[2];
+        piso.decisiones.resize(static_cast<size_t>(estadosPiso));
+        piso.valores.resize(static_cast<size_t>(estadosPiso));
+        leer(piso.decisiones.data(), piso.decisiones.size() * sizeof(uint32_t));
+        leer(piso.valores.data(), piso.valores.size() * sizeof(float));
+        leida.pisos.push_back(std::move(piso));
+    }
+    if (restantes != 0) {
+        return false;
+    }
+    *this = std::move(leida);
+    return true;
+}
+
+bool resolverPolitica(const Partida& partida, TablaPolitica& tabla, const OpcionesPolitica& opciones, PoolHilos* pool) {
+    const Piso& actual = partida.piso;
+    if (!partida.juego || partida.jugador.health <= 0 || !partida.jugador.posicion
+        || partida.pisoCalabozo < 1 || partida.pisoCalabozo > partida.numPisos) {
+        return false;
+    }
+
+    // Contenido del piso actual (lo que queda) y de los pisos que faltan,
+    // generados como lo haría avanzarPiso
+    std::vector<ContenidoPiso> contenidos;
+    contenidos.push_back(contenidoDe(actual));
+    Partida auxiliar;
+    auxiliar.generador = partida.generador;
+    auxiliar.equilibrio = partida.equilibrio;
+    auxiliar.piso.columnas = actual.columnas;
+    auxiliar.piso.filas = actual.filas;
+    auxiliar.numEnemies = partida.numEnemies;
+    for (int numero = partida.pisoCalabozo + 1; numero <= partida.numPisos; ++numero) {
+        auxiliar.pisoCalabozo = numero;
+        crearCalabozo(auxiliar);
+        contenidos.push_back(contenidoDe(auxiliar.piso));
+    }
+    liberarPiso(auxiliar.piso);
+
+    // La salud se recorta a la que aguanta un golpe del Arcángel (recortar es
+    // pesimista); más ataque que la salud del enemigo más fuerte no cambia nada
+    const Jugador& jugador = partida.jugador;
+    int saludObjetivo = opciones.soloLlegar ? 0 : partida.arcangel.health;
+    for (const ContenidoPiso& contenido : contenidos) {
+        for (const auto& tipo : contenido.tipos) {
+            saludObjetivo = std::max(saludObjetivo, tipo.first);
+        }
+    }
+    int saludModelo = std::max(jugador.health, partida.arcangel.attackPower + 1);
+    int nivelesAtaque = 1 + std::max(0, (saludObjetivo - jugador.attackPower + 4) / 5);
+
+    tabla = TablaPolitica();
+    tabla.limiteTiradas = partida.equilibrio.limiteTiradas;
+    tabla.columnas = actual.columnas;
+    tabla.filas = actual.filas;
+    tabla.saludModelo = saludModelo;
+    tabla.ataqueBase = jugador.attackPower;
+    tabla.nivelesAtaque = nivelesAtaque;
+    tabla.pisoInicial = partida.pisoCalabozo;
+    uint64_t porPiso = tabla.estadosPorPiso();
+    if (porPiso * contenidos.size() > opciones.limiteEstados) {
+        tabla = TablaPolitica();
+        return false;
+    }
+    tabla.pisos.resize(contenidos.size());
+
+    int capas = tabla.limiteTiradas + 1;
+    int progresos = actual.columnas + actual.filas - 1;
+    int64_t celdas = static_cast<int64_t>(actual.columnas) * actual.filas;
+    size_t anchoSalud = static_cast<size_t>(saludModelo) + 1;
+
+    // Salud final de cada combate: combates[p][((tipo, nivel, salud antes), salud después)]
+    CalculadoraCombate calculadora;
+    std::vector<std::vector<double>> combates(contenidos.size());
+    for (size_t p = 0; p < contenidos.size(); ++p) {
+        const ContenidoPiso& contenido = contenidos[p];
+        combates[p].assign(contenido.tipos.size() * nivelesAtaque * anchoSalud * anchoSalud, 0.0);
+        for (size_t tipo = 0; tipo < contenido.tipos.size(); ++tipo) {
+            for (int nivel = 0; nivel < nivelesAtaque; ++nivel) {
+                for (int salud = 1; salud <= saludModelo; ++salud) {
+                    std::vector<double> distribucion = calculadora.distribucionVida(CalculadoraCombate::estadoInicial(
+                        conNivel(jugador, salud, nivel), contenido.tipos[tipo].first, contenido.tipos[tipo].second));
+                    size_t fila = (tipo * nivelesAtaque + nivel) * anchoSalud + salud;
+                    std::copy(distribucion.begin(), distribucion.end(), combates[p].begin() + fila * anchoSalud);
+                }
+            }
+        }
+    }
+
+    // Valor de llegar a la salida del último piso con cada salud y nivel
+    std::vector<double> arcangel(nivelesAtaque * anchoSalud, 0.0);
+    for (int nivel = 0; nivel < nivelesAtaque; ++nivel) {
+        for (int salud = 1; salud <= saludModelo; ++salud) {
+            arcangel[nivel * anchoSalud + salud] = opciones.soloLlegar
+                ? 1.0 : calculadora.contraArcangel(conNivel(jugador, salud, nivel), partida.arcangel).probVictoria;
+        }
+    }
+
+    std::vector<int64_t> destinos = calcularDestinos(actual);
+    std::vector<int> diagonal(static_cast<size_t>(celdas));
+    for (int64_t c = 0; c < celdas; ++c) {
+        diagonal[static_cast<size_t>(c)] = static_cast<int>(c % actual.columnas + c / actual.columnas);
+    }
+    double probabilidades[resultadosDados];
+    for (int pasos = 2; pasos <= 12; ++pasos) {
+        probabilidades[pasos - 2] = probabilidadDados(pasos);
+    }
+
+    for (size_t p = contenidos.size(); p-- > 0;) {
+        TablaPolitica::PisoPolitica& piso = tabla.pisos[p];
+        const ContenidoPiso& contenido = contenidos[p];
+        const std::vector<double>& combate = combates[p];
+        piso.numero = partida.pisoCalabozo + static_cast<int>(p);
+        piso.enemigos = contenido.enemigos;
+        piso.armas = contenido.armas;
+        piso.decisiones.assign(static_cast<size_t>(porPiso), 0);
+        piso.valores.assign(static_cast<size_t>(porPiso), 0.0f);
+
+        // Salir del piso lleva al inicio del siguiente con la misma salud y ataque
+        std::vector<double> salida(nivelesAtaque * anchoSalud, 0.0);
+        for (int nivel = 0; nivel < nivelesAtaque; ++nivel) {
+            for (int salud = 1; salud <= saludModelo; ++salud) {
+                salida[nivel * anchoSalud + salud] = (p + 1 == contenidos.size())
+                    ? arcangel[nivel * anchoSalud + salud]
+                    : tabla.pisos[p + 1].valores[tabla.posicion(0, 0, salud, nivel, 0)];
+            }
+        }
+
+        // Valor de caer en 'destino' con la tirada 'tiradas' ya contada: combate, cofre y lo que siga
+        auto caer = [&](int64_t destino, int tiradas, int salud, int nivel, int progreso) {
+            size_t i = static_cast<size_t>(destino);
+            bool celdaNueva = diagonal[i] > progreso;
+            int nuevoProgreso = std::max(progreso, diagonal[i]);
+            auto conCofre = [&](int queda) {
+                int nuevoNivel = nivel;
+                if (celdaNueva) {
+                    switch (contenido.cofre[i]) {
+                    case 1: nuevoNivel = std::min(nivel + 1, nivelesAtaque - 1); break;
+                    case 2: queda = std::min(queda + 1, saludModelo); break;
+                    case 3: queda = std::min(std::max(queda + static_cast<int>(queda * 0.1), 1), saludModelo); break;
+                    }
+                }
+                return static_cast<double>(piso.valores[tabla.posicion(destino, tiradas, queda, nuevoNivel, nuevoProgreso)]);
+            };
+
+            int tipo = contenido.enemigo[i];
+            if (tipo < 0) {
+                return conCofre(salud);
+            }
+            const double* despues = &combate[((static_cast<size_t>(tipo) * nivelesAtaque + nivel) * anchoSalud + salud) * anchoSalud];
+            double valor = 0.0;
+            for (int queda = 1; queda <= salud; ++queda) {
+                if (despues[queda] > 0.0) {
+                    valor += despues[queda] * conCofre(queda);
+                }
+            }
+            return valor;
+        };
+
+        uint64_t porCapa = porPiso / capas;
+        for (int tiradas = capas - 1; tiradas >= 0; --tiradas) {
+            bool ultima = (tiradas + 1 >= capas);   // Si no sale del piso en esta tirada, pierde
+
+            // Resuelve los estados [desde, hasta) de esta capa; solo leen la capa siguiente
+            auto resolverRango = [&, tiradas, ultima](uint64_t desde, uint64_t hasta) {
+                for (uint64_t j = desde; j < hasta; ++j) {
+                    int64_t celda = static_cast<int64_t>(j % celdas);
+                    uint64_t resto = j / celdas;
+                    int progreso = static_cast<int>(resto % progresos);
+                    resto /= progresos;
+                    int nivel = static_cast<int>(resto % nivelesAtaque);
+                    int salud = static_cast<int>(resto / nivelesAtaque) + 1;
+                    if (progreso < diagonal[static_cast<size_t>(celda)]) {
+                        continue; // Imposible: la celda actual ya cuenta en el progreso
+                    }
+
+                    double valor = 0.0;
+                    uint32_t decision = 0;
+                    for (int r = 0; r < resultadosDados; ++r) {
+                        double mejor = -1.0;
+                        int elegida = 0;
+                        for (int d = 0; d < 4; ++d) {
+                            int64_t destino = destinos[(static_cast<size_t>(celda) * 4 + d) * resultadosDados + r];
+                            double resultado = 0.0;
+                            if (destino < 0) {
+                                resultado = salida[nivel * anchoSalud + salud];
+                            }
+                            else if (!ultima) {
+                                resultado = caer(destino, tiradas + 1, salud, nivel, progreso);
+                            }
+                            if (resultado > mejor) {
+                                mejor = resultado;
+                                elegida = d;
+                            }
+                        }
+                        valor += probabilidades[r] * mejor;
+                        decision |= static_cast<uint32_t>(elegida) << (2 * r);
+                    }
+
+                    size_t i = static_cast<size_t>(tiradas * porCapa + j);
+                    piso.decisiones[i] = decision;
+                    piso.valores[i] = static_cast<float>(valor);
+                }
+            };
+
+            if (pool && porCapa >= 4096) {
+                uint64_t trozo = std::max<uint64_t>(1024, porCapa / (pool->hilos() * 8ull));
+                for (uint64_t desde = 0; desde < porCapa; desde += trozo) {
+                    uint64_t hasta = std::min(porCapa, desde + trozo);
+                    pool->encolar([&resolverRango, desde, hasta] { resolverRango(desde, hasta); });
+                }
+                pool->esperar();
+            }
+            else {
+                resolverRango(0, porCapa);
+            }
+        }
+    }
+
+    int64_t celda = actual.indiceDe(jugador.posicion);
+    int tiradas = std::min(std::max(partida.numDiceThrows, 0), capas - 1);
+    tabla.inicial = tabla.probabilidad(partida.pisoCalabozo, celda, tiradas, jugador.health, jugador.attackPower,
+        diagonal[static_cast<size_t>(celda)]);
+    return true;
+}
+
+PoliticaMovimiento politicaOptima(const OpcionesPolitica& opciones) {
+    std::shared_ptr<TablaPolitica> tabla;
+    int piso = 0;
+    int progreso = 0;
+    return [opciones, tabla, piso, progreso](Partida& partida, int pasos) mutable {
+        if (!tabla) {
+            tabla = std::make_shared<TablaPolitica>();
+            resolverPolitica(partida, *tabla, opciones); // Si no se puede, la tabla vacía va hacia la salida
+        }
+        // El progreso es la mayor diagonal de las celdas donde el jugador cayó en este piso
+        if (partida.pisoCalabozo != piso) {
+            piso = partida.pisoCalabozo;
+            progreso = 0;
+        }
+        const Piso& actual = partida.piso;
+        progreso = std::max(progreso, actual.columnaDe(partida.jugador.posicion) + actual.filaDe(partida.jugador.posicion));
+        return tabla->direccion(partida, progreso, pasos);
+    };
+}
+
+std::vector<DificultadPartida> clasificarPartidas(const OpcionesClasificacion& opciones) {
+    std::vector<DificultadPartida> partidas(static_cast<size_t>(opciones.partidas));
+    {
+        PoolHilos pool(opciones.hilos);
+        for (uint64_t n = 0; n < opciones.partidas; ++n) {
+            pool.encolar([&, n] {
+                Partida partida;
+                configurarPartidaSinTerminal(partida, opciones.semilla, n, PoliticaMovimiento());
+                aplicarTablero(partida, opciones.tablero);
+                iniciarPartida(partida);
+
+                TablaPolitica tabla;
+                DificultadPartida& dificultad = partidas[static_cast<size_t>(n)];
+                dificultad.flujo = n;
+                dificultad.probabilidad = resolverPolitica(partida, tabla, opciones.politica) ? tabla.probabilidadInicial() : -1.0;
+                for (int piso = tabla.primerPiso(); piso <= tabla.ultimoPiso(); ++piso) {
+                    dificultad.enemigos += tabla.enemigosEnPiso(piso);
+                    dificultad.armas += tabla.armasEnPiso(piso);
+                }
+                liberarPiso(partida.piso);
+            });
+        }
+        pool.esperar();
+    }
+
+    std::stable_sort(partidas.begin(), partidas.end(), [](const DificultadPartida& a, const DificultadPartida& b) {
+        return a.probabilidad < b.probabilidad;
+    });
+    return partidas;
+}
+
+void imprimirClasificacion(const std::vector<DificultadPartida>& partidas, std::ostream& salida) {
+    uint64_t resueltas = 0;
+    uint64_t imposibles = 0;
+    double suma = 0.0;
+    for (const DificultadPartida& partida : partidas) {
+        if (partida.probabilidad < 0.0) {
+            continue;
+        }
+        ++resueltas;
+        suma += partida.probabilidad;
+        if (partida.probabilidad <= 0.0) {
+            ++imposibles;
+        }
+    }
+
+    salida << "Partidas resueltas: " << resueltas << " de " << partidas.size() << std::endl;
+    if (resueltas == 0) {
+        return;
+    }
+    salida << std::fixed << std::setprecision(4);
+    salida << "Probabilidad media con la politica optima: " << 100.0 * suma / resueltas << " %" << std::endl;
+    salida << "Partidas imposibles: " << imposibles << std::endl;
+
+    auto imprimir = [&](const DificultadPartida& partida) {
+        salida << "  flujo " << std::setw(8) << partida.flujo << "  " << std::setw(9) << 100.0 * partida.probabilidad
+            << " %  " << partida.enemigos << " enemigos, " << partida.armas << " armas" << std::endl;
+    };
+    size_t cuantas = std::min<size_t>(5, resueltas);
+    size_t primera = partidas.size() - resueltas;  // Las no resueltas quedan al principio
+    salida << "Mas dificiles:" << std::endl;
+    for (size_t i = 0; i < cuantas; ++i) {
+        imprimir(partidas[primera + i]);
+    }
+    salida << "Mas faciles:" << std::endl;
+    for (size_t i = 0; i < cuantas; ++i) {
+        imprimir(partidas[partidas.size() - 1 - i]);
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class PoolHilos;
+
+/**
+ * Opciones del cálculo de la política óptima.
+ */
+struct OpcionesPolitica {
+    bool soloLlegar = false;            // Maximizar la probabilidad de llegar al Arcángel en vez de la de vencerlo
+    uint64_t limiteEstados = 1ull << 28; // Si el modelo tiene más estados, no se resuelve
+};
+
+/**
+ * Política óptima de movimiento de una partida, calculada sin jugar.
+ *
+ * El modelo es un proceso de decisión de Markov por piso con estado
+ * (celda, tiradas usadas, salud, armas encontradas, progreso). Los dados
+ * (2d6) y los combates son exactos: el movimiento sigue las reglas de
+ * avanzarJugador (bordes y salida revisada en cada paso) y cada combate usa
+ * la distribución de salud final de CalculadoraCombate.
+ *
+ * Recordar qué celdas ya se vaciaron no cabe en la tabla, así que el modelo
+ * es pesimista en lo que no sabe:
+ * - Los enemigos se consideran siempre presentes (pelear de nuevo solo cuesta salud).
+ * - Un cofre solo cuenta si su celda está en una diagonal (columna + fila) más
+ *   lejana que todas las celdas donde ya cayó el jugador en el piso; así nunca
+ *   se cuenta dos veces el mismo cofre. Ese máximo es el "progreso".
+ * - Las tabernas se ignoran; el equipo queda fijo en el del estado inicial.
+ * - La salud se recorta a saludMaxima() y el ataque a los niveles que todavía
+ *   cambian algún combate.
+ * Por eso la probabilidad calculada es una cota inferior de la del juego.
+ *
+ * La dirección se elige después de ver los dados, así que la tabla guarda una
+ * dirección por estado y por resultado (2 bits x 11 resultados en 32 bits) y
+ * un valor por estado. Todas las consultas son O(1).
+ */
+class TablaPolitica {
+public:
+    /**
+     * Dirección óptima (W, A, S o D) para el turno en curso. Pensada para usarse
+     * desde una PoliticaMovimiento: lanzarDados ya contó la tirada.
+     * param partida Partida en el estado en que se resolvió la tabla o uno posterior.
+     * param progreso Mayor columna + fila de las celdas donde cayó el jugador en este piso.
+     * param pasos Resultado de los dados (2 a 12).
+     */
+    char direccion(const Partida& partida, int progreso, int pasos) const;
+
+    /**
+     * Dirección óptima para un estado dado, o 0 si el estado está fuera de la tabla.
+     * param piso Número de piso (primerPiso() a ultimoPiso()).
+     * param celda Índice de la celda (Piso::indice).
+     * param tiradas Tiradas usadas en el piso antes de esta.
+     * param salud Salud del jugador; se recorta a saludMaxima().
+     * param ataque Poder de ataque del jugador.
+     * param progreso Como en la versión anterior.
+     * param pasos Resultado de los dados (2 a 12).
+     */
+    char direccion(int piso, int64_t celda, int tiradas, int salud, int ataque, int progreso, int pasos) const;
+
+    /**
+     * Probabilidad de cumplir el objetivo desde un estado, antes de lanzar los dados.
+     * Mismos parámetros que direccion.
+     */
+    double probabilidad(int piso, int64_t celda, int tiradas, int salud, int ataque, int progreso) const;
+
+    /**
+     * Probabilidad de cumplir el objetivo desde el estado con el que se resolvió la tabla.
+     */
+    double probabilidadInicial() const {
+        return inicial;
+    }
+
+    int primerPiso() const { return pisoInicial; }
+    int ultimoPiso() const { return pisoInicial + static_cast<int>(pisos.size()) - 1; }
+    int saludMaxima() const { return saludModelo; }
+    int ataqueInicial() const { return ataqueBase; }
+    int enemigosEnPiso(int piso) const;
+    int armasEnPiso(int piso) const;
+    uint64_t estados() const;
+    size_t bytes() const;
+
+    /**
+     * Escribe la tabla en un archivo binario (de forma atómica).
+     */
+    bool guardar(const char* ruta) const;
+
+    /**
+     * Lee una tabla escrita con guardar.
+     */
+    bool cargar(const char* ruta);
+
+private:
+    friend bool resolverPolitica(const Partida& partida, TablaPolitica& tabla, const OpcionesPolitica& opciones, PoolHilos* pool);
+
+    struct PisoPolitica {
+        int numero = 0;
+        int enemigos = 0;
+        int armas = 0;                      // Cofres con arma
+        std::vector<uint32_t> decisiones;   // 2 bits por resultado de los dados (2 a 12)
+        std::vector<float> valores;
+    };
+
+    uint64_t estadosPorPiso() const;
+    size_t posicion(int64_t celda, int tiradas, int salud, int nivel, int progreso) const;
+    const PisoPolitica* pisoNumero(int numero) const;
+    bool dentro(const PisoPolitica* piso, int64_t celda, int tiradas, int salud, int progreso) const;
+    int nivelAtaque(int ataque) const;
+
+    int columnas = 0;
+    int filas = 0;
+    int limiteTiradas = 15;
+    int saludModelo = 1;
+    int ataqueBase = 0;
+    int nivelesAtaque = 1;                  // Niveles de ataque: ataqueBase + 5 * nivel
+    int pisoInicial = 1;
+    double inicial = 0.0;
+    std::vector<PisoPolitica> pisos;
+};
+
+/**
+ * Resuelve la política óptima desde el estado actual de la partida hasta el
+ * Arcángel. Los pisos que faltan se generan con el mismo generador, como lo
+ * haría avanzarPiso, así que la tabla vale exactamente para esta partida.
+ * Las tiradas solo aumentan, así que basta una pasada de inducción hacia
+ * atrás, capa de tiradas por capa; los estados de cada capa se reparten entre
+ * los hilos del pool.
+ * param partida Partida en curso (no se modifica).
+ * param tabla Tabla a llenar.
+ * param pool Pool de hilos; nullptr resuelve en el hilo que llama.
+ * return false si el modelo supera opciones.limiteEstados o la partida ya terminó.
+ */
+bool resolverPolitica(const Partida& partida, TablaPolitica& tabla, const OpcionesPolitica& opciones = OpcionesPolitica(), PoolHilos* pool = nullptr);
+
+/**
+ * Política de movimiento que resuelve la tabla de su partida en la primera
+ * tirada y después solo la consulta. Cada copia de la política resuelve la suya.
+ */
+PoliticaMovimiento politicaOptima(const OpcionesPolitica& opciones = OpcionesPolitica());
+
+/**
+ * Opciones para resolver muchas partidas y ordenarlas por dificultad.
+ */
+struct OpcionesClasificacion {
+    uint64_t partidas = 100;            // Partidas a resolver (flujos 0 a partidas-1)
+    unsigned hilos = 0;                 // Hilos del pool (0 = todos los núcleos)
+    uint64_t semilla = 1;               // Semilla común, como en la simulación
+    Tablero tablero;                    // Tamaño del calabozo de cada partida
+    OpcionesPolitica politica;
+};
+
+struct DificultadPartida {
+    uint64_t flujo = 0;
+    double probabilidad = 0.0;          // Con la política óptima; -1 si no se pudo resolver
+    int enemigos = 0;                   // Enemigos del calabozo completo
+    int armas = 0;                      // Cofres con arma del calabozo completo
+};
+
+/**
+ * Resuelve cada partida en una tarea del pool.
+ * return Las partidas de la más difícil a la más fácil.
+ */
+std::vector<DificultadPartida> clasificarPartidas(const OpcionesClasificacion& opciones);
+
+void imprimirClasificacion(const std::vector<DificultadPartida>& partidas, std::ostream& salida);
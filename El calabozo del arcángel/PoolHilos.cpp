@@ -0,0 +1,115 @@
+#include "PoolHilos.h"
+
+#include <algorithm>
+
+namespace {
+    // Pool e índice del hilo actual, para que las tareas encoladas desde un hilo
+    // del pool vayan a su propia cola.
+    thread_local const PoolHilos* poolActual = nullptr;
+    thread_local int indiceActual = -1;
+}
+
+PoolHilos::PoolHilos(unsigned hilos) {
+    if (hilos == 0) {
+        hilos = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < hilos; ++i) {
+        colas.push_back(std::make_unique<Cola>());
+    }
+    for (unsigned i = 0; i < hilos; ++i) {
+        trabajadores.emplace_back(&PoolHilos::trabajar, this, i);
+    }
+}
+
+PoolHilos::~PoolHilos() {
+    {
+        std::lock_guard<std::mutex> bloqueo(mutexEstado);
+        detener = true;
+    }
+    hayTrabajo.notify_all();
+    for (auto& hilo : trabajadores) {
+        hilo.join();
+    }
+}
+
+int PoolHilos::indiceHiloActual() const {
+    return poolActual == this ? indiceActual : -1;
+}
+
+void PoolHilos::encolar(std::function<void()> tarea) {
+    int propia = indiceHiloActual();
+    unsigned destino = propia >= 0
+        ? static_cast<unsigned>(propia)
+        : siguienteCola.fetch_add(1, std::memory_order_relaxed) % colas.size();
+
+    {
+        std::lock_guard<std::mutex> bloqueo(colas[destino]->mutex);
+        colas[destino]->tareas.push_back(std::move(tarea));
+    }
+    {
+        std::lock_guard<std::mutex> bloqueo(mutexEstado);
+        ++enCola;
+        ++pendientes;
+    }
+    hayTrabajo.notify_one();
+}
+
+void PoolHilos::esperar() {
+    std::unique_lock<std::mutex> bloqueo(mutexEstado);
+    terminado.wait(bloqueo, [this] { return pendientes == 0; });
+}
+
+/**
+ * Saca una tarea de la cola propia (por el final) o la roba de otra (por el principio).
+ * return true si se obtuvo una tarea.
+ */
+bool PoolHilos::tomarTarea(unsigned propia, std::function<void()>& tarea) {
+    {
+        Cola& cola = *colas[propia];
+        std::lock_guard<std::mutex> bloqueo(cola.mutex);
+        if (!cola.tareas.empty()) {
+            tarea = std::move(cola.tareas.back());
+            cola.tareas.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < colas.size(); ++i) {
+        Cola& victima = *colas[(propia + i) % colas.size()];
+        std::lock_guard<std::mutex> bloqueo(victima.mutex);
+        if (!victima.tareas.empty()) {
+            tarea = std::move(victima.tareas.front());
+            victima.tareas.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void PoolHilos::trabajar(unsigned indice) {
+    poolActual = this;
+    indiceActual = static_cast<int>(indice);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> bloqueo(mutexEstado);
+            hayTrabajo.wait(bloqueo, [this] { return detener || enCola > 0; });
+            if (enCola == 0) {
+                return; // Se pidió detener y no queda nada por hacer
+            }
+            --enCola; // Reservar una tarea; alguna cola la tiene seguro
+        }
+
+        std::function<void()> tarea;
+        while (!tomarTarea(indice, tarea)) {
+            std::this_thread::yield(); // La tarea reservada aún se está insertando
+        }
+        tarea();
+
+        std::lock_guard<std::mutex> bloqueo(mutexEstado);
+        if (--pendientes == 0) {
+            terminado.notify_all();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool de hilos con robo de trabajo. Cada hilo tiene su propia cola: saca
+ * tareas del final de la suya y, cuando se queda sin trabajo, roba del
+ * principio de las colas de los demás. Las tareas encoladas desde un hilo
+ * del pool van a la cola de ese hilo.
+ */
+class PoolHilos {
+public:
+    /**
+     * Crea el pool.
+     * param hilos Cantidad de hilos; 0 usa todos los núcleos disponibles.
+     */
+    explicit PoolHilos(unsigned hilos = 0);
+    ~PoolHilos();
+
+    PoolHilos(const PoolHilos&) = delete;
+    PoolHilos& operator=(const PoolHilos&) = delete;
+
+    /**
+     * Agrega una tarea al pool.
+     */
+    void encolar(std::function<void()> tarea);
+
+    /**
+     * Bloquea hasta que todas las tareas encoladas hayan terminado.
+     * No debe llamarse desde una tarea del propio pool.
+     */
+    void esperar();
+
+    unsigned hilos() const {
+        return static_cast<unsigned>(trabajadores.size());
+    }
+
+    /**
+     * Índice del hilo del pool que ejecuta la llamada, o -1 si no es un hilo del pool.
+     */
+    int indiceHiloActual() const;
+
+private:
+    struct Cola {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tareas;
+    };
+
+    bool tomarTarea(unsigned propia, std::function<void()>& tarea);
+    void trabajar(unsigned indice);
+
+    std::vector<std::unique_ptr<Cola>> colas;
+    std::vector<std::thread> trabajadores;
+
+    std::mutex mutexEstado;
+    std::condition_variable hayTrabajo;
+    std::condition_variable terminado;
+    size_t enCola = 0;                  // Tareas encoladas que nadie tomó todavía
+    size_t pendientes = 0;              // Tareas encoladas que no han terminado
+    bool detener = false;
+    std::atomic<unsigned> siguienteCola{ 0 };
+};
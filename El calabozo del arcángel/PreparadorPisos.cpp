@@ -0,0 +1,138 @@
+#include "PreparadorPisos.h"
+
+#include <new>
+#include <utility>
+
+PreparadorPisos::PreparadorPisos() : hilo(&PreparadorPisos::trabajar, this) {}
+
+PreparadorPisos::~PreparadorPisos() {
+    {
+        std::lock_guard<std::mutex> candado(mutex);
+        detener = true;
+    }
+    hayTrabajo.notify_one();
+    hilo.join();
+}
+
+PreparadorPisos::Encargo PreparadorPisos::encargoPara(const Partida& partida, int pisoCalabozo) {
+    Encargo encargo;
+    encargo.semilla = partida.generador.obtenerSemilla();
+    encargo.flujo = partida.generador.obtenerFlujo();
+    encargo.pisoCalabozo = pisoCalabozo;
+    encargo.numEnemies = partida.numEnemies;
+    encargo.maxEnemigos = partida.equilibrio.maxEnemigos;
+    encargo.reglas = partida.equilibrio.celdas;
+    encargo.columnas = partida.piso.columnas;
+    encargo.filas = partida.piso.filas;
+    encargo.perezoso = partida.pisosPerezosos;
+    encargo.arena = partida.arena;
+    return encargo;
+}
+
+void PreparadorPisos::preparar(const Partida& partida) {
+    if (partida.pisoCalabozo >= partida.numPisos) {
+        return; // Después del último piso está el Arcángel, no otro piso
+    }
+    {
+        std::lock_guard<std::mutex> candado(mutex);
+        pedido = encargoPara(partida, partida.pisoCalabozo + 1);
+        hayPedido = true;
+    }
+    hayTrabajo.notify_one();
+}
+
+bool PreparadorPisos::tomar(Partida& partida) {
+    // numEnemies todavía es el de antes del piso nuevo, igual que al encargarlo
+    Encargo buscado = encargoPara(partida, partida.pisoCalabozo);
+
+    std::unique_lock<std::mutex> candado(mutex);
+    listo.wait(candado, [&] {
+        return !(hayPedido && pedido == buscado) && !(generando && enCurso == buscado);
+    });
+    if (!hayHecho || !(hecho == buscado)) {
+        ++numFallos;
+        return false;
+    }
+
+    basura.push_back(std::move(partida.piso));
+    partida.piso = std::move(pisoHecho);
+    partida.numEnemies = enemigosHecho;
+    pisoHecho = Piso();
+    hayHecho = false;
+    ++numAciertos;
+    candado.unlock();
+    hayTrabajo.notify_one();
+    return true;
+}
+
+uint64_t PreparadorPisos::aciertos() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numAciertos;
+}
+
+uint64_t PreparadorPisos::fallos() const {
+    std::lock_guard<std::mutex> candado(mutex);
+    return numFallos;
+}
+
+void PreparadorPisos::trabajar() {
+    std::unique_lock<std::mutex> candado(mutex);
+    while (true) {
+        hayTrabajo.wait(candado, [this] { return hayPedido || !basura.empty() || detener; });
+        if (detener) {
+            break;
+        }
+
+        if (!basura.empty()) {
+            std::vector<Piso> liberar;
+            liberar.swap(basura);
+            candado.unlock();
+            liberar.clear(); // La memoria de los pisos viejos se devuelve aquí
+            candado.lock();
+            continue;
+        }
+
+        enCurso = pedido;
+        hayPedido = false;
+        generando = true;
+        candado.unlock();
+
+        // Partida auxiliar con lo único que usa crearCalabozo
+        Partida auxiliar;
+        auxiliar.generador = GeneradorPartida(enCurso.semilla, enCurso.flujo);
+        auxiliar.pisoCalabozo = enCurso.pisoCalabozo;
+        auxiliar.numEnemies = enCurso.numEnemies;
+        auxiliar.equilibrio.maxEnemigos = enCurso.maxEnemigos;
+        auxiliar.equilibrio.celdas = enCurso.reglas;
+        auxiliar.piso.columnas = enCurso.columnas;
+        auxiliar.piso.filas = enCurso.filas;
+        auxiliar.pisosPerezosos = enCurso.perezoso;
+        auxiliar.arena = enCurso.arena;
+        bool creado = true;
+        try {
+            crearCalabozo(auxiliar);
+        }
+        catch (const std::bad_alloc&) {
+            creado = false; // La arena llegó a su límite; tomar() no encontrará el piso
+            liberarPiso(auxiliar.piso);
+        }
+
+        candado.lock();
+        generando = false;
+        if (hayPedido && pedido == enCurso) {
+            hayPedido = false; // Se volvió a pedir el mismo piso mientras se generaba
+        }
+        if (!creado) {
+            hayHecho = false;
+        }
+        else if (!hayPedido) {
+            hecho = enCurso;
+            hayHecho = true;
+            pisoHecho = std::move(auxiliar.piso);
+            enemigosHecho = auxiliar.numEnemies;
+        }
+        candado.unlock();
+        listo.notify_all();
+        candado.lock();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Genera el siguiente piso en un hilo aparte mientras se juega el actual.
+ *
+ * Un piso solo depende de la semilla, el número de piso, el tamaño y los
+ * enemigos generados antes que él, y numEnemies no cambia mientras se juega.
+ * Por eso el piso N+1 se puede construir en cuanto existe el piso N y es
+ * idéntico al que crearía crearCalabozo en la salida. El piso viejo también se
+ * libera en este hilo, fuera del turno.
+ *
+ * Los pisos se construyen con la ArenaPisos de la partida, así que los bloques
+ * del piso viejo vuelven a ella y sirven para el piso que se prepare después.
+ * Si la arena no tiene lugar para el piso siguiente, no se prepara nada y
+ * crearCalabozo lo vuelve a intentar (y falla) en el hilo de la partida.
+ */
+class PreparadorPisos {
+public:
+    PreparadorPisos();
+    ~PreparadorPisos();
+
+    PreparadorPisos(const PreparadorPisos&) = delete;
+    PreparadorPisos& operator=(const PreparadorPisos&) = delete;
+
+    /**
+     * Empieza a generar el piso siguiente al actual de la partida (si no es el último).
+     * Reemplaza cualquier encargo anterior.
+     */
+    void preparar(const Partida& partida);
+
+    /**
+     * Pone en partida.piso el piso ya generado para partida.pisoCalabozo y
+     * actualiza numEnemies. Si todavía se está generando, espera a que termine.
+     * El piso anterior se libera en segundo plano.
+     * return false si no hay un piso preparado para esa partida y piso.
+     */
+    bool tomar(Partida& partida);
+
+    uint64_t aciertos() const;  // Pisos entregados por tomar
+    uint64_t fallos() const;    // Llamadas a tomar sin piso preparado
+
+private:
+    /**
+     * Todo lo que determina el contenido de un piso.
+     */
+    struct Encargo {
+        uint64_t semilla = 0;
+        uint64_t flujo = 0;
+        int pisoCalabozo = 0;
+        int numEnemies = 0;     // Enemigos generados antes de este piso
+        int maxEnemigos = 0;
+        ReglasCeldas reglas;
+        int columnas = 0;
+        int filas = 0;
+        bool perezoso = false;
+        ArenaPisos* arena = nullptr;
+
+        bool operator==(const Encargo& otro) const {
+            return semilla == otro.semilla && flujo == otro.flujo && pisoCalabozo == otro.pisoCalabozo
+                && numEnemies == otro.numEnemies && maxEnemigos == otro.maxEnemigos && reglas == otro.reglas
+                && columnas == otro.columnas && filas == otro.filas
+                && perezoso == otro.perezoso && arena == otro.arena;
+        }
+    };
+
+    static Encargo encargoPara(const Partida& partida, int pisoCalabozo);
+    void trabajar();
+
+    mutable std::mutex mutex;
+    std::condition_variable hayTrabajo;
+    std::condition_variable listo;
+
+    Encargo pedido;                 // Próximo piso a generar
+    bool hayPedido = false;
+    Encargo enCurso;                // Piso que se está generando
+    bool generando = false;
+    Encargo hecho;                  // Piso terminado que espera a tomar()
+    bool hayHecho = false;
+    Piso pisoHecho;
+    int enemigosHecho = 0;          // numEnemies después de generar pisoHecho
+
+    std::vector<Piso> basura;       // Pisos viejos por liberar
+    bool detener = false;
+    uint64_t numAciertos = 0;
+    uint64_t numFallos = 0;
+    std::thread hilo;
+};
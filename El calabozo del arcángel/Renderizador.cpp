@@ -0,0 +1,283 @@
+#include "Renderizador.h"
+#include "Instrumentacion.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Filas de la terminal ocupadas por texto: título, letras de columnas,
+    // separador, ocho líneas del jugador y separador final.
+    const int lineasTitulo = 2;
+    const int lineasJugador = 10;
+    const int lineasMensajes = 8;   // Mínimo que se deja para los mensajes del juego
+    const int lineasFijas = lineasTitulo + lineasJugador;
+    const char* separador = "---------------------------------------------------------------------------------------------------";
+
+    char simboloDe(const Celda& celda, bool conJugador) {
+        if (conJugador) {
+            return 'x';
+        }
+        if (celda.tiene(CeldaVisitada)) {
+            return '.';
+        }
+        if (celda.tiene(CeldaEnemigo)) {
+            return 'E';
+        }
+        if (celda.tiene(CeldaGuardado)) {
+            return 'S';
+        }
+        if (celda.tiene(CeldaTaberna)) {
+            return 'T';
+        }
+        if (celda.tiene(CeldaCofre)) {
+            return 'C';
+        }
+        return ' ';
+    }
+
+    int digitos(int n) {
+        int d = 1;
+        while (n >= 10) {
+            n /= 10;
+            ++d;
+        }
+        return d;
+    }
+
+    /**
+     * Mueve el origen de la vista solo si el jugador quedó fuera, centrándolo.
+     */
+    int seguir(int origen, int visible, int total, int jugador) {
+        if (jugador < origen || jugador >= origen + visible) {
+            origen = jugador - visible / 2;
+        }
+        return std::max(0, std::min(origen, total - visible));
+    }
+}
+
+RenderizadorTablero::RenderizadorTablero(int columnasVista, int filasVista)
+    : columnasPedidas(columnasVista), filasPedidas(filasVista) {
+#ifdef _WIN32
+    HANDLE consola = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD modo = 0;
+    if (GetConsoleMode(consola, &modo)) {
+        SetConsoleMode(consola, modo | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(consola, &info)) {
+        anchoTerminal = info.srWindow.Right - info.srWindow.Left + 1;
+        altoTerminal = info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
+#else
+    winsize tam;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &tam) == 0 && tam.ws_col > 0 && tam.ws_row > 0) {
+        anchoTerminal = tam.ws_col;
+        altoTerminal = tam.ws_row;
+    }
+#endif
+    lineas.resize(lineasFijas);
+    lineasAnteriores.resize(lineasFijas);
+    salida.reserve(64 * 1024);
+}
+
+RenderizadorTablero::~RenderizadorTablero() {
+    if (!iniciado) {
+        return;
+    }
+    salida.clear();
+    salida += "\033[r"; // Toda la terminal vuelve a desplazarse
+    agregarMovimiento(altoTerminal, 1);
+    salida += "\n";
+    escribir();
+}
+
+void RenderizadorTablero::calcularVista(const Piso& piso) {
+    int nuevaEtiqueta = digitos(piso.filas);
+    if (nuevaEtiqueta != anchoEtiqueta) {
+        anchoEtiqueta = nuevaEtiqueta;
+        completo = true; // Las celdas se corren de columna
+    }
+    int maxColumnas = std::max(1, (anchoTerminal - anchoEtiqueta) / 4);
+    int maxFilas = std::max(1, altoTerminal - lineasFijas - lineasMensajes);
+    if (columnasPedidas > 0) {
+        maxColumnas = std::min(maxColumnas, columnasPedidas);
+    }
+    if (filasPedidas > 0) {
+        maxFilas = std::min(maxFilas, filasPedidas);
+    }
+
+    int nuevoAncho = std::min(piso.columnas, maxColumnas);
+    int nuevoAlto = std::min(piso.filas, maxFilas);
+    if (nuevoAncho != ancho || nuevoAlto != alto) {
+        ancho = nuevoAncho;
+        alto = nuevoAlto;
+        simbolos.assign(static_cast<size_t>(ancho) * alto, ' ');
+        anteriores.assign(simbolos.size(), ' ');
+        completo = true; // Cambió la disposición de la pantalla
+    }
+}
+
+void RenderizadorTablero::armarLineas(const Partida& partida) {
+    const Piso& piso = partida.piso;
+    const Jugador& jugador = partida.jugador;
+
+    lineas[0] = "Calabozo - Estado del Piso " + std::to_string(partida.pisoCalabozo) + ":";
+    if (ancho < piso.columnas || alto < piso.filas) {
+        lineas[0] += " (vista " + etiquetaColumna(origenColumna) + std::to_string(origenFila + 1) + "-"
+            + etiquetaColumna(origenColumna + ancho - 1) + std::to_string(origenFila + alto)
+            + " de " + std::to_string(piso.columnas) + "x" + std::to_string(piso.filas) + ")";
+    }
+    lineas[1].assign(static_cast<size_t>(anchoEtiqueta), ' ');
+    for (int columna = 0; columna < ancho; ++columna) {
+        // Cada celda ocupa 4 caracteres; las etiquetas de varias letras se alinean a la derecha
+        std::string etiqueta = etiquetaColumna(origenColumna + columna);
+        lineas[1].append(etiqueta.size() < 4 ? 4 - etiqueta.size() : 1, ' ');
+        lineas[1] += etiqueta;
+    }
+
+    int i = lineasTitulo;
+    lineas[i++] = separador;
+    lineas[i++] = "Estado del jugador:";
+    lineas[i++] = " - Salud: " + std::to_string(jugador.health);
+    lineas[i++] = " - Poder de ataque: " + std::to_string(jugador.attackPower);
+    lineas[i++] = " - Equipo:";
+    for (size_t r = 0; r < 3; ++r) {
+        lineas[i].clear();
+        if (r < jugador.equipo.size()) {
+            const Recluta& recluta = jugador.equipo[r];
+            lineas[i] = "   * Nombre: " + recluta.nombre + ", Salud: " + std::to_string(recluta.health)
+                + ", Poder de ataque: " + std::to_string(recluta.attackPower);
+        }
+        ++i;
+    }
+    lineas[i++] = " - Tiradas de dados realizadas: " + std::to_string(partida.numDiceThrows);
+    lineas[i++] = separador;
+
+    for (std::string& linea : lineas) {
+        if (linea.size() > static_cast<size_t>(anchoTerminal)) {
+            linea.resize(static_cast<size_t>(anchoTerminal)); // Una línea que salta de renglón corre toda la pantalla
+        }
+    }
+}
+
+void RenderizadorTablero::agregarMovimiento(int fila, int columna) {
+    salida += "\033[";
+    salida += std::to_string(fila);
+    salida += ';';
+    salida += std::to_string(columna);
+    salida += 'H';
+}
+
+void RenderizadorTablero::escribir() {
+    std::cout.flush(); // Lo que el juego ya escribió va antes que el cuadro
+#ifdef _WIN32
+    DWORD escritos = 0;
+    WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), salida.data(), static_cast<DWORD>(salida.size()), &escritos, nullptr);
+#else
+    const char* datos = salida.data();
+    size_t pendientes = salida.size();
+    while (pendientes > 0) {
+        ssize_t escritos = write(STDOUT_FILENO, datos, pendientes);
+        if (escritos <= 0) {
+            break;
+        }
+        datos += escritos;
+        pendientes -= static_cast<size_t>(escritos);
+    }
+#endif
+    numBytes += salida.size();
+    CONTAR_ACTIVO(Contador::BytesEscritos, salida.size());
+    CONTAR_ACTIVO(Contador::Vaciados, 1);
+}
+
+void RenderizadorTablero::dibujar(const Partida& partida) {
+    const Piso& piso = partida.piso;
+    calcularVista(piso);
+
+    int columnaJugador = partida.jugador.posicion ? piso.columnaDe(partida.jugador.posicion) : -1;
+    int filaJugador = partida.jugador.posicion ? piso.filaDe(partida.jugador.posicion) : -1;
+    int nuevaColumna = seguir(origenColumna, ancho, piso.columnas, std::max(columnaJugador, 0));
+    int nuevaFila = seguir(origenFila, alto, piso.filas, std::max(filaJugador, 0));
+    bool desplazada = nuevaColumna != origenColumna || nuevaFila != origenFila;
+    origenColumna = nuevaColumna;
+    origenFila = nuevaFila;
+
+    for (int fila = 0; fila < alto; ++fila) {
+        for (int columna = 0; columna < ancho; ++columna) {
+            int c = origenColumna + columna;
+            int f = origenFila + fila;
+            simbolos[static_cast<size_t>(fila) * ancho + columna] = simboloDe(piso.consultar(c, f), c == columnaJugador && f == filaJugador);
+        }
+    }
+    armarLineas(partida);
+    CONTAR(partida, Contador::CeldasRecorridas, static_cast<uint64_t>(ancho) * alto);
+
+    // Fila de la terminal (desde 1) de cada parte del cuadro
+    int filaTablero = lineasTitulo + 1;
+    int filaJugadorTexto = filaTablero + alto;
+    auto filaDeLinea = [&](int i) { return i < lineasTitulo ? i + 1 : filaJugadorTexto + (i - lineasTitulo); };
+    int primeraFilaMensajes = filaJugadorTexto + lineasJugador;
+
+    salida.clear();
+    if (completo) {
+        salida += "\033[2J";
+        salida += "\033[" + std::to_string(primeraFilaMensajes) + ";" + std::to_string(altoTerminal) + "r";
+    }
+    else {
+        salida += "\0337"; // Guardar el cursor de la región de mensajes
+    }
+
+    for (int i = 0; i < lineasFijas; ++i) {
+        if (completo || lineas[i] != lineasAnteriores[i]) {
+            agregarMovimiento(filaDeLinea(i), 1);
+            salida += lineas[i];
+            salida += "\033[K";
+            lineasAnteriores[i] = lineas[i];
+        }
+    }
+
+    for (int fila = 0; fila < alto; ++fila) {
+        const char* nueva = &simbolos[static_cast<size_t>(fila) * ancho];
+        char* vieja = &anteriores[static_cast<size_t>(fila) * ancho];
+        if (completo || desplazada) {
+            // Fila entera: cambian la etiqueta y casi todas las celdas
+            agregarMovimiento(filaTablero + fila, 1);
+            std::string etiqueta = std::to_string(origenFila + fila + 1);
+            salida.append(static_cast<size_t>(anchoEtiqueta) - etiqueta.size(), ' ');
+            salida += etiqueta;
+            for (int columna = 0; columna < ancho; ++columna) {
+                salida += " [";
+                salida += nueva[columna];
+                salida += ']';
+            }
+            salida += "\033[K";
+            std::copy(nueva, nueva + ancho, vieja);
+            continue;
+        }
+        for (int columna = 0; columna < ancho; ++columna) {
+            if (nueva[columna] != vieja[columna]) {
+                agregarMovimiento(filaTablero + fila, anchoEtiqueta + 4 * columna + 3);
+                salida += nueva[columna];
+                vieja[columna] = nueva[columna];
+            }
+        }
+    }
+
+    if (completo) {
+        agregarMovimiento(primeraFilaMensajes, 1);
+    }
+    else {
+        salida += "\0338";
+    }
+    escribir();
+    completo = false;
+    iniciado = true;
+    ++numCuadros;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Calabozo.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Dibuja el tablero y el estado del jugador en una zona fija en la parte de
+ * arriba de la terminal, con secuencias ANSI.
+ *
+ * Cada cuadro se arma en un buffer reservado una sola vez y se compara con el
+ * anterior: solo se envían los movimientos del cursor y los símbolos de las
+ * celdas y líneas que cambiaron, con una única escritura por cuadro. Debajo
+ * del tablero queda una región con desplazamiento propio donde los mensajes
+ * del juego siguen saliendo por std::cout como siempre.
+ *
+ * Si el piso no cabe en la terminal se muestra solo una vista que sigue al
+ * jugador, así que el costo de un cuadro depende del tamaño de la vista y no
+ * del piso.
+ */
+class RenderizadorTablero {
+public:
+    /**
+     * param columnasVista Máximo de columnas visibles; 0 = las que quepan en la terminal.
+     * param filasVista Máximo de filas visibles; 0 = las que quepan en la terminal.
+     */
+    explicit RenderizadorTablero(int columnasVista = 0, int filasVista = 0);
+    ~RenderizadorTablero(); // Quita la región de desplazamiento y deja el cursor al final
+
+    RenderizadorTablero(const RenderizadorTablero&) = delete;
+    RenderizadorTablero& operator=(const RenderizadorTablero&) = delete;
+
+    void dibujar(const Partida& partida);
+
+    uint64_t cuadros() const { return numCuadros; }
+    uint64_t bytesEscritos() const { return numBytes; }
+
+private:
+    void calcularVista(const Piso& piso);
+    void armarLineas(const Partida& partida);
+    void agregarMovimiento(int fila, int columna);
+    void escribir();
+
+    int columnasPedidas;
+    int filasPedidas;
+    int anchoTerminal = 80;
+    int altoTerminal = 24;
+
+    // Vista actual: celdas [origenColumna, origenColumna + ancho) x [origenFila, origenFila + alto)
+    int ancho = 0;
+    int alto = 0;
+    int origenColumna = 0;
+    int origenFila = 0;
+    int anchoEtiqueta = 1;          // Dígitos del número de fila más grande
+
+    std::vector<char> simbolos;     // Símbolo de cada celda visible en el cuadro nuevo
+    std::vector<char> anteriores;   // Y en el cuadro ya dibujado
+    std::vector<std::string> lineas;            // Líneas de texto del cuadro nuevo
+    std::vector<std::string> lineasAnteriores;  // Y del cuadro ya dibujado
+    std::string salida;             // Bytes del cuadro, se reserva una vez
+    bool completo = true;           // El próximo cuadro se dibuja entero
+    bool iniciado = false;          // Ya se tocó la terminal
+
+    uint64_t numCuadros = 0;
+    uint64_t numBytes = 0;
+};
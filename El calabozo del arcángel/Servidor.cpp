@@ -0,0 +1,502 @@
+#include "Servidor.h"
+#include "PisosCompartidos.h"
+#include "Simulacion.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char* nombreResultado(const Partida& partida) {
+        if (partida.resultado == Resultado::EnCurso) {
+            return "jugando";
+        }
+        return partida.resultado == Resultado::Victoria ? "victoria" : "derrota";
+    }
+
+    /**
+     * Medidor que suman las sesiones, o nullptr si el servidor no mide.
+     */
+    MedidorCompartido* metricasPedidas(const OpcionesServidor& opciones, MedidorCompartido& metricas) {
+        return opciones.rutaMetricas.empty() ? nullptr : &metricas;
+    }
+
+    /**
+     * Catálogo de pisos compartidos, o nullptr si el servidor no comparte pisos.
+     */
+    CatalogoPisos* compartidosPedidos(const OpcionesServidor& opciones, CatalogoPisos& catalogo) {
+        return opciones.rutaCompartidos.empty() ? nullptr : &catalogo;
+    }
+
+    void escribirMetricasServidor(const OpcionesServidor& opciones, const MedidorCompartido& metricas) {
+        if (!opciones.rutaMetricas.empty() && !escribirMetricas(metricas.copia(), opciones.rutaMetricas)) {
+            std::cerr << "Error: No se pudo escribir '" << opciones.rutaMetricas << "'." << std::endl;
+        }
+    }
+
+    std::string describirEstado(const Partida& partida) {
+        const Piso& piso = partida.piso;
+        std::ostringstream respuesta;
+        respuesta << "ESTADO " << partida.pisoCalabozo << " " << piso.columnaDe(partida.jugador.posicion) << " "
+            << piso.filaDe(partida.jugador.posicion) << " " << partida.jugador.health << " " << nombreResultado(partida);
+        return respuesta.str();
+    }
+
+    std::string describirMemoria(const ArenaPisos& arena) {
+        std::ostringstream respuesta;
+        respuesta << "MEMORIA " << arena.enUso() << " " << arena.guardados() << " " << arena.pico() << " " << arena.limite();
+        return respuesta.str();
+    }
+
+    std::string ejecutarEnSesion(SesionJuego& sesion, const std::string& comando, bool pisosPerezosos, const Tablero& tablero,
+        CatalogoPisos* compartidos) {
+        std::istringstream lector(comando);
+        std::string nombre;
+        lector >> nombre;
+        Partida& partida = sesion.partida;
+
+        if (nombre == "NUEVA") {
+            uint64_t semilla = 0;
+            lector >> semilla;
+            partida = Partida();
+            configurarPartidaSinTerminal(partida, semilla, 0, PoliticaMovimiento());
+            partida.pisosPerezosos = pisosPerezosos;
+            partida.medidor = sesion.medidor.get();
+            partida.arena = sesion.arena.get();
+            aplicarTablero(partida, tablero);
+            if (compartidos) {
+                partida.calabozoCompartido = compartidos->obtener(partida);
+            }
+            iniciarPartida(partida);
+            sesion.pasos = 0;
+            sesion.iniciada = true;
+            return "OK " + std::to_string(partida.piso.columnas) + " " + std::to_string(partida.piso.filas);
+        }
+        if (nombre == "MEMORIA") {
+            if (!sesion.arena) {
+                return "ERROR la sesion no tiene arena";
+            }
+            return describirMemoria(*sesion.arena);
+        }
+        if (!sesion.iniciada) {
+            return "ERROR sin partida";
+        }
+        if (nombre == "ESTADO") {
+            return describirEstado(partida);
+        }
+        if (nombre == "METRICAS") {
+            if (!sesion.medidor) {
+                return "ERROR el servidor no mide las sesiones";
+            }
+            std::ostringstream respuesta;
+            respuesta << "METRICAS ";
+            sesion.medidor->escribirJson(respuesta);
+            return respuesta.str();
+        }
+        if (!partida.juego) {
+            return "ERROR partida terminada";
+        }
+        if (nombre == "TIRAR") {
+            if (sesion.pasos > 0) {
+                return "ERROR ya se tiraron los dados";
+            }
+            sesion.pasos = lanzarDados(partida);
+            return "PASOS " + std::to_string(sesion.pasos);
+        }
+        if (nombre == "MOVER") {
+            char direccion = 0;
+            lector >> direccion;
+            if (sesion.pasos == 0) {
+                return "ERROR faltan los dados";
+            }
+            if (direccion != 'W' && direccion != 'A' && direccion != 'S' && direccion != 'D') {
+                return "ERROR direccion no valida";
+            }
+            avanzarJugador(partida, sesion.pasos, direccion);
+            sesion.pasos = 0;
+            return describirEstado(partida);
+        }
+        return "ERROR comando desconocido";
+    }
+}
+
+std::string ejecutarComando(SesionJuego& sesion, const std::string& comando, bool pisosPerezosos, const Tablero& tablero,
+    CatalogoPisos* compartidos) {
+    try {
+        return ejecutarEnSesion(sesion, comando, pisosPerezosos, tablero, compartidos);
+    }
+    catch (const std::bad_alloc&) {
+        // El piso quedó a medio crear: la partida no se puede seguir jugando
+        liberarPiso(sesion.partida.piso);
+        sesion.partida.jugador.posicion = nullptr;
+        sesion.partida.juego = false;
+        sesion.iniciada = false;
+        sesion.pasos = 0;
+        return "ERROR memoria";
+    }
+}
+
+Conexion::Conexion(PoolHilos& pool, bool pisosPerezosos, std::function<void()> hayRespuestas, MedidorCompartido* metricas,
+    size_t memoriaSesion, const Tablero& tablero, CatalogoPisos* compartidos)
+    : pool(pool), pisosPerezosos(pisosPerezosos), hayRespuestas(std::move(hayRespuestas)), metricas(metricas),
+    memoriaSesion(memoriaSesion), tablero(tablero), compartidos(compartidos) {}
+
+void Conexion::recibir(const char* datos, size_t bytes) {
+    size_t inicio = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        if (datos[i] != '\n') {
+            continue;
+        }
+        entrada.append(datos + inicio, i - inicio);
+        if (!entrada.empty() && entrada.back() == '\r') {
+            entrada.pop_back();
+        }
+        if (!entrada.empty()) {
+            despachar(entrada);
+        }
+        entrada.clear();
+        inicio = i + 1;
+    }
+    entrada.append(datos + inicio, bytes - inicio);
+}
+
+std::string Conexion::tomarRespuestas() {
+    std::lock_guard<std::mutex> candado(mutexSalida);
+    std::string listas;
+    listas.swap(salida);
+    return listas;
+}
+
+void Conexion::despachar(const std::string& linea) {
+    size_t espacio = linea.find(' ');
+    uint64_t id = 0;
+    try {
+        id = std::stoull(linea.substr(0, espacio));
+    }
+    catch (const std::exception&) {
+        responder(0, "ERROR falta el id");
+        return;
+    }
+    std::string comando = (espacio == std::string::npos) ? std::string() : linea.substr(espacio + 1);
+
+    std::shared_ptr<Sesion> sesion;
+    bool programar = false;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> candado(mutexSesiones);
+            std::shared_ptr<Sesion>& encontrada = sesiones[id];
+            if (!encontrada) {
+                encontrada = std::make_shared<Sesion>();
+                encontrada->id = id;
+                encontrada->juego.arena.reset(new ArenaPisos(memoriaSesion));
+                if (metricas) {
+                    encontrada->juego.medidor.reset(new Medidor());
+                }
+            }
+            sesion = encontrada;
+        }
+
+        std::lock_guard<std::mutex> candado(sesion->mutex);
+        if (sesion->cerrada) {
+            continue; // Se cerró después de buscarla y ya salió del mapa: el comando es de una sesión nueva
+        }
+        sesion->comandos.push_back(std::move(comando));
+        if (!sesion->programada) {
+            sesion->programada = true;
+            programar = true;
+        }
+        break;
+    }
+    if (programar) {
+        std::shared_ptr<Conexion> propia = shared_from_this(); // La conexión vive mientras haya tareas
+        pool.encolar([propia, sesion] { propia->procesar(sesion); });
+    }
+}
+
+void Conexion::procesar(const std::shared_ptr<Sesion>& sesion) {
+    while (true) {
+        std::string comando;
+        {
+            std::lock_guard<std::mutex> candado(sesion->mutex);
+            if (sesion->comandos.empty()) {
+                sesion->programada = false;
+                return;
+            }
+            comando = std::move(sesion->comandos.front());
+            sesion->comandos.pop_front();
+        }
+
+        if (comando == "CERRAR" || comando == "APAGAR") {
+            if (metricas && sesion->juego.medidor) {
+                metricas->sumar(*sesion->juego.medidor);
+            }
+            if (comando == "APAGAR") {
+                apagar = true;
+            }
+            responder(sesion->id, "ADIOS");
+            // Lo que quedaba en cola no corre sobre la partida descartada, y una
+            // sesión nueva con el mismo id no corre a la vez que esta
+            std::lock_guard<std::mutex> candado(sesion->mutex);
+            sesion->cerrada = true;
+            sesion->comandos.clear();
+            sesion->programada = false;
+            std::lock_guard<std::mutex> candadoSesiones(mutexSesiones);
+            sesiones.erase(sesion->id);
+            return;
+        }
+        responder(sesion->id, ejecutarComando(sesion->juego, comando, pisosPerezosos, tablero, compartidos));
+    }
+}
+
+void Conexion::responder(uint64_t id, const std::string& respuesta) {
+    bool estabaVacia;
+    {
+        std::lock_guard<std::mutex> candado(mutexSalida);
+        estabaVacia = salida.empty();
+        salida += std::to_string(id);
+        salida += ' ';
+        salida += respuesta;
+        salida += '\n';
+    }
+    if (estabaVacia) {
+        hayRespuestas(); // Solo hace falta avisar una vez hasta que alguien tome las respuestas
+    }
+}
+
+namespace {
+    /**
+     * Transporte por stdin/stdout: el hilo principal lee líneas y cada aviso de
+     * respuestas las escribe en stdout.
+     */
+    bool servirEntradaEstandar(const OpcionesServidor& opciones) {
+        MedidorCompartido metricas;
+        CatalogoPisos catalogo(opciones.rutaCompartidos);
+        PoolHilos pool(opciones.hilos);
+        std::mutex mutexSalida;
+        std::weak_ptr<Conexion> debil;
+        auto conexion = std::make_shared<Conexion>(pool, opciones.pisosPerezosos, [&] {
+            std::shared_ptr<Conexion> propia = debil.lock();
+            if (!propia) {
+                return;
+            }
+            std::lock_guard<std::mutex> candado(mutexSalida);
+            std::string listas = propia->tomarRespuestas();
+            std::fwrite(listas.data(), 1, listas.size(), stdout);
+            std::fflush(stdout);
+        }, metricasPedidas(opciones, metricas), opciones.memoriaSesion, opciones.tablero, compartidosPedidos(opciones, catalogo));
+        debil = conexion;
+
+        std::string linea;
+        while (!conexion->pidioApagar() && std::getline(std::cin, linea)) {
+            linea += '\n';
+            conexion->recibir(linea.data(), linea.size());
+        }
+        pool.esperar(); // Responder todo lo recibido antes de salir
+        escribirMetricasServidor(opciones, metricas);
+        return true;
+    }
+}
+
+#ifdef _WIN32
+
+bool ejecutarServidor(const OpcionesServidor& opciones) {
+    if (opciones.ruta == "-") {
+        return servirEntradaEstandar(opciones);
+    }
+    std::cerr << "Los sockets Unix no estan disponibles en Windows; use --servidor -" << std::endl;
+    return false;
+}
+
+#else
+
+namespace {
+    /**
+     * Socket de un cliente y lo que falta enviarle.
+     */
+    struct Cliente {
+        int descriptor = -1;
+        std::shared_ptr<Conexion> conexion;
+        std::string pendiente;      // Respuestas que el socket todavía no aceptó
+    };
+
+    void noBloqueante(int descriptor) {
+        fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    /**
+     * Envía lo que el socket acepte sin bloquear.
+     * return false si el cliente se desconectó.
+     */
+    bool enviarPendiente(Cliente& cliente) {
+        while (!cliente.pendiente.empty()) {
+            ssize_t enviados = send(cliente.descriptor, cliente.pendiente.data(), cliente.pendiente.size(), MSG_NOSIGNAL);
+            if (enviados < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            cliente.pendiente.erase(0, static_cast<size_t>(enviados));
+        }
+        return true;
+    }
+}
+
+bool ejecutarServidor(const OpcionesServidor& opciones) {
+    if (opciones.ruta == "-") {
+        return servirEntradaEstandar(opciones);
+    }
+
+    int escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un direccion = {};
+    direccion.sun_family = AF_UNIX;
+    if (escucha < 0 || opciones.ruta.size() >= sizeof(direccion.sun_path)) {
+        std::cerr << "Error: No se pudo crear el socket '" << opciones.ruta << "'." << std::endl;
+        return false;
+    }
+    opciones.ruta.copy(direccion.sun_path, opciones.ruta.size());
+    unlink(opciones.ruta.c_str()); // Un socket viejo de una ejecución anterior
+    if (bind(escucha, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0 || listen(escucha, 128) != 0) {
+        std::cerr << "Error: No se pudo escuchar en '" << opciones.ruta << "'." << std::endl;
+        close(escucha);
+        return false;
+    }
+    noBloqueante(escucha);
+
+    // Las tareas del pool avisan por este tubo qué clientes tienen respuestas
+    int tubo[2];
+    if (pipe(tubo) != 0) {
+        close(escucha);
+        return false;
+    }
+    noBloqueante(tubo[0]);
+    noBloqueante(tubo[1]);
+    std::mutex mutexListos;
+    std::vector<uint64_t> listos;
+
+    MedidorCompartido metricas;
+    CatalogoPisos catalogo(opciones.rutaCompartidos);
+    PoolHilos pool(opciones.hilos);
+    std::unordered_map<uint64_t, Cliente> clientes;
+    uint64_t siguienteCliente = 1;
+    bool apagar = false;
+    std::vector<pollfd> vigilados;
+    std::vector<uint64_t> idsVigilados;
+    std::vector<char> buffer(64 * 1024);
+
+    std::cerr << "Servidor escuchando en '" << opciones.ruta << "' con " << pool.hilos() << " hilos." << std::endl;
+
+    while (!apagar) {
+        vigilados.assign({ pollfd{ tubo[0], POLLIN, 0 }, pollfd{ escucha, POLLIN, 0 } });
+        idsVigilados.assign(2, 0);
+        for (auto& par : clientes) {
+            short eventos = POLLIN;
+            if (!par.second.pendiente.empty()) {
+                eventos |= POLLOUT;
+            }
+            vigilados.push_back(pollfd{ par.second.descriptor, eventos, 0 });
+            idsVigilados.push_back(par.first);
+        }
+        if (poll(vigilados.data(), static_cast<nfds_t>(vigilados.size()), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (vigilados[0].revents & POLLIN) {
+            while (read(tubo[0], buffer.data(), buffer.size()) > 0) {
+            }
+            std::vector<uint64_t> tomados;
+            {
+                std::lock_guard<std::mutex> candado(mutexListos);
+                tomados.swap(listos);
+            }
+            for (uint64_t id : tomados) {
+                auto encontrado = clientes.find(id);
+                if (encontrado == clientes.end()) {
+                    continue; // Se desconectó antes de recibir sus respuestas
+                }
+                Cliente& cliente = encontrado->second;
+                cliente.pendiente += cliente.conexion->tomarRespuestas();
+                apagar = apagar || cliente.conexion->pidioApagar();
+                if (!enviarPendiente(cliente)) {
+                    close(cliente.descriptor);
+                    clientes.erase(encontrado);
+                }
+            }
+        }
+
+        if (vigilados[1].revents & POLLIN) {
+            int nuevo;
+            while ((nuevo = accept(escucha, nullptr, nullptr)) >= 0) {
+                noBloqueante(nuevo);
+                uint64_t id = siguienteCliente++;
+                Cliente& cliente = clientes[id];
+                cliente.descriptor = nuevo;
+                int aviso = tubo[1];
+                cliente.conexion = std::make_shared<Conexion>(pool, opciones.pisosPerezosos, [&mutexListos, &listos, id, aviso] {
+                    {
+                        std::lock_guard<std::mutex> candado(mutexListos);
+                        listos.push_back(id);
+                    }
+                    char byte = 1;
+                    ssize_t escrito = write(aviso, &byte, 1); // Si el tubo está lleno el bucle ya tiene un aviso
+                    (void)escrito;
+                }, metricasPedidas(opciones, metricas), opciones.memoriaSesion, opciones.tablero, compartidosPedidos(opciones, catalogo));
+            }
+        }
+
+        for (size_t i = 2; i < vigilados.size(); ++i) {
+            auto encontrado = clientes.find(idsVigilados[i]);
+            if (encontrado == clientes.end() || vigilados[i].revents == 0) {
+                continue;
+            }
+            Cliente& cliente = encontrado->second;
+            bool sigue = true;
+            if (vigilados[i].revents & POLLIN) {
+                ssize_t leidos = read(cliente.descriptor, buffer.data(), buffer.size());
+                if (leidos > 0) {
+                    cliente.conexion->recibir(buffer.data(), static_cast<size_t>(leidos));
+                }
+                else if (leidos == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    sigue = false;
+                }
+            }
+            else if (vigilados[i].revents & (POLLERR | POLLHUP)) {
+                sigue = false;
+            }
+            if (sigue && (vigilados[i].revents & POLLOUT)) {
+                sigue = enviarPendiente(cliente);
+            }
+            if (!sigue) {
+                close(cliente.descriptor);
+                clientes.erase(encontrado); // Las tareas en curso terminan sobre su propia copia de la conexión
+            }
+        }
+    }
+
+    pool.esperar();
+    for (auto& par : clientes) {
+        par.second.pendiente += par.second.conexion->tomarRespuestas();
+        fcntl(par.second.descriptor, F_SETFL, fcntl(par.second.descriptor, F_GETFL, 0) & ~O_NONBLOCK);
+        enviarPendiente(par.second); // Lo último se envía bloqueando
+        close(par.second.descriptor);
+    }
+    close(tubo[0]);
+    close(tubo[1]);
+    close(escucha);
+    unlink(opciones.ruta.c_str());
+    escribirMetricasServidor(opciones, metricas);
+    return true;
+}
+
+#endif
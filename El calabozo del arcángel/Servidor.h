@@ -0,0 +1,133 @@
+#pragma once
+
+#include "ArenaPisos.h"
+#include "Calabozo.h"
+#include "Instrumentacion.h"
+#include "PoolHilos.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class CatalogoPisos;
+
+/**
+ * Protocolo del servidor, una línea por mensaje:
+ *
+ *     <id> NUEVA [semilla]   ->  <id> OK <columnas> <filas>
+ *     <id> TIRAR             ->  <id> PASOS <n>
+ *     <id> MOVER <W|A|S|D>   ->  <id> ESTADO <piso> <columna> <fila> <salud> <jugando|victoria|derrota>
+ *     <id> ESTADO            ->  <id> ESTADO ...
+ *     <id> METRICAS          ->  <id> METRICAS <json>   (tiempos y contadores de la sesión)
+ *     <id> MEMORIA           ->  <id> MEMORIA <en uso> <guardados> <pico> <límite>   (bytes de los pisos)
+ *     <id> CERRAR            ->  <id> ADIOS
+ *     <id> APAGAR            ->  <id> ADIOS, y el servidor termina
+ *
+ * <id> lo elige el cliente y separa las sesiones de una misma conexión. Los
+ * errores se responden como "<id> ERROR <motivo>". Los comandos que quedaban
+ * en cola detrás de CERRAR se descartan; los que llegan después con el mismo
+ * <id> son de una sesión nueva.
+ */
+
+/**
+ * Partida manejada por comandos: TIRAR y MOVER son las dos mitades de
+ * moverJugador (lanzarDados y avanzarJugador), así que un turno nunca bloquea
+ * esperando la dirección.
+ */
+struct SesionJuego {
+    std::unique_ptr<ArenaPisos> arena; // Memoria de los pisos; se declara antes que la partida para vivir más que ella
+    Partida partida;
+    int pasos = 0;              // Pasos de la última tirada, 0 si no hay tirada pendiente
+    bool iniciada = false;
+    std::unique_ptr<Medidor> medidor; // Solo si el servidor mide (OpcionesServidor::rutaMetricas)
+};
+
+/**
+ * Ejecuta un comando (sin el id) sobre una sesión y devuelve la respuesta (sin el id).
+ * Si los pisos superan el límite de la arena de la sesión, la partida se
+ * descarta y se responde "ERROR memoria".
+ * param pisosPerezosos Modo de generación de las partidas nuevas.
+ * param tablero Tamaño del calabozo de las partidas nuevas.
+ * param compartidos Si existe, las partidas nuevas toman sus pisos de él (PisosCompartidos.h).
+ */
+std::string ejecutarComando(SesionJuego& sesion, const std::string& comando, bool pisosPerezosos,
+    const Tablero& tablero = Tablero(), CatalogoPisos* compartidos = nullptr);
+
+/**
+ * Sesiones de una conexión. Cada sesión procesa sus comandos en orden, de a uno,
+ * en una tarea del pool; sesiones distintas avanzan en paralelo. Las respuestas
+ * se juntan en un buffer y se avisa con hayRespuestas cuando deja de estar vacío.
+ * Con 'metricas', cada sesión mide su partida y al cerrarse suma su medidor ahí.
+ * Cada sesión tiene su propia ArenaPisos, con 'memoriaSesion' bytes como límite (0 = sin límite).
+ * Con 'compartidos', las sesiones juegan sobre pisos compartidos y solo guardan sus celdas modificadas.
+ */
+class Conexion : public std::enable_shared_from_this<Conexion> {
+public:
+    Conexion(PoolHilos& pool, bool pisosPerezosos, std::function<void()> hayRespuestas, MedidorCompartido* metricas = nullptr,
+        size_t memoriaSesion = 0, const Tablero& tablero = Tablero(), CatalogoPisos* compartidos = nullptr);
+
+    /**
+     * Agrega bytes recibidos; cada línea completa se despacha a su sesión.
+     */
+    void recibir(const char* datos, size_t bytes);
+
+    /**
+     * Saca todas las respuestas listas.
+     */
+    std::string tomarRespuestas();
+
+    bool pidioApagar() const { return apagar; }
+
+private:
+    struct Sesion {
+        uint64_t id = 0;
+        std::mutex mutex;
+        std::deque<std::string> comandos;   // Comandos aún sin procesar
+        bool programada = false;            // Hay una tarea en el pool procesándola
+        bool cerrada = false;               // Ya respondió ADIOS y salió del mapa: no acepta más comandos
+        SesionJuego juego;
+    };
+
+    void despachar(const std::string& linea);
+    void procesar(const std::shared_ptr<Sesion>& sesion);
+    void responder(uint64_t id, const std::string& respuesta);
+
+    PoolHilos& pool;
+    bool pisosPerezosos;
+    std::function<void()> hayRespuestas;
+    MedidorCompartido* metricas;
+    size_t memoriaSesion;
+    Tablero tablero;
+    CatalogoPisos* compartidos;
+    std::string entrada;                    // Línea incompleta
+
+    std::mutex mutexSesiones;
+    std::unordered_map<uint64_t, std::shared_ptr<Sesion>> sesiones;
+
+    std::mutex mutexSalida;
+    std::string salida;
+    std::atomic<bool> apagar{ false };
+};
+
+struct OpcionesServidor {
+    std::string ruta = "-";         // Socket Unix, o "-" para stdin/stdout
+    unsigned hilos = 0;             // Hilos del pool (0 = todos los núcleos)
+    bool pisosPerezosos = false;
+    std::string rutaMetricas;       // Si no está vacía, se miden las sesiones y al terminar se escribe la suma de las cerradas
+    size_t memoriaSesion = 0;       // Bytes máximos de los pisos de cada sesión (0 = sin límite)
+    Tablero tablero;                // Tamaño del calabozo de las partidas nuevas
+    std::string rutaCompartidos;    // Si no está vacía, directorio donde se publican los pisos compartidos (PisosCompartidos.h)
+};
+
+/**
+ * Atiende comandos hasta fin de entrada (stdin/stdout) o hasta APAGAR (socket).
+ * El socket usa un bucle de eventos con poll en un solo hilo; las partidas se
+ * juegan en el pool. Solo hay sockets Unix fuera de Windows.
+ * return false si no se pudo abrir el socket.
+ */
+bool ejecutarServidor(const OpcionesServidor& opciones);
@@ -0,0 +1,240 @@
+#include "Simulacion.h"
+#include "PoliticaOptima.h"
+#include "PoolHilos.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+    /**
+     * Elige cualquiera de las cuatro direcciones con la misma probabilidad.
+     */
+    char politicaAleatoria(Partida& partida, int /*pasos*/) {
+        static const char direcciones[] = { 'W', 'A', 'S', 'D' };
+        int64_t celda = partida.piso.indiceDe(partida.jugador.posicion);
+        return direcciones[partida.sortear(Proposito::Politica, celda, 0, 4)];
+    }
+
+    /**
+     * Avanza por el eje en el que falta más distancia hasta la salida.
+     */
+    char politicaSalida(Partida& partida, int /*pasos*/) {
+        const Piso& piso = partida.piso;
+        int faltanColumnas = piso.columnas - 1 - piso.columnaDe(partida.jugador.posicion);
+        int faltanFilas = piso.filas - 1 - piso.filaDe(partida.jugador.posicion);
+        return faltanColumnas >= faltanFilas ? 'D' : 'S';
+    }
+
+    void imprimirLinea(std::ostream& salida, const char* nombre, uint64_t cantidad, uint64_t total) {
+        double porcentaje = total ? 100.0 * static_cast<double>(cantidad) / static_cast<double>(total) : 0.0;
+        salida << "  " << std::left << std::setw(26) << nombre << std::right << std::setw(12) << cantidad
+            << "  (" << std::fixed << std::setprecision(2) << porcentaje << " %)" << std::endl;
+    }
+}
+
+void ResumenSimulacion::registrar(const Partida& partida) {
+    ++partidas;
+    switch (partida.resultado) {
+    case Resultado::Victoria:        ++victorias; break;
+    case Resultado::DerrotaArcangel: ++derrotasArcangel; break;
+    case Resultado::DerrotaCombate:  ++derrotasCombate; break;
+    case Resultado::DerrotaTiradas:  ++derrotasTiradas; break;
+    case Resultado::EnCurso:         break;
+    }
+    if (partida.pisoCalabozo >= 1) {
+        if (partida.pisoCalabozo >= static_cast<int>(pisoFinal.size())) {
+            pisoFinal.resize(static_cast<size_t>(partida.pisoCalabozo) + 1, 0);
+        }
+        ++pisoFinal[static_cast<size_t>(partida.pisoCalabozo)];
+    }
+}
+
+void ResumenSimulacion::sumar(const ResumenSimulacion& otro) {
+    partidas += otro.partidas;
+    victorias += otro.victorias;
+    derrotasArcangel += otro.derrotasArcangel;
+    derrotasCombate += otro.derrotasCombate;
+    derrotasTiradas += otro.derrotasTiradas;
+    bloquesPedidos += otro.bloquesPedidos;
+    bloquesReusados += otro.bloquesReusados;
+    if (otro.pisoFinal.size() > pisoFinal.size()) {
+        pisoFinal.resize(otro.pisoFinal.size(), 0);
+    }
+    for (size_t i = 0; i < otro.pisoFinal.size(); ++i) {
+        pisoFinal[i] += otro.pisoFinal[i];
+    }
+}
+
+PoliticaMovimiento politicaPorNombre(const std::string& nombre) {
+    if (nombre == "aleatoria") {
+        return politicaAleatoria;
+    }
+    if (nombre == "salida") {
+        return politicaSalida;
+    }
+    if (nombre == "optima") {
+        return politicaOptima();
+    }
+    return PoliticaMovimiento();
+}
+
+void configurarPartidaSinTerminal(Partida& partida, uint64_t semilla, uint64_t flujo, const PoliticaMovimiento& politica) {
+    partida.generador = GeneradorPartida(semilla, flujo);
+    partida.politica = politica;
+    partida.salida = nullptr;
+    partida.interactivo = false;
+    partida.guardadoHabilitado = false;
+}
+
+ResumenSimulacion simularPartidas(const OpcionesSimulacion& opciones) {
+    PoliticaMovimiento politica = politicaPorNombre(opciones.politica);
+    if (!politica) {
+        politica = politicaSalida;
+    }
+
+    uint64_t porTarea = std::max<uint64_t>(1, opciones.partidasPorTarea);
+    uint64_t tareas = (opciones.partidas + porTarea - 1) / porTarea;
+    std::vector<ResumenSimulacion> parciales(static_cast<size_t>(tareas)); // Uno por tarea, sin bloqueos
+    for (auto& parcial : parciales) {
+        parcial.pisoFinal.assign(static_cast<size_t>(opciones.tablero.pisos) + 1, 0);
+    }
+    std::vector<Medidor> medidores(opciones.medir ? static_cast<size_t>(tareas) : 0);
+    std::shared_ptr<Medidor> traza;
+    if (opciones.trazar && opciones.partidas > 0) {
+        traza = std::make_shared<Medidor>(true);
+    }
+
+    std::shared_ptr<EstadisticasSimulacion> estadisticas;
+    uint64_t instantaneas = 0;
+    auto escribirInstantanea = [&] {
+        if (!escribirEstadisticas(estadisticas->instantanea(), opciones.rutaEstadisticas)) {
+            std::cerr << "No se pudo escribir " << opciones.rutaEstadisticas << std::endl;
+        }
+        ++instantaneas;
+    };
+
+    auto inicio = std::chrono::steady_clock::now();
+    {
+        PoolHilos pool(opciones.hilos);
+        if (opciones.estadisticas) {
+            // Una franja por hilo del pool y una más por si alguna tarea corre fuera de él
+            estadisticas = std::make_shared<EstadisticasSimulacion>(pool.hilos() + 1, opciones.tablero.pisos,
+                opciones.equilibrio.limiteTiradas, opciones.mejores);
+        }
+
+        std::mutex mutexInstantaneas;
+        std::condition_variable terminar;
+        bool terminado = false;
+        std::thread escritor;
+        if (estadisticas && !opciones.rutaEstadisticas.empty() && opciones.segundosEntreInstantaneas > 0) {
+            escritor = std::thread([&] {
+                auto intervalo = std::chrono::duration<double>(opciones.segundosEntreInstantaneas);
+                std::unique_lock<std::mutex> candado(mutexInstantaneas);
+                while (!terminar.wait_for(candado, intervalo, [&] { return terminado; })) {
+                    escribirInstantanea();
+                }
+            });
+        }
+
+        for (uint64_t t = 0; t < tareas; ++t) {
+            pool.encolar([&, t] {
+                uint64_t primera = t * porTarea;
+                uint64_t ultima = std::min(opciones.partidas, primera + porTarea);
+                ResumenSimulacion& parcial = parciales[static_cast<size_t>(t)];
+                Medidor* medidor = opciones.medir ? &medidores[static_cast<size_t>(t)] : nullptr;
+                ArenaPisos arena; // Los pisos de cada partida reusan los bloques de la anterior
+                FranjaEstadisticas* franja = nullptr;
+                if (estadisticas) {
+                    int hilo = pool.indiceHiloActual();
+                    franja = &estadisticas->franja(hilo < 0 ? estadisticas->numFranjas() - 1 : static_cast<size_t>(hilo));
+                }
+                for (uint64_t n = primera; n < ultima; ++n) {
+                    Partida partida;
+                    configurarPartidaSinTerminal(partida, opciones.semilla, n, politica);
+                    partida.pisosPerezosos = opciones.pisosPerezosos;
+                    partida.arena = &arena;
+                    aplicarTablero(partida, opciones.tablero);
+                    aplicarEquilibrio(partida, opciones.equilibrio);
+                    partida.medidor = (n == 0 && traza) ? traza.get() : medidor;
+                    partida.estadisticas = franja;
+                    iniciarPartida(partida);
+                    jugarPartida(partida);
+                    parcial.registrar(partida);
+                    if (franja) {
+                        franja->anotarPartida(partida);
+                    }
+                    if (n == 0 && traza && medidor) {
+                        medidor->sumar(*traza);
+                    }
+                }
+                parcial.bloquesPedidos = arena.reservas();
+                parcial.bloquesReusados = arena.reusos();
+            });
+        }
+        pool.esperar();
+        if (escritor.joinable()) {
+            {
+                std::lock_guard<std::mutex> candado(mutexInstantaneas);
+                terminado = true;
+            }
+            terminar.notify_one();
+            escritor.join();
+        }
+    }
+    auto fin = std::chrono::steady_clock::now();
+    if (estadisticas && !opciones.rutaEstadisticas.empty()) {
+        escribirInstantanea(); // La última, con todas las partidas
+    }
+
+    ResumenSimulacion resumen;
+    resumen.pisoFinal.assign(static_cast<size_t>(opciones.tablero.pisos) + 1, 0);
+    for (const auto& parcial : parciales) {
+        resumen.sumar(parcial);
+    }
+    resumen.segundos = std::chrono::duration<double>(fin - inicio).count();
+    if (opciones.medir) {
+        resumen.medidor = std::make_shared<Medidor>();
+        for (const auto& medidor : medidores) {
+            resumen.medidor->sumar(medidor);
+        }
+    }
+    resumen.traza = traza;
+    resumen.estadisticas = estadisticas;
+    resumen.instantaneas = instantaneas;
+    return resumen;
+}
+
+void imprimirResumen(const ResumenSimulacion& resumen, std::ostream& salida) {
+    double porSegundo = resumen.segundos > 0 ? static_cast<double>(resumen.partidas) / resumen.segundos : 0.0;
+
+    salida << "Partidas simuladas: " << resumen.partidas << " en " << std::fixed << std::setprecision(3)
+        << resumen.segundos << " s (" << std::setprecision(0) << porSegundo << " partidas/s, "
+        << porSegundo * 60.0 << " partidas/min)" << std::endl;
+
+    salida << "Resultados:" << std::endl;
+    imprimirLinea(salida, "Victorias (Arcangel)", resumen.victorias, resumen.partidas);
+    imprimirLinea(salida, "Derrotas ante el Arcangel", resumen.derrotasArcangel, resumen.partidas);
+    imprimirLinea(salida, "Derrotas en combate", resumen.derrotasCombate, resumen.partidas);
+    imprimirLinea(salida, "Derrotas por tiradas", resumen.derrotasTiradas, resumen.partidas);
+
+    salida << "Piso en el que terminaron:" << std::endl;
+    for (size_t piso = 1; piso < resumen.pisoFinal.size(); ++piso) {
+        std::string nombre = "Piso " + std::to_string(piso);
+        imprimirLinea(salida, nombre.c_str(), resumen.pisoFinal[piso], resumen.partidas);
+    }
+
+    salida << "Bloques de memoria de los pisos: " << resumen.bloquesPedidos << " pedidos, "
+        << resumen.bloquesReusados << " reusados" << std::endl;
+
+    if (resumen.estadisticas) {
+        imprimirEstadisticas(resumen.estadisticas->instantanea(), salida);
+    }
+    if (resumen.instantaneas > 0) {
+        salida << "Instantaneas de las estadisticas escritas: " << resumen.instantaneas << std::endl;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Calabozo.h"
+#include "Estadisticas.h"
+#include "Instrumentacion.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Opciones de una simulación por lotes sin terminal.
+ */
+struct OpcionesSimulacion {
+    uint64_t partidas = 100000;         // Partidas a jugar
+    unsigned hilos = 0;                 // Hilos del pool (0 = todos los núcleos)
+    uint64_t semilla = 1;               // Semilla común; cada partida usa su número como flujo
+    std::string politica = "salida";    // Nombre de la política de movimiento
+    uint64_t partidasPorTarea = 1024;   // Partidas que juega cada tarea del pool
+    bool pisosPerezosos = false;        // Generar las celdas al usarlas (mismos resultados)
+    Tablero tablero;                    // Tamaño de los pisos y número de pisos
+    Equilibrio equilibrio;              // Parámetros de equilibrio de todas las partidas
+    bool medir = false;                 // Sumar los tiempos y contadores de todas las partidas
+    bool trazar = false;                // Guardar la línea de tiempo de la partida 0
+    bool estadisticas = false;          // Anotar estadísticas por piso, pelea y cofre (ver Estadisticas.h)
+    size_t mejores = 10;                // Partidas de la tabla de victorias con menos tiradas
+    std::string rutaEstadisticas;       // Si no está vacía, instantáneas de las estadísticas en este archivo
+    double segundosEntreInstantaneas = 0.0; // Cada cuánto se reescribe rutaEstadisticas (0 = solo al terminar)
+};
+
+/**
+ * Conteo de resultados de una simulación.
+ */
+struct ResumenSimulacion {
+    uint64_t partidas = 0;
+    uint64_t victorias = 0;             // Arcángel derrotado
+    uint64_t derrotasArcangel = 0;      // Muertes en pelearConArcangel
+    uint64_t derrotasCombate = 0;       // Muertes en combatirEnemigo
+    uint64_t derrotasTiradas = 0;       // Más tiradas que el límite en un piso
+    std::vector<uint64_t> pisoFinal = std::vector<uint64_t>(11, 0); // Partidas que terminaron en cada piso (desde el 1)
+    double segundos = 0.0;              // Tiempo de pared de la simulación
+    uint64_t bloquesPedidos = 0;        // Bloques de memoria de pisos pedidos al sistema
+    uint64_t bloquesReusados = 0;       // Bloques de pisos anteriores reusados por la arena de su tarea
+    std::shared_ptr<Medidor> medidor;   // Con opciones.medir, la suma de todas las partidas
+    std::shared_ptr<Medidor> traza;     // Con opciones.trazar, el medidor de la partida 0
+    std::shared_ptr<EstadisticasSimulacion> estadisticas; // Con opciones.estadisticas, una franja por hilo
+    uint64_t instantaneas = 0;          // Veces que se escribió rutaEstadisticas
+
+    void registrar(const Partida& partida);
+    void sumar(const ResumenSimulacion& otro);
+};
+
+/**
+ * Devuelve la política de movimiento con ese nombre ("aleatoria", "salida" u "optima",
+ * que resuelve la política óptima de cada partida en su primera tirada; ver PoliticaOptima.h).
+ * return Una política vacía si el nombre no existe.
+ */
+PoliticaMovimiento politicaPorNombre(const std::string& nombre);
+
+/**
+ * Prepara una partida sin terminal: sin mensajes, sin esperas y sin guardar en disco.
+ * param partida Partida a configurar.
+ * param semilla Semilla de su generador aleatorio.
+ * param flujo Flujo del generador; partidas con la misma semilla y distinto flujo son independientes.
+ * param politica Política que elegirá las direcciones.
+ */
+void configurarPartidaSinTerminal(Partida& partida, uint64_t semilla, uint64_t flujo, const PoliticaMovimiento& politica);
+
+/**
+ * Juega opciones.partidas partidas completas sin terminal, repartidas en un pool de hilos.
+ * Las partidas de una misma tarea se juegan una tras otra con la misma ArenaPisos.
+ * Con opciones.estadisticas cada hilo anota en su franja; si hay rutaEstadisticas,
+ * un hilo aparte suma las franjas y reescribe el archivo cada
+ * segundosEntreInstantaneas mientras se juega, y una última vez al terminar.
+ */
+ResumenSimulacion simularPartidas(const OpcionesSimulacion& opciones);
+
+void imprimirResumen(const ResumenSimulacion& resumen, std::ostream& salida);
@@ -0,0 +1,690 @@
+// Pruebas de rendimiento de los caminos calientes del juego. Cada prueba se mide
+// por separado, con la terminal descartada y una semilla fija, y los resultados
+// salen en JSON para comparar compilaciones (ver --comparar).
+
+#include "Calabozo.h"
+#include "Combate.h"
+#include "ConsultasPiso.h"
+#include "GeneracionMasiva.h"
+#include "Guardado.h"
+#include "PisosCompartidos.h"
+#include "Simulacion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    using Reloj = std::chrono::steady_clock;
+
+    /**
+     * Buffer que descarta todo lo que recibe. Con él, mostrarEstado y los mensajes
+     * formatean igual que con terminal pero sin escribir en ella.
+     */
+    class BufferDescarte : public std::streambuf {
+    protected:
+        int overflow(int caracter) override {
+            return traits_type::not_eof(caracter);
+        }
+        std::streamsize xsputn(const char*, std::streamsize cantidad) override {
+            return cantidad;
+        }
+    };
+
+    struct OpcionesRendimiento {
+        std::vector<int> tamanos = { 10, 100, 1000 };   // Lado de los pisos (10x10 a 1000x1000)
+        std::vector<int> reclutas = { 0, 1, 3 };        // Tamaños del equipo
+        uint64_t semilla = 1;
+        double segundos = 0.2;                          // Tiempo aproximado de cada prueba
+        int repeticiones = 5;                           // Muestras por prueba
+        std::string salida;                             // JSON; vacío = salida estándar
+        std::string comparar;                           // JSON de referencia
+        double umbral = 10.0;                           // % de empeoramiento que cuenta como regresión
+        std::string directorio;                         // Donde se escriben celdas.txt y jugador.txt
+        std::string solo;                               // Prefijo de las pruebas a ejecutar
+    };
+
+    struct Medicion {
+        std::string nombre;
+        int columnas = 0;
+        int filas = 0;
+        int reclutas = 0;
+        uint64_t iteraciones = 0;
+        double mediana = 0.0;       // Nanosegundos por operación
+        double minimo = 0.0;
+        double maximo = 0.0;
+        bool valido = true;         // false si la operación no dio el resultado esperado
+
+        std::string clave() const {
+            return nombre + " " + std::to_string(columnas) + "x" + std::to_string(filas) + " r" + std::to_string(reclutas);
+        }
+    };
+
+    /**
+     * Mide una operación: la calibra con una primera llamada para que cada muestra
+     * dure segundos / repeticiones y se queda con la mediana de las muestras.
+     * param operacion Recibe el número de iteración, para variar los datos.
+     */
+    template <typename Operacion>
+    Medicion medir(const OpcionesRendimiento& opciones, const std::string& nombre, int columnas, int filas, int reclutas, Operacion&& operacion) {
+        Medicion medicion;
+        medicion.nombre = nombre;
+        medicion.columnas = columnas;
+        medicion.filas = filas;
+        medicion.reclutas = reclutas;
+
+        uint64_t contador = 0;
+        auto inicio = Reloj::now();
+        operacion(contador++);
+        double primera = std::chrono::duration<double>(Reloj::now() - inicio).count();
+        double porMuestra = opciones.segundos / std::max(1, opciones.repeticiones);
+        uint64_t iteraciones = static_cast<uint64_t>(std::min(1e9, std::max(1.0, porMuestra / std::max(primera, 1e-9))));
+
+        std::vector<double> muestras;
+        for (int r = 0; r < std::max(1, opciones.repeticiones); ++r) {
+            inicio = Reloj::now();
+            for (uint64_t i = 0; i < iteraciones; ++i) {
+                operacion(contador++);
+            }
+            double ns = std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count();
+            muestras.push_back(ns / static_cast<double>(iteraciones));
+        }
+        std::sort(muestras.begin(), muestras.end());
+        medicion.iteraciones = iteraciones * muestras.size();
+        medicion.mediana = muestras[muestras.size() / 2];
+        medicion.minimo = muestras.front();
+        medicion.maximo = muestras.back();
+        return medicion;
+    }
+
+    /**
+     * Partida sin terminal con un piso de columnas x filas ya generado y un equipo de 'reclutas'.
+     */
+    void prepararPartida(Partida& partida, const OpcionesRendimiento& opciones, int columnas, int filas, int reclutas, bool perezosa) {
+        configurarPartidaSinTerminal(partida, opciones.semilla, 0, PoliticaMovimiento());
+        partida.pisosPerezosos = perezosa;
+        partida.piso.columnas = columnas;
+        partida.piso.filas = filas;
+        crearCalabozo(partida);
+        colocarJugador(partida.piso, partida.jugador);
+        static const Recluta disponibles[] = { {"Recluta1", 5, 5}, {"Recluta2", 6, 4}, {"Recluta4", 4, 6} };
+        for (int i = 0; i < reclutas; ++i) {
+            partida.jugador.equipo.push_back(disponibles[i % 3]);
+        }
+    }
+
+    /**
+     * Como prepararPartida, pero el piso sale de un calabozo compartido de un solo
+     * piso generado aquí (ver PisosCompartidos.h).
+     */
+    void prepararCompartida(Partida& partida, const OpcionesRendimiento& opciones, int lado) {
+        configurarPartidaSinTerminal(partida, opciones.semilla, 0, PoliticaMovimiento());
+        partida.numPisos = 1;
+        partida.piso.columnas = lado;
+        partida.piso.filas = lado;
+        partida.calabozoCompartido = CalabozoCompartido::generar(ClaveCalabozo::de(partida));
+        crearCalabozo(partida);
+        colocarJugador(partida.piso, partida.jugador);
+    }
+
+    /**
+     * Dirección al azar que nunca cruza la salida, para moverse sin cambiar de piso.
+     */
+    char direccionSinSalida(Partida& partida, int /*pasos*/) {
+        static const char direcciones[] = { 'W', 'A', 'S', 'D' };
+        const Piso& piso = partida.piso;
+        int columna = piso.columnaDe(partida.jugador.posicion);
+        int fila = piso.filaDe(partida.jugador.posicion);
+        char direccion = direcciones[partida.sortear(Proposito::Politica, piso.indiceDe(partida.jugador.posicion), 0, 4)];
+        if (direccion == 'D' && fila == piso.filas - 1) {
+            return 'A';
+        }
+        if (direccion == 'S' && columna == piso.columnas - 1) {
+            return 'W';
+        }
+        return direccion;
+    }
+
+    bool pedida(const OpcionesRendimiento& opciones, const std::string& nombre) {
+        return nombre.compare(0, opciones.solo.size(), opciones.solo) == 0;
+    }
+
+    void pruebasDePiso(const OpcionesRendimiento& opciones, int lado, std::vector<Medicion>& resultados, std::ostream& terminal) {
+        for (bool perezosa : { false, true }) {
+            std::string modo = perezosa ? "/perezosa" : "";
+
+            if (pedida(opciones, "crearCalabozo" + modo)) {
+                Partida partida;
+                prepararPartida(partida, opciones, lado, lado, 0, perezosa);
+                resultados.push_back(medir(opciones, "crearCalabozo" + modo, lado, lado, 0, [&](uint64_t) {
+                    partida.numEnemies = 0;
+                    crearCalabozo(partida);
+                }));
+                liberarPiso(partida.piso);
+            }
+
+            // Salida de un piso: se suelta el viejo y se crea el nuevo, con la memoria del sistema o de una arena
+            for (bool conArena : { false, true }) {
+                std::string nombre = "cambioDePiso" + modo + (conArena ? "/arena" : "");
+                if (!pedida(opciones, nombre)) {
+                    continue;
+                }
+                ArenaPisos arena;
+                Partida partida;
+                partida.arena = conArena ? &arena : nullptr;
+                prepararPartida(partida, opciones, lado, lado, 0, perezosa);
+                resultados.push_back(medir(opciones, nombre, lado, lado, 0, [&](uint64_t) {
+                    liberarPiso(partida.piso);
+                    partida.numEnemies = 0;
+                    crearCalabozo(partida);
+                    colocarJugador(partida.piso, partida.jugador);
+                }));
+                // Con la arena solo el primer piso pide memoria: un piso completo pide celdas, planos
+                // y tocadas; uno perezoso, los bloques de su tabla de celdas modificadas
+                size_t bloques = perezosa ? 2 : 3;
+                resultados.back().valido = !conArena || arena.reservas() <= bloques;
+                liberarPiso(partida.piso);
+            }
+
+            if (pedida(opciones, "moverJugador" + modo)) {
+                // Turno completo sin terminal: dados, dirección, búsqueda de celdas y eventos
+                Partida partida;
+                prepararPartida(partida, opciones, lado, lado, 0, perezosa);
+                partida.politica = direccionSinSalida;
+                resultados.push_back(medir(opciones, "moverJugador" + modo, lado, lado, 0, [&](uint64_t i) {
+                    partida.jugador.health = 1000000;   // Ningún combate termina la partida
+                    partida.numDiceThrows = static_cast<int>(i % 15);
+                    partida.juego = true;
+                    moverJugador(partida);
+                }));
+                resultados.back().valido = partida.pisoCalabozo == 1;
+                liberarPiso(partida.piso);
+            }
+
+            if (pedida(opciones, "contarCeldas" + modo)) {
+                // Enemigos que quedan y celdas sin visitar: popcounts con planos, recorrido del piso sin ellos
+                Partida partida;
+                prepararPartida(partida, opciones, lado, lado, 0, perezosa);
+                const Piso& piso = partida.piso;
+                int64_t total = 0;
+                resultados.push_back(medir(opciones, "contarCeldas" + modo, lado, lado, 0, [&](uint64_t) {
+                    total += piso.contar(CeldaEnemigo) + (piso.indice(0, lado) - piso.contar(CeldaVisitada));
+                }));
+                int64_t enemigos = 0;
+                for (int fila = 0; fila < lado; ++fila) {
+                    for (int columna = 0; columna < lado; ++columna) {
+                        enemigos += piso.consultar(columna, fila).tiene(CeldaEnemigo) ? 1 : 0;
+                    }
+                }
+                resultados.back().valido = total > 0 && piso.contar(CeldaEnemigo) == enemigos && piso.contar(CeldaVisitada) == 1;
+                liberarPiso(partida.piso);
+            }
+
+            if (pedida(opciones, "consultasPiso" + modo)) {
+                // Pistas de un turno desde celdas distintas: destinos, cofre más cercano y enemigos a dos tiradas
+                Partida partida;
+                prepararPartida(partida, opciones, lado, lado, 0, perezosa);
+                ConsultasPiso consultas(partida.piso);
+                int64_t celdas = static_cast<int64_t>(lado) * lado;
+                double probabilidad = 0.0;
+                resultados.push_back(medir(opciones, "consultasPiso" + modo, lado, lado, 0, [&](uint64_t i) {
+                    int64_t celda = static_cast<int64_t>(i % static_cast<uint64_t>(celdas));
+                    for (const DestinoTurno& destino : consultas.alcanceTurno(celda)) {
+                        probabilidad += destino.probabilidad;
+                    }
+                    probabilidad += static_cast<double>(consultas.masCercana(celda, CeldaCofre) + consultas.contarAlAlcance(celda, 2, CeldaEnemigo));
+                }));
+                resultados.back().valido = probabilidad > 0.0;
+                liberarPiso(partida.piso);
+            }
+        }
+
+        // El generador de pisos completos solo, con AVX2 (si el procesador lo tiene) y de a una celda
+        for (bool vectorial : { true, false }) {
+            std::string nombre = vectorial ? "generarPisoMasivo" : "generarPisoMasivo/escalar";
+            if (!pedida(opciones, nombre) || (vectorial && !generacionVectorial())) {
+                continue;
+            }
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, 0, false);
+            Piso& piso = partida.piso;
+            std::vector<Celda> esperadas(piso.celdas.begin(), piso.celdas.end());
+            int64_t ultimoEsperado = piso.ultimoEnemigo;
+            int64_t ultimoEnemigo = -1;
+            resultados.push_back(medir(opciones, nombre, lado, lado, 0, [&](uint64_t) {
+                std::fill(piso.planos.begin(), piso.planos.end(), 0);
+                partida.numEnemies = 0;
+                ultimoEnemigo = generarPisoMasivo(partida, vectorial);
+            }));
+            esperadas[static_cast<size_t>(piso.indiceDe(partida.jugador.posicion))].poner(CeldaJugador, false);
+            esperadas[static_cast<size_t>(piso.indiceDe(partida.jugador.posicion))].poner(CeldaVisitada, false);
+            resultados.back().valido = ultimoEnemigo == ultimoEsperado
+                && std::equal(esperadas.begin(), esperadas.end(), piso.celdas.begin(), [](const Celda& a, const Celda& b) {
+                    return std::memcmp(&a, &b, sizeof(Celda)) == 0;
+                });
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "crearCalabozo/compartida")) {
+            // Piso tomado de un calabozo compartido: no se genera ninguna celda
+            Partida partida;
+            prepararCompartida(partida, opciones, lado);
+            resultados.push_back(medir(opciones, "crearCalabozo/compartida", lado, lado, 0, [&](uint64_t) {
+                partida.numEnemies = 0;
+                crearCalabozo(partida);
+            }));
+            resultados.back().valido = partida.piso.compartidas != nullptr;
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "contarCeldas/compartida")) {
+            // Sin planos, como en la generación perezosa, pero las celdas se leen en vez de calcularse
+            Partida partida;
+            prepararCompartida(partida, opciones, lado);
+            const Piso& piso = partida.piso;
+            int64_t total = 0;
+            resultados.push_back(medir(opciones, "contarCeldas/compartida", lado, lado, 0, [&](uint64_t) {
+                total += piso.contar(CeldaEnemigo) + (piso.indice(0, lado) - piso.contar(CeldaVisitada));
+            }));
+            resultados.back().valido = total > 0 && piso.compartidas != nullptr && piso.contar(CeldaVisitada) == 1;
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "insertarCelda")) {
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, 0, false);
+            int64_t celdas = static_cast<int64_t>(lado) * lado;
+            resultados.push_back(medir(opciones, "insertarCelda", lado, lado, 0, [&](uint64_t i) {
+                int64_t celda = static_cast<int64_t>(i % static_cast<uint64_t>(celdas));
+                insertarCelda(partida, static_cast<int>(celda / lado), static_cast<int>(celda % lado));
+            }));
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "mostrarEstado")) {
+            BufferDescarte descarte;
+            std::ostream sumidero(&descarte);
+            for (int reclutas : opciones.reclutas) {
+                Partida partida;
+                prepararPartida(partida, opciones, lado, lado, reclutas, false);
+                partida.salida = &sumidero;
+                resultados.push_back(medir(opciones, "mostrarEstado", lado, lado, reclutas, [&](uint64_t) {
+                    mostrarEstado(partida);
+                }));
+                liberarPiso(partida.piso);
+            }
+        }
+
+        if (pedida(opciones, "guardarCeldasEnArchivo") || pedida(opciones, "cargarCeldasDesdeArchivo")) {
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, 0, false);
+            std::string original = serializarCeldas(partida.piso);
+            if (pedida(opciones, "guardarCeldasEnArchivo")) {
+                resultados.push_back(medir(opciones, "guardarCeldasEnArchivo", lado, lado, 0, [&](uint64_t) {
+                    guardarCeldasEnArchivo(partida.piso);
+                }));
+            }
+            guardarCeldasEnArchivo(partida.piso);
+
+            Partida cargada;
+            configurarPartidaSinTerminal(cargada, opciones.semilla, 0, PoliticaMovimiento());
+            if (pedida(opciones, "cargarCeldasDesdeArchivo")) {
+                resultados.push_back(medir(opciones, "cargarCeldasDesdeArchivo", lado, lado, 0, [&](uint64_t) {
+                    cargarCeldasDesdeArchivo(cargada);
+                }));
+                // El formato de texto solo sabe escribir columnas de una letra
+                resultados.back().valido = serializarCeldas(cargada.piso) == original;
+            }
+            liberarPiso(cargada.piso);
+            liberarPiso(partida.piso);
+        }
+
+        for (FormatoGuardado formato : { FormatoGuardado::Binario, FormatoGuardado::Delta }) {
+            std::string nombre = std::string("escribirGuardado/") + (formato == FormatoGuardado::Delta ? "delta" : "binario");
+            if (!pedida(opciones, nombre)) {
+                continue;
+            }
+            // Piso ya recorrido un rato, como cuando se pisa un punto de guardado
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, 0, false);
+            partida.politica = direccionSinSalida;
+            partida.guardadoHabilitado = false;
+            partida.formatoGuardado = formato;
+            for (int turno = 0; turno < 200; ++turno) {
+                partida.jugador.health = 1000000;
+                partida.numDiceThrows = turno % 15;
+                partida.juego = true;
+                moverJugador(partida);
+            }
+            resultados.push_back(medir(opciones, nombre, lado, lado, 0, [&](uint64_t) {
+                escribirGuardado(partida);
+            }));
+
+            // Cargar lo escrito da lo mismo que cargar el partida.dat de la partida
+            Partida cargada;
+            Partida referencia;
+            configurarPartidaSinTerminal(cargada, opciones.semilla, 0, PoliticaMovimiento());
+            configurarPartidaSinTerminal(referencia, opciones.semilla, 0, PoliticaMovimiento());
+            std::vector<unsigned char> binario = serializarPartidaBinaria(partida);
+            bool cargado = (formato == FormatoGuardado::Delta) ? cargarPartidaDelta(cargada) : cargarPartidaBinaria(cargada);
+            resultados.back().valido = cargado && deserializarPartidaBinaria(referencia, binario.data(), binario.size(), "la partida")
+                && serializarPartidaBinaria(cargada) == serializarPartidaBinaria(referencia);
+            liberarPiso(cargada.piso);
+            liberarPiso(referencia.piso);
+            liberarPiso(partida.piso);
+        }
+        terminal << "  " << lado << "x" << lado << " listo" << std::endl;
+    }
+
+    void pruebasDeEquipo(const OpcionesRendimiento& opciones, int reclutas, std::vector<Medicion>& resultados) {
+        const int lado = 10;
+
+        for (bool conEventos : { false, true }) {
+            std::string modo = conEventos ? "/eventos" : "";
+            if (!pedida(opciones, "combatirEnemigo" + modo)) {
+                continue;
+            }
+            // Enemigo del piso 10 contra un jugador que no cae, en celdas distintas para variar los dados.
+            // Con /eventos además se anotan los hechos de cada pelea, como haría un servidor
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, reclutas, false);
+            partida.pisoCalabozo = 10;
+            partida.jugador.health = 1000;
+            Jugador inicial = partida.jugador;
+            std::vector<EventoCombate> eventos;
+            eventos.reserve(256);
+            if (conEventos) {
+                partida.eventosCombate = &eventos;
+            }
+            bool terminadas = true;
+            resultados.push_back(medir(opciones, "combatirEnemigo" + modo, lado, lado, reclutas, [&](uint64_t i) {
+                Celda* enemigo = partida.piso.celda(static_cast<int>(i % lado), static_cast<int>(i / lado % lado));
+                partida.piso.marcar(enemigo, CeldaEnemigo, true);
+                enemigo->enemyHealth = 11;
+                enemigo->enemyAttack = 10;
+                partida.jugador.health = inicial.health;
+                partida.jugador.equipo = inicial.equipo;
+                partida.numDiceThrows = static_cast<int>(i / (lado * lado) % 16);
+                eventos.clear();
+                combatirEnemigo(partida, enemigo);
+                terminadas = terminadas && (!conEventos || eventos.back().tipo == TipoEventoCombate::Victoria);
+            }));
+            resultados.back().valido = terminadas;
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "pelearConArcangel")) {
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, reclutas, false);
+            partida.pisoCalabozo = 10;
+            Jugador inicial = partida.jugador;
+            resultados.push_back(medir(opciones, "pelearConArcangel", lado, lado, reclutas, [&](uint64_t i) {
+                partida.arcangel = Arcangel();
+                partida.jugador.health = inicial.health + static_cast<int>(i % 20);
+                partida.jugador.equipo = inicial.equipo;
+                partida.numDiceThrows = static_cast<int>(i % 16);
+                partida.juego = true;
+                pelearConArcangel(partida);
+            }));
+            liberarPiso(partida.piso);
+        }
+
+        if (pedida(opciones, "guardarInformacionJugador") || pedida(opciones, "cargarInformacionJugador")) {
+            Partida partida;
+            prepararPartida(partida, opciones, lado, lado, reclutas, false);
+            std::string original = serializarJugador(partida);
+            if (pedida(opciones, "guardarInformacionJugador")) {
+                resultados.push_back(medir(opciones, "guardarInformacionJugador", lado, lado, reclutas, [&](uint64_t) {
+                    guardarInformacionJugador(partida);
+                }));
+            }
+            guardarInformacionJugador(partida);
+            if (pedida(opciones, "cargarInformacionJugador")) {
+                bool cargada = true;
+                resultados.push_back(medir(opciones, "cargarInformacionJugador", lado, lado, reclutas, [&](uint64_t) {
+                    cargada = cargarInformacionJugador(partida) && cargada;
+                }));
+                resultados.back().valido = cargada && serializarJugador(partida) == original;
+            }
+            liberarPiso(partida.piso);
+        }
+    }
+
+    std::string escaparJson(const std::string& texto) {
+        std::string escapado;
+        for (char c : texto) {
+            if (c == '"' || c == '\\') {
+                escapado += '\\';
+            }
+            escapado += c;
+        }
+        return escapado;
+    }
+
+    std::string compilador() {
+#if defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+        return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+        return std::string("gcc ") + __VERSION__;
+#else
+        return "desconocido";
+#endif
+    }
+
+    /**
+     * Escribe los resultados en JSON, un resultado por línea para que --comparar
+     * (y cualquier diff) los lea sin un parser completo.
+     */
+    void escribirJson(const OpcionesRendimiento& opciones, const std::vector<Medicion>& resultados, std::ostream& salida) {
+        salida << "{\n";
+        salida << "  \"semilla\": " << opciones.semilla << ",\n";
+        salida << "  \"compilador\": \"" << escaparJson(compilador()) << "\",\n";
+#ifdef NDEBUG
+        salida << "  \"optimizado\": true,\n";
+#else
+        salida << "  \"optimizado\": false,\n";
+#endif
+        salida << "  \"resultados\": [\n";
+        salida << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < resultados.size(); ++i) {
+            const Medicion& m = resultados[i];
+            salida << "    {\"nombre\": \"" << escaparJson(m.nombre) << "\", \"columnas\": " << m.columnas << ", \"filas\": " << m.filas
+                << ", \"reclutas\": " << m.reclutas << ", \"iteraciones\": " << m.iteraciones
+                << ", \"ns_mediana\": " << m.mediana << ", \"ns_min\": " << m.minimo << ", \"ns_max\": " << m.maximo
+                << ", \"valido\": " << (m.valido ? "true" : "false") << "}" << (i + 1 < resultados.size() ? "," : "") << "\n";
+        }
+        salida << "  ]\n}\n";
+    }
+
+    /**
+     * Valor de un campo en una línea de resultados de escribirJson.
+     */
+    std::string campo(const std::string& linea, const std::string& nombre) {
+        std::string buscado = "\"" + nombre + "\": ";
+        size_t inicio = linea.find(buscado);
+        if (inicio == std::string::npos) {
+            return "";
+        }
+        inicio += buscado.size();
+        if (linea[inicio] == '"') {
+            size_t fin = linea.find('"', inicio + 1);
+            return linea.substr(inicio + 1, fin - inicio - 1);
+        }
+        size_t fin = linea.find_first_of(",}", inicio);
+        return linea.substr(inicio, fin - inicio);
+    }
+
+    std::vector<Medicion> leerJson(const std::string& ruta) {
+        std::vector<Medicion> resultados;
+        std::ifstream archivo(ruta);
+        std::string linea;
+        while (std::getline(archivo, linea)) {
+            if (linea.find("\"nombre\"") == std::string::npos) {
+                continue;
+            }
+            Medicion m;
+            m.nombre = campo(linea, "nombre");
+            m.columnas = std::stoi(campo(linea, "columnas"));
+            m.filas = std::stoi(campo(linea, "filas"));
+            m.reclutas = std::stoi(campo(linea, "reclutas"));
+            m.mediana = std::stod(campo(linea, "ns_mediana"));
+            resultados.push_back(m);
+        }
+        return resultados;
+    }
+
+    /**
+     * Compara con una ejecución anterior.
+     * return Cantidad de pruebas que empeoraron más que opciones.umbral.
+     */
+    int comparar(const OpcionesRendimiento& opciones, const std::vector<Medicion>& actuales, std::ostream& salida) {
+        std::vector<Medicion> anteriores = leerJson(opciones.comparar);
+        int regresiones = 0;
+        salida << std::fixed << std::setprecision(1);
+        for (const Medicion& actual : actuales) {
+            auto anterior = std::find_if(anteriores.begin(), anteriores.end(),
+                [&](const Medicion& m) { return m.clave() == actual.clave(); });
+            if (anterior == anteriores.end() || anterior->mediana <= 0.0) {
+                continue;
+            }
+            double cambio = 100.0 * (actual.mediana - anterior->mediana) / anterior->mediana;
+            bool regresion = cambio > opciones.umbral;
+            regresiones += regresion ? 1 : 0;
+            salida << (regresion ? "REGRESION " : "          ") << std::left << std::setw(44) << actual.clave() << std::right
+                << std::setw(14) << anterior->mediana << " ns -> " << std::setw(14) << actual.mediana << " ns  ("
+                << std::showpos << cambio << std::noshowpos << " %)" << std::endl;
+        }
+        return regresiones;
+    }
+
+    std::vector<int> leerLista(const std::string& valor) {
+        std::vector<int> lista;
+        std::istringstream entrada(valor);
+        std::string parte;
+        while (std::getline(entrada, parte, ',')) {
+            lista.push_back(std::stoi(parte));
+        }
+        return lista;
+    }
+
+    /**
+     * Lee las opciones de la línea de comandos.
+     *        --tamanos 10,100,1000   Lados de los pisos.
+     *        --reclutas 0,1,3        Tamaños del equipo (0 a 3).
+     *        --semilla S             Semilla fija de las partidas.
+     *        --tiempo T              Segundos aproximados por prueba.
+     *        --repeticiones R        Muestras por prueba; se informa la mediana.
+     *        --salida R              Archivo JSON (por defecto, la salida estándar).
+     *        --comparar R            JSON de una ejecución anterior; marca las regresiones.
+     *        --umbral P              Porcentaje de empeoramiento que cuenta como regresión.
+     *        --directorio D          Directorio donde se escriben celdas.txt y jugador.txt.
+     *        --solo P                Solo las pruebas cuyo nombre empieza por P.
+     */
+    OpcionesRendimiento leerOpciones(int argc, char* argv[]) {
+        OpcionesRendimiento opciones;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string opcion = argv[i];
+            std::string valor = argv[i + 1];
+            if (opcion == "--tamanos") {
+                opciones.tamanos = leerLista(valor);
+            }
+            else if (opcion == "--reclutas") {
+                opciones.reclutas = leerLista(valor);
+            }
+            else if (opcion == "--semilla") {
+                opciones.semilla = std::stoull(valor);
+            }
+            else if (opcion == "--tiempo") {
+                opciones.segundos = std::stod(valor);
+            }
+            else if (opcion == "--repeticiones") {
+                opciones.repeticiones = std::stoi(valor);
+            }
+            else if (opcion == "--salida") {
+                opciones.salida = valor;
+            }
+            else if (opcion == "--comparar") {
+                opciones.comparar = valor;
+            }
+            else if (opcion == "--umbral") {
+                opciones.umbral = std::stod(valor);
+            }
+            else if (opcion == "--directorio") {
+                opciones.directorio = valor;
+            }
+            else if (opcion == "--solo") {
+                opciones.solo = valor;
+            }
+        }
+        for (int& reclutas : opciones.reclutas) {
+            reclutas = std::min(std::max(reclutas, 0), 3);
+        }
+        return opciones;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    OpcionesRendimiento opciones = leerOpciones(argc, argv);
+    if (!opciones.directorio.empty()) {
+#ifdef _WIN32
+        int cambio = _chdir(opciones.directorio.c_str());
+#else
+        int cambio = chdir(opciones.directorio.c_str());
+#endif
+        if (cambio != 0) {
+            std::cerr << "No se pudo entrar en " << opciones.directorio << std::endl;
+            return 1;
+        }
+    }
+
+    // Los guardados escriben sus mensajes en std::cout: se descartan mientras se mide
+    BufferDescarte descarte;
+    std::streambuf* terminal = std::cout.rdbuf(&descarte);
+
+    std::vector<Medicion> resultados;
+    std::cerr << "Pruebas por tamano de piso:" << std::endl;
+    for (int lado : opciones.tamanos) {
+        pruebasDePiso(opciones, lado, resultados, std::cerr);
+    }
+    std::cerr << "Pruebas por tamano del equipo:" << std::endl;
+    for (int reclutas : opciones.reclutas) {
+        pruebasDeEquipo(opciones, reclutas, resultados);
+        std::cerr << "  " << reclutas << " reclutas listo" << std::endl;
+    }
+    std::cout.rdbuf(terminal);
+
+    if (opciones.salida.empty()) {
+        escribirJson(opciones, resultados, std::cout);
+    }
+    else {
+        std::ofstream archivo(opciones.salida);
+        escribirJson(opciones, resultados, archivo);
+        if (!archivo) {
+            std::cerr << "No se pudo escribir " << opciones.salida << std::endl;
+            return 1;
+        }
+    }
+
+    if (!opciones.comparar.empty()) {
+        int regresiones = comparar(opciones, resultados, std::cerr);
+        std::cerr << regresiones << " regresiones por encima del " << opciones.umbral << " %" << std::endl;
+        return regresiones > 0 ? 2 : 0;
+    }
+    return 0;
+}